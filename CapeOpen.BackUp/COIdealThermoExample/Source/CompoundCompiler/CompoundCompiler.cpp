@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include <string.h>
+#include <CPPExports.h>     // exports from the IdealThermoModule
+
+/*! \mainpage Compound Compiler
+*
+*This project (CompoundCompiler) packs the compound libraries (.compoundlibrary)
+*and the .compound files of a folder into
+*a single compound database image: fixed-layout records, a string pool and
+*a hash index on the compound names, with a version number and a checksum.
+*
+*If the image is stored as compounds.compounddb in the compound data folder
+*(which is the default output), property packages load their compounds from
+*the memory-mapped image instead of parsing the libraries and .compound files.
+*Compounds that are not in the image are still loaded from the libraries and
+*.compound files. Run the compiler again after editing these.
+*
+*Usage: compound_compiler [--data folder] [--out file]
+*
+*where folder defaults to the compound data folder of IdealThermoModule.
+*
+*/
+
+//! Print usage
+static void Usage()
+{fprintf(stderr,"Usage: compound_compiler [--data folder] [--out file]\n");
+}
+
+//! Entry point
+int main(int argc,char **argv)
+{const char *folder=NULL;
+ const char *outName=NULL;
+ char error[1024];
+ int i,count;
+ for (i=1;i<argc;i++)
+  {if ((strcmp(argv[i],"--data")==0)&&(i+1<argc)) folder=argv[++i];
+   else if ((strcmp(argv[i],"--out")==0)&&(i+1<argc)) outName=argv[++i];
+   else
+    {Usage();
+     return 1;
+    }
+  }
+ if (!CompileCompoundDatabase(folder,outName,&count,error,sizeof(error)))
+  {fprintf(stderr,"%s\n",error);
+   return 1;
+  }
+ printf("%d compounds\n",count);
+ return 0;
+}
@@ -19,6 +19,13 @@ class Antoine
 	double A,B,C; /*!< correlation coefficients */
 	double Bln10; /*!< constant */
 
+
+	//the correlation table copies the coefficients, the surrogate tabulates the equation,
+	//the compound database stores the coefficients
+	friend class CorrelationTable;
+	friend class VaporPressureSurrogate;
+	friend class CompoundDatabase;
+
  public:
 
 
@@ -44,7 +51,7 @@ class Antoine
 	  \return Vapore pressure / Pa
 	*/
 	
-	double Value(double T)
+	double Value(double T) const
 	{return pow(10,A-B/(C+T));
 	}
 
@@ -55,7 +62,7 @@ class Antoine
 	  \return Temperature derivative of vapor pressure / Pa/K
 	*/
 	
-	double ValueDT(double T)
+	double ValueDT(double T) const
 	{double d=C+T;
 	 return Value(T)*Bln10/(d*d);
 	}
@@ -1,8 +1,16 @@
-#include "StdAfx.h"
+#include "stdafx.h"
 #include "CPPExports.h"
 #include "PropertyPackage.h"
 #include "PropertyPackageEnumerator.h"
+#include "FlashBatch.h"
+#include "CorrelationTable.h"
+#include "Compound.h"
+#include "CompoundDatabase.h"
+#include "CompoundRegistry.h"
+#include "IdealThermoModule.h"
+#ifdef _WIN32
 #include "ThermoSystemEditor.h"
+#endif
 
 //! Constructor
 /*!
@@ -39,6 +47,129 @@ int PropertyPackEnumerator::Count() {return ppEnum->Count();}
 
 const char *PropertyPackEnumerator::PackageName(int index) {return ppEnum->PackageName(index);}
 
+//! Constructor
+/*!
+  Constructor, creates a PropertyWorkspace class
+  \sa PropertyWorkspace
+*/
+
+PropertyPackWorkspace::PropertyPackWorkspace()
+ {ws=new PropertyWorkspace();
+ }
+
+//! Destructor
+/*!
+  Destructor, cleans up
+  \sa PropertyWorkspace
+*/
+
+PropertyPackWorkspace::~PropertyPackWorkspace()
+ {delete ws;
+ }
+
+//! Return the last error
+ /*!
+  Returns the error message of the last calculation that failed
+  using this workspace
+*/
+
+const char *PropertyPackWorkspace::LastError() {return ws->LastError();}
+
+//! Return the number of solver evaluations
+ /*!
+  Returns the number of function evaluations performed by the 
+  1-dimensional solvers during the last flash using this workspace
+*/
+
+int PropertyPackWorkspace::SolverEvaluations() {return ws->SolverEvaluations();}
+
+//! Set the size of the pure component cache
+ /*!
+  Set the number of temperatures for which this workspace keeps the pure
+  component quantities (vapor pressure, heat capacity, ...); zero disables
+  the cache
+  \param size Number of entries
+*/
+
+void PropertyPackWorkspace::SetCacheSize(int size) {ws->SetCacheSize(size);}
+
+//! Return the number of pure component cache hits
+ /*!
+  Returns the number of calls using this workspace that found all pure
+  component quantities they needed in the cache
+*/
+
+long PropertyPackWorkspace::CacheHits() {return ws->CacheHits();}
+
+//! Return the number of pure component cache misses
+ /*!
+  Returns the number of calls using this workspace that evaluated pure 
+  component quantities
+*/
+
+long PropertyPackWorkspace::CacheMisses() {return ws->CacheMisses();}
+
+//! Set the size of the flash solution history
+ /*!
+  Set the number of compositions for which this workspace keeps the last
+  flash solution, to start subsequent flashes from; zero (the default) disables
+  the history
+  \param size Number of entries
+*/
+
+void PropertyPackWorkspace::SetFlashHistorySize(int size) {ws->SetFlashHistorySize(size);}
+
+//! Return the number of flash history hits
+ /*!
+  Returns the number of flashes using this workspace that found a previous
+  solution for their composition
+*/
+
+long PropertyPackWorkspace::FlashHistoryHits() {return ws->FlashHistoryHits();}
+
+//! Return the number of flash history misses
+ /*!
+  Returns the number of flashes using this workspace that did not find a 
+  previous solution for their composition
+*/
+
+long PropertyPackWorkspace::FlashHistoryMisses() {return ws->FlashHistoryMisses();}
+
+//! Return the number of flash history fallbacks
+ /*!
+  Returns the number of solutions started from a previous solution that 
+  failed, after which the full range was searched
+*/
+
+long PropertyPackWorkspace::FlashHistoryFallbacks() {return ws->FlashHistoryFallbacks();}
+
+//! Constructor
+/*!
+  Constructor, creates an empty PreparedMixture class
+  \sa PreparedMixture, PropertyPack::PrepareMixture()
+*/
+
+PropertyPackMixture::PropertyPackMixture()
+ {mixture=new PreparedMixture();
+ }
+
+//! Destructor
+/*!
+  Destructor, cleans up
+  \sa PreparedMixture
+*/
+
+PropertyPackMixture::~PropertyPackMixture()
+ {delete mixture;
+ }
+
+//! Number of compounds
+/*!
+  \return The number of compounds in the mixture, zero if not prepared
+*/
+
+int PropertyPackMixture::CompoundCount() {return mixture->CompoundCount();}
+
 //! Constructor
 /*!
   Constructor, creates a PropertyPackage class
@@ -103,6 +234,48 @@ bool PropertyPack::Save(const char *pathName) {return pp->Save(pathName);}
 */
 
 bool PropertyPack::LoadFromPPFile(const char *ppName) {return pp->LoadFromPPFile(ppName);}
+
+//! Set deferred loading of the correlations
+/*!
+  Defer loading the correlations of each compound until a calculation first
+  involves it. Must be called before the property package is loaded.
+  \param lazy True to defer loading the correlations
+  \return True for success, false for error
+  \sa GetLoadCounters(), Load(), LastError()
+*/
+
+bool PropertyPack::SetLazyLoading(bool lazy) {return pp->SetLazyLoading(lazy);}
+
+//! Get the load counters
+/*!
+  \param compoundCount Receives the number of compounds
+  \param deferred Receives the number of compounds of which loading the correlations was deferred
+  \param loaded Receives the number of those compounds of which the correlations have been loaded since
+  \sa SetLazyLoading()
+*/
+
+void PropertyPack::GetLoadCounters(int &compoundCount,int &deferred,int &loaded) const {pp->GetLoadCounters(compoundCount,deferred,loaded);}
+
+//! Set the tabulated mode
+/*!
+  Evaluate the vapor pressures from tabulated splines instead of the Antoine
+  equation, trading a controlled error for speed, or switch back to the Antoine
+  equation. Must not be called while calculations are running.
+  \param maxRelError Maximum relative error of the vapor pressures; zero to use the Antoine equation
+  \return True for success, false for error
+  \sa GetTabulationReport(), LastError()
+*/
+
+bool PropertyPack::SetTabulation(double maxRelError) {return pp->SetTabulation(maxRelError);}
+
+//! Get the validation report of the tabulated mode
+/*!
+  Compare the tabulated vapor pressures to the Antoine equation for each compound
+  \return The report as comma separated values, or NULL in case of failure
+  \sa SetTabulation(), LastError()
+*/
+
+const char *PropertyPack::GetTabulationReport() {return pp->GetTabulationReport();}
  
 
 //! Get number of compounds
@@ -126,6 +299,17 @@ bool PropertyPack::GetCompoundCount(int *compoundCount) {return pp->GetCompoundC
  
 const char *PropertyPack::GetCompoundStringConstant(int compIndex,StringConstant constID) {return pp->GetCompoundStringConstant(compIndex,constID);}
  
+//! Get compound index
+/*!
+  Find a compound by name, ignoring character case, in constant time
+  \param compName Name of the compound
+  \param compIndex Receives the index of the compound
+  \return True if ok, false if the compound is not in the property package
+  \sa GetCompoundCount(), GetCompoundStringConstant(), LastError()
+*/
+ 
+bool PropertyPack::GetCompoundIndex(const char *compName,int &compIndex) {return pp->GetCompoundIndex(compName,compIndex);}
+ 
 //! Get compound real constant
 /*!
   Get real constant for a compound.
@@ -254,6 +438,449 @@ bool PropertyPack::Flash(int nComp,const int *compIndices,const double *X,FlashT
 
 bool PropertyPack::Flash(int nComp,const int *compIndices,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *&phases,double *&phaseFractions,double **&phaseCompositions,double &T, double &P) {return pp->Flash(nComp,compIndices,X,type,phaseType,spec1,spec2,phaseCount,phases,phaseFractions,phaseCompositions,T,P);}
 
+//! Get compound temperature dependent property value at specified temperature
+/*!
+  Get real constant for a compound. Can be called from multiple threads at the 
+  same time, if each thread uses its own workspace.
+  \param ws Workspace that receives the error
+  \param compIndex Index of the compound. Must be between zero and number of compounds-1, inclusive.
+  \param propID ID of the temperature dependent property to be obtained
+  \param T Temperature [K]. Must be between zero and critical temperature of the compound
+  \param value Receives the value of the requested temperature dependent property.
+  \return True if ok
+  \sa GetCompoundCount(), PropertyPackWorkspace::LastError(), TDependentProperty
+*/
+
+bool PropertyPack::GetTemperatureDependentProperty(PropertyPackWorkspace &ws,int compIndex,TDependentProperty propID,double T,double &value) const {return pp->GetTemperatureDependentProperty(*ws.ws,compIndex,propID,T,value);}
+
+//! Get single-phase mixture properties at specified temperature, pressure and composition
+/*!
+  Calculate and get single phase mixture properties. The properties are returned in arrays 
+  that are stored in the workspace. The return values are only valid until the next
+  call with the same workspace, so store the return values, but not the pointers to them. 
+  Can be called from multiple threads at the same time, if each thread uses its own workspace.
+  
+  \param ws Workspace that receives the return values and the error
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param phaseID ID of the phase for which to calculate the properties
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions [mol/mol], one value for each compound, assumed normalized
+  \param nProp Number of properties requested
+  \param propIDs IDs of the properties requested
+  \param valueCount Receives the number of values for each of the properties, one value for each property
+  \param values Receives the values, one double array for each property. Size of the array corresponds to valueCount for each property
+  \return True if ok
+  \sa GetCompoundCount(), PropertyPackWorkspace::LastError(), Phase, SinglePhaseProperty
+*/
+
+bool PropertyPack::GetSinglePhaseProperties(PropertyPackWorkspace &ws,int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int *&valueCount,double **&values) const {return pp->GetSinglePhaseProperties(*ws.ws,nComp,compIndices,phaseID,T,P,X,nProp,propIDs,valueCount,values);}
+
+//! Get two-phase mixture properties at specified temperature, pressure and composition
+/*!
+  Calculate and get two-phase mixture properties. The properties are returned in arrays 
+  that are stored in the workspace. The return values are only valid until the next
+  call with the same workspace, so store the return values, but not the pointers to them. 
+  Can be called from multiple threads at the same time, if each thread uses its own workspace.
+  
+  \param ws Workspace that receives the return values and the error
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param phaseID1 ID of the first phase for which to calculate the property
+  \param phaseID2 ID of the second phase for which to calculate the property
+  \param T1 Temperature of phase 1[K]
+  \param T2 Temperature of phase 2[K]
+  \param P1 Pressure of phase 1 [Pa]
+  \param P2 Pressure of phase 2 [Pa]
+  \param X1 Mole fractions for phase 1 [mol/mol], one value for each compound, assumed normalized
+  \param X2 Mole fractions for phase 2 [mol/mol], one value for each compound, assumed normalized
+  \param nProp Number of properties requested
+  \param propIDs IDs of the properties requested
+  \param valueCount Receives the number of values for each of the properties, one value for each property
+  \param values Receives the values, one double array for each property. Size of the array corresponds to valueCount for each property
+  \return True if ok
+  \sa GetCompoundCount(), PropertyPackWorkspace::LastError(), Phase, TwoPhaseProperty
+*/
+
+bool PropertyPack::GetTwoPhaseProperties(PropertyPackWorkspace &ws,int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2,int nProp,TwoPhaseProperty *propIDs,int *&valueCount,double **&values) const {return pp->GetTwoPhaseProperties(*ws.ws,nComp,compIndices,phaseID1,phaseID2,T1,T2,P1,P2,X1,X2,nProp,propIDs,valueCount,values);}
+
+//! Calculate phase equilibrium
+/*!
+  Calculate phase equilibrium. The vaues are returned in arrays that are stored in the 
+  workspace. The return values are only valid until the next call with the same workspace,
+  so store the return values, but not the pointers to them. Can be called from multiple 
+  threads at the same time, if each thread uses its own workspace.
+  
+  \param ws Workspace that receives the return values and the error
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param X Overall mole fractions[mol/mol], one value for each compound, assumed normalized
+  \param type Type of specifications passed (e.g. TP for a temperature and pressure specification)
+  \param phaseType Specified allowed phases in flash. 
+  \param spec1 Value of first specification (e.g. T/[K] for TP)
+  \param spec2 Value of second specification (e.g. P/[Pa] for TP)
+  \param phaseCount Receives the number of phases at equilibrium
+  \param phases Receives the types of the existing phases (Vapor or Liquid)
+  \param phaseFractions Receives the phase fractions of the existing phases [mol/mol]
+  \param phaseCompositions Receives the compositions of the existing phases [mol/mol]; one array for each phase, each array contains one mole fraction for each compound
+  \param T Receives the temperature at equilibrium
+  \param P Receives the pressure at equilibrium
+  \return True if ok
+  \sa GetCompoundCount(), PropertyPackWorkspace::LastError(), Phase, FlashType
+*/
+
+bool PropertyPack::Flash(PropertyPackWorkspace &ws,int nComp,const int *compIndices,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *&phases,double *&phaseFractions,double **&phaseCompositions,double &T, double &P) const {return pp->Flash(*ws.ws,nComp,compIndices,X,type,phaseType,spec1,spec2,phaseCount,phases,phaseFractions,phaseCompositions,T,P);}
+
+//! Prepare a mixture
+/*!
+  Check a compound set once, and store it for calculations by GetSinglePhaseProperties()
+  and Flash() on the prepared mixture, which then skip the checks and mapping of the 
+  compound indices. A prepared mixture can be used from multiple threads at the same time,
+  if each thread uses its own workspace. The mixture must be prepared again if the property
+  package is loaded again.
+  
+  \param ws Workspace that receives the error
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param mixture Receives the prepared mixture
+  \return True if ok
+  \sa GetCompoundCount(), PropertyPackWorkspace::LastError(), PropertyPackMixture
+*/
+
+bool PropertyPack::PrepareMixture(PropertyPackWorkspace &ws,int nComp,const int *compIndices,PropertyPackMixture &mixture) const {return pp->PrepareMixture(*ws.ws,nComp,compIndices,*mixture.mixture);}
+
+//! Get single-phase mixture properties of a prepared mixture
+/*!
+  As GetSinglePhaseProperties() with compound indices, for a mixture prepared by PrepareMixture()
+  \param ws Workspace that receives the return values and the error
+  \param mixture Mixture prepared for this property package
+  \param phaseID ID of the phase for which to calculate the properties
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions [mol/mol], one value for each compound of the mixture, assumed normalized
+  \param nProp Number of properties requested
+  \param propIDs IDs of the properties requested
+  \param valueCount Receives the number of values for each of the properties, one value for each property
+  \param values Receives the values, one double array for each property. Size of the array corresponds to valueCount for each property
+  \return True if ok
+  \sa PrepareMixture(), PropertyPackWorkspace::LastError(), Phase, SinglePhaseProperty
+*/
+
+bool PropertyPack::GetSinglePhaseProperties(PropertyPackWorkspace &ws,const PropertyPackMixture &mixture,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int *&valueCount,double **&values) const {return pp->GetSinglePhaseProperties(*ws.ws,*mixture.mixture,phaseID,T,P,X,nProp,propIDs,valueCount,values);}
+
+//! Calculate phase equilibrium of a prepared mixture
+/*!
+  As Flash() with compound indices, for a mixture prepared by PrepareMixture()
+  \param ws Workspace that receives the return values and the error
+  \param mixture Mixture prepared for this property package
+  \param X Overall mole fractions[mol/mol], one value for each compound of the mixture, assumed normalized
+  \param type Type of specifications passed (e.g. TP for a temperature and pressure specification)
+  \param phaseType Specified allowed phases in flash. 
+  \param spec1 Value of first specification (e.g. T/[K] for TP)
+  \param spec2 Value of second specification (e.g. P/[Pa] for TP)
+  \param phaseCount Receives the number of phases at equilibrium
+  \param phases Receives the types of the existing phases (Vapor or Liquid)
+  \param phaseFractions Receives the phase fractions of the existing phases [mol/mol]
+  \param phaseCompositions Receives the compositions of the existing phases [mol/mol]; one array for each phase, each array contains one mole fraction for each compound
+  \param T Receives the temperature at equilibrium
+  \param P Receives the pressure at equilibrium
+  \return True if ok
+  \sa PrepareMixture(), PropertyPackWorkspace::LastError(), Phase, FlashType
+*/
+
+bool PropertyPack::Flash(PropertyPackWorkspace &ws,const PropertyPackMixture &mixture,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *&phases,double *&phaseFractions,double **&phaseCompositions,double &T, double &P) const {return pp->Flash(*ws.ws,*mixture.mixture,X,type,phaseType,spec1,spec2,phaseCount,phases,phaseFractions,phaseCompositions,T,P);}
+
+//! Get the number of values of single-phase mixture properties
+/*!
+  Get the sizes of the buffers that GetSinglePhaseProperties() with caller-supplied buffers
+  needs for a set of properties. The sizes only depend on the number of compounds and the 
+  properties, so the buffers can be allocated once for all calculations on a mixture.
+  \param nComp Number of compounds in the mixture
+  \param nProp Number of properties requested
+  \param propIDs IDs of the properties requested
+  \param valueCount Receives the number of values for each of the properties, one value for each property; can be NULL
+  \param totalCount Receives the total number of values of all properties
+  \return False if one or more of the property IDs is invalid
+  \sa GetSinglePhaseProperties(), SinglePhaseProperty
+*/
+
+bool PropertyPack::GetSinglePhasePropertySizes(int nComp,int nProp,const SinglePhaseProperty *propIDs,int *valueCount,int &totalCount) {return PropertyPackage::GetSinglePhasePropertySizes(nComp,nProp,propIDs,valueCount,totalCount);}
+
+//! Get the number of values of two-phase mixture properties
+/*!
+  Get the sizes of the buffers that GetTwoPhaseProperties() with caller-supplied buffers
+  needs for a set of properties. 
+  \param nComp Number of compounds in the mixture
+  \param nProp Number of properties requested
+  \param propIDs IDs of the properties requested
+  \param valueCount Receives the number of values for each of the properties, one value for each property; can be NULL
+  \param totalCount Receives the total number of values of all properties
+  \return False if one or more of the property IDs is invalid
+  \sa GetTwoPhaseProperties(), TwoPhaseProperty
+*/
+
+bool PropertyPack::GetTwoPhasePropertySizes(int nComp,int nProp,const TwoPhaseProperty *propIDs,int *valueCount,int &totalCount) {return PropertyPackage::GetTwoPhasePropertySizes(nComp,nProp,propIDs,valueCount,totalCount);}
+
+//! Get the sizes of the results of a flash
+/*!
+  Get the sizes of the buffers that Flash() with caller-supplied buffers needs
+  \param nComp Number of compounds in the mixture
+  \param phaseCapacity Receives the number of values of the phases and phase fractions
+  \param compositionCapacity Receives the number of values of the phase compositions
+  \sa Flash()
+*/
+
+void PropertyPack::GetFlashResultSizes(int nComp,int &phaseCapacity,int &compositionCapacity) {PropertyPackage::GetFlashResultSizes(nComp,phaseCapacity,compositionCapacity);}
+
+//! Get single-phase mixture properties into caller-supplied buffers
+/*!
+  As GetSinglePhaseProperties(), but the values are written into buffers of the caller, 
+  so they remain valid after subsequent calls. The values of all properties are stored 
+  consecutively, in the order of the properties.
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param phaseID ID of the phase for which to calculate the properties
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions [mol/mol], one value for each compound, assumed normalized
+  \param nProp Number of properties requested
+  \param propIDs IDs of the properties requested
+  \param valueCapacity Number of values that fit in values
+  \param valueCount Receives the number of values for each of the properties, one value for each property
+  \param values Receives the values of all properties, those of each property following those of the previous property
+  \return True if ok
+  \sa GetSinglePhasePropertySizes(), LastError(), Phase, SinglePhaseProperty
+*/
+
+bool PropertyPack::GetSinglePhaseProperties(int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values) {return pp->GetSinglePhaseProperties(nComp,compIndices,phaseID,T,P,X,nProp,propIDs,valueCapacity,valueCount,values);}
+
+//! Get two-phase mixture properties into caller-supplied buffers
+/*!
+  As GetTwoPhaseProperties(), but the values are written into buffers of the caller, 
+  so they remain valid after subsequent calls. The values of all properties are stored 
+  consecutively, in the order of the properties.
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param phaseID1 ID of the first phase for which to calculate the property
+  \param phaseID2 ID of the second phase for which to calculate the property
+  \param T1 Temperature of phase 1[K]
+  \param T2 Temperature of phase 2[K]
+  \param P1 Pressure of phase 1 [Pa]
+  \param P2 Pressure of phase 2 [Pa]
+  \param X1 Mole fractions for phase 1 [mol/mol], one value for each compound, assumed normalized
+  \param X2 Mole fractions for phase 2 [mol/mol], one value for each compound, assumed normalized
+  \param nProp Number of properties requested
+  \param propIDs IDs of the properties requested
+  \param valueCapacity Number of values that fit in values
+  \param valueCount Receives the number of values for each of the properties, one value for each property
+  \param values Receives the values of all properties, those of each property following those of the previous property
+  \return True if ok
+  \sa GetTwoPhasePropertySizes(), LastError(), Phase, TwoPhaseProperty
+*/
+
+bool PropertyPack::GetTwoPhaseProperties(int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2,int nProp,TwoPhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values) {return pp->GetTwoPhaseProperties(nComp,compIndices,phaseID1,phaseID2,T1,T2,P1,P2,X1,X2,nProp,propIDs,valueCapacity,valueCount,values);}
+
+//! Calculate phase equilibrium into caller-supplied buffers
+/*!
+  As Flash(), but the results are written into buffers of the caller, so they remain 
+  valid after subsequent calls
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param X Overall mole fractions[mol/mol], one value for each compound, assumed normalized
+  \param type Type of specifications passed (e.g. TP for a temperature and pressure specification)
+  \param phaseType Specified allowed phases in flash. 
+  \param spec1 Value of first specification (e.g. T/[K] for TP)
+  \param spec2 Value of second specification (e.g. P/[Pa] for TP)
+  \param phaseCount Receives the number of phases at equilibrium
+  \param phases Receives the types of the existing phases (Vapor or Liquid); room for PhaseCount values
+  \param phaseFractions Receives the phase fractions of the existing phases [mol/mol]; room for PhaseCount values
+  \param phaseCompositions Receives the compositions of the existing phases [mol/mol]; room for PhaseCount*nComp values, the composition of phase j starts at phaseCompositions[j*nComp]
+  \param T Receives the temperature at equilibrium
+  \param P Receives the pressure at equilibrium
+  \return True if ok
+  \sa GetFlashResultSizes(), LastError(), Phase, FlashType
+*/
+
+bool PropertyPack::Flash(int nComp,const int *compIndices,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *phases,double *phaseFractions,double *phaseCompositions,double &T, double &P) {return pp->Flash(nComp,compIndices,X,type,phaseType,spec1,spec2,phaseCount,phases,phaseFractions,phaseCompositions,T,P);}
+
+//! Get single-phase mixture properties into caller-supplied buffers
+/*!
+  As GetSinglePhaseProperties() with workspace argument, but the values are written into 
+  buffers of the caller. Can be called from multiple threads at the same time, if each 
+  thread uses its own workspace and its own buffers.
+  \param ws Workspace that receives the error
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param phaseID ID of the phase for which to calculate the properties
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions [mol/mol], one value for each compound, assumed normalized
+  \param nProp Number of properties requested
+  \param propIDs IDs of the properties requested
+  \param valueCapacity Number of values that fit in values
+  \param valueCount Receives the number of values for each of the properties, one value for each property
+  \param values Receives the values of all properties, those of each property following those of the previous property
+  \return True if ok
+  \sa GetSinglePhasePropertySizes(), PropertyPackWorkspace::LastError(), Phase, SinglePhaseProperty
+*/
+
+bool PropertyPack::GetSinglePhaseProperties(PropertyPackWorkspace &ws,int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values) const {return pp->GetSinglePhaseProperties(*ws.ws,nComp,compIndices,phaseID,T,P,X,nProp,propIDs,valueCapacity,valueCount,values);}
+
+//! Get two-phase mixture properties into caller-supplied buffers
+/*!
+  As GetTwoPhaseProperties() with workspace argument, but the values are written into 
+  buffers of the caller. Can be called from multiple threads at the same time, if each 
+  thread uses its own workspace and its own buffers.
+  \param ws Workspace that receives the error
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param phaseID1 ID of the first phase for which to calculate the property
+  \param phaseID2 ID of the second phase for which to calculate the property
+  \param T1 Temperature of phase 1[K]
+  \param T2 Temperature of phase 2[K]
+  \param P1 Pressure of phase 1 [Pa]
+  \param P2 Pressure of phase 2 [Pa]
+  \param X1 Mole fractions for phase 1 [mol/mol], one value for each compound, assumed normalized
+  \param X2 Mole fractions for phase 2 [mol/mol], one value for each compound, assumed normalized
+  \param nProp Number of properties requested
+  \param propIDs IDs of the properties requested
+  \param valueCapacity Number of values that fit in values
+  \param valueCount Receives the number of values for each of the properties, one value for each property
+  \param values Receives the values of all properties, those of each property following those of the previous property
+  \return True if ok
+  \sa GetTwoPhasePropertySizes(), PropertyPackWorkspace::LastError(), Phase, TwoPhaseProperty
+*/
+
+bool PropertyPack::GetTwoPhaseProperties(PropertyPackWorkspace &ws,int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2,int nProp,TwoPhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values) const {return pp->GetTwoPhaseProperties(*ws.ws,nComp,compIndices,phaseID1,phaseID2,T1,T2,P1,P2,X1,X2,nProp,propIDs,valueCapacity,valueCount,values);}
+
+//! Calculate phase equilibrium into caller-supplied buffers
+/*!
+  As Flash() with workspace argument, but the results are written into buffers of the 
+  caller. Can be called from multiple threads at the same time, if each thread uses its 
+  own workspace and its own buffers.
+  \param ws Workspace that receives the error
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param X Overall mole fractions[mol/mol], one value for each compound, assumed normalized
+  \param type Type of specifications passed (e.g. TP for a temperature and pressure specification)
+  \param phaseType Specified allowed phases in flash. 
+  \param spec1 Value of first specification (e.g. T/[K] for TP)
+  \param spec2 Value of second specification (e.g. P/[Pa] for TP)
+  \param phaseCount Receives the number of phases at equilibrium
+  \param phases Receives the types of the existing phases (Vapor or Liquid); room for PhaseCount values
+  \param phaseFractions Receives the phase fractions of the existing phases [mol/mol]; room for PhaseCount values
+  \param phaseCompositions Receives the compositions of the existing phases [mol/mol]; room for PhaseCount*nComp values, the composition of phase j starts at phaseCompositions[j*nComp]
+  \param T Receives the temperature at equilibrium
+  \param P Receives the pressure at equilibrium
+  \return True if ok
+  \sa GetFlashResultSizes(), PropertyPackWorkspace::LastError(), Phase, FlashType
+*/
+
+bool PropertyPack::Flash(PropertyPackWorkspace &ws,int nComp,const int *compIndices,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *phases,double *phaseFractions,double *phaseCompositions,double &T, double &P) const {return pp->Flash(*ws.ws,nComp,compIndices,X,type,phaseType,spec1,spec2,phaseCount,phases,phaseFractions,phaseCompositions,T,P);}
+
+//! Get single-phase mixture properties of a prepared mixture into caller-supplied buffers
+/*!
+  As GetSinglePhaseProperties() with caller-supplied buffers and compound indices, for a 
+  mixture prepared by PrepareMixture()
+  \param ws Workspace that receives the error
+  \param mixture Mixture prepared for this property package
+  \param phaseID ID of the phase for which to calculate the properties
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions [mol/mol], one value for each compound of the mixture, assumed normalized
+  \param nProp Number of properties requested
+  \param propIDs IDs of the properties requested
+  \param valueCapacity Number of values that fit in values
+  \param valueCount Receives the number of values for each of the properties, one value for each property
+  \param values Receives the values of all properties, those of each property following those of the previous property
+  \return True if ok
+  \sa PrepareMixture(), GetSinglePhasePropertySizes(), PropertyPackWorkspace::LastError()
+*/
+
+bool PropertyPack::GetSinglePhaseProperties(PropertyPackWorkspace &ws,const PropertyPackMixture &mixture,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values) const {return pp->GetSinglePhaseProperties(*ws.ws,*mixture.mixture,phaseID,T,P,X,nProp,propIDs,valueCapacity,valueCount,values);}
+
+//! Calculate phase equilibrium of a prepared mixture into caller-supplied buffers
+/*!
+  As Flash() with caller-supplied buffers and compound indices, for a mixture prepared 
+  by PrepareMixture()
+  \param ws Workspace that receives the error
+  \param mixture Mixture prepared for this property package
+  \param X Overall mole fractions[mol/mol], one value for each compound of the mixture, assumed normalized
+  \param type Type of specifications passed (e.g. TP for a temperature and pressure specification)
+  \param phaseType Specified allowed phases in flash. 
+  \param spec1 Value of first specification (e.g. T/[K] for TP)
+  \param spec2 Value of second specification (e.g. P/[Pa] for TP)
+  \param phaseCount Receives the number of phases at equilibrium
+  \param phases Receives the types of the existing phases (Vapor or Liquid); room for PhaseCount values
+  \param phaseFractions Receives the phase fractions of the existing phases [mol/mol]; room for PhaseCount values
+  \param phaseCompositions Receives the compositions of the existing phases [mol/mol]; room for PhaseCount*nComp values, the composition of phase j starts at phaseCompositions[j*nComp]
+  \param T Receives the temperature at equilibrium
+  \param P Receives the pressure at equilibrium
+  \return True if ok
+  \sa PrepareMixture(), GetFlashResultSizes(), PropertyPackWorkspace::LastError()
+*/
+
+bool PropertyPack::Flash(PropertyPackWorkspace &ws,const PropertyPackMixture &mixture,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *phases,double *phaseFractions,double *phaseCompositions,double &T, double &P) const {return pp->Flash(*ws.ws,*mixture.mixture,X,type,phaseType,spec1,spec2,phaseCount,phases,phaseFractions,phaseCompositions,T,P);}
+
+//! Get a single-phase composition-derivative matrix in structured form
+/*!
+  Get a matrix-valued single-phase property as a diagonal, diagonal plus rank-one 
+  or zero matrix, without forming the dense matrix
+  \param ws Workspace that receives the matrix values and the error
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param phaseID ID of the phase for which to calculate the property
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions [mol/mol], one value for each compound, assumed normalized
+  \param propID ID of the property, a matrix-valued property
+  \param matrix Receives the matrix; its vectors are valid until the next calculation on ws
+  \return True if ok
+  \sa StructuredMatrix, GetSinglePhaseProperties(), PropertyPackWorkspace::LastError()
+*/
+
+bool PropertyPack::GetSinglePhaseMatrix(PropertyPackWorkspace &ws,int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X,SinglePhaseProperty propID,StructuredMatrix &matrix) const {return pp->GetSinglePhaseMatrix(*ws.ws,nComp,compIndices,phaseID,T,P,X,propID,matrix);}
+
+//! Get a single-phase composition-derivative matrix of a prepared mixture in structured form
+/*!
+  As GetSinglePhaseMatrix() with compound indices, for a mixture prepared by PrepareMixture()
+  \param ws Workspace that receives the matrix values and the error
+  \param mixture Mixture prepared for this property package
+  \param phaseID ID of the phase for which to calculate the property
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions [mol/mol], one value for each compound of the mixture, assumed normalized
+  \param propID ID of the property, a matrix-valued property
+  \param matrix Receives the matrix; its vectors are valid until the next calculation on ws
+  \return True if ok
+  \sa PrepareMixture(), StructuredMatrix, PropertyPackWorkspace::LastError()
+*/
+
+bool PropertyPack::GetSinglePhaseMatrix(PropertyPackWorkspace &ws,const PropertyPackMixture &mixture,Phase phaseID,double T,double P,const double *X,SinglePhaseProperty propID,StructuredMatrix &matrix) const {return pp->GetSinglePhaseMatrix(*ws.ws,*mixture.mixture,phaseID,T,P,X,propID,matrix);}
+
+//! Get a two-phase composition-derivative matrix in structured form
+/*!
+  Get a matrix-valued two-phase property without forming the dense matrix
+  \param ws Workspace that receives the matrix values and the error
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param phaseID1 ID of the first phase for which to calculate the property
+  \param phaseID2 ID of the second phase for which to calculate the property
+  \param T1 Temperature of phase 1[K]
+  \param T2 Temperature of phase 2[K]
+  \param P1 Pressure of phase 1 [Pa]
+  \param P2 Pressure of phase 2 [Pa]
+  \param X1 Mole fractions for phase 1 [mol/mol], one value for each compound, assumed normalized
+  \param X2 Mole fractions for phase 2 [mol/mol], one value for each compound, assumed normalized
+  \param propID ID of the property, a matrix-valued property
+  \param matrix Receives the matrix
+  \return True if ok
+  \sa StructuredMatrix, GetTwoPhaseProperties(), PropertyPackWorkspace::LastError()
+*/
+
+bool PropertyPack::GetTwoPhaseMatrix(PropertyPackWorkspace &ws,int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2,TwoPhaseProperty propID,StructuredMatrix &matrix) const {return pp->GetTwoPhaseMatrix(*ws.ws,nComp,compIndices,phaseID1,phaseID2,T1,T2,P1,P2,X1,X2,propID,matrix);}
+
 //! Edit the property package
 /*!
   Edit the property package
@@ -262,19 +889,205 @@ bool PropertyPack::Flash(int nComp,const int *compIndices,const double *X,FlashT
 
 bool PropertyPack::Edit() {return pp->Edit();}
 
+//! Constructor
+/*!
+  Constructor, creates a FlashBatch class and its worker threads
+  \param pack Property package on which the flashes are performed; must remain valid during the life time of this object
+  \param threadCount Number of threads, including the calling thread. If zero or negative, the number of processors is used
+  \sa FlashBatch
+*/
+
+PropertyPackBatch::PropertyPackBatch(PropertyPack &pack,int threadCount)
+ {batch=new FlashBatch(pack.pp,threadCount);
+ }
+
+//! Destructor
+/*!
+  Destructor, cleans up
+  \sa FlashBatch
+*/
+
+PropertyPackBatch::~PropertyPackBatch()
+ {delete batch;
+ }
+
+//! Number of threads
+/*!
+  \return The number of threads that perform the flashes, including the calling thread
+*/
+
+int PropertyPackBatch::ThreadCount() {return batch->ThreadCount();}
+
+//! Return the last error
+/*!
+  Returns the error message of the last call to Flash() that failed as a whole
+*/
+
+const char *PropertyPackBatch::LastError() {return batch->LastError();}
+
+//! Perform a batch of flash calculations
+/*!
+  Perform itemCount independent flash calculations, distributed over the worker threads.
+  Output arrays are provided by the caller. Failure of individual items does not cause 
+  the batch to fail; their status is set to BatchItemFailed.
+
+  \param itemCount Number of flashes
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param X Overall mole fractions[mol/mol]; nComp values for each item, item i starts at X[i*nComp]
+  \param types Flash type for each item
+  \param phaseType Specified allowed phases in flash, for all items
+  \param spec1 Value of first specification for each item (e.g. T/[K] for TP)
+  \param spec2 Value of second specification for each item (e.g. P/[Pa] for TP)
+  \param phaseCounts Receives the number of phases at equilibrium for each item
+  \param phases Receives the types of the existing phases; PhaseCount values for each item
+  \param phaseFractions Receives the phase fractions of the existing phases [mol/mol]; PhaseCount values for each item
+  \param phaseCompositions Receives the compositions of the existing phases [mol/mol]; PhaseCount*nComp values for each item
+  \param T Receives the temperature at equilibrium for each item
+  \param P Receives the pressure at equilibrium for each item
+  \param status Receives the status for each item
+  \return True if the batch was calculated, false in case of invalid arguments
+  \sa FlashBatch::Flash()
+*/
+
+bool PropertyPackBatch::Flash(int itemCount,int nComp,const int *compIndices,const double *X,const FlashType *types,FlashPhaseType phaseType,const double *spec1,const double *spec2,int *phaseCounts,Phase *phases,double *phaseFractions,double *phaseCompositions,double *T,double *P,BatchItemStatus *status) {return batch->Flash(itemCount,nComp,compIndices,X,types,phaseType,spec1,spec2,phaseCounts,phases,phaseFractions,phaseCompositions,T,P,status);}
+
+//! Number of failed items
+/*!
+  \return The number of items that failed in the last call to Flash()
+*/
+
+int PropertyPackBatch::FailureCount() {return batch->FailureCount();}
+
+//! Error of a failed item
+/*!
+  \param index Index of the item
+  \return The error message, or NULL if the item did not fail in the last call to Flash()
+*/
+
+const char *PropertyPackBatch::ItemError(int index) {return batch->ItemError(index);}
+
 //! Edit routine for collection of Property Packages
 /*!
   Show the edit dialog for the Property Packages available
-  on this system (for the current user). 
+  on this system (for the current user). Does nothing on
+  platforms other than Windows.
   
   \sa ThermoSystemEditor
   
 */
 
 void IMPORTEXPORT EditThermoSystem()
-{ThermoSystemEditor editor;
+{
+#ifdef _WIN32
+ ThermoSystemEditor editor;
  editor.Edit();
+#endif
 }
 
+//! Set the compound data path
+/*!
+  Override the folder from which compounds are loaded. Must be
+  called before any property package is loaded. By default, compounds
+  are loaded from the data sub folder of the folder that contains 
+  IdealThermoModule. The compound database of the folder, if any, is
+  opened again upon next use, and compounds are loaded again rather than
+  shared with property packages that were loaded before.
+  \param path Folder that contains the compound libraries and .compound files
+  \sa ::GetDataPath(), CompileCompoundDatabase()
+*/
 
+void IMPORTEXPORT SetCompoundDataPath(const char *path)
+{SetDataPath(path);
+ CompoundDatabase::Reset();
+ CompoundRegistry::Reset();
+}
 
+//! Set the number of threads that load compounds
+/*!
+  Compounds of a property package that are stored in .compound files are
+  loaded concurrently, which mostly helps for data folders on network storage.
+  Must not be called while a property package is being loaded.
+  \param threadCount Largest number of threads, including the calling thread; 1 loads
+  sequentially, zero or negative restores the default (8)
+  \sa Compound::SetLoadThreads()
+*/
+
+void IMPORTEXPORT SetCompoundLoadThreads(int threadCount)
+{Compound::SetLoadThreads(threadCount);
+}
+
+//! Get the number of shared compounds
+/*!
+  Property packages share the data of the compounds they have in common; each
+  compound is loaded once, while in use by any property package.
+  \return The number of distinct compounds in use by all property packages
+  \sa CompoundRegistry
+*/
+
+int IMPORTEXPORT GetSharedCompoundCount()
+{return CompoundRegistry::Count();
+}
+
+//! Compile a compound database
+/*!
+  Pack all compound libraries and .compound files of a folder into a compound database image, from
+  which compounds are then loaded without parsing. Property packages use the
+  image if it is stored as compounds.compounddb in the compound data folder.
+  \param folder Folder that contains the compound libraries and .compound files, or NULL for the compound data folder
+  \param fileName Path of the image, or NULL for compounds.compounddb in folder
+  \param compoundCount Receives the number of compounds, if not NULL
+  \param error Receives the error message in case of failure, truncated to errorSize characters including the terminating zero; may be NULL
+  \param errorSize Size of error
+  \return True for success, false for error
+  \sa CompoundDatabase::Compile(), SetCompoundDataPath()
+*/
+
+bool IMPORTEXPORT CompileCompoundDatabase(const char *folder,const char *fileName,int *compoundCount,char *error,int errorSize)
+{string folderName,path,lastError;
+ int count;
+ bool res;
+ folderName=(folder)?folder:GetDataPath();
+ if (fileName) path=fileName;
+ else
+  {path=folderName;
+   path+=PATH_SEPARATOR;
+   path+=COMPOUND_DATABASE_FILE;
+  }
+ res=CompoundDatabase::Compile(folderName.c_str(),path.c_str(),count,lastError);
+ if (compoundCount) *compoundCount=(res)?count:0;
+ if ((error)&&(errorSize>0))
+  {strncpy(error,lastError.c_str(),errorSize-1);
+   error[errorSize-1]=0;
+  }
+ return res;
+}
+
+//! Select the correlation kernels
+/*!
+  Select the instruction set that is used to evaluate the correlations
+  for all compounds of a mixture at once. By default, the best instruction
+  set supported by the processor is used. Must not be called while 
+  calculations are running.
+  \param name Instruction set: "scalar", "avx2" or "avx512"
+  \return False if the instruction set is not known or not supported
+  \sa GetCorrelationKernels(), CorrelationTable::SetKernels()
+*/
+
+bool IMPORTEXPORT SetCorrelationKernels(const char *name)
+{int i;
+ for (i=ScalarKernels;i<=AVX512Kernels;i++)
+  if (strcmp(name,CorrelationTable::KernelsName((CorrelationKernels)i))==0)
+   return CorrelationTable::SetKernels((CorrelationKernels)i);
+ return false;
+}
+
+//! Get the correlation kernels
+/*!
+  \return Name of the instruction set that is used to evaluate the correlations
+  \sa SetCorrelationKernels()
+*/
+
+IMPORTEXPORT const char *GetCorrelationKernels()
+{return CorrelationTable::KernelsName(CorrelationTable::Kernels());
+}
@@ -1,10 +1,14 @@
 #pragma once
 #include "Properties.h"
 #include "ImportExport.h"
+#include "StructuredMatrix.h"
 
 //forward declarations
 class PropertyPackageEnumerator;
 class PropertyPackage;
+class PropertyWorkspace;
+class PreparedMixture;
+class FlashBatch;
 
 //! PropertyPackEnumerator class
 /*!
@@ -27,6 +31,62 @@ class IMPORTEXPORT PropertyPackEnumerator
 };
 
 
+//! PropertyPackWorkspace class
+/*!
+  This is a wrapper class that exposes the PropertyWorkspace in a
+  manner that is ok to expose from the DLL. Each thread that performs
+  calculations on a shared PropertyPack should use its own 
+  PropertyPackWorkspace.
+  
+  \sa PropertyWorkspace, PropertyPack
+  
+*/
+
+class IMPORTEXPORT PropertyPackWorkspace
+{//a wrapper version of PropertyWorkspace with exported class definition
+ private:
+ PropertyWorkspace *ws; /*!< the actual workspace */
+ friend class PropertyPack;
+ public:
+ PropertyPackWorkspace();
+ ~PropertyPackWorkspace();
+ const char *LastError();
+ int SolverEvaluations();
+ void SetCacheSize(int size);
+ long CacheHits();
+ long CacheMisses();
+ void SetFlashHistorySize(int size);
+ long FlashHistoryHits();
+ long FlashHistoryMisses();
+ long FlashHistoryFallbacks();
+};
+
+
+//! PropertyPackMixture class
+/*!
+  This is a wrapper class that exposes the PreparedMixture in a
+  manner that is ok to expose from the DLL. A mixture is prepared
+  once by PropertyPack::PrepareMixture, after which calculations on
+  it skip the checks and mapping of the compound indices.
+  
+  \sa PreparedMixture, PropertyPack
+  
+*/
+
+class IMPORTEXPORT PropertyPackMixture
+{//a wrapper version of PreparedMixture with exported class definition
+ private:
+ PreparedMixture *mixture; /*!< the actual prepared mixture */
+ friend class PropertyPack;
+ PropertyPackMixture(const PropertyPackMixture &); //no copies
+ PropertyPackMixture &operator=(const PropertyPackMixture &);
+ public:
+ PropertyPackMixture();
+ ~PropertyPackMixture();
+ int CompoundCount();
+};
+
+
 //! PropertyPack class
 /*!
   This is a wrapper class that access the PropertyPackage in a
@@ -41,6 +101,7 @@ class IMPORTEXPORT PropertyPack
 {//a wrapper version of PropertyPackage with exported class definition
  private:
  PropertyPackage *pp; /*!< the actual property package */
+ friend class PropertyPackBatch;
  public:
  PropertyPack();
  ~PropertyPack();
@@ -48,16 +109,76 @@ class IMPORTEXPORT PropertyPack
  bool Load(const char *pathName);
  bool Save(const char *pathName);
  bool LoadFromPPFile(const char *ppName);
+ bool SetLazyLoading(bool lazy);
+ void GetLoadCounters(int &compoundCount,int &deferred,int &loaded) const;
+ bool SetTabulation(double maxRelError);
+ const char *GetTabulationReport();
  bool GetCompoundCount(int *compoundCount);
  const char *GetCompoundStringConstant(int compIndex,StringConstant constID);
+ bool GetCompoundIndex(const char *compName,int &compIndex);
  bool GetCompoundRealConstant(int compIndex,RealConstant constID,double &value);
  bool GetTemperatureDependentProperty(int compIndex,TDependentProperty propID,double T,double &value);
  bool GetSinglePhaseProperties(int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int *&valueCount,double **&values);
  bool GetTwoPhaseProperties(int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2,int nProp,TwoPhaseProperty *propIDs,int *&valueCount,double **&values);
  bool Flash(int nComp,const int *compIndices,const double *X,FlashType type,double spec1,double spec2,int &phaseCount,Phase *&phases,double *&phaseFractions,double **&phaseCompositions,double &T, double &P);
  bool Flash(int nComp,const int *compIndices,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *&phases,double *&phaseFractions,double **&phaseCompositions,double &T, double &P);
+ //thread-safe versions, results and errors are stored in the workspace
+ bool GetTemperatureDependentProperty(PropertyPackWorkspace &ws,int compIndex,TDependentProperty propID,double T,double &value) const;
+ bool GetSinglePhaseProperties(PropertyPackWorkspace &ws,int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int *&valueCount,double **&values) const;
+ bool GetTwoPhaseProperties(PropertyPackWorkspace &ws,int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2,int nProp,TwoPhaseProperty *propIDs,int *&valueCount,double **&values) const;
+ bool Flash(PropertyPackWorkspace &ws,int nComp,const int *compIndices,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *&phases,double *&phaseFractions,double **&phaseCompositions,double &T, double &P) const;
+ //prepared mixtures, thread-safe
+ bool PrepareMixture(PropertyPackWorkspace &ws,int nComp,const int *compIndices,PropertyPackMixture &mixture) const;
+ bool GetSinglePhaseProperties(PropertyPackWorkspace &ws,const PropertyPackMixture &mixture,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int *&valueCount,double **&values) const;
+ bool Flash(PropertyPackWorkspace &ws,const PropertyPackMixture &mixture,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *&phases,double *&phaseFractions,double **&phaseCompositions,double &T, double &P) const;
+ //results in caller-supplied buffers
+ static bool GetSinglePhasePropertySizes(int nComp,int nProp,const SinglePhaseProperty *propIDs,int *valueCount,int &totalCount);
+ static bool GetTwoPhasePropertySizes(int nComp,int nProp,const TwoPhaseProperty *propIDs,int *valueCount,int &totalCount);
+ static void GetFlashResultSizes(int nComp,int &phaseCapacity,int &compositionCapacity);
+ bool GetSinglePhaseProperties(int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values);
+ bool GetTwoPhaseProperties(int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2,int nProp,TwoPhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values);
+ bool Flash(int nComp,const int *compIndices,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *phases,double *phaseFractions,double *phaseCompositions,double &T, double &P);
+ bool GetSinglePhaseProperties(PropertyPackWorkspace &ws,int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values) const;
+ bool GetTwoPhaseProperties(PropertyPackWorkspace &ws,int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2,int nProp,TwoPhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values) const;
+ bool Flash(PropertyPackWorkspace &ws,int nComp,const int *compIndices,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *phases,double *phaseFractions,double *phaseCompositions,double &T, double &P) const;
+ bool GetSinglePhaseProperties(PropertyPackWorkspace &ws,const PropertyPackMixture &mixture,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values) const;
+ bool Flash(PropertyPackWorkspace &ws,const PropertyPackMixture &mixture,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *phases,double *phaseFractions,double *phaseCompositions,double &T, double &P) const;
+ //composition-derivative matrices in structured form
+ bool GetSinglePhaseMatrix(PropertyPackWorkspace &ws,int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X,SinglePhaseProperty propID,StructuredMatrix &matrix) const;
+ bool GetSinglePhaseMatrix(PropertyPackWorkspace &ws,const PropertyPackMixture &mixture,Phase phaseID,double T,double P,const double *X,SinglePhaseProperty propID,StructuredMatrix &matrix) const;
+ bool GetTwoPhaseMatrix(PropertyPackWorkspace &ws,int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2,TwoPhaseProperty propID,StructuredMatrix &matrix) const;
  bool Edit();
 };
 
+//! PropertyPackBatch class
+/*!
+  This is a wrapper class that exposes the FlashBatch in a manner that is 
+  ok to expose from the DLL. External C++ clients can use this class to 
+  perform many flashes on a PropertyPack using multiple threads.
+  
+  \sa FlashBatch, PropertyPack
+  
+*/
+
+class IMPORTEXPORT PropertyPackBatch
+{//a wrapper version of FlashBatch with exported class definition
+ private:
+ FlashBatch *batch; /*!< the actual flash batch */
+ public:
+ PropertyPackBatch(PropertyPack &pack,int threadCount=0);
+ ~PropertyPackBatch();
+ int ThreadCount();
+ const char *LastError();
+ bool Flash(int itemCount,int nComp,const int *compIndices,const double *X,const FlashType *types,FlashPhaseType phaseType,const double *spec1,const double *spec2,int *phaseCounts,Phase *phases,double *phaseFractions,double *phaseCompositions,double *T,double *P,BatchItemStatus *status);
+ int FailureCount();
+ const char *ItemError(int index);
+};
+
 void IMPORTEXPORT EditThermoSystem();
+void IMPORTEXPORT SetCompoundDataPath(const char *path);
+void IMPORTEXPORT SetCompoundLoadThreads(int threadCount);
+int IMPORTEXPORT GetSharedCompoundCount();
+bool IMPORTEXPORT CompileCompoundDatabase(const char *folder,const char *fileName,int *compoundCount,char *error,int errorSize);
+bool IMPORTEXPORT SetCorrelationKernels(const char *name);
+IMPORTEXPORT const char *GetCorrelationKernels();
 
@@ -1,13 +1,311 @@
-#include "StdAfx.h"
+#include "stdafx.h"
 #include "Compound.h"
 #include "IdealThermoModule.h"
+#include "CompoundDatabase.h"
+#include "CompoundLibrary.h"
+#include "LineReader.h"
+#include <algorithm>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
 
-//! Load the Compound from a configuration file
+//! Default largest number of threads that load .compound files, including the calling thread
+#define COMPOUND_LOAD_THREADS 8
+
+//! Smallest number of .compound files per loading thread
+#define COMPOUND_LOAD_FILES_PER_THREAD 8
+
+static int compoundLoadThreads=COMPOUND_LOAD_THREADS; /*!< largest number of threads that load .compound files, as set by Compound::SetLoadThreads() */
+
+//! CompoundFileLoad class
+/*!
+	Loads the .compound files of a set of compounds on a number of threads.
+	Opening a file costs little processor time but may take milliseconds on
+	network storage, so the files are loaded concurrently. The threads take
+	the files in order from a shared counter; the error of each file is kept,
+	so that the error of the first failing file in order is reported, as for
+	a sequential load. Files after a failed file are not started.
+	\sa Compound::LoadCompounds()
+*/
+
+class CompoundFileLoad
+{public:
+
+	const string *names; /*!< names of all compounds */
+	Compound **compounds; /*!< all compounds */
+	vector<int> items; /*!< indices of the compounds to load, in order */
+	vector<string> errors; /*!< error of each item */
+	string dataPath; /*!< the data folder */
+	int next; /*!< next item to load */
+	int firstFailure; /*!< first item that failed, or items.size() */
+	bool deferCorrelations; /*!< skip the correlation lines, see Compound::Read() */
+#ifdef _WIN32
+	CRITICAL_SECTION mutex; /*!< protects next and firstFailure */
+#else
+	pthread_mutex_t mutex; /*!< protects next and firstFailure */
+#endif
+
+	//! Constructor
+	CompoundFileLoad()
+	{next=firstFailure=0;
+	 deferCorrelations=false;
+#ifdef _WIN32
+	 InitializeCriticalSection(&mutex);
+#else
+	 pthread_mutex_init(&mutex,NULL);
+#endif
+	}
+
+	//! Destructor
+	~CompoundFileLoad()
+	{
+#ifdef _WIN32
+	 DeleteCriticalSection(&mutex);
+#else
+	 pthread_mutex_destroy(&mutex);
+#endif
+	}
+
+	//! Lock the counter
+	void Lock()
+	{
+#ifdef _WIN32
+	 EnterCriticalSection(&mutex);
+#else
+	 pthread_mutex_lock(&mutex);
+#endif
+	}
+
+	//! Unlock the counter
+	void Unlock()
+	{
+#ifdef _WIN32
+	 LeaveCriticalSection(&mutex);
+#else
+	 pthread_mutex_unlock(&mutex);
+#endif
+	}
+
+	//! Load items until none are left
+	void Work()
+	{int item;
+	 string path;
+	 for (;;)
+	  {Lock();
+	   item=(next<firstFailure)?next++:-1;
+	   Unlock();
+	   if (item<0) break;
+	   Compound *c=compounds[items[item]];
+	   const string &name=names[items[item]];
+	   path=dataPath;
+	   path+=PATH_SEPARATOR;
+	   path+=name;
+	   path+=".compound";
+	   if (!c->LoadFile(path.c_str(),name.c_str(),errors[item],deferCorrelations))
+	    {Lock();
+	     if (item<firstFailure) firstFailure=item;
+	     Unlock();
+	    }
+	  }
+	}
+
+	//! Loading thread
+	/*!
+	  \param param The CompoundFileLoad
+	*/
+
+#ifdef _WIN32
+	static DWORD WINAPI ThreadProc(LPVOID param)
+#else
+	static void *ThreadProc(void *param)
+#endif
+	{((CompoundFileLoad *)param)->Work();
+	 return 0;
+	}
+
+	//! Load all items
+	/*!
+	  \param threadCount Largest number of threads, including the calling thread
+	  \param error Error message of the first item that failed
+	  \return True for success, false for error
+	*/
+
+	bool Run(int threadCount,string &error)
+	{int i;
+	 if (threadCount>(int)items.size()/COMPOUND_LOAD_FILES_PER_THREAD) threadCount=(int)items.size()/COMPOUND_LOAD_FILES_PER_THREAD;
+	 errors.resize(items.size());
+	 next=0;
+	 firstFailure=(int)items.size();
+#ifdef _WIN32
+	 vector<HANDLE> threads;
+	 for (i=1;i<threadCount;i++)
+	  {HANDLE thread=::CreateThread(NULL,0,ThreadProc,this,0,NULL);
+	   if (!thread) break; //continue with the threads we have
+	   threads.push_back(thread);
+	  }
+	 Work();
+	 for (i=0;i<(int)threads.size();i++)
+	  {WaitForSingleObject(threads[i],INFINITE);
+	   CloseHandle(threads[i]);
+	  }
+#else
+	 vector<pthread_t> threads;
+	 for (i=1;i<threadCount;i++)
+	  {pthread_t thread;
+	   if (pthread_create(&thread,NULL,ThreadProc,this)!=0) break; //continue with the threads we have
+	   threads.push_back(thread);
+	  }
+	 Work();
+	 for (i=0;i<(int)threads.size();i++) pthread_join(threads[i],NULL);
+#endif
+	 if (firstFailure<(int)items.size())
+	  {error=errors[firstFailure];
+	   return false;
+	  }
+	 return true;
+	}
+
+};
+
+//! Key of a compound name
+/*!
+  Compound names are case insensitive, as compared by lstrcmpi
+  \param name The compound name
+  \return The name in lower case
+  \sa PropertyPackage::GetCompoundIndex()
+*/
+
+string Compound::NameKey(const char *name)
+{string key(name);
+ for (size_t i=0;i<key.size();i++) key[i]=(char)tolower((unsigned char)key[i]);
+ return key;
+}
+
+//! Load the Compound
 /*!
   The compound configuration files are stored in 
   the data folder contained by the folder that 
-  contains the DLL.
-  
+  contains the DLL. The compound is loaded from the first of
+  the compound database (see CompoundDatabase), the compound 
+  libraries (see CompoundLibrary) and the .compound file that 
+  contains it.
+  \param compName Name of the compound to load (e.g. "hexane")
+  \param error Error message in case of failure
+  \return True for success, false for error
+  \sa ::GetDataPath(), LoadCompounds()
+*/
+
+bool Compound::Load(const char *compName,string &error)
+{unordered_map<string,int> indices;
+ string name(compName);
+ Compound *compound=this;
+ if (!this->name.empty()) 
+  {error="Compounds can only be loaded once";
+   return false;
+  }
+ indices[NameKey(compName)]=0;
+ return LoadCompounds(1,&name,&compound,indices,error);
+}
+
+//! Load a set of compounds
+/*!
+  Load compounds from the data folder: first from the compound database, then 
+  from the compound libraries, in alphabetical order of their file names, in a 
+  single pass over each library, and then from the .compound files of the 
+  remaining compounds. The .compound files are loaded concurrently, see
+  SetLoadThreads(); the error is that of the first compound in order that
+  fails, as for a sequential load.
+  \param count Number of compounds
+  \param names Names of the compounds
+  \param compounds The compounds to load, which must not have been loaded yet
+  \param indices Index in names of each compound, by NameKey() of its name
+  \param error Error message in case of failure
+  \param deferCorrelations If set, the correlations of compounds that are read from
+  libraries and .compound files are not parsed, see Read(); compounds from the
+  compound database are always loaded completely
+  \return True for success, false for error
+  \sa Load(), CompoundDatabase::Default(), CompoundLibrary::Load(), LoadFile(), CompoundFileLoad
+*/
+
+bool Compound::LoadCompounds(int count,const string *names,Compound **compounds,const unordered_map<string,int> &indices,string &error,bool deferCorrelations)
+{shared_ptr<const CompoundDatabase> database=CompoundDatabase::Default();
+ vector<string> libraries;
+ string dataPath,path;
+ int i,remaining=0;
+ for (i=0;i<count;i++)
+  {const CompoundRecord *record=(database)?database->Find(names[i].c_str()):NULL;
+   if (record)
+    {if (!compounds[i]->Load(*database,*record,error)) return false;
+    }
+   else remaining++;
+  }
+ if (!remaining) return true;
+ dataPath=GetDataPath();
+ ListFiles(dataPath.c_str(),COMPOUND_LIBRARY_EXTENSION,libraries);
+ sort(libraries.begin(),libraries.end());
+ for (i=0;(i<(int)libraries.size())&&(remaining);i++)
+  {path=dataPath;
+   path+=PATH_SEPARATOR;
+   path+=libraries[i];
+   path+=".";
+   path+=COMPOUND_LIBRARY_EXTENSION;
+   if (!CompoundLibrary::Load(path.c_str(),indices,compounds,remaining,error,deferCorrelations)) return false;
+  }
+ if (!remaining) return true;
+ CompoundFileLoad load;
+ load.names=names;
+ load.compounds=compounds;
+ load.dataPath=dataPath;
+ load.deferCorrelations=deferCorrelations;
+ for (i=0;i<count;i++)
+  if (compounds[i]->name.empty()) load.items.push_back(i);
+ return load.Run(compoundLoadThreads,error);
+}
+
+//! Set the number of threads that load .compound files
+/*!
+  Must not be called while compounds are being loaded
+  \param threadCount Largest number of threads, including the calling thread; 1 loads
+  sequentially, zero or negative restores the default of COMPOUND_LOAD_THREADS
+  \sa LoadCompounds()
+*/
+
+void Compound::SetLoadThreads(int threadCount)
+{compoundLoadThreads=(threadCount>0)?threadCount:COMPOUND_LOAD_THREADS;
+}
+
+//! Load the Compound from a compound database
+/*!
+  Copy the data of a compound from its record; no parsing is involved
+  \param database The compound database
+  \param record Record of the compound in the database
+  \param error Error message in case of failure
+  \return True for success, false for error
+  \sa CompoundDatabase::Find()
+*/
+
+bool Compound::Load(const CompoundDatabase &database,const CompoundRecord &record,string &error)
+{if (!name.empty()) 
+  {error="Compounds can only be loaded once";
+   return false;
+  }
+ name=database.String(record.name);
+ formula=database.String(record.formula);
+ CAS=database.String(record.CAS);
+ MW=record.MW;
+ NBP=record.NBP;
+ TC=record.TC;
+ PC=record.PC;
+ VC=record.VC;
+ CpCorrelation=new Correlation(record.Cp[0],record.Cp[1],record.Cp[2],record.Cp[3],record.Cp[4]);
+ HvapCorrelation=new Correlation(record.Hvap[0],record.Hvap[1],record.Hvap[2],record.Hvap[3],record.Hvap[4]);
+ liqDensCorrelation=new Correlation(record.liqDens[0],record.liqDens[1],record.liqDens[2],record.liqDens[3],record.liqDens[4]);
+ pSatCorrelation=new Antoine(record.antoine[0],record.antoine[1],record.antoine[2]);
+ return true;
+}
+
+//! Load the Compound from a configuration file
+/*!
   Compounds are stored in .compound files, each line contains one data item in the following order:
   
   Name: compound name 
@@ -34,24 +332,23 @@
 
   ANTA, ANTB, ANTC: coefficients of the Antoine correlation [Pa]
   
-  \param compName Name of the file of the compound to load (e.g. "hexane")
+  Empty lines and lines that start with # are skipped.
+  \param path Path of the .compound file
+  \param compName Name of the compound to load (e.g. "hexane"), which must match the name in the file
   \param error Error message in case of failure
+  \param deferCorrelations If set, the correlation lines are skipped, see Read()
   \return True for success, false for error
-  \sa ::GetDataPath(), Correlation, Antoine
+  \sa Load(), Read(), Correlation, Antoine
 */
 
-bool Compound::Load(const char *compName,string &error)
-{string path;
- path=GetDataPath();
- path+="\\";
- path+=compName;
- path+=".compound";
- FILE *fin;
+bool Compound::LoadFile(const char *path,const char *compName,string &error,bool deferCorrelations)
+{LineReader reader;
+ const char *line;
  if (!name.empty()) 
   {error="Compounds can only be loaded once";
    return false;
   }
- int errCode=fopen_s(&fin,path.c_str(),"rb");
+ int errCode=reader.Open(path);
  if (errCode)
   {error="Failed to open \"";
    error+=path;
@@ -59,107 +356,161 @@ bool Compound::Load(const char *compName,string &error)
    error+=ErrorString(errCode);
    return false;
   }
- //read content
- string line;
- if (!ReadLine(fin,line))
-  {eof:
-   error="Failed to read compound from \"";
+ line=reader.Next();
+ if (!line)
+  {error="Failed to read compound from \"";
    error+=path;
    error+="\": unexpected end of file";
-   fclose(fin);
    return false;
   }
- if (lstrcmpi(compName,line.c_str())!=0)
+ if (lstrcmpi(compName,line)!=0)
   {//compound name must match file name (we depend on this while saving property packages)
    error="Compound name does not match file name for \"";
    error+=path;
    error+="\"";
-   fclose(fin);
    return false;
   }
  name=line;
- if (!ReadLine(fin,line)) goto eof;
+ return Read(reader,path,error,deferCorrelations);
+}
+
+//! Error message for a data item that cannot be read
+/*!
+  \param error Receives the error message
+  \param item Description of the data item
+  \param path Path of the file
+  \param reader The reader, positioned at the line of the item
+  \return False
+*/
+
+static bool ReadError(string &error,const char *item,const char *path,const LineReader &reader)
+{char lineNumber[32];
+ sprintf_s(lineNumber,sizeof(lineNumber),"%d",reader.LineNumber());
+ error="Failed to read ";
+ error+=item;
+ error+=" from \"";
+ error+=path;
+ error+="\", line ";
+ error+=lineNumber;
+ return false;
+}
+
+//! Error message for a compound record that ends early
+/*!
+  \param error Receives the error message
+  \param name Name of the compound
+  \param path Path of the file
+  \return False
+*/
+
+static bool EndOfFileError(string &error,const string &name,const char *path)
+{error="Failed to read compound \"";
+ error+=name;
+ error+="\" from \"";
+ error+=path;
+ error+="\": unexpected end of file";
+ return false;
+}
+
+//! Read the data of the Compound
+/*!
+  Read the lines that follow the compound name in a .compound file or in a 
+  compound library record, from the formula to the Antoine coefficients. 
+
+  If deferCorrelations is set, the four correlation lines are skipped without
+  parsing them; their file and position are kept in correlationSource,
+  correlationPosition and correlationLine, and LoadCorrelations() reads them
+  when they are needed. Errors in the correlation lines are then reported by
+  LoadCorrelations().
+  \param reader The reader, positioned after the name line
+  \param path Path of the file, for error messages
+  \param error Error message in case of failure
+  \param deferCorrelations If set, the correlation lines are skipped
+  \return True for success, false for error
+  \sa LoadFile(), CompoundLibrary, ReadCorrelations()
+*/
+
+bool Compound::Read(LineReader &reader,const char *path,string &error,bool deferCorrelations)
+{const char *line;
+ double *values[5]={&MW,&NBP,&TC,&PC,&VC};
+ static const char *valueNames[5]={"molecular weight","normal boiling point","critical temperature","critical pressure","critical volume"};
+ int i;
+ if ((line=reader.Next())==NULL) return EndOfFileError(error,name,path);
  formula=line;
- if (!ReadLine(fin,line)) goto eof;
+ if ((line=reader.Next())==NULL) return EndOfFileError(error,name,path);
  CAS=line;
- if (!ReadLine(fin,line)) goto eof;
- if (sscanf_s(line.c_str(),"%lg",&MW)!=1)
-  {error="Failed to read molecular weight from \"";
-   error+=path;
-   error+='"'; 
-   fclose(fin);
-   return false;
-  }
- if (!ReadLine(fin,line)) goto eof;
- if (sscanf_s(line.c_str(),"%lg",&NBP)!=1)
-  {error="Failed to read normal boiling point from \"";
-   error+=path;
-   error+='"'; 
-   fclose(fin);
-   return false;
-  }
- if (!ReadLine(fin,line)) goto eof;
- if (sscanf_s(line.c_str(),"%lg",&TC)!=1)
-  {error="Failed to read critical temperature from \"";
-   error+=path;
-   error+='"';
-   fclose(fin);
-   return false;
-  }
- if (!ReadLine(fin,line)) goto eof;
- if (sscanf_s(line.c_str(),"%lg",&PC)!=1)
-  {error="Failed to read critical pressure from \"";
-   error+=path;
-   error+='"';
-   fclose(fin);
-   return false;
-  }
- if (!ReadLine(fin,line)) goto eof;
- if (sscanf_s(line.c_str(),"%lg",&VC)!=1)
-  {error="Failed to read critical volume from \"";
-   error+=path;
-   error+='"';
-   fclose(fin);
-   return false;
+ for (i=0;i<5;i++)
+  {if ((line=reader.Next())==NULL) return EndOfFileError(error,name,path);
+   if (sscanf_s(line,"%lg",values[i])!=1) return ReadError(error,valueNames[i],path,reader);
   }
- //correlations
- double A,B,C,D,E;
- if (!ReadLine(fin,line)) goto eof;
- if (sscanf_s(line.c_str(),"%lg %lg %lg %lg %lg",&A,&B,&C,&D,&E)!=5)
-  {error="Failed to read heat capacity coefficients from \"";
-   error+=path;
-   error+='"';
-   fclose(fin);
-   return false;
-  }
- CpCorrelation=new Correlation(A,B,C,D,E);
- if (!ReadLine(fin,line)) goto eof;
- if (sscanf_s(line.c_str(),"%lg %lg %lg %lg %lg",&A,&B,&C,&D,&E)!=5)
-  {error="Failed to read heat of vaporization coefficients from \"";
-   error+=path;
-   error+='"';
-   fclose(fin);
-   return false;
+ if (!deferCorrelations) return ReadCorrelations(reader,path,error);
+ correlationSource=path;
+ correlationPosition=reader.Position();
+ correlationLine=reader.LineNumber();
+ if (!reader.Skip(4)) return EndOfFileError(error,name,path);
+ return true;
+}
+
+//! Read the correlations of the Compound
+/*!
+  Read the heat capacity, heat of vaporization, liquid density and Antoine
+  coefficients. The correlations are only created if all four lines are read 
+  successfully.
+  \param reader The reader, positioned after the critical volume line
+  \param path Path of the file, for error messages
+  \param error Error message in case of failure
+  \return True for success, false for error
+  \sa Read(), LoadCorrelations()
+*/
+
+bool Compound::ReadCorrelations(LineReader &reader,const char *path,string &error)
+{const char *line;
+ static const char *coefficientNames[3]={"heat capacity coefficients","heat of vaporization coefficients","liquid density coefficients"};
+ double coef[3][5],A,B,C;
+ int i;
+ for (i=0;i<3;i++)
+  {if ((line=reader.Next())==NULL) return EndOfFileError(error,name,path);
+   if (sscanf_s(line,"%lg %lg %lg %lg %lg",&coef[i][0],&coef[i][1],&coef[i][2],&coef[i][3],&coef[i][4])!=5) return ReadError(error,coefficientNames[i],path,reader);
   }
- HvapCorrelation=new Correlation(A,B,C,D,E);
- if (!ReadLine(fin,line)) goto eof;
- if (sscanf_s(line.c_str(),"%lg %lg %lg %lg %lg",&A,&B,&C,&D,&E)!=5)
-  {error="Failed to read liquid density coefficients from \"";
-   error+=path;
-   error+='"';
-   fclose(fin);
+ if ((line=reader.Next())==NULL) return EndOfFileError(error,name,path);
+ if (sscanf_s(line,"%lg %lg %lg",&A,&B,&C)!=3) return ReadError(error,"Antoine coefficients",path,reader);
+ CpCorrelation=new Correlation(coef[0][0],coef[0][1],coef[0][2],coef[0][3],coef[0][4]);
+ HvapCorrelation=new Correlation(coef[1][0],coef[1][1],coef[1][2],coef[1][3],coef[1][4]);
+ liqDensCorrelation=new Correlation(coef[2][0],coef[2][1],coef[2][2],coef[2][3],coef[2][4]);
+ pSatCorrelation=new Antoine(A,B,C);
+ return true;
+}
+
+//! Load deferred correlations
+/*!
+  Read the correlations of a compound of which loading the correlations was 
+  deferred by Read(), from the position in the file that was recorded. The 
+  file must not have been changed in between. Does nothing if the correlations
+  are loaded already. Not thread safe; the caller must serialize calls for
+  the same compound.
+  \param error Error message in case of failure
+  \return True for success, false for error
+  \sa HasCorrelations(), PropertyPackage::SetLazyLoading()
+*/
+
+bool Compound::LoadCorrelations(string &error)
+{LineReader reader;
+ int errCode;
+ if (HasCorrelations()) return true;
+ if (correlationSource.empty())
+  {error="No correlation data for compound \"";
+   error+=name;
+   error+="\"";
    return false;
   }
- liqDensCorrelation=new Correlation(A,B,C,D,E);
- if (!ReadLine(fin,line)) goto eof;
- if (sscanf_s(line.c_str(),"%lg %lg %lg",&A,&B,&C)!=3)
-  {error="Failed to read Antoine coefficients from \"";
-   error+=path;
-   error+='"';
-   fclose(fin);
+ errCode=reader.Open(correlationSource.c_str());
+ if (errCode)
+  {error="Failed to open \"";
+   error+=correlationSource;
+   error+="\": ";
+   error+=ErrorString(errCode);
    return false;
   }
- pSatCorrelation=new Antoine(A,B,C);
- fclose(fin);
- return true;
+ if (!reader.Seek(correlationPosition,correlationLine)) return EndOfFileError(error,name,correlationSource.c_str());
+ return ReadCorrelations(reader,correlationSource.c_str(),error);
 }
@@ -2,6 +2,12 @@
 
 #include "Correlation.h"
 #include "Antoine.h"
+#include <unordered_map>
+
+//forward declarations
+class CompoundDatabase; //forward declaration
+struct CompoundRecord; //forward declaration
+class LineReader; //forward declaration
 
 //! Compound class
 /*!
@@ -28,6 +34,9 @@ public:
 	Correlation *HvapCorrelation; /*!< Heat of vaporization correlation / J/mol */
 	Correlation *liqDensCorrelation; /*!< liquid density correlation / mol/m3 */
 	Antoine *pSatCorrelation; /*!< Saturated Vapor Pressure correlation / Pa */	
+	string correlationSource; /*!< file of the correlation data, if loading it was deferred */
+	long correlationPosition; /*!< position of the correlation data in correlationSource */
+	int correlationLine; /*!< line number of the line before the correlation data in correlationSource */
 
 	//! Constructor
 	/*!
@@ -41,6 +50,8 @@ public:
 	 HvapCorrelation=NULL;
 	 liqDensCorrelation=NULL;
 	 pSatCorrelation=NULL; 
+	 correlationPosition=0;
+	 correlationLine=0;
 	}
 	
 	//! Destructor
@@ -57,6 +68,22 @@ public:
 	
 	//member functions 
 	bool Load(const char *compName,std::string &error);
+	bool LoadFile(const char *path,const char *compName,std::string &error,bool deferCorrelations=false);
+	bool Load(const CompoundDatabase &database,const CompoundRecord &record,std::string &error);
+	bool Read(LineReader &reader,const char *path,std::string &error,bool deferCorrelations=false);
+	bool ReadCorrelations(LineReader &reader,const char *path,std::string &error);
+	bool LoadCorrelations(std::string &error);
+	static bool LoadCompounds(int count,const std::string *names,Compound **compounds,const std::unordered_map<std::string,int> &indices,std::string &error,bool deferCorrelations=false);
+	static std::string NameKey(const char *name);
+	static void SetLoadThreads(int threadCount);
+
+	//! Check whether the correlations are loaded
+	/*!
+	  \return False if loading the correlations was deferred and they have not been loaded yet
+	  \sa LoadCorrelations()
+	*/
+
+	bool HasCorrelations() const {return (pSatCorrelation!=NULL);}
 
 
 
@@ -0,0 +1,493 @@
+#include "stdafx.h"
+#include "CompoundDatabase.h"
+#include "Compound.h"
+#include "CompoundLibrary.h"
+#include "IdealThermoModule.h"
+#include "Lock.h"
+#include <algorithm>
+#include <string.h>
+#include <ctype.h>
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+//! Magic at the start of a compound database image
+static const char compoundDatabaseMagic[8]={'I','D','T','H','M','C','D','B'};
+
+//! Byte order marker of a compound database image
+#define COMPOUND_DATABASE_BYTE_ORDER 0x01020304
+
+static shared_ptr<const CompoundDatabase> defaultDatabase; /*!< the database of the data folder, as returned by CompoundDatabase::Default() */
+static string defaultDatabasePath; /*!< path of defaultDatabase, or of the image that could not be opened */
+static bool defaultDatabaseChecked=false; /*!< set once an attempt is made to open defaultDatabasePath */
+
+//! Constructor
+/*!
+  Called upon construction of a CompoundDatabase instance; the database is
+  empty until Open() is called
+*/
+
+CompoundDatabase::CompoundDatabase()
+{image=NULL;
+ imageSize=0;
+ header=NULL;
+ records=NULL;
+ hash=NULL;
+ strings=NULL;
+#ifdef _WIN32
+ file=INVALID_HANDLE_VALUE;
+ mapping=NULL;
+#endif
+}
+
+//! Destructor
+/*!
+  Unmaps the image
+*/
+
+CompoundDatabase::~CompoundDatabase()
+{Close();
+}
+
+//! Case-insensitive hash of a compound name
+/*!
+  \param name The compound name
+  \return FNV-1a hash of the lower case name
+*/
+
+uint32_t CompoundDatabase::NameHash(const char *name)
+{uint32_t h=2166136261u;
+ for (;*name;name++)
+  {h^=(uint32_t)(unsigned char)tolower((unsigned char)*name);
+   h*=16777619u;
+  }
+ return h;
+}
+
+//! Checksum of the body of an image
+/*!
+  \param data Start of the data
+  \param size Size of the data
+  \return FNV-1a 64-bit hash of the data
+*/
+
+uint64_t CompoundDatabase::Checksum(const char *data,size_t size)
+{uint64_t h=14695981039346656037ull;
+ size_t i;
+ for (i=0;i<size;i++)
+  {h^=(uint64_t)(unsigned char)data[i];
+   h*=1099511628211ull;
+  }
+ return h;
+}
+
+//! Map an image file
+/*!
+  \param path Path of the image file
+  \param error Error message in case of failure
+  \return True for success, false for error
+*/
+
+bool CompoundDatabase::Map(const char *path,string &error)
+#ifdef _WIN32
+{LARGE_INTEGER size;
+ file=CreateFileA(path,GENERIC_READ,FILE_SHARE_READ|FILE_SHARE_DELETE,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+ if (file==INVALID_HANDLE_VALUE)
+  {error="Failed to open \"";
+   error+=path;
+   error+='"';
+   return false;
+  }
+ if ((!GetFileSizeEx(file,&size))||(size.QuadPart<(LONGLONG)sizeof(CompoundDatabaseHeader)))
+  {error="Compound database \"";
+   error+=path;
+   error+="\" is truncated";
+   return false;
+  }
+ imageSize=(size_t)size.QuadPart;
+ mapping=CreateFileMappingA(file,NULL,PAGE_READONLY,0,0,NULL);
+ if (mapping) image=(const char *)MapViewOfFile(mapping,FILE_MAP_READ,0,0,0);
+ if (!image)
+  {error="Failed to map \"";
+   error+=path;
+   error+='"';
+   return false;
+  }
+ return true;
+}
+#else
+{struct stat info;
+ void *data;
+ int fd=open(path,O_RDONLY);
+ if (fd<0)
+  {error="Failed to open \"";
+   error+=path;
+   error+="\": ";
+   error+=ErrorString(errno);
+   return false;
+  }
+ if ((fstat(fd,&info)!=0)||(info.st_size<(off_t)sizeof(CompoundDatabaseHeader)))
+  {close(fd);
+   error="Compound database \"";
+   error+=path;
+   error+="\" is truncated";
+   return false;
+  }
+ data=mmap(NULL,(size_t)info.st_size,PROT_READ,MAP_SHARED,fd,0);
+ close(fd); //the mapping keeps the file open
+ if (data==MAP_FAILED)
+  {error="Failed to map \"";
+   error+=path;
+   error+="\": ";
+   error+=ErrorString(errno);
+   return false;
+  }
+ image=(const char *)data;
+ imageSize=(size_t)info.st_size;
+ return true;
+}
+#endif
+
+//! Check that a region lies within an image
+/*!
+  The offset is compared against the image size before the size is added, so
+  that corrupt values cannot wrap around
+  \param offset Offset of the region
+  \param size Size of the region in bytes
+  \param imageSize Size of the image
+  \return True if the region is within the image
+*/
+
+static bool InImage(uint64_t offset,uint64_t size,uint64_t imageSize)
+{return (offset<=imageSize)&&(size<=imageSize-offset);
+}
+
+//! Open an image
+/*!
+  Map a compound database image and validate it. The image is rejected if it
+  is of another version or byte order, if its layout is inconsistent, or if
+  its checksum does not match.
+  \param path Path of the image file
+  \param error Error message in case of failure
+  \return True for success, false for error
+  \sa Compile()
+*/
+
+bool CompoundDatabase::Open(const char *path,string &error)
+{uint32_t i,used;
+ const CompoundDatabaseHeader *h;
+ Close();
+ if (!Map(path,error))
+  {Close();
+   return false;
+  }
+ h=(const CompoundDatabaseHeader *)image;
+ if ((memcmp(h->magic,compoundDatabaseMagic,sizeof(h->magic))!=0)||(h->version!=COMPOUND_DATABASE_VERSION)
+    ||(h->byteOrder!=COMPOUND_DATABASE_BYTE_ORDER)||(h->recordSize!=sizeof(CompoundRecord)))
+  {error="\"";
+   error+=path;
+   error+="\" is not a compound database of this version";
+   Close();
+   return false;
+  }
+ //layout; the hash index must have at least one empty slot for Find() to terminate
+ if ((h->imageSize!=imageSize)||(h->recordsOffset%sizeof(double))||(h->hashOffset%sizeof(uint32_t))
+    ||(h->recordsOffset<sizeof(CompoundDatabaseHeader))||(!InImage(h->recordsOffset,(uint64_t)h->recordCount*sizeof(CompoundRecord),imageSize))
+    ||(h->hashSize<=h->recordCount)||(h->hashSize&(h->hashSize-1))||(!InImage(h->hashOffset,(uint64_t)h->hashSize*sizeof(uint32_t),imageSize))
+    ||(h->stringsSize==0)||(!InImage(h->stringsOffset,h->stringsSize,imageSize))||(image[h->stringsOffset+h->stringsSize-1]!=0))
+  {error="Compound database \"";
+   error+=path;
+   error+="\" is corrupt";
+   Close();
+   return false;
+  }
+ if (Checksum(image+sizeof(CompoundDatabaseHeader),imageSize-sizeof(CompoundDatabaseHeader))!=h->checksum)
+  {error="Checksum of compound database \"";
+   error+=path;
+   error+="\" does not match";
+   Close();
+   return false;
+  }
+ header=h;
+ records=(const CompoundRecord *)(image+h->recordsOffset);
+ hash=(const uint32_t *)(image+h->hashOffset);
+ strings=image+h->stringsOffset;
+ //references
+ for (i=0;i<h->recordCount;i++)
+  if ((records[i].name>=h->stringsSize)||(records[i].formula>=h->stringsSize)||(records[i].CAS>=h->stringsSize))
+   {error="Compound database \"";
+    error+=path;
+    error+="\" is corrupt";
+    Close();
+    return false;
+   }
+ //each record is in the index once, so that the empty slots remain for Find() to terminate
+ used=0;
+ for (i=0;i<h->hashSize;i++)
+  {if (hash[i]>h->recordCount) break;
+   if (hash[i]) used++;
+  }
+ if ((i<h->hashSize)||(used!=h->recordCount))
+  {error="Compound database \"";
+   error+=path;
+   error+="\" is corrupt";
+   Close();
+   return false;
+  }
+ return true;
+}
+
+//! Close the image
+/*!
+  Unmaps the image, if any. Records and strings obtained from the database
+  are no longer valid.
+*/
+
+void CompoundDatabase::Close()
+{
+#ifdef _WIN32
+ if (image) UnmapViewOfFile(image);
+ if (mapping) CloseHandle(mapping);
+ if (file!=INVALID_HANDLE_VALUE) CloseHandle(file);
+ file=INVALID_HANDLE_VALUE;
+ mapping=NULL;
+#else
+ if (image) munmap((void*)image,imageSize);
+#endif
+ image=NULL;
+ imageSize=0;
+ header=NULL;
+ records=NULL;
+ hash=NULL;
+ strings=NULL;
+}
+
+//! Find a compound
+/*!
+  \param name The compound name, case-insensitive
+  \return The record of the compound, or NULL if not in the database
+*/
+
+const CompoundRecord *CompoundDatabase::Find(const char *name) const
+{uint32_t mask,slot;
+ if (!header) return NULL;
+ mask=header->hashSize-1;
+ for (slot=NameHash(name)&mask;hash[slot];slot=(slot+1)&mask)
+  {const CompoundRecord *record=records+hash[slot]-1;
+   if (lstrcmpi(strings+record->name,name)==0) return record;
+  }
+ return NULL;
+}
+
+//! Compounds that are deleted when going out of scope
+struct CompoundList
+{vector<Compound*> items; /*!< the compounds */
+
+ //! Destructor
+ ~CompoundList()
+ {for (size_t i=0;i<items.size();i++) delete items[i];
+ }
+};
+
+//! Compile a compound database
+/*!
+  Load all compound libraries and .compound files of a folder and write them 
+  to a compound database image. The image is written to a temporary file that
+  then replaces path, so that processes that have the previous image mapped 
+  are not affected. The Default() database is reopened upon next use.
+  \param folder Folder that contains the compound libraries and .compound files
+  \param path Path of the image file
+  \param count Receives the number of compounds
+  \param error Error message in case of failure
+  \return True for success, false for error
+  \sa CompoundLibrary::LoadAll(), Compound::LoadFile(), Open()
+*/
+
+bool CompoundDatabase::Compile(const char *folder,const char *path,int &count,string &error)
+{vector<string> names;
+ CompoundList compounds;
+ vector<CompoundRecord> recordTable;
+ vector<uint32_t> hashTable;
+ string pool,compPath,tempPath;
+ CompoundDatabaseHeader h;
+ uint32_t hashSize,mask,slot;
+ int i;
+ count=0;
+ //libraries
+ ListFiles(folder,COMPOUND_LIBRARY_EXTENSION,names);
+ sort(names.begin(),names.end());
+ for (i=0;i<(int)names.size();i++)
+  {compPath=folder;
+   compPath+=PATH_SEPARATOR;
+   compPath+=names[i];
+   compPath+=".";
+   compPath+=COMPOUND_LIBRARY_EXTENSION;
+   if (!CompoundLibrary::LoadAll(compPath.c_str(),compounds.items,error)) return false;
+  }
+ //compound files
+ ListFiles(folder,"compound",names);
+ sort(names.begin(),names.end());
+ for (i=0;i<(int)names.size();i++)
+  {Compound *c=new Compound;
+   compounds.items.push_back(c);
+   compPath=folder;
+   compPath+=PATH_SEPARATOR;
+   compPath+=names[i];
+   compPath+=".compound";
+   if (!c->LoadFile(compPath.c_str(),names[i].c_str(),error)) return false;
+  }
+ if (compounds.items.empty())
+  {error="No compound libraries or .compound files in \"";
+   error+=folder;
+   error+='"';
+   return false;
+  }
+ for (hashSize=1;hashSize<2*compounds.items.size();hashSize*=2) ;
+ mask=hashSize-1;
+ recordTable.resize(compounds.items.size());
+ hashTable.assign(hashSize,0);
+ for (i=0;i<(int)compounds.items.size();i++)
+  {const Compound &c=*compounds.items[i];
+   CompoundRecord &r=recordTable[i];
+   memset(&r,0,sizeof(r));
+   r.name=(uint32_t)pool.size();
+   pool.append(c.name.c_str(),c.name.size()+1);
+   r.formula=(uint32_t)pool.size();
+   pool.append(c.formula.c_str(),c.formula.size()+1);
+   r.CAS=(uint32_t)pool.size();
+   pool.append(c.CAS.c_str(),c.CAS.size()+1);
+   r.MW=c.MW;
+   r.NBP=c.NBP;
+   r.TC=c.TC;
+   r.PC=c.PC;
+   r.VC=c.VC;
+   const Correlation *correlations[3]={c.CpCorrelation,c.HvapCorrelation,c.liqDensCorrelation};
+   double *coefficients[3]={r.Cp,r.Hvap,r.liqDens};
+   for (int k=0;k<3;k++)
+    {coefficients[k][0]=correlations[k]->A;
+     coefficients[k][1]=correlations[k]->B;
+     coefficients[k][2]=correlations[k]->C;
+     coefficients[k][3]=correlations[k]->D;
+     coefficients[k][4]=correlations[k]->E;
+    }
+   r.antoine[0]=c.pSatCorrelation->A;
+   r.antoine[1]=c.pSatCorrelation->B;
+   r.antoine[2]=c.pSatCorrelation->C;
+   //hash index; names that only differ in case cannot both be found
+   for (slot=NameHash(c.name.c_str())&mask;hashTable[slot];slot=(slot+1)&mask)
+    if (lstrcmpi(pool.c_str()+recordTable[hashTable[slot]-1].name,c.name.c_str())==0)
+     {error="Compound \"";
+      error+=c.name;
+      error+="\" is present in \"";
+      error+=folder;
+      error+="\" more than once";
+      return false;
+     }
+   hashTable[slot]=(uint32_t)i+1;
+  }
+ //layout: header, records, hash index, strings
+ memset(&h,0,sizeof(h));
+ memcpy(h.magic,compoundDatabaseMagic,sizeof(h.magic));
+ h.version=COMPOUND_DATABASE_VERSION;
+ h.byteOrder=COMPOUND_DATABASE_BYTE_ORDER;
+ h.recordSize=sizeof(CompoundRecord);
+ h.recordCount=(uint32_t)recordTable.size();
+ h.hashSize=hashSize;
+ h.recordsOffset=sizeof(CompoundDatabaseHeader);
+ h.hashOffset=h.recordsOffset+recordTable.size()*sizeof(CompoundRecord);
+ h.stringsOffset=h.hashOffset+hashTable.size()*sizeof(uint32_t);
+ h.stringsSize=pool.size();
+ h.imageSize=h.stringsOffset+h.stringsSize;
+ string body;
+ body.reserve((size_t)(h.imageSize-sizeof(h)));
+ body.append((const char *)&recordTable[0],recordTable.size()*sizeof(CompoundRecord));
+ body.append((const char *)&hashTable[0],hashTable.size()*sizeof(uint32_t));
+ body.append(pool);
+ h.checksum=Checksum(body.c_str(),body.size());
+ //write
+ FILE *f;
+ tempPath=path;
+ tempPath+=".tmp";
+ int errCode=fopen_s(&f,tempPath.c_str(),"wb");
+ if (errCode)
+  {error="Failed to open \"";
+   error+=tempPath;
+   error+="\": ";
+   error+=ErrorString(errCode);
+   return false;
+  }
+ bool ok=(fwrite(&h,sizeof(h),1,f)==1)&&(fwrite(body.c_str(),1,body.size(),f)==body.size());
+ if (fclose(f)!=0) ok=false;
+ if (!ok)
+  {remove(tempPath.c_str());
+   error="Failed to write \"";
+   error+=tempPath;
+   error+='"';
+   return false;
+  }
+#ifdef _WIN32
+ ok=(MoveFileExA(tempPath.c_str(),path,MOVEFILE_REPLACE_EXISTING)!=0);
+#else
+ ok=(rename(tempPath.c_str(),path)==0);
+#endif
+ if (!ok)
+  {remove(tempPath.c_str());
+   error="Failed to replace \"";
+   error+=path;
+   error+='"';
+   return false;
+  }
+ Reset();
+ count=(int)recordTable.size();
+ return true;
+}
+
+//! Database of the data folder
+/*!
+  The image COMPOUND_DATABASE_FILE in the data folder, opened upon first use
+  and again when the data folder changes. A missing or invalid image is not
+  an error: the compounds are then loaded from the compound libraries and
+  .compound files.
+
+  The database is shared; a caller keeps it mapped for as long as it holds
+  the returned pointer, also if the data folder changes meanwhile.
+  \return The database, or NULL if the data folder has no valid image
+  \sa ::GetDataPath(), Compound::Load()
+*/
+
+shared_ptr<const CompoundDatabase> CompoundDatabase::Default()
+{shared_ptr<const CompoundDatabase> res;
+ string path=GetDataPath();
+ path+=PATH_SEPARATOR;
+ path+=COMPOUND_DATABASE_FILE;
+ theLock.Lock();
+ if ((!defaultDatabaseChecked)||(path!=defaultDatabasePath))
+  {string error;
+   CompoundDatabase *database=new CompoundDatabase;
+   defaultDatabase.reset();
+   defaultDatabasePath=path;
+   defaultDatabaseChecked=true;
+   if (database->Open(path.c_str(),error)) defaultDatabase.reset(database);
+   else delete database;
+  }
+ res=defaultDatabase;
+ theLock.Unlock();
+ return res;
+}
+
+//! Forget the database of the data folder
+/*!
+  The next call to Default() opens the image again, e.g. after it has been
+  compiled. Callers that hold the previous database keep it mapped.
+*/
+
+void CompoundDatabase::Reset()
+{theLock.Lock();
+ defaultDatabase.reset();
+ defaultDatabaseChecked=false;
+ theLock.Unlock();
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+
+//! File name of the compound database in the data folder
+#define COMPOUND_DATABASE_FILE "compounds.compounddb"
+
+//! Version of the compound database layout; images of other versions are not opened
+#define COMPOUND_DATABASE_VERSION 1
+
+//forward declarations
+class Compound; //forward declaration
+
+//! CompoundDatabaseHeader struct
+/*!
+	Header at the start of a compound database image. All offsets are in
+	bytes from the start of the image; all values are in the byte order of
+	the machine that compiled the image, which is checked by byteOrder.
+	\sa CompoundDatabase
+*/
+
+struct CompoundDatabaseHeader
+{char magic[8]; /*!< "IDTHMCDB" */
+ uint32_t version; /*!< COMPOUND_DATABASE_VERSION */
+ uint32_t byteOrder; /*!< 0x01020304 as written by the compiling machine */
+ uint32_t recordSize; /*!< sizeof(CompoundRecord) */
+ uint32_t recordCount; /*!< number of compounds */
+ uint32_t hashSize; /*!< number of slots of the name hash index, a power of 2 */
+ uint32_t reserved; /*!< zero */
+ uint64_t recordsOffset; /*!< offset of the records */
+ uint64_t hashOffset; /*!< offset of the name hash index */
+ uint64_t stringsOffset; /*!< offset of the string pool */
+ uint64_t stringsSize; /*!< size of the string pool, including the terminating zero of the last string */
+ uint64_t imageSize; /*!< size of the image */
+ uint64_t checksum; /*!< FNV-1a hash of all bytes that follow the header */
+};
+
+//! CompoundRecord struct
+/*!
+	Fixed-layout record of a single compound in a compound database image.
+	Strings are offsets into the string pool of the image; the numbers are
+	the items of the .compound file, in the same units.
+	\sa CompoundDatabase, Compound::Load()
+*/
+
+struct CompoundRecord
+{uint32_t name; /*!< string offset of the compound name */
+ uint32_t formula; /*!< string offset of the chemical formula */
+ uint32_t CAS; /*!< string offset of the CAS number */
+ uint32_t reserved; /*!< zero */
+ double MW; /*!< relative molecular weight */
+ double NBP; /*!< normal boiling point / K */
+ double TC; /*!< critical temperature / K */
+ double PC; /*!< critical pressure / Pa */
+ double VC; /*!< critical volume / m3/mol */
+ double Cp[5]; /*!< coefficients of the ideal gas heat capacity correlation */
+ double Hvap[5]; /*!< coefficients of the heat of vaporization correlation */
+ double liqDens[5]; /*!< coefficients of the liquid density correlation */
+ double antoine[3]; /*!< coefficients of the Antoine correlation */
+};
+
+//! CompoundDatabase class
+/*!
+	A read-only, memory-mapped image of the compounds of a folder of compound
+	libraries and .compound files, as produced by Compile() (and by the
+	compound_compiler tool). The image consists of a header, an array of
+	fixed-layout CompoundRecord entries, an open-addressing hash index on the
+	case-insensitive compound names and a pool of zero-terminated strings.
+
+	Opening an image maps it and validates the header, the layout and the
+	checksum; after that, finding a compound costs a hash probe and its data is
+	read directly from the mapped record, without file access or parsing.
+
+	Compound::Load() uses the image COMPOUND_DATABASE_FILE in the data folder,
+	if present, for the compounds it contains, and the compound libraries and
+	.compound files for all others. The libraries and .compound files remain 
+	the source: the image must be compiled again after they are edited.
+
+	\sa Compound, Default(), Compile()
+*/
+
+class CompoundDatabase
+{public:
+
+	//construction
+	CompoundDatabase();
+	~CompoundDatabase();
+
+	//functions
+	bool Open(const char *path,string &error);
+	void Close();
+	const CompoundRecord *Find(const char *name) const;
+
+	//! Number of compounds
+	/*!
+	  \return The number of compounds in the image, zero if not open
+	*/
+
+	int Count() const {return header?(int)header->recordCount:0;}
+
+	//! Record of a compound
+	/*!
+	  \param index Index of the compound, 0 to Count()-1
+	  \return The record
+	*/
+
+	const CompoundRecord &Record(int index) const {return records[index];}
+
+	//! String from the string pool
+	/*!
+	  \param offset String offset, as stored in a CompoundRecord
+	  \return The zero-terminated string
+	*/
+
+	const char *String(uint32_t offset) const {return strings+offset;}
+
+	static bool Compile(const char *folder,const char *path,int &count,string &error);
+	static shared_ptr<const CompoundDatabase> Default();
+	static void Reset();
+
+private:
+
+	const char *image; /*!< the mapped image, NULL if not open */
+	size_t imageSize; /*!< size of the mapped image */
+	const CompoundDatabaseHeader *header; /*!< header of the image */
+	const CompoundRecord *records; /*!< the records */
+	const uint32_t *hash; /*!< the hash index: record index+1 per slot, zero for an empty slot */
+	const char *strings; /*!< the string pool */
+#ifdef _WIN32
+	HANDLE file; /*!< the image file */
+	HANDLE mapping; /*!< the file mapping */
+#endif
+
+	bool Map(const char *path,string &error);
+	static uint32_t NameHash(const char *name);
+	static uint64_t Checksum(const char *data,size_t size);
+
+	//no copies of the mapping
+	CompoundDatabase(const CompoundDatabase &);
+	CompoundDatabase &operator=(const CompoundDatabase &);
+
+};
@@ -0,0 +1,87 @@
+#include "stdafx.h"
+#include "CompoundLibrary.h"
+#include "Compound.h"
+#include "IdealThermoModule.h"
+#include "LineReader.h"
+
+//! Open a compound library
+/*!
+  \param reader The reader
+  \param path Path of the library
+  \param error Error message in case of failure
+  \return True for success, false for error
+*/
+
+static bool OpenLibrary(LineReader &reader,const char *path,string &error)
+{int errCode=reader.Open(path);
+ if (errCode)
+  {error="Failed to open \"";
+   error+=path;
+   error+="\": ";
+   error+=ErrorString(errCode);
+   return false;
+  }
+ return true;
+}
+
+//! Load compounds from a library
+/*!
+  Load the compounds that are needed and not loaded yet from a compound library
+  \param path Path of the library
+  \param indices Index of each needed compound, by Compound::NameKey() of its name
+  \param compounds The compounds, by index; compounds that have a name are already loaded
+  \param remaining Number of compounds that are not loaded yet; decremented for each compound loaded
+  \param error Error message in case of failure
+  \param deferCorrelations If set, the correlation lines are skipped, see Compound::Read()
+  \return True for success, false for error
+*/
+
+bool CompoundLibrary::Load(const char *path,const unordered_map<string,int> &indices,Compound **compounds,int &remaining,string &error,bool deferCorrelations)
+{LineReader reader;
+ unordered_map<string,int>::const_iterator it;
+ string key;
+ char *line;
+ size_t i;
+ if (!OpenLibrary(reader,path,error)) return false;
+ while ((remaining)&&((line=reader.Next())!=NULL))
+  {//lower case key, in a string that is reused between records
+   key=line;
+   for (i=0;i<key.size();i++) key[i]=(char)tolower((unsigned char)key[i]);
+   it=indices.find(key);
+   if ((it!=indices.end())&&(compounds[it->second]->name.empty()))
+    {Compound *c=compounds[it->second];
+     c->name=line;
+     if (!c->Read(reader,path,error,deferCorrelations)) return false;
+     remaining--;
+    }
+   else if (!reader.Skip(COMPOUND_RECORD_LINES-1))
+    {error="Failed to read compound from \"";
+     error+=path;
+     error+="\": unexpected end of file";
+     return false;
+    }
+  }
+ return true;
+}
+
+//! Load all compounds from a library
+/*!
+  \param path Path of the library
+  \param compounds The compounds of the library are appended, and must be deleted by the caller, also in case of failure
+  \param error Error message in case of failure
+  \return True for success, false for error
+  \sa CompoundDatabase::Compile()
+*/
+
+bool CompoundLibrary::LoadAll(const char *path,vector<Compound*> &compounds,string &error)
+{LineReader reader;
+ char *line;
+ if (!OpenLibrary(reader,path,error)) return false;
+ while ((line=reader.Next())!=NULL)
+  {Compound *c=new Compound;
+   compounds.push_back(c);
+   c->name=line;
+   if (!c->Read(reader,path,error)) return false;
+  }
+ return true;
+}
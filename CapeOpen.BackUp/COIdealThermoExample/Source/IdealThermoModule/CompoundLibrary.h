@@ -0,0 +1,37 @@
+#pragma once
+
+#include <unordered_map>
+
+//! File extension of compound libraries in the data folder
+#define COMPOUND_LIBRARY_EXTENSION "compoundlibrary"
+
+//! Number of data lines of a compound record, from the name to the Antoine coefficients
+#define COMPOUND_RECORD_LINES 12
+
+//forward declarations
+class Compound; //forward declaration
+
+//! CompoundLibrary class
+/*!
+	A compound library is a single file that holds the records of many
+	compounds, each in the format of a .compound file: the name, formula, CAS
+	number, molecular weight, normal boiling point, critical temperature,
+	pressure and volume, the heat capacity, heat of vaporization and liquid
+	density coefficients and the Antoine coefficients, one item per line.
+	Empty lines and lines that start with # are skipped, also between records.
+
+	Libraries are stored in the data folder with extension .compoundlibrary.
+	A library is read in a single sequential pass: of the compounds that are
+	not needed, only the lines are scanned, the numbers are not parsed. Only
+	the first record of a compound is used.
+
+	\sa Compound::LoadCompounds(), LineReader
+*/
+
+class CompoundLibrary
+{public:
+
+	static bool Load(const char *path,const unordered_map<string,int> &indices,Compound **compounds,int &remaining,string &error,bool deferCorrelations=false);
+	static bool LoadAll(const char *path,vector<Compound*> &compounds,string &error);
+
+};
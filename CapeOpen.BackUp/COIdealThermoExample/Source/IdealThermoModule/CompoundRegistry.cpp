@@ -0,0 +1,116 @@
+#include "stdafx.h"
+#include "CompoundRegistry.h"
+#include "Compound.h"
+#include "Lock.h"
+#include <unordered_map>
+
+static unordered_map<string,weak_ptr<Compound> > registeredCompounds; /*!< the registered compounds, by Compound::NameKey() of their name; protected by theLock */
+
+//! Obtain a set of compounds
+/*!
+  Compounds that are registered and still in use are shared; the others are
+  loaded by Compound::LoadCompounds(), outside the lock, and registered. If
+  another thread registers the same compound meanwhile, the compound of that
+  thread is used, and its deferred correlations are loaded if needed, so that
+  each compound is shared by all packages that use it.
+  \param count Number of compounds
+  \param names Names of the compounds, which must be unique
+  \param compounds Receives the compounds; cleared in case of failure
+  \param error Error message in case of failure
+  \param deferCorrelations If set, the correlations of compounds that are loaded
+  need not be loaded yet, see Compound::Read(); if not set, the deferred
+  correlations of shared compounds are loaded
+  \return True for success, false for error
+  \sa Compound::HasCorrelations()
+*/
+
+bool CompoundRegistry::Acquire(int count,const string *names,vector<shared_ptr<Compound> > &compounds,string &error,bool deferCorrelations)
+{unordered_map<string,weak_ptr<Compound> >::const_iterator it;
+ unordered_map<string,int> indices;
+ vector<string> loadNames;
+ vector<shared_ptr<Compound> > loaded;
+ vector<Compound*> loadCompounds;
+ vector<int> items;
+ bool ok=true;
+ int i,j;
+ compounds.assign(count,shared_ptr<Compound>());
+ //shared compounds
+ theLock.Lock();
+ for (i=0;(i<count)&&(ok);i++)
+  {it=registeredCompounds.find(Compound::NameKey(names[i].c_str()));
+   if (it!=registeredCompounds.end()) compounds[i]=it->second.lock();
+   if (!compounds[i]) items.push_back(i);
+   else if (!deferCorrelations) ok=compounds[i]->LoadCorrelations(error);
+  }
+ theLock.Unlock();
+ if (!ok)
+  {compounds.clear();
+   return false;
+  }
+ if (items.empty()) return true;
+ //load the others
+ loadNames.resize(items.size());
+ loaded.resize(items.size());
+ loadCompounds.resize(items.size());
+ for (j=0;j<(int)items.size();j++)
+  {loadNames[j]=names[items[j]];
+   loaded[j].reset(new Compound);
+   loadCompounds[j]=loaded[j].get();
+   indices[Compound::NameKey(loadNames[j].c_str())]=j;
+  }
+ if (!Compound::LoadCompounds((int)items.size(),&loadNames[0],&loadCompounds[0],indices,error,deferCorrelations))
+  {compounds.clear();
+   return false;
+  }
+ //register them, unless registered meanwhile
+ theLock.Lock();
+ for (j=0;(j<(int)items.size())&&(ok);j++)
+  {weak_ptr<Compound> &entry=registeredCompounds[Compound::NameKey(loadNames[j].c_str())];
+   shared_ptr<Compound> registered=entry.lock();
+   if (!registered)
+    {entry=loaded[j];
+     registered=loaded[j];
+    }
+   else if (!deferCorrelations) ok=registered->LoadCorrelations(error);
+   compounds[items[j]]=registered;
+  }
+ theLock.Unlock();
+ if (!ok)
+  {compounds.clear();
+   return false;
+  }
+ return true;
+}
+
+//! Number of compounds in use
+/*!
+  \return The number of registered compounds that are in use by property packages
+*/
+
+int CompoundRegistry::Count()
+{unordered_map<string,weak_ptr<Compound> >::iterator it;
+ int count=0;
+ theLock.Lock();
+ for (it=registeredCompounds.begin();it!=registeredCompounds.end();)
+  {if (it->second.expired()) it=registeredCompounds.erase(it);
+   else
+    {count++;
+     ++it;
+    }
+  }
+ theLock.Unlock();
+ return count;
+}
+
+//! Forget all registered compounds
+/*!
+  Property packages that are loaded after this call load their compounds
+  again, e.g. after the compound data path has changed. Packages that are
+  loaded keep their compounds.
+*/
+
+void CompoundRegistry::Reset()
+{theLock.Lock();
+ registeredCompounds.clear();
+ theLock.Unlock();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <memory>
+
+//forward declarations
+class Compound; //forward declaration
+
+//! CompoundRegistry class
+/*!
+	Process-wide registry of the loaded compounds, by case-insensitive name.
+	Property packages obtain their compounds from the registry, so that a
+	compound that is used by several property packages at the same time is
+	loaded and stored only once: creating another package with the same
+	compounds (e.g. one per unit operation of a flowsheet) costs a hash lookup
+	per compound instead of reading and parsing the compound data.
+
+	The registry holds weak references: a compound is deleted when the last
+	property package that uses it is deleted, and is loaded again upon next
+	use. The compound data is not modified once loaded, except that deferred
+	correlations are loaded by Compound::LoadCorrelations(), which is done
+	under the global lock. All functions are thread safe.
+
+	Compound data that is edited on disk is picked up by packages that are
+	loaded after the compound is no longer in use, or after Reset().
+
+	\sa PropertyPackage::Load(), Compound::LoadCompounds()
+*/
+
+class CompoundRegistry
+{public:
+
+	static bool Acquire(int count,const string *names,vector<shared_ptr<Compound> > &compounds,string &error,bool deferCorrelations=false);
+	static int Count();
+	static void Reset();
+
+};
@@ -23,6 +23,12 @@ class Correlation
 	double halfC,thirdD,quarterE; /*!< used for integrals over T*/
 	double intConstant,intConstantOverT; /*!< integration constants*/
 
+
+	//the correlation table copies the coefficients
+	friend class CorrelationTable;
+	//the compound database compiler stores the coefficients
+	friend class CompoundDatabase;
+
  public:
 
 	//! Constructor
@@ -62,7 +68,7 @@ class Correlation
 	  \return Property value
 	*/
 	
-	double Value(double T)
+	double Value(double T) const
 	{return A+T*(B+T*(C+T*(D+T*E)));
 	}
 
@@ -73,7 +79,7 @@ class Correlation
 	  \return Temperature derivative of property value
 	*/
 	
-	double ValueDT(double T)
+	double ValueDT(double T) const
 	{return B+T*(twoC+T*(threeD+T*fourE));
 	}
 
@@ -84,7 +90,7 @@ class Correlation
 	  \return Integral from Tref to T of the value
 	*/
 	
-	double IntValue(double T)
+	double IntValue(double T) const
 	{return T*(A+T*(halfB+T*(thirdC+T*(quarterD+T*fifthE))))+intConstant;
 	}
 
@@ -96,7 +102,7 @@ class Correlation
 	  \return Integral of value over T from Tref to T of the value
 	*/
 
-    double IntValueOverT(double T)
+    double IntValueOverT(double T) const
     {return A*log(T)+T*(B+T*(halfC+T*(thirdD+T*quarterE)))+intConstantOverT;
     }
 
@@ -0,0 +1,815 @@
+#include "stdafx.h"
+#include "CorrelationTable.h"
+#include "Compound.h"
+#include "VaporPressureSurrogate.h"
+#include "Lock.h"
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+//SIMD kernels are available for x86 compilers that support per-function instruction sets
+#if (defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))) || (defined(_MSC_VER) && (_MSC_VER>=1910) && defined(_M_X64))
+#define CORRELATIONTABLE_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+//the kernels must not fuse multiplications and additions (AVX-512F includes FMA),
+// so that all kernels give the same results as Correlation and Antoine
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+#ifdef __GNUC__
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define TARGET_AVX2
+#define TARGET_AVX512
+#endif
+
+//coefficient arrays of each polynomial correlation
+enum
+{	PolyA=0,PolyB,PolyC,PolyD,PolyE,
+	PolyTwoC,PolyThreeD,PolyFourE,
+	PolyHalfB,PolyThirdC,PolyQuarterD,PolyFifthE,
+	PolyHalfC,PolyThirdD,PolyQuarterE,
+	PolyIntConstant,PolyIntConstantOverT,
+	PolyArrayCount
+};
+
+//coefficient arrays of the Antoine equation, following those of the polynomial correlations
+enum
+{	AntoineA=CorrelationIDCount*PolyArrayCount,
+	AntoineB,AntoineC,AntoineBln10,
+	ArrayCount
+};
+
+//! Polynomial form
+/*!
+	Describes the evaluation of one of the functions of a Correlation in the form
+
+	value = log * ln(T) + T^m * (c[0] + T * (c[1] + ... + T * c[degree])) + constant
+
+	where m is 1 if multiplyT is set and 0 otherwise, and log and constant are
+	omitted if NULL. For each coefficient, the argument points to the array
+	of values for all compounds.
+*/
+
+struct PolyForm
+{	const double *c[5]; /*!< polynomial coefficients, c[0] to c[degree] */
+	int degree; /*!< degree of the polynomial */
+	bool multiplyT; /*!< multiply the polynomial by T */
+	const double *log; /*!< coefficient of ln(T), or NULL */
+	const double *constant; /*!< constant term, or NULL */
+};
+
+//kernel signatures
+typedef void (*PolyKernel)(const PolyForm &form,int first,int n,const int *indices,double T,double logT,double *values);
+typedef void (*AntoineKernel)(const double *A,const double *B,const double *C,int first,int n,const int *indices,double T,double *values);
+typedef void (*AntoineDTKernel)(const double *C,const double *Bln10,int first,int n,const int *indices,double T,const double *pSat,double *values);
+
+//! Scalar polynomial kernel for a specific degree
+/*!
+  Evaluate a polynomial form for compounds first to n-1
+  \param form The polynomial form, of degree Degree
+  \param first First compound to evaluate
+  \param n Number of compounds
+  \param indices Indices of the compounds in the table, or NULL for compounds 0 to n-1
+  \param T Temperature
+  \param logT ln(T), only used if form.log is not NULL
+  \param values Receives the values
+*/
+
+template <int Degree> static void PolyScalarDegree(const PolyForm &form,int first,int n,const int *indices,double T,double logT,double *values)
+{int i,d;
+ //local copies, as the stores to values could otherwise alias the form
+ const double *c[5];
+ const double *logCoef=form.log,*constant=form.constant;
+ bool multiplyT=form.multiplyT;
+ for (d=0;d<=Degree;d++) c[d]=form.c[d];
+ if (Degree<4) c[4]=NULL;
+ for (i=first;i<n;i++)
+  {int k=(indices)?indices[i]:i;
+   double h=c[Degree][k];
+   if (Degree==4) h=c[3][k]+T*h;
+   h=c[2][k]+T*h;
+   h=c[1][k]+T*h;
+   h=c[0][k]+T*h;
+   if (multiplyT) h=T*h;
+   if (logCoef) h=logCoef[k]*logT+h;
+   if (constant) h=h+constant[k];
+   values[i]=h;
+  }
+}
+
+//! Scalar polynomial kernel
+/*!
+  Evaluate a polynomial form for compounds first to n-1
+  \param form The polynomial form
+  \param first First compound to evaluate
+  \param n Number of compounds
+  \param indices Indices of the compounds in the table, or NULL for compounds 0 to n-1
+  \param T Temperature
+  \param logT ln(T), only used if form.log is not NULL
+  \param values Receives the values
+*/
+
+static void PolyScalar(const PolyForm &form,int first,int n,const int *indices,double T,double logT,double *values)
+{if (form.degree==3) PolyScalarDegree<3>(form,first,n,indices,T,logT,values);
+ else PolyScalarDegree<4>(form,first,n,indices,T,logT,values);
+}
+
+//! Scalar Antoine exponent kernel
+/*!
+  Evaluate the Antoine exponent A-B/(C+T) for compounds first to n-1
+  \param A Antoine A coefficients
+  \param B Antoine B coefficients
+  \param C Antoine C coefficients
+  \param first First compound to evaluate
+  \param n Number of compounds
+  \param indices Indices of the compounds in the table, or NULL for compounds 0 to n-1
+  \param T Temperature
+  \param values Receives the values
+*/
+
+static void AntoineScalar(const double *A,const double *B,const double *C,int first,int n,const int *indices,double T,double *values)
+{int i;
+ for (i=first;i<n;i++)
+  {int k=(indices)?indices[i]:i;
+   values[i]=A[k]-B[k]/(C[k]+T);
+  }
+}
+
+//! Scalar Antoine derivative kernel
+/*!
+  Evaluate the temperature derivative of the vapor pressure, Psat*B*ln(10)/(C+T)^2, for compounds first to n-1
+  \param C Antoine C coefficients
+  \param Bln10 Antoine B coefficients times ln(10)
+  \param first First compound to evaluate
+  \param n Number of compounds
+  \param indices Indices of the compounds in the table, or NULL for compounds 0 to n-1
+  \param T Temperature
+  \param pSat Vapor pressures at T
+  \param values Receives the values
+*/
+
+static void AntoineDTScalar(const double *C,const double *Bln10,int first,int n,const int *indices,double T,const double *pSat,double *values)
+{int i;
+ for (i=first;i<n;i++)
+  {int k=(indices)?indices[i]:i;
+   double d=C[k]+T;
+   values[i]=pSat[i]*Bln10[k]/(d*d);
+  }
+}
+
+#ifdef CORRELATIONTABLE_SIMD
+
+//! Load 4 coefficients for AVX2 kernels
+TARGET_AVX2 static inline __m256d Load4(const double *c,const int *indices,int i,__m128i idx)
+{return (indices)?_mm256_i32gather_pd(c,idx,8):_mm256_loadu_pd(c+i);
+}
+
+//! AVX2 polynomial kernel
+/*!
+  As PolyScalar(), for 4 compounds at a time
+  \sa PolyScalar()
+*/
+
+TARGET_AVX2 static void PolyAVX2(const PolyForm &form,int first,int n,const int *indices,double T,double logT,double *values)
+{int i;
+ //local copies, as the stores to values could otherwise alias the form
+ const double *c[5]={form.c[0],form.c[1],form.c[2],form.c[3],form.c[4]};
+ const double *logCoef=form.log,*constant=form.constant;
+ int degree=form.degree;
+ bool multiplyT=form.multiplyT;
+ __m256d t=_mm256_set1_pd(T);
+ __m256d lt=_mm256_set1_pd(logT);
+ __m128i idx=_mm_setzero_si128();
+ for (i=first;i+4<=n;i+=4)
+  {if (indices) idx=_mm_loadu_si128((const __m128i *)(indices+i));
+   __m256d h=Load4(c[degree],indices,i,idx);
+   if (degree==4) h=_mm256_add_pd(Load4(c[3],indices,i,idx),_mm256_mul_pd(t,h));
+   h=_mm256_add_pd(Load4(c[2],indices,i,idx),_mm256_mul_pd(t,h));
+   h=_mm256_add_pd(Load4(c[1],indices,i,idx),_mm256_mul_pd(t,h));
+   h=_mm256_add_pd(Load4(c[0],indices,i,idx),_mm256_mul_pd(t,h));
+   if (multiplyT) h=_mm256_mul_pd(t,h);
+   if (logCoef) h=_mm256_add_pd(_mm256_mul_pd(Load4(logCoef,indices,i,idx),lt),h);
+   if (constant) h=_mm256_add_pd(h,Load4(constant,indices,i,idx));
+   _mm256_storeu_pd(values+i,h);
+  }
+ if (i<n) PolyScalar(form,i,n,indices,T,logT,values);
+}
+
+//! AVX2 Antoine exponent kernel
+/*!
+  As AntoineScalar(), for 4 compounds at a time
+  \sa AntoineScalar()
+*/
+
+TARGET_AVX2 static void AntoineAVX2(const double *A,const double *B,const double *C,int first,int n,const int *indices,double T,double *values)
+{int i;
+ __m256d t=_mm256_set1_pd(T);
+ __m128i idx=_mm_setzero_si128();
+ for (i=first;i+4<=n;i+=4)
+  {if (indices) idx=_mm_loadu_si128((const __m128i *)(indices+i));
+   __m256d d=_mm256_add_pd(Load4(C,indices,i,idx),t);
+   _mm256_storeu_pd(values+i,_mm256_sub_pd(Load4(A,indices,i,idx),_mm256_div_pd(Load4(B,indices,i,idx),d)));
+  }
+ if (i<n) AntoineScalar(A,B,C,i,n,indices,T,values);
+}
+
+//! AVX2 Antoine derivative kernel
+/*!
+  As AntoineDTScalar(), for 4 compounds at a time
+  \sa AntoineDTScalar()
+*/
+
+TARGET_AVX2 static void AntoineDTAVX2(const double *C,const double *Bln10,int first,int n,const int *indices,double T,const double *pSat,double *values)
+{int i;
+ __m256d t=_mm256_set1_pd(T);
+ __m128i idx=_mm_setzero_si128();
+ for (i=first;i+4<=n;i+=4)
+  {if (indices) idx=_mm_loadu_si128((const __m128i *)(indices+i));
+   __m256d d=_mm256_add_pd(Load4(C,indices,i,idx),t);
+   __m256d v=_mm256_mul_pd(_mm256_loadu_pd(pSat+i),Load4(Bln10,indices,i,idx));
+   _mm256_storeu_pd(values+i,_mm256_div_pd(v,_mm256_mul_pd(d,d)));
+  }
+ if (i<n) AntoineDTScalar(C,Bln10,i,n,indices,T,pSat,values);
+}
+
+//! Load 8 coefficients for AVX-512 kernels
+TARGET_AVX512 static inline __m512d Load8(const double *c,const int *indices,int i,__m256i idx)
+{return (indices)?_mm512_i32gather_pd(idx,c,8):_mm512_loadu_pd(c+i);
+}
+
+//! AVX-512 polynomial kernel
+/*!
+  As PolyScalar(), for 8 compounds at a time
+  \sa PolyScalar()
+*/
+
+TARGET_AVX512 static void PolyAVX512(const PolyForm &form,int first,int n,const int *indices,double T,double logT,double *values)
+{int i;
+ //local copies, as the stores to values could otherwise alias the form
+ const double *c[5]={form.c[0],form.c[1],form.c[2],form.c[3],form.c[4]};
+ const double *logCoef=form.log,*constant=form.constant;
+ int degree=form.degree;
+ bool multiplyT=form.multiplyT;
+ __m512d t=_mm512_set1_pd(T);
+ __m512d lt=_mm512_set1_pd(logT);
+ __m256i idx=_mm256_setzero_si256();
+ for (i=first;i+8<=n;i+=8)
+  {if (indices) idx=_mm256_loadu_si256((const __m256i *)(indices+i));
+   __m512d h=Load8(c[degree],indices,i,idx);
+   if (degree==4) h=_mm512_add_pd(Load8(c[3],indices,i,idx),_mm512_mul_pd(t,h));
+   h=_mm512_add_pd(Load8(c[2],indices,i,idx),_mm512_mul_pd(t,h));
+   h=_mm512_add_pd(Load8(c[1],indices,i,idx),_mm512_mul_pd(t,h));
+   h=_mm512_add_pd(Load8(c[0],indices,i,idx),_mm512_mul_pd(t,h));
+   if (multiplyT) h=_mm512_mul_pd(t,h);
+   if (logCoef) h=_mm512_add_pd(_mm512_mul_pd(Load8(logCoef,indices,i,idx),lt),h);
+   if (constant) h=_mm512_add_pd(h,Load8(constant,indices,i,idx));
+   _mm512_storeu_pd(values+i,h);
+  }
+ if (i<n) PolyScalar(form,i,n,indices,T,logT,values);
+}
+
+//! AVX-512 Antoine exponent kernel
+/*!
+  As AntoineScalar(), for 8 compounds at a time
+  \sa AntoineScalar()
+*/
+
+TARGET_AVX512 static void AntoineAVX512(const double *A,const double *B,const double *C,int first,int n,const int *indices,double T,double *values)
+{int i;
+ __m512d t=_mm512_set1_pd(T);
+ __m256i idx=_mm256_setzero_si256();
+ for (i=first;i+8<=n;i+=8)
+  {if (indices) idx=_mm256_loadu_si256((const __m256i *)(indices+i));
+   __m512d d=_mm512_add_pd(Load8(C,indices,i,idx),t);
+   _mm512_storeu_pd(values+i,_mm512_sub_pd(Load8(A,indices,i,idx),_mm512_div_pd(Load8(B,indices,i,idx),d)));
+  }
+ if (i<n) AntoineScalar(A,B,C,i,n,indices,T,values);
+}
+
+//! AVX-512 Antoine derivative kernel
+/*!
+  As AntoineDTScalar(), for 8 compounds at a time
+  \sa AntoineDTScalar()
+*/
+
+TARGET_AVX512 static void AntoineDTAVX512(const double *C,const double *Bln10,int first,int n,const int *indices,double T,const double *pSat,double *values)
+{int i;
+ __m512d t=_mm512_set1_pd(T);
+ __m256i idx=_mm256_setzero_si256();
+ for (i=first;i+8<=n;i+=8)
+  {if (indices) idx=_mm256_loadu_si256((const __m256i *)(indices+i));
+   __m512d d=_mm512_add_pd(Load8(C,indices,i,idx),t);
+   __m512d v=_mm512_mul_pd(_mm512_loadu_pd(pSat+i),Load8(Bln10,indices,i,idx));
+   _mm512_storeu_pd(values+i,_mm512_div_pd(v,_mm512_mul_pd(d,d)));
+  }
+ if (i<n) AntoineDTScalar(C,Bln10,i,n,indices,T,pSat,values);
+}
+
+//! Check processor and OS support for an instruction set
+/*!
+  \param kernels Instruction set to check
+  \return True if the kernels can run on this machine
+*/
+
+static bool Supported(CorrelationKernels kernels)
+{switch (kernels)
+  {case ScalarKernels:
+    return true;
+#ifdef __GNUC__
+   case AVX2Kernels:
+    __builtin_cpu_init();
+    return (__builtin_cpu_supports("avx2")!=0);
+   case AVX512Kernels:
+    __builtin_cpu_init();
+    return (__builtin_cpu_supports("avx512f")!=0);
+#else
+   case AVX2Kernels:
+   case AVX512Kernels:
+    {int info[4];
+     unsigned __int64 xcr0;
+     __cpuid(info,0);
+     if (info[0]<7) return false;
+     __cpuid(info,1);
+     if (!(info[2]&(1<<27))) return false; //OSXSAVE
+     xcr0=_xgetbv(0);
+     if ((xcr0&0x6)!=0x6) return false; //SSE and AVX state
+     __cpuidex(info,7,0);
+     if (kernels==AVX2Kernels) return ((info[1]&(1<<5))!=0);
+     if ((xcr0&0xE0)!=0xE0) return false; //AVX-512 state
+     return ((info[1]&(1<<16))!=0);
+    }
+#endif
+   default:
+    break;
+  }
+ return false;
+}
+
+#else
+
+//! Check processor and OS support for an instruction set
+/*!
+  \param kernels Instruction set to check
+  \return True if the kernels can run on this machine
+*/
+
+static bool Supported(CorrelationKernels kernels)
+{return (kernels==ScalarKernels);
+}
+
+#endif
+
+//! Kernel selection
+/*!
+	The kernels in use; initialized to the best kernels that are supported by the processor
+*/
+
+struct KernelSet
+{	CorrelationKernels kernels; /*!< instruction set in use */
+	PolyKernel poly; /*!< polynomial kernel */
+	AntoineKernel antoine; /*!< Antoine exponent kernel */
+	AntoineDTKernel antoineDT; /*!< Antoine derivative kernel */
+
+	//! Select kernels
+	/*!
+	  \param kernels Instruction set to use, must be supported
+	*/
+
+	void Select(CorrelationKernels kernels)
+	{this->kernels=kernels;
+	 switch (kernels)
+	  {
+#ifdef CORRELATIONTABLE_SIMD
+	   case AVX512Kernels:
+	    poly=PolyAVX512;
+	    antoine=AntoineAVX512;
+	    antoineDT=AntoineDTAVX512;
+	    break;
+	   case AVX2Kernels:
+	    poly=PolyAVX2;
+	    antoine=AntoineAVX2;
+	    antoineDT=AntoineDTAVX2;
+	    break;
+#endif
+	   default:
+	    this->kernels=ScalarKernels;
+	    poly=PolyScalar;
+	    antoine=AntoineScalar;
+	    antoineDT=AntoineDTScalar;
+	    break;
+	  }
+	}
+
+	//! Constructor
+	/*!
+	  Select the best supported kernels
+	*/
+
+	KernelSet()
+	{if (Supported(AVX512Kernels)) Select(AVX512Kernels);
+	 else if (Supported(AVX2Kernels)) Select(AVX2Kernels);
+	 else Select(ScalarKernels);
+	}
+
+};
+
+static KernelSet kernelSet; /*!< the kernels in use */
+
+//! Constructor
+/*!
+  Called upon construction of a CorrelationTable instance; the table is empty until Build() is called
+*/
+
+CorrelationTable::CorrelationTable()
+{data=NULL;
+ stride=0;
+ count=0;
+ serial=0;
+ surrogate=NULL;
+}
+
+//! Destructor
+/*!
+  Called upon destruction of a CorrelationTable instance
+*/
+
+CorrelationTable::~CorrelationTable()
+{if (surrogate) delete surrogate;
+ if (data)
+  {
+#ifdef _WIN32
+   _aligned_free(data);
+#else
+   free(data);
+#endif
+  }
+}
+
+//! Build the table
+/*!
+  Copy the coefficients of all correlations of all compounds into the table.
+  Must be called again if the compounds change. The coefficients of compounds
+  of which the correlations are not loaded (see Compound::HasCorrelations())
+  are left zero, and must be copied by Set() once they are loaded.
+  \param compounds The compounds; table index i corresponds to compounds[i]
+*/
+
+void CorrelationTable::Build(const vector<Compound*> &compounds)
+{int i;
+ void *mem;
+ //new serial number, so that stored results of the previous contents are not used
+ serial=NewSerial();
+ if (surrogate)
+  {delete surrogate;
+   surrogate=NULL;
+  }
+ if (data)
+  {
+#ifdef _WIN32
+   _aligned_free(data);
+#else
+   free(data);
+#endif
+   data=NULL;
+  }
+ count=(int)compounds.size();
+ //round up to a cache line, so that each array is 64-byte aligned
+ stride=((size_t)count+7)&~(size_t)7;
+ if (!stride) stride=8;
+#ifdef _WIN32
+ mem=_aligned_malloc(ArrayCount*stride*sizeof(double),64);
+#else
+ if (posix_memalign(&mem,64,ArrayCount*stride*sizeof(double))) mem=NULL;
+#endif
+ if (!mem) throw std::bad_alloc();
+ data=(double*)mem;
+ memset(data,0,ArrayCount*stride*sizeof(double));
+ for (i=0;i<count;i++)
+  if (compounds[i]->HasCorrelations()) Set(i,*compounds[i]);
+}
+
+//! Copy the coefficients of a compound
+/*!
+  Copy the coefficients of all correlations of a single compound into its column
+  of the table. Only the column of this compound is written, so that calculations
+  on other compounds can continue meanwhile; the column must not be in use.
+  \param index Table index of the compound
+  \param compound The compound, of which the correlations are loaded
+  \sa Build(), PropertyPackage::LoadCorrelations()
+*/
+
+void CorrelationTable::Set(int index,const Compound &compound)
+{int k;
+ const Correlation *corr[CorrelationIDCount]={compound.CpCorrelation,compound.HvapCorrelation,compound.liqDensCorrelation};
+ for (k=0;k<CorrelationIDCount;k++)
+  {double *p=data+k*PolyArrayCount*stride+index;
+   p[PolyA*stride]=corr[k]->A;
+   p[PolyB*stride]=corr[k]->B;
+   p[PolyC*stride]=corr[k]->C;
+   p[PolyD*stride]=corr[k]->D;
+   p[PolyE*stride]=corr[k]->E;
+   p[PolyTwoC*stride]=corr[k]->twoC;
+   p[PolyThreeD*stride]=corr[k]->threeD;
+   p[PolyFourE*stride]=corr[k]->fourE;
+   p[PolyHalfB*stride]=corr[k]->halfB;
+   p[PolyThirdC*stride]=corr[k]->thirdC;
+   p[PolyQuarterD*stride]=corr[k]->quarterD;
+   p[PolyFifthE*stride]=corr[k]->fifthE;
+   p[PolyHalfC*stride]=corr[k]->halfC;
+   p[PolyThirdD*stride]=corr[k]->thirdD;
+   p[PolyQuarterE*stride]=corr[k]->quarterE;
+   p[PolyIntConstant*stride]=corr[k]->intConstant;
+   p[PolyIntConstantOverT*stride]=corr[k]->intConstantOverT;
+  }
+ data[AntoineA*stride+index]=compound.pSatCorrelation->A;
+ data[AntoineB*stride+index]=compound.pSatCorrelation->B;
+ data[AntoineC*stride+index]=compound.pSatCorrelation->C;
+ data[AntoineBln10*stride+index]=compound.pSatCorrelation->Bln10;
+}
+
+//! Tabulate the vapor pressures
+/*!
+  Evaluate the vapor pressures from a VaporPressureSurrogate instead of the Antoine
+  equation, or switch back to the Antoine equation. Must be called after Build().
+  \param compounds The compounds, as passed to Build()
+  \param maxRelError Maximum relative error of the vapor pressure; zero or less to evaluate the Antoine equation
+  \sa VaporPressureSurrogate
+*/
+
+void CorrelationTable::Tabulate(const vector<Compound*> &compounds,double maxRelError)
+{serial=NewSerial();
+ if (surrogate)
+  {delete surrogate;
+   surrogate=NULL;
+  }
+ if (maxRelError<=0) return;
+ surrogate=new VaporPressureSurrogate;
+ surrogate->Build(compounds,maxRelError);
+}
+
+//! Tabulate the vapor pressures from another table
+/*!
+  Copy the tabulated vapor pressures of a number of compounds from another table, or
+  switch to the Antoine equation if the other table is not tabulated. Must be 
+  called after Build().
+  \param source The table to copy from
+  \param n Number of compounds
+  \param indices Indices of the compounds in source; table index i corresponds to source index indices[i]
+*/
+
+void CorrelationTable::Tabulate(const CorrelationTable &source,int n,const int *indices)
+{serial=NewSerial();
+ if (surrogate)
+  {delete surrogate;
+   surrogate=NULL;
+  }
+ if (!source.surrogate) return;
+ surrogate=new VaporPressureSurrogate;
+ surrogate->Build(*source.surrogate,n,indices);
+}
+
+//! New serial number
+/*!
+  \return A serial number that differs from all serial numbers returned before
+*/
+
+unsigned long CorrelationTable::NewSerial()
+{unsigned long s;
+ static unsigned long serialCount=0;
+ theLock.Lock();
+ s=++serialCount;
+ theLock.Unlock();
+ return s;
+}
+
+//! Get the coefficient data
+/*!
+  Get the start of the coefficient data for evaluating a number of compounds. If the
+  compound indices are a consecutive range, they are set to NULL and the returned
+  data starts at the first compound of the range, so that the kernels can use 
+  contiguous loads in stead of gathers.
+  \param indices Compound indices, may be modified
+  \param n Number of compounds
+  \return Start of the data; coefficient array k starts at k*stride from here
+*/
+
+const double *CorrelationTable::Data(const int *&indices,int n) const
+{int i;
+ if ((indices)&&(n>0))
+  {for (i=1;i<n;i++) if (indices[i]!=indices[0]+i) break;
+   if (i==n)
+    {const double *c=data+indices[0];
+     indices=NULL;
+     return c;
+    }
+  }
+ return data;
+}
+
+//! Value
+/*!
+  Gets values of a correlation at specific temperature for a number of compounds,
+  as Correlation::Value()
+  \param id The correlation
+  \param n Number of compounds
+  \param indices Indices of the compounds, or NULL for compounds 0 to n-1
+  \param T Temperature
+  \param values Receives n property values
+  \sa Correlation::Value()
+*/
+
+void CorrelationTable::Value(CorrelationID id,int n,const int *indices,double T,double *values) const
+{PolyForm form;
+ int base=id*PolyArrayCount;
+ const double *c=Data(indices,n);
+ form.c[0]=c+(base+PolyA)*stride;
+ form.c[1]=c+(base+PolyB)*stride;
+ form.c[2]=c+(base+PolyC)*stride;
+ form.c[3]=c+(base+PolyD)*stride;
+ form.c[4]=c+(base+PolyE)*stride;
+ form.degree=4;
+ form.multiplyT=false;
+ form.log=form.constant=NULL;
+ kernelSet.poly(form,0,n,indices,T,0,values);
+}
+
+//! ValueDT
+/*!
+  Gets temperature derivatives of a correlation at specific temperature for a number
+  of compounds, as Correlation::ValueDT()
+  \param id The correlation
+  \param n Number of compounds
+  \param indices Indices of the compounds, or NULL for compounds 0 to n-1
+  \param T Temperature
+  \param values Receives n temperature derivatives
+  \sa Correlation::ValueDT()
+*/
+
+void CorrelationTable::ValueDT(CorrelationID id,int n,const int *indices,double T,double *values) const
+{PolyForm form;
+ int base=id*PolyArrayCount;
+ const double *c=Data(indices,n);
+ form.c[0]=c+(base+PolyB)*stride;
+ form.c[1]=c+(base+PolyTwoC)*stride;
+ form.c[2]=c+(base+PolyThreeD)*stride;
+ form.c[3]=c+(base+PolyFourE)*stride;
+ form.c[4]=NULL;
+ form.degree=3;
+ form.multiplyT=false;
+ form.log=form.constant=NULL;
+ kernelSet.poly(form,0,n,indices,T,0,values);
+}
+
+//! IntValue
+/*!
+  Gets the integrals of a correlation from reference temperature to T for a number
+  of compounds, as Correlation::IntValue()
+  \param id The correlation
+  \param n Number of compounds
+  \param indices Indices of the compounds, or NULL for compounds 0 to n-1
+  \param T Temperature
+  \param values Receives n integrals
+  \sa Correlation::IntValue()
+*/
+
+void CorrelationTable::IntValue(CorrelationID id,int n,const int *indices,double T,double *values) const
+{PolyForm form;
+ int base=id*PolyArrayCount;
+ const double *c=Data(indices,n);
+ form.c[0]=c+(base+PolyA)*stride;
+ form.c[1]=c+(base+PolyHalfB)*stride;
+ form.c[2]=c+(base+PolyThirdC)*stride;
+ form.c[3]=c+(base+PolyQuarterD)*stride;
+ form.c[4]=c+(base+PolyFifthE)*stride;
+ form.degree=4;
+ form.multiplyT=true;
+ form.log=NULL;
+ form.constant=c+(base+PolyIntConstant)*stride;
+ kernelSet.poly(form,0,n,indices,T,0,values);
+}
+
+//! IntValueOverT
+/*!
+  Gets the integrals of a correlation divided by T from reference temperature to T
+  for a number of compounds, as Correlation::IntValueOverT()
+  \param id The correlation
+  \param n Number of compounds
+  \param indices Indices of the compounds, or NULL for compounds 0 to n-1
+  \param T Temperature
+  \param values Receives n integrals
+  \sa Correlation::IntValueOverT()
+*/
+
+void CorrelationTable::IntValueOverT(CorrelationID id,int n,const int *indices,double T,double *values) const
+{PolyForm form;
+ int base=id*PolyArrayCount;
+ const double *c=Data(indices,n);
+ form.c[0]=c+(base+PolyB)*stride;
+ form.c[1]=c+(base+PolyHalfC)*stride;
+ form.c[2]=c+(base+PolyThirdD)*stride;
+ form.c[3]=c+(base+PolyQuarterE)*stride;
+ form.c[4]=NULL;
+ form.degree=3;
+ form.multiplyT=true;
+ form.log=c+(base+PolyA)*stride;
+ form.constant=c+(base+PolyIntConstantOverT)*stride;
+ kernelSet.poly(form,0,n,indices,T,log(T),values);
+}
+
+//! Vapor pressure
+/*!
+  Gets the vapor pressures at specific temperature for a number of compounds,
+  as Antoine::Value(), or from the surrogate if the table is tabulated
+  \param n Number of compounds
+  \param indices Indices of the compounds, or NULL for compounds 0 to n-1
+  \param T Temperature / K
+  \param values Receives n vapor pressures / Pa
+  \sa Antoine::Value()
+*/
+
+void CorrelationTable::PSat(int n,const int *indices,double T,double *values) const
+{int i;
+ double x;
+ const int *tableIndices=indices;
+ const double *c=Data(indices,n);
+ if (surrogate)
+  {x=1.0/T;
+   for (i=0;i<n;i++)
+    if (!surrogate->Value((tableIndices)?tableIndices[i]:i,x,values[i]))
+     {int k=(indices)?indices[i]:i;
+      values[i]=pow(10,c[AntoineA*stride+k]-c[AntoineB*stride+k]/(c[AntoineC*stride+k]+T));
+     }
+   return;
+  }
+ kernelSet.antoine(c+AntoineA*stride,c+AntoineB*stride,c+AntoineC*stride,0,n,indices,T,values);
+ for (i=0;i<n;i++) values[i]=pow(10,values[i]);
+}
+
+//! Vapor pressure temperature derivative
+/*!
+  Gets the temperature derivatives of the vapor pressure at specific temperature for
+  a number of compounds, as Antoine::ValueDT(), from the given vapor pressures; if
+  the table is tabulated, these are the tabulated vapor pressures, and the derivatives
+  have the same relative error
+  \param n Number of compounds
+  \param indices Indices of the compounds, or NULL for compounds 0 to n-1
+  \param T Temperature / K
+  \param pSat Vapor pressures at T, as obtained from PSat()
+  \param values Receives n temperature derivatives of the vapor pressure / Pa/K; may be the same array as pSat
+  \sa Antoine::ValueDT(), PSat()
+*/
+
+void CorrelationTable::PSatDT(int n,const int *indices,double T,const double *pSat,double *values) const
+{const double *c=Data(indices,n);
+ kernelSet.antoineDT(c+AntoineC*stride,c+AntoineBln10*stride,0,n,indices,T,pSat,values);
+}
+
+//! Kernels in use
+/*!
+  \return The instruction set of the kernels in use
+  \sa SetKernels()
+*/
+
+CorrelationKernels CorrelationTable::Kernels()
+{return kernelSet.kernels;
+}
+
+//! Select kernels
+/*!
+  Select the instruction set of the kernels. By default, the best instruction set
+  supported by the processor is used. Affects all tables; must not be called while
+  calculations are running.
+  \param kernels Instruction set to use
+  \return False if the instruction set is not supported by this build or processor
+  \sa Kernels()
+*/
+
+bool CorrelationTable::SetKernels(CorrelationKernels kernels)
+{if (!Supported(kernels)) return false;
+ kernelSet.Select(kernels);
+ return (kernelSet.kernels==kernels);
+}
+
+//! Name of an instruction set
+/*!
+  \param kernels Instruction set
+  \return Name of the instruction set
+*/
+
+const char *CorrelationTable::KernelsName(CorrelationKernels kernels)
+{switch (kernels)
+  {case ScalarKernels: return "scalar";
+   case AVX2Kernels: return "avx2";
+   case AVX512Kernels: return "avx512";
+   default: break;
+  }
+ return "unknown";
+}
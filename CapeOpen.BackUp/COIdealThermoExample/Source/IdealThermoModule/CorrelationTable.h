@@ -0,0 +1,114 @@
+#pragma once
+
+//forward declarations
+class Compound; //forward declaration
+class VaporPressureSurrogate; //forward declaration
+
+//! Correlation identifiers
+/*!
+	Identifies one of the polynomial correlations of a Compound
+	\sa CorrelationTable, Correlation
+*/
+
+typedef enum
+{	CpCorrelationID=0,        /*!< Ideal gas heat capacity correlation / J/mol/K */
+	HvapCorrelationID=1,      /*!< Heat of vaporization correlation / J/mol */
+	liqDensCorrelationID=2,   /*!< Liquid density correlation / mol/m3 */
+} CorrelationID;
+
+//! Number of polynomial correlations per compound
+#define CorrelationIDCount 3
+
+//! Correlation kernel instruction sets
+/*!
+	Instruction set used by the CorrelationTable kernels
+	\sa CorrelationTable
+*/
+
+typedef enum
+{	ScalarKernels=0,          /*!< plain C++ */
+	AVX2Kernels=1,            /*!< AVX2, 4 compounds at a time */
+	AVX512Kernels=2,          /*!< AVX-512F, 8 compounds at a time */
+} CorrelationKernels;
+
+//! CorrelationTable class
+/*!
+	Holds the coefficients of the correlations of all compounds of a property
+	package in structure-of-arrays form: for each coefficient, the values of all
+	compounds are stored in a contiguous, 64-byte aligned array. This allows
+	evaluating a correlation for all compounds of a mixture at once, using SIMD
+	kernels where the processor supports these.
+
+	The kernels are selected at run time. The SIMD kernels do not use fused
+	multiply-add and evaluate the polynomials in the same order as Correlation
+	and Antoine, so that all kernels return identical results.
+
+	The vapor pressure itself is obtained by calling pow() for each compound;
+	the Antoine exponent and derivative are evaluated by the kernels. Optionally,
+	the vapor pressures are evaluated from a VaporPressureSurrogate instead, 
+	trading a controlled error for speed.
+
+	The table is built after the compounds of a property package are loaded
+	and is not modified by calculations.
+
+	\sa Correlation, Antoine, PropertyPackage
+*/
+
+class CorrelationTable
+{public:
+
+	//construction and destruction
+	CorrelationTable();
+	~CorrelationTable();
+
+	//functions
+	void Build(const vector<Compound*> &compounds);
+	void Set(int index,const Compound &compound);
+	void Value(CorrelationID id,int n,const int *indices,double T,double *values) const;
+	void ValueDT(CorrelationID id,int n,const int *indices,double T,double *values) const;
+	void IntValue(CorrelationID id,int n,const int *indices,double T,double *values) const;
+	void IntValueOverT(CorrelationID id,int n,const int *indices,double T,double *values) const;
+	void PSat(int n,const int *indices,double T,double *values) const;
+	void PSatDT(int n,const int *indices,double T,const double *pSat,double *values) const;
+
+	//! Serial number
+	/*!
+	  \return A number that identifies the contents of the table; it is unique for each call to Build()
+	  \sa PureComponentCache
+	*/
+
+	unsigned long Serial() const {return serial;}
+
+	//tabulated vapor pressures
+	void Tabulate(const vector<Compound*> &compounds,double maxRelError);
+	void Tabulate(const CorrelationTable &source,int n,const int *indices);
+
+	//! Vapor pressure surrogate
+	/*!
+	  \return The surrogate of the vapor pressures, or NULL if the Antoine equation is evaluated
+	  \sa Tabulate()
+	*/
+
+	const VaporPressureSurrogate *Surrogate() const {return surrogate;}
+
+	//kernel selection
+	static CorrelationKernels Kernels();
+	static bool SetKernels(CorrelationKernels kernels);
+	static const char *KernelsName(CorrelationKernels kernels);
+
+private:
+
+	double *data; /*!< aligned storage for all coefficient arrays */
+	size_t stride; /*!< distance between coefficient arrays, in doubles */
+	int count; /*!< number of compounds */
+	unsigned long serial; /*!< serial number, set by Build() and Tabulate() */
+	VaporPressureSurrogate *surrogate; /*!< tabulated vapor pressures, or NULL */
+
+	//no copies
+	CorrelationTable(const CorrelationTable &);
+	CorrelationTable &operator=(const CorrelationTable &);
+
+	const double *Data(const int *&indices,int n) const;
+	static unsigned long NewSerial();
+
+};
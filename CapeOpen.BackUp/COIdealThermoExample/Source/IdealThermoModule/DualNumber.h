@@ -0,0 +1,133 @@
+#pragma once
+
+//! DualNumber class
+/*!
+	Forward-mode dual number with derivatives to temperature and pressure.
+
+	The mixture property kernels of PropertyPackage are templates over their
+	scalar type. Instantiated with double they produce a value; instantiated
+	with DualNumber they produce the value and its temperature and pressure
+	derivatives in the same sweep, so that the derivative properties (EnthalpyDT,
+	DensityDP, LogFugacityCoefficientDT, ...) follow from the same expressions
+	as the values and cannot get out of sync with them.
+
+	Temperature and pressure enter a kernel as Variable() values; temperature
+	dependent pure component quantities, of which the derivative is evaluated
+	from the correlations, enter by PureComponent(). The composition derivatives
+	are linear in the ideal models, and are not carried.
+
+	\code
+	DualNumber T=DualNumber::Variable(T0,1,0);
+	DualNumber P=DualNumber::Variable(P0,0,1);
+	DualNumber V=GAS_CONSTANT*T/P; //V.dT and V.dP are the derivatives
+	\endcode
+
+	\sa PureComponent()
+*/
+
+class DualNumber
+{public:
+
+	double value; /*!< the value */
+	double dT; /*!< derivative to temperature */
+	double dP; /*!< derivative to pressure */
+
+	//! Default constructor, the value is not initialized
+	DualNumber() {}
+
+	//! Constant
+	/*!
+	  \param value The value; both derivatives are zero
+	*/
+
+	DualNumber(double value) : value(value),dT(0),dP(0) {}
+
+	//! Independent or dependent variable
+	/*!
+	  \param value The value
+	  \param dT Derivative to temperature
+	  \param dP Derivative to pressure
+	  \return The dual number
+	*/
+
+	static DualNumber Variable(double value,double dT,double dP)
+	{DualNumber d;
+	 d.value=value;
+	 d.dT=dT;
+	 d.dP=dP;
+	 return d;
+	}
+
+	DualNumber &operator+=(const DualNumber &b) {value+=b.value;dT+=b.dT;dP+=b.dP;return *this;}
+	DualNumber &operator-=(const DualNumber &b) {value-=b.value;dT-=b.dT;dP-=b.dP;return *this;}
+	DualNumber &operator*=(const DualNumber &b) {dT=dT*b.value+value*b.dT;dP=dP*b.value+value*b.dP;value*=b.value;return *this;}
+	DualNumber &operator/=(const DualNumber &b) {double inv=1.0/b.value;value*=inv;dT=(dT-value*b.dT)*inv;dP=(dP-value*b.dP)*inv;return *this;}
+
+};
+
+inline DualNumber operator-(const DualNumber &a) {return DualNumber::Variable(-a.value,-a.dT,-a.dP);}
+inline DualNumber operator+(DualNumber a,const DualNumber &b) {return a+=b;}
+inline DualNumber operator-(DualNumber a,const DualNumber &b) {return a-=b;}
+inline DualNumber operator*(DualNumber a,const DualNumber &b) {return a*=b;}
+inline DualNumber operator/(DualNumber a,const DualNumber &b) {return a/=b;}
+inline DualNumber operator*(double a,const DualNumber &b) {return DualNumber::Variable(a*b.value,a*b.dT,a*b.dP);}
+inline DualNumber operator*(const DualNumber &a,double b) {return DualNumber::Variable(a.value*b,a.dT*b,a.dP*b);}
+
+//! Natural logarithm of a dual number
+inline DualNumber log(const DualNumber &a) {double inv=1.0/a.value;return DualNumber::Variable(log(a.value),a.dT*inv,a.dP*inv);}
+
+//! Value of a dual number, or of a double
+inline double ValueOf(double a) {return a;}
+
+//! Value of a dual number, or of a double
+inline double ValueOf(const DualNumber &a) {return a.value;}
+
+//! Pure component quantity as a double
+/*!
+  Temperature dependent pure component quantity of compound j, as used by the
+  templated kernels instantiated with double
+  \param s Receives the quantity
+  \param values Quantity of each compound
+  \param valuesDT Temperature derivative of each compound; not used
+  \param j Compound index
+*/
+
+inline void PureComponent(double &s,const double *values,const double * /*valuesDT*/,int j) {s=values[j];}
+
+//! Pure component quantity as a dual number
+/*!
+  Temperature dependent pure component quantity of compound j, as used by the
+  templated kernels instantiated with DualNumber
+  \param s Receives the quantity and its temperature derivative
+  \param values Quantity of each compound
+  \param valuesDT Temperature derivative of each compound
+  \param j Compound index
+*/
+
+inline void PureComponent(DualNumber &s,const double *values,const double *valuesDT,int j) {s=DualNumber::Variable(values[j],valuesDT[j],0);}
+
+//! Pure component quantity with a scaled derivative as a double
+/*!
+  As PureComponent(), for a quantity of which the temperature derivative is
+  valuesDT[j]*scaleDT, such as the integral of Cp/T with derivative Cp/T
+  \param s Receives the quantity
+  \param values Quantity of each compound
+  \param valuesDT Unscaled temperature derivative of each compound; not used
+  \param j Compound index
+  \param scaleDT Scale factor of the temperature derivative; not used
+*/
+
+inline void PureComponent(double &s,const double *values,const double * /*valuesDT*/,int j,double /*scaleDT*/) {s=values[j];}
+
+//! Pure component quantity with a scaled derivative as a dual number
+/*!
+  As PureComponent(), for a quantity of which the temperature derivative is
+  valuesDT[j]*scaleDT, such as the integral of Cp/T with derivative Cp/T
+  \param s Receives the quantity and its temperature derivative
+  \param values Quantity of each compound
+  \param valuesDT Unscaled temperature derivative of each compound
+  \param j Compound index
+  \param scaleDT Scale factor of the temperature derivative
+*/
+
+inline void PureComponent(DualNumber &s,const double *values,const double *valuesDT,int j,double scaleDT) {s=DualNumber::Variable(values[j],valuesDT[j]*scaleDT,0);}
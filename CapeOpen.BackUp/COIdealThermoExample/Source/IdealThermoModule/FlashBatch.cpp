@@ -0,0 +1,461 @@
+#include "stdafx.h"
+#include "FlashBatch.h"
+#include "PropertyPackage.h"
+#include <algorithm>
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+//! FlashBatchWorker class
+/*!
+	State of a single worker of a FlashBatch: its workspace, the range
+	of items it has yet to calculate, the errors of the items it failed,
+	and the thread and synchronization objects. Worker 0 is the thread
+	that calls FlashBatch::Flash() and has no thread of its own.
+
+	The item range is protected by the mutex, as other workers may steal
+	items from it.
+
+	\sa FlashBatch
+*/
+
+class FlashBatchWorker
+{public:
+
+	FlashBatch *batch; /*!< the batch this worker belongs to */
+	int index; /*!< index of this worker */
+	PropertyWorkspace ws; /*!< workspace for the calculations of this worker */
+	int next; /*!< next item to calculate */
+	int end; /*!< end of range of items to calculate */
+	vector<int> failedItems; /*!< items that failed in the current batch */
+	vector<string> failedItemErrors; /*!< errors of items that failed in the current batch */
+	bool quit; /*!< set to terminate the thread */
+#ifdef _WIN32
+	CRITICAL_SECTION mutex; /*!< protects the item range */
+	HANDLE thread; /*!< worker thread */
+	HANDLE startEvent; /*!< set to start working on a batch */
+	HANDLE doneEvent; /*!< set by worker upon completion of a batch */
+#else
+	pthread_mutex_t mutex; /*!< protects the item range and the start and done flags */
+	pthread_cond_t startCond; /*!< signalled to start working on a batch */
+	pthread_cond_t doneCond; /*!< signalled by worker upon completion of a batch */
+	pthread_t thread; /*!< worker thread */
+	bool start; /*!< set to start working on a batch */
+	bool done; /*!< set by worker upon completion of a batch */
+#endif
+
+	//! Constructor
+	/*!
+	  Called upon construction of a FlashBatchWorker instance; does not create the thread
+	  \param batch The batch this worker belongs to
+	  \param index Index of this worker
+	*/
+
+	FlashBatchWorker(FlashBatch *batch,int index)
+	{this->batch=batch;
+	 this->index=index;
+	 next=end=0;
+	 quit=false;
+#ifdef _WIN32
+	 InitializeCriticalSection(&mutex);
+	 thread=startEvent=doneEvent=NULL;
+#else
+	 pthread_mutex_init(&mutex,NULL);
+	 pthread_cond_init(&startCond,NULL);
+	 pthread_cond_init(&doneCond,NULL);
+	 start=done=false;
+#endif
+	}
+
+	//! Destructor
+	/*!
+	  Called upon destruction of a FlashBatchWorker instance; the thread must have been stopped
+	*/
+
+	~FlashBatchWorker()
+	{
+#ifdef _WIN32
+	 if (thread) CloseHandle(thread);
+	 if (startEvent) CloseHandle(startEvent);
+	 if (doneEvent) CloseHandle(doneEvent);
+	 DeleteCriticalSection(&mutex);
+#else
+	 pthread_cond_destroy(&doneCond);
+	 pthread_cond_destroy(&startCond);
+	 pthread_mutex_destroy(&mutex);
+#endif
+	}
+
+	//! Lock the item range
+	void Lock()
+	{
+#ifdef _WIN32
+	 EnterCriticalSection(&mutex);
+#else
+	 pthread_mutex_lock(&mutex);
+#endif
+	}
+
+	//! Unlock the item range
+	void Unlock()
+	{
+#ifdef _WIN32
+	 LeaveCriticalSection(&mutex);
+#else
+	 pthread_mutex_unlock(&mutex);
+#endif
+	}
+
+	//! Create the worker thread
+	/*!
+	  \return True if ok
+	*/
+
+	bool CreateWorkerThread()
+	{
+#ifdef _WIN32
+	 startEvent=CreateEvent(NULL,FALSE,FALSE,NULL);
+	 doneEvent=CreateEvent(NULL,FALSE,FALSE,NULL);
+	 if ((!startEvent)||(!doneEvent)) return false;
+	 thread=::CreateThread(NULL,0,ThreadProc,this,0,NULL);
+	 return (thread!=NULL);
+#else
+	 return (pthread_create(&thread,NULL,ThreadProc,this)==0);
+#endif
+	}
+
+	//! Start calculation of a batch on the worker thread
+	void Start()
+	{
+#ifdef _WIN32
+	 SetEvent(startEvent);
+#else
+	 pthread_mutex_lock(&mutex);
+	 start=true;
+	 pthread_cond_signal(&startCond);
+	 pthread_mutex_unlock(&mutex);
+#endif
+	}
+
+	//! Wait for the worker thread to complete a batch
+	void Wait()
+	{
+#ifdef _WIN32
+	 WaitForSingleObject(doneEvent,INFINITE);
+#else
+	 pthread_mutex_lock(&mutex);
+	 while (!done) pthread_cond_wait(&doneCond,&mutex);
+	 done=false;
+	 pthread_mutex_unlock(&mutex);
+#endif
+	}
+
+	//! Terminate the worker thread and wait for it to exit
+	void Stop()
+	{quit=true;
+#ifdef _WIN32
+	 SetEvent(startEvent);
+	 WaitForSingleObject(thread,INFINITE);
+#else
+	 Start();
+	 pthread_join(thread,NULL);
+#endif
+	}
+
+	//! Worker thread
+	/*!
+	  Waits for a batch to be started, works on it, and signals completion, until quit is set
+	  \param param The FlashBatchWorker
+	*/
+
+#ifdef _WIN32
+	static DWORD WINAPI ThreadProc(LPVOID param)
+#else
+	static void *ThreadProc(void *param)
+#endif
+	{FlashBatchWorker *worker=(FlashBatchWorker *)param;
+	 for (;;)
+	  {
+#ifdef _WIN32
+	   WaitForSingleObject(worker->startEvent,INFINITE);
+#else
+	   pthread_mutex_lock(&worker->mutex);
+	   while (!worker->start) pthread_cond_wait(&worker->startCond,&worker->mutex);
+	   worker->start=false;
+	   pthread_mutex_unlock(&worker->mutex);
+#endif
+	   if (worker->quit) break;
+	   worker->batch->Work(worker->index);
+#ifdef _WIN32
+	   SetEvent(worker->doneEvent);
+#else
+	   pthread_mutex_lock(&worker->mutex);
+	   worker->done=true;
+	   pthread_cond_signal(&worker->doneCond);
+	   pthread_mutex_unlock(&worker->mutex);
+#endif
+	  }
+	 return 0;
+	}
+
+};
+
+//! Constructor
+/*!
+  Called upon construction of a FlashBatch instance; creates the worker threads
+  \param package Property package on which to perform the flashes. Must have been loaded
+  \param threadCount Number of threads, including the calling thread. If zero or negative, the number of processors is used
+*/
+
+FlashBatch::FlashBatch(const PropertyPackage *package,int threadCount)
+{int i;
+ this->package=package;
+ lastError="No error";
+ if (threadCount<=0)
+  {//use all processors
+#ifdef _WIN32
+   SYSTEM_INFO info;
+   GetSystemInfo(&info);
+   threadCount=(int)info.dwNumberOfProcessors;
+#else
+   threadCount=(int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+   if (threadCount<1) threadCount=1;
+  }
+ workers.push_back(new FlashBatchWorker(this,0)); //the calling thread
+ for (i=1;i<threadCount;i++)
+  {FlashBatchWorker *worker=new FlashBatchWorker(this,i);
+   if (!worker->CreateWorkerThread())
+    {//continue with the workers we have
+     delete worker;
+     break;
+    }
+   workers.push_back(worker);
+  }
+}
+
+//! Destructor
+/*!
+  Called upon destruction of a FlashBatch instance; terminates the worker threads
+*/
+
+FlashBatch::~FlashBatch()
+{int i;
+ for (i=1;i<(int)workers.size();i++) workers[i]->Stop();
+ for (i=0;i<(int)workers.size();i++) delete workers[i];
+}
+
+//! Number of threads
+/*!
+  \return The number of threads that perform the flashes, including the calling thread
+*/
+
+int FlashBatch::ThreadCount()
+{return (int)workers.size();
+}
+
+//! Return the last error
+/*!
+  Returns the error message of the last call to Flash() that failed as a whole.
+  Errors of individual items are obtained from ItemError()
+  \sa ItemError()
+*/
+
+const char *FlashBatch::LastError()
+{return lastError.c_str();
+}
+
+//! Perform a batch of flash calculations
+/*!
+  Perform itemCount independent flash calculations, distributed over the worker threads.
+  All items share the compounds and the allowed phases, each item has its own composition,
+  flash type and specifications. Output arrays are provided by the caller. For each item,
+  PhaseCount (2) slots are reserved for phase results, of which the first phaseCounts[i]
+  are filled in.
+
+  Failure of individual items does not cause the batch to fail; their status is set to
+  BatchItemFailed, their phase count to zero, and their error is available from ItemError().
+
+  \param itemCount Number of flashes
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param X Overall mole fractions[mol/mol]; nComp values for each item, item i starts at X[i*nComp]
+  \param types Flash type for each item
+  \param phaseType Specified allowed phases in flash, for all items
+  \param spec1 Value of first specification for each item (e.g. T/[K] for TP)
+  \param spec2 Value of second specification for each item (e.g. P/[Pa] for TP)
+  \param phaseCounts Receives the number of phases at equilibrium for each item
+  \param phases Receives the types of the existing phases; PhaseCount values for each item, item i starts at phases[i*PhaseCount]
+  \param phaseFractions Receives the phase fractions of the existing phases [mol/mol]; PhaseCount values for each item
+  \param phaseCompositions Receives the compositions of the existing phases [mol/mol]; PhaseCount*nComp values for each item, phase j of item i starts at phaseCompositions[(i*PhaseCount+j)*nComp]
+  \param T Receives the temperature at equilibrium for each item
+  \param P Receives the pressure at equilibrium for each item
+  \param status Receives the status for each item
+  \return True if the batch was calculated, false in case of invalid arguments (including invalid compound indices)
+  \sa ItemError(), FailureCount(), LastError(), PropertyPackage::Flash()
+*/
+
+bool FlashBatch::Flash(int itemCount,int nComp,const int *compIndices,const double *X,const FlashType *types,FlashPhaseType phaseType,const double *spec1,const double *spec2,int *phaseCounts,Phase *phases,double *phaseFractions,double *phaseCompositions,double *T,double *P,BatchItemStatus *status)
+{int i,j,workerCount;
+ failedItems.clear();
+ failedItemErrors.clear();
+ if (itemCount<0)
+  {lastError="Item count cannot be negative";
+   return false;
+  }
+ if (nComp<1)
+  {lastError="Mixture must contain at least one compound";
+   return false;
+  }
+ if (itemCount==0) return true;
+ if ((!compIndices)||(!X)||(!types)||(!spec1)||(!spec2)||(!phaseCounts)||(!phases)||(!phaseFractions)||(!phaseCompositions)||(!T)||(!P)||(!status))
+  {lastError="Missing argument";
+   return false;
+  }
+ //check and prepare the compounds once for all items
+ if (!package->PrepareMixture(workers[0]->ws,nComp,compIndices,mixture))
+  {lastError=workers[0]->ws.LastError();
+   return false;
+  }
+ //store the batch
+ this->nComp=nComp;
+ this->X=X;
+ this->types=types;
+ this->phaseType=phaseType;
+ this->spec1=spec1;
+ this->spec2=spec2;
+ this->phaseCounts=phaseCounts;
+ this->phases=phases;
+ this->phaseFractions=phaseFractions;
+ this->phaseCompositions=phaseCompositions;
+ this->T=T;
+ this->P=P;
+ this->status=status;
+ //divide the items evenly over the workers
+ workerCount=(int)workers.size();
+ for (i=0;i<workerCount;i++)
+  {FlashBatchWorker *worker=workers[i];
+   worker->next=(int)(((double)itemCount*i)/workerCount);
+   worker->end=(int)(((double)itemCount*(i+1))/workerCount);
+   worker->failedItems.clear();
+   worker->failedItemErrors.clear();
+  }
+ //calculate
+ for (i=1;i<workerCount;i++) workers[i]->Start();
+ Work(0);
+ for (i=1;i<workerCount;i++) workers[i]->Wait();
+ //collect the errors, in order of item index
+ vector<pair<int,const string*> > failures;
+ for (i=0;i<workerCount;i++)
+  for (j=0;j<(int)workers[i]->failedItems.size();j++)
+   failures.push_back(pair<int,const string*>(workers[i]->failedItems[j],&workers[i]->failedItemErrors[j]));
+ if (failures.size())
+  {sort(failures.begin(),failures.end());
+   failedItems.resize(failures.size());
+   failedItemErrors.resize(failures.size());
+   for (i=0;i<(int)failures.size();i++)
+    {failedItems[i]=failures[i].first;
+     failedItemErrors[i]=*failures[i].second;
+    }
+  }
+ return true;
+}
+
+//! Number of failed items
+/*!
+  \return The number of items that failed in the last call to Flash()
+  \sa ItemError()
+*/
+
+int FlashBatch::FailureCount()
+{return (int)failedItems.size();
+}
+
+//! Error of a failed item
+/*!
+  Get the error message of an item that failed in the last call to Flash()
+  \param index Index of the item
+  \return The error message, or NULL if the item did not fail
+  \sa FailureCount()
+*/
+
+const char *FlashBatch::ItemError(int index)
+{vector<int>::iterator it=lower_bound(failedItems.begin(),failedItems.end(),index);
+ if ((it==failedItems.end())||(*it!=index)) return NULL;
+ return failedItemErrors[it-failedItems.begin()].c_str();
+}
+
+//! Get the next item to calculate
+/*!
+  Get the next item from the range of the worker. If the range of the worker is
+  exhausted, half of the remaining range of another worker is taken over.
+  \param workerIndex Index of the worker
+  \param itemIndex Receives the index of the item to calculate
+  \return False if there are no more items
+*/
+
+bool FlashBatch::NextItem(int workerIndex,int &itemIndex)
+{int i,workerCount;
+ FlashBatchWorker *worker=workers[workerIndex];
+ worker->Lock();
+ if (worker->next<worker->end)
+  {itemIndex=worker->next++;
+   worker->Unlock();
+   return true;
+  }
+ worker->Unlock();
+ //steal from the back of another worker's range
+ workerCount=(int)workers.size();
+ for (i=1;i<workerCount;i++)
+  {FlashBatchWorker *victim=workers[(workerIndex+i)%workerCount];
+   int count,first;
+   victim->Lock();
+   count=(victim->end-victim->next+1)/2;
+   if (count>0)
+    {first=victim->end-count;
+     victim->end=first;
+     victim->Unlock();
+     itemIndex=first;
+     worker->Lock();
+     worker->next=first+1;
+     worker->end=first+count;
+     worker->Unlock();
+     return true;
+    }
+   victim->Unlock();
+  }
+ return false;
+}
+
+//! Calculate a single item
+/*!
+  Flash an item using the workspace of a worker and store the results
+  \param worker The worker that calculates the item
+  \param itemIndex Index of the item
+*/
+
+void FlashBatch::FlashItem(FlashBatchWorker *worker,int itemIndex)
+{size_t offset=(size_t)itemIndex*PhaseCount;
+ //the results are written directly into the batch outputs
+ if (!package->Flash(worker->ws,mixture,X+(size_t)itemIndex*nComp,types[itemIndex],phaseType,spec1[itemIndex],spec2[itemIndex],phaseCounts[itemIndex],phases+offset,phaseFractions+offset,phaseCompositions+offset*nComp,T[itemIndex],P[itemIndex]))
+  {phaseCounts[itemIndex]=0;
+   status[itemIndex]=BatchItemFailed;
+   worker->failedItems.push_back(itemIndex);
+   worker->failedItemErrors.push_back(worker->ws.LastError());
+   return;
+  }
+ status[itemIndex]=BatchItemOK;
+}
+
+//! Work on the current batch
+/*!
+  Calculate items until no items are left
+  \param workerIndex Index of the worker
+*/
+
+void FlashBatch::Work(int workerIndex)
+{int itemIndex;
+ FlashBatchWorker *worker=workers[workerIndex];
+ while (NextItem(workerIndex,itemIndex)) FlashItem(worker,itemIndex);
+}
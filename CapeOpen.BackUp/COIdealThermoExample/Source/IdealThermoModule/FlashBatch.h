@@ -0,0 +1,82 @@
+#pragma once
+#include "Properties.h"
+#include "PreparedMixture.h"
+
+//forward declarations
+class PropertyPackage; //forward declaration
+class FlashBatchWorker; //forward declaration, defined in FlashBatch.cpp
+
+//! FlashBatch class
+/*!
+	Performs a batch of independent flash calculations on a single property
+	package, using a pool of worker threads. The threads are created once,
+	upon construction, and are re-used for each call to Flash(). The thread
+	that calls Flash() is one of the workers.
+
+	The compounds are checked and prepared once per batch (see PreparedMixture),
+	after which all items are flashed on the prepared mixture.
+
+	Each worker has its own PropertyWorkspace, so that all workers calculate
+	on the same PropertyPackage. The items of the batch are initially divided
+	evenly over the workers; a worker that runs out of items takes half of the
+	remaining items of another worker (work stealing), so that batches with
+	unevenly expensive items (e.g. some items converge slowly) still keep
+	all workers busy.
+
+	Results are written to caller-provided arrays. Failure of an item does
+	not abort the batch; the status of each item is returned, and the error
+	message of failed items is available from ItemError().
+
+	A FlashBatch object can only be used by one thread at a time. The property
+	package must remain loaded and unmodified during its life time.
+
+	\sa PropertyPackage, PropertyWorkspace
+*/
+
+class FlashBatch
+{public:
+
+	//construction and destruction
+	FlashBatch(const PropertyPackage *package,int threadCount=0);
+	~FlashBatch();
+
+	//functions
+	int ThreadCount();
+	const char *LastError();
+	bool Flash(int itemCount,int nComp,const int *compIndices,const double *X,const FlashType *types,FlashPhaseType phaseType,const double *spec1,const double *spec2,int *phaseCounts,Phase *phases,double *phaseFractions,double *phaseCompositions,double *T,double *P,BatchItemStatus *status);
+	int FailureCount();
+	const char *ItemError(int index);
+
+private:
+
+	//data members
+	const PropertyPackage *package; /*!< the property package that performs the flashes */
+	string lastError; /*!< the last error is stored as text */
+	vector<FlashBatchWorker*> workers; /*!< the workers; worker 0 is the calling thread */
+	vector<int> failedItems; /*!< indices of the failed items of the last batch, in ascending order */
+	vector<string> failedItemErrors; /*!< error messages of the failed items of the last batch */
+
+	//parameters of the running batch
+	int nComp; /*!< number of compounds in each item */
+	PreparedMixture mixture; /*!< compounds, shared by all items */
+	const double *X; /*!< compositions, nComp values per item */
+	const FlashType *types; /*!< flash type per item */
+	FlashPhaseType phaseType; /*!< allowed phases, shared by all items */
+	const double *spec1; /*!< first specification per item */
+	const double *spec2; /*!< second specification per item */
+	int *phaseCounts; /*!< receives phase count per item */
+	Phase *phases; /*!< receives phases, PhaseCount per item */
+	double *phaseFractions; /*!< receives phase fractions, PhaseCount per item */
+	double *phaseCompositions; /*!< receives compositions, PhaseCount*nComp per item */
+	double *T; /*!< receives temperature per item */
+	double *P; /*!< receives pressure per item */
+	BatchItemStatus *status; /*!< receives status per item */
+
+	//workers
+	bool NextItem(int workerIndex,int &itemIndex);
+	void FlashItem(FlashBatchWorker *worker,int itemIndex);
+	void Work(int workerIndex);
+
+	friend class FlashBatchWorker;
+
+};
@@ -0,0 +1,143 @@
+#include "stdafx.h"
+#include "FlashHistory.h"
+
+//! FNV-1a offset basis
+#define FNV_OFFSET 14695981039346656037ULL
+//! FNV-1a prime
+#define FNV_PRIME 1099511628211ULL
+
+//! Add a value to an FNV-1a hash
+/*!
+  \param hash The hash
+  \param value The value to add, byte by byte
+  \return The new hash
+*/
+
+static inline unsigned long long HashValue(unsigned long long hash,unsigned long long value)
+{int i;
+ for (i=0;i<8;i++)
+  {hash^=(value&0xFF);
+   hash*=FNV_PRIME;
+   value>>=8;
+  }
+ return hash;
+}
+
+//! Constructor
+/*!
+  Called upon construction of a FlashHistory instance; the history is disabled until SetSize() is called
+*/
+
+FlashHistory::FlashHistory()
+{useCount=0;
+ hits=misses=fallbacks=0;
+}
+
+//! Set the number of entries
+/*!
+  Set the number of compositions for which the last solution is kept; clears the
+  history. Zero disables the history.
+  \param size Number of entries
+*/
+
+void FlashHistory::SetSize(int size)
+{if (size<0) size=0;
+ entries.clear();
+ entries.resize(size);
+ useCount=0;
+}
+
+//! Get the number of entries
+/*!
+  \return The number of entries; zero if the history is disabled
+*/
+
+int FlashHistory::Size() const
+{return (int)entries.size();
+}
+
+//! Clear the history
+/*!
+  Remove all entries; the counters are not reset
+*/
+
+void FlashHistory::Clear()
+{int i;
+ for (i=0;i<(int)entries.size();i++) entries[i].lastUse=0;
+ useCount=0;
+}
+
+//! Fingerprint of a flash
+/*!
+  Calculate the fingerprint of the compounds and composition of a flash. The 
+  composition is rounded to 1e-6.
+  \param package The property package
+  \param serial Serial number of the compound data of the package, so that entries do not survive reloading
+  \param n Number of compounds
+  \param indices Indices of the compounds in the package
+  \param X Composition
+  \return The fingerprint
+*/
+
+unsigned long long FlashHistory::Fingerprint(const void *package,unsigned long serial,int n,const int *indices,const double *X)
+{int i;
+ unsigned long long hash=FNV_OFFSET;
+ hash=HashValue(hash,(unsigned long long)(size_t)package);
+ hash=HashValue(hash,serial);
+ for (i=0;i<n;i++)
+  {hash=HashValue(hash,(unsigned long long)indices[i]);
+   hash=HashValue(hash,(unsigned long long)floor(X[i]*1e6+0.5));
+  }
+ return hash;
+}
+
+//! Find the last solution for a fingerprint
+/*!
+  \param fingerprint The fingerprint
+  \return The entry, or NULL if not found; valid until the next call to Store()
+*/
+
+const FlashHistoryEntry *FlashHistory::Find(unsigned long long fingerprint)
+{int i;
+ for (i=0;i<(int)entries.size();i++)
+  if ((entries[i].lastUse)&&(entries[i].fingerprint==fingerprint))
+   {entries[i].lastUse=++useCount;
+    hits++;
+    return &entries[i];
+   }
+ misses++;
+ return NULL;
+}
+
+//! Store a solution
+/*!
+  Store the converged solution for a fingerprint, replacing the previous solution 
+  for the fingerprint, or else the least recently used entry
+  \param fingerprint The fingerprint
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param VF Vapor phase fraction [mol/mol]
+*/
+
+void FlashHistory::Store(unsigned long long fingerprint,double T,double P,double VF)
+{int i;
+ FlashHistoryEntry *entry=NULL;
+ if (entries.empty()) return;
+ for (i=0;i<(int)entries.size();i++)
+  if ((entries[i].lastUse)&&(entries[i].fingerprint==fingerprint))
+   {entry=&entries[i];
+    entry->dT=fabs(T-entry->T);
+    break;
+   }
+ if (!entry)
+  {//replace the least recently used entry; unused entries have lastUse zero
+   entry=&entries[0];
+   for (i=1;i<(int)entries.size();i++) if (entries[i].lastUse<entry->lastUse) entry=&entries[i];
+   entry->fingerprint=fingerprint;
+   entry->dT=0;
+  }
+ entry->T=T;
+ entry->P=P;
+ entry->VF=VF;
+ entry->lastUse=++useCount;
+}
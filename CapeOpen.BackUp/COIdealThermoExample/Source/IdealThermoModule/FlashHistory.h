@@ -0,0 +1,114 @@
+#pragma once
+
+//! FlashHistoryEntry class
+/*!
+	The last converged flash solution for a composition fingerprint, as
+	stored by FlashHistory
+	\sa FlashHistory
+*/
+
+class FlashHistoryEntry
+{public:
+
+	unsigned long long fingerprint; /*!< fingerprint of the compounds and composition */
+	double T; /*!< last converged temperature [K] */
+	double P; /*!< last converged pressure [Pa] */
+	double VF; /*!< last converged vapor phase fraction [mol/mol] */
+	double dT; /*!< change of T between the last two solutions [K] */
+	unsigned long lastUse; /*!< time of last use, for replacing the least recently used entry; zero if not in use */
+
+	//! Constructor
+	FlashHistoryEntry()
+	{fingerprint=0;
+	 T=P=VF=dT=0;
+	 lastUse=0;
+	}
+
+	//! Half width of a temperature bracket around T
+	/*!
+	  \return Twice the last change of T, at least 1 K
+	*/
+
+	double TStep() const {return (2.0*dT>1.0)?2.0*dT:1.0;}
+
+};
+
+//! FlashHistory class
+/*!
+	An opt-in, bounded history of converged flash solutions, keyed on a
+	fingerprint of the compounds and the composition of the flash.
+
+	Inside a converging flowsheet the same feed is flashed at nearly the same
+	specification many times. The flashes that solve iteratively for T 
+	(PVF, PVFm, PH and PS) first try a tight bracket around the last converged
+	temperature for the composition, which is found in a few function 
+	evaluations and skips the search for the bubble and dew points. If the 
+	solution is not inside the tight bracket, the flash falls back to the full 
+	bracket. The bracket width follows from the change between the last two 
+	solutions, so that it adapts to the step size of the flowsheet solver.
+	The TVF flashes are not seeded, as their full bracket (the dew and bubble
+	point pressures) is known in closed form.
+
+	The composition is rounded to 1e-6 in the fingerprint, so that a feed that
+	changes very little between flowsheet iterations keeps its entry. As the
+	stored solution is only used as a starting point, fingerprint collisions
+	cannot lead to wrong solutions.
+
+	Each PropertyWorkspace has its own history, which is disabled (size zero)
+	by default. The number of lookups that found an entry (hits), that did
+	not (misses), and the number of seeded solutions that failed and fell back
+	to the full bracket (fallbacks) are counted.
+
+	\sa PropertyWorkspace::SetFlashHistorySize(), PropertyPackage::Flash()
+*/
+
+class FlashHistory
+{public:
+
+	//construction
+	FlashHistory();
+
+	//functions
+	void SetSize(int size);
+	int Size() const;
+	void Clear();
+	static unsigned long long Fingerprint(const void *package,unsigned long serial,int n,const int *indices,const double *X);
+	const FlashHistoryEntry *Find(unsigned long long fingerprint);
+	void Store(unsigned long long fingerprint,double T,double P,double VF);
+
+	//! Count a seeded solution that failed
+	void SeedFailed() {fallbacks++;}
+
+	//! Number of hits
+	/*!
+	  \return Number of lookups that found a previous solution
+	*/
+
+	long Hits() const {return hits;}
+
+	//! Number of misses
+	/*!
+	  \return Number of lookups that did not find a previous solution
+	*/
+
+	long Misses() const {return misses;}
+
+	//! Number of fallbacks
+	/*!
+	  \return Number of seeded solutions that failed, after which the full bracket was used
+	*/
+
+	long Fallbacks() const {return fallbacks;}
+
+	//! Reset the counters
+	void ResetCounters() {hits=misses=fallbacks=0;}
+
+private:
+
+	vector<FlashHistoryEntry> entries; /*!< the entries */
+	unsigned long useCount; /*!< incremented at each use of an entry */
+	long hits; /*!< number of lookups that found an entry */
+	long misses; /*!< number of lookups that did not find an entry */
+	long fallbacks; /*!< number of seeded solutions that failed */
+
+};
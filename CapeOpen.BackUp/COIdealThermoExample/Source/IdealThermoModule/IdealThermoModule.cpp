@@ -3,7 +3,14 @@
 
 #include "stdafx.h"
 #include "IdealThermoModule.h"
+#ifdef _WIN32
 #include <shlobj.h>
+#else
+#include <sys/stat.h>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <stdlib.h>
+#endif
 
 /*! \mainpage Ideal Thermo Module
 *
@@ -31,14 +38,24 @@
 *
 *This example implementation uses compound definitions stored in 
 *.compound files in the data subfolder of the folder that contains
-*IdealThermoModule.dll. In addition, Property Package definition 
+*IdealThermoModule.dll, or in compound libraries (.compoundlibrary files
+*that hold many compounds) or a compiled compound database image 
+*(compounds.compounddb) in the same folder. In addition, Property Package definition 
 *files are used, and stored as .propertypackage in the user's
 *roaming data folder, in sub-folder CO-LaN_IdealThermoExample
 *
+*On non-Windows systems only the numerical core is built (see CMakeLists.txt);
+*the user data folder is $XDG_DATA_HOME/CO-LaN_IdealThermoExample and the
+*data folder can be overridden by the IDEALTHERMO_DATA_PATH environment 
+*variable or by SetDataPath()
+*
 */
 
 string userDataPath;   /*!< user data path (obtained via GetUserDataPath()) */
 string systemDataPath; /*!< data path (obtained via GetDataPath()) */
+
+#ifdef _WIN32
+
 HMODULE module;		   /*!< Handle of the current module */
 
 //! DllMain DLL entry point
@@ -127,46 +144,114 @@ string GetDataPath()
  return systemDataPath.c_str();
 }
 
-//! Helper function to read a line from a file
+#else
+
+//! Helper function to copy a file
 /*!
-  Lines are stripped of leading and trailing white space (space, tab).
-  Empty lines or lines starting with # are skipped.
-  \param f File from which to read line. Must have been opened with read access
-  \param line String returning the content of the line read
-  \return False in case no lines are available anymore
+  Copy a file, unless the destination already exists
+  \param src Source file
+  \param dest Destination file
+  \return True for success, false for error
 */
 
-bool ReadLine(FILE *f,string &line)
-{bool eof=false;
- line.clear();
- while ((line.size()==0)&&(!eof))
-  {char c;
-   while (true)
-    {if (fread(&c,1,1,f)!=1) 
-      {eof=true;
-       break;
-      }
-     if (c)
-      if (c!='\r')
-       {if (c=='\n') break;
-        line+=c;
-       }
+static bool CopyFileIfNew(const char *src,const char *dest)
+{FILE *fin,*fout;
+ char buf[4096];
+ size_t n;
+ if (fopen_s(&fout,dest,"rb")==0)
+  {//exists
+   fclose(fout);
+   return false;
+  }
+ if (fopen_s(&fin,src,"rb")) return false;
+ if (fopen_s(&fout,dest,"wb")) 
+  {fclose(fin);
+   return false;
+  }
+ while ((n=fread(buf,1,sizeof(buf),fin))>0) fwrite(buf,1,n,fout);
+ fclose(fin);
+ fclose(fout);
+ return true;
+}
+
+//! GetUserDataPath
+/*!
+  Get the path for the storage of user data (property package configurations)
+  \return user data path
+  \sa GetDataPath()
+*/
+
+string GetUserDataPath()
+{if (userDataPath.empty())
+  {//get the user data path, following the XDG base directory convention
+   const char *path=getenv("XDG_DATA_HOME");
+   if ((path)&&(*path)) userDataPath=path;
+   else 
+    {path=getenv("HOME");
+     userDataPath=(path)?path:".";
+     userDataPath+="/.local";
+     mkdir(userDataPath.c_str(),0755);
+     userDataPath+="/share";
+     mkdir(userDataPath.c_str(),0755);
     }
-   //strip white space
-   while (line.size()) 
-    {c=line[0];
-     if ((c!=' ')&&(c!='\t')) break;
-     line=line.substr(1);
+   if (userDataPath[userDataPath.length()-1]!='/') userDataPath+='/';
+   userDataPath+="CO-LaN_IdealThermoExample";
+   if (mkdir(userDataPath.c_str(),0755)==0)
+    {//directory was created newly, copy sample packages in there
+     int i;
+     string src,dest;
+     vector<string> examplePackages;
+     GetDataPath();
+     ListFiles(systemDataPath.c_str(),"propertypackage",examplePackages);
+     for (i=0;i<(int)examplePackages.size();i++)
+      {src=systemDataPath;src+='/';src+=examplePackages[i];src+=".propertypackage";
+       dest=userDataPath;dest+='/';dest+=examplePackages[i];dest+=".propertypackage";
+       CopyFileIfNew(src.c_str(),dest.c_str());
+      }
     }
-   while (line.size()) 
-    {c=line[line.size()-1];
-     if ((c!=' ')&&(c!='\t')) break;
-     line=line.substr(0,line.size()-1);
+  }
+ return userDataPath.c_str();
+}
+
+//! GetDataPath
+/*!
+  Get the path for the storage of compounds, etc. This is the value passed to
+  SetDataPath(), or the value of the IDEALTHERMO_DATA_PATH environment variable,
+  or the data sub folder of the folder of the module that contains this code
+  \return data path
+  \sa GetUserDataPath(), SetDataPath()
+*/
+
+string GetDataPath()
+{if (systemDataPath.empty())
+  {const char *path=getenv("IDEALTHERMO_DATA_PATH");
+   if ((path)&&(*path)) systemDataPath=path;
+   else
+    {//data is located in the data sub folder of the folder this module is in
+     Dl_info info;
+     if ((dladdr((void*)&GetDataPath,&info))&&(info.dli_fname)) systemDataPath=info.dli_fname;
+     string::size_type index=systemDataPath.rfind('/');
+     if (index==string::npos) systemDataPath="./";
+     else systemDataPath=systemDataPath.substr(0,index+1);
+     systemDataPath+="data";
     }
-   //check comment line
-   if (line.size()) if (line[0]=='#') line.clear();
   }
- return (line.size()>0);
+ return systemDataPath.c_str();
+}
+
+#endif
+
+//! SetDataPath
+/*!
+  Override the path for the storage of compounds. Must be called before 
+  any compounds are loaded. Used by stand-alone tools (e.g. the benchmark)
+  that generate their own compound data.
+  \param path Data path
+  \sa GetDataPath()
+*/
+
+void SetDataPath(const char *path)
+{systemDataPath=path;
 }
 
 //! Helper function to list files in a folder
@@ -178,6 +263,7 @@ bool ReadLine(FILE *f,string &line)
 */
 
 void ListFiles(const char *folder,const char *ext,vector<string> &fileNames)
+#ifdef _WIN32
 {WIN32_FIND_DATA FindFileData;
  HANDLE hFind=INVALID_HANDLE_VALUE;
  int i;
@@ -214,6 +300,24 @@ void ListFiles(const char *folder,const char *ext,vector<string> &fileNames)
    FindClose(hFind);
   }
 }
+#else
+{DIR *dir;
+ struct dirent *entry;
+ string fileName;
+ string::size_type i;
+ fileNames.clear();
+ dir=opendir(folder);
+ if (!dir) return;
+ while ((entry=readdir(dir))!=NULL)
+  {fileName=entry->d_name;
+   i=fileName.rfind('.');
+   if (i==string::npos) continue;
+   if (lstrcmpi(fileName.c_str()+i+1,ext)!=0) continue;
+   fileNames.push_back(fileName.substr(0,i));
+  }
+ closedir(dir);
+}
+#endif
 
 //! Helper function for error string from errno error code
 /*!
@@ -2,6 +2,6 @@
 //function declarations
 string GetUserDataPath();
 string GetDataPath();
-bool ReadLine(FILE *f,string &line);
+void SetDataPath(const char *path);
 void ListFiles(const char *folder,const char *ext,vector<string> &fileNames);
 string ErrorString(int errCode);
\ No newline at end of file
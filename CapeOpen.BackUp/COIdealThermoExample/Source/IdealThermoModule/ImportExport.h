@@ -1,6 +1,9 @@
 #pragma once
 
-#ifdef IDEALTHERMOMODULE_EXPORTS
+#if (!defined(_WIN32))||(defined(IDEALTHERMOMODULE_STATIC))
+//static library build of the numerical core, nothing to export or import
+#define IMPORTEXPORT
+#elif defined(IDEALTHERMOMODULE_EXPORTS)
 //for the IdealThermoModule.dll, the symbol IDEALTHERMOMODULE_EXPORTS is defined
 #define IMPORTEXPORT __declspec( dllexport )
 #else
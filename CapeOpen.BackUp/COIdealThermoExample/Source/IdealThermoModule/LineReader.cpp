@@ -0,0 +1,156 @@
+#include "stdafx.h"
+#include "LineReader.h"
+#include <string.h>
+
+//! Size of the blocks that are read from the file
+#define LINE_READER_BLOCK_SIZE 65536
+
+//! Constructor
+/*!
+  Called upon construction of a LineReader instance; no lines are available
+  until Open() is called
+*/
+
+LineReader::LineReader()
+{f=NULL;
+ begin=end=0;
+ fileOffset=0;
+ eof=true;
+ lineNumber=0;
+}
+
+//! Destructor
+/*!
+  Closes the file
+*/
+
+LineReader::~LineReader()
+{Close();
+}
+
+//! Open a file
+/*!
+  \param path Path of the file
+  \return Zero for success, errno value in case of failure, as for fopen_s
+*/
+
+int LineReader::Open(const char *path)
+{int errCode;
+ Close();
+ errCode=fopen_s(&f,path,"rb");
+ if (errCode)
+  {f=NULL;
+   return errCode;
+  }
+ if (buffer.size()<LINE_READER_BLOCK_SIZE+1) buffer.resize(LINE_READER_BLOCK_SIZE+1);
+ eof=false;
+ return 0;
+}
+
+//! Close the file
+/*!
+  The buffer is kept, for the next file that is opened
+*/
+
+void LineReader::Close()
+{if (f) fclose(f);
+ f=NULL;
+ begin=end=0;
+ fileOffset=0;
+ eof=true;
+ lineNumber=0;
+}
+
+//! Read the next block
+/*!
+  Move the unread data to the start of the buffer, growing the buffer if
+  it is full (for a line longer than the buffer), and read the next block
+  behind it. One byte at the end of the buffer is always kept free, to
+  terminate a last line that has no line end.
+  \return False if the end of the file has been reached
+*/
+
+bool LineReader::Fill()
+{size_t count;
+ if (eof) return false;
+ if (begin)
+  {memmove(&buffer[0],&buffer[0]+begin,end-begin);
+   fileOffset+=(long)begin;
+   end-=begin;
+   begin=0;
+  }
+ if (end+1>=buffer.size()) buffer.resize(2*buffer.size());
+ count=fread(&buffer[0]+end,1,buffer.size()-1-end,f);
+ if (count==0) eof=true;
+ end+=count;
+ return (count>0);
+}
+
+//! Next line
+/*!
+  \return The next line that is not empty and not a comment, or NULL if no lines
+  are available anymore. The line is valid until the next call to Next(), Skip(),
+  Open() or Close(), and may be modified by the caller.
+*/
+
+char *LineReader::Next()
+{char *line,*lineEnd,*src,*dst;
+ size_t scanned=0;
+ while (true)
+  {if (begin==end)
+    {scanned=0;
+     if (!Fill()) return NULL;
+    }
+   line=&buffer[0]+begin;
+   lineEnd=(char*)memchr(line+scanned,'\n',end-begin-scanned);
+   if (!lineEnd)
+    {//incomplete line; the last line of a file need not end with a line end
+     scanned=end-begin;
+     if (Fill()) continue;
+     line=&buffer[0]+begin;
+     lineEnd=&buffer[0]+end;
+     begin=end;
+    }
+   else begin=lineEnd+1-&buffer[0];
+   scanned=0;
+   lineNumber++;
+   //remove carriage returns and zero characters
+   for (src=dst=line;src<lineEnd;src++)
+    if ((*src!='\r')&&(*src)) *dst++=*src;
+   //strip white space
+   while ((dst>line)&&((dst[-1]==' ')||(dst[-1]=='\t'))) dst--;
+   *dst=0;
+   while ((*line==' ')||(*line=='\t')) line++;
+   //skip empty and comment lines
+   if ((*line)&&(*line!='#')) return line;
+  }
+}
+
+//! Skip lines
+/*!
+  Skip a number of lines that are not empty and not a comment
+  \param count Number of lines to skip
+  \return False if fewer lines are available
+*/
+
+bool LineReader::Skip(int count)
+{for (;count>0;count--)
+  if (!Next()) return false;
+ return true;
+}
+
+//! Continue reading at a position
+/*!
+  \param position Offset in the file, as returned by Position()
+  \param lineNumber Line number of the line before position, as returned by LineNumber()
+  \return False if the file is not open or the position cannot be reached
+*/
+
+bool LineReader::Seek(long position,int lineNumber)
+{if ((!f)||(fseek(f,position,SEEK_SET)!=0)) return false;
+ begin=end=0;
+ fileOffset=position;
+ eof=false;
+ this->lineNumber=lineNumber;
+ return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+//! LineReader class
+/*!
+	Block-buffered reader for the line-based data files (.compound,
+	.compoundlibrary, .propertypackage). The file is read in blocks of 64 kB;
+	lines are returned as zero-terminated strings inside the block buffer, so
+	that reading a line does not allocate and does not copy.
+
+	Lines are stripped of leading and trailing white space (space, tab), and
+	of carriage return and zero characters. Empty lines and lines starting
+	with # are skipped.
+
+	\code
+	LineReader reader;
+	if (reader.Open(path)==0)
+	 {const char *line;
+	  while ((line=reader.Next())!=NULL) ... //line is valid until the next call
+	 }
+	\endcode
+*/
+
+class LineReader
+{public:
+
+	//construction
+	LineReader();
+	~LineReader();
+
+	//functions
+	int Open(const char *path);
+	void Close();
+	char *Next();
+	bool Skip(int count);
+	bool Seek(long position,int lineNumber);
+
+	//! Position in the file
+	/*!
+	  \return The offset in the file of the data after the line last returned by Next(),
+	  for Seek()
+	*/
+
+	long Position() const {return fileOffset+(long)begin;}
+
+	//! Line number
+	/*!
+	  \return The line number in the file of the line last returned by Next(), starting at 1
+	*/
+
+	int LineNumber() const {return lineNumber;}
+
+private:
+
+	FILE *f; /*!< the file, NULL if not open */
+	vector<char> buffer; /*!< the block buffer */
+	size_t begin; /*!< start of the unread data in buffer */
+	size_t end; /*!< end of the unread data in buffer */
+	long fileOffset; /*!< offset in the file of the start of buffer */
+	bool eof; /*!< set once the end of the file has been read into buffer */
+	int lineNumber; /*!< number of lines read */
+
+	bool Fill();
+
+	//no copies of the file handle
+	LineReader(const LineReader &);
+	LineReader &operator=(const LineReader &);
+
+};
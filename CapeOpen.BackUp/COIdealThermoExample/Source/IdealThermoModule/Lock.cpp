@@ -1,7 +1,12 @@
 #include "stdafx.h"
 #include "Lock.h"
 
+#ifdef _WIN32
 CRITICAL_SECTION TheCriticalSection; /*!< CRITICAL_SECTION object to perform locking */
+#else
+#include <pthread.h>
+pthread_mutex_t TheMutex; /*!< recursive mutex to perform locking, behaves as a CRITICAL_SECTION */
+#endif
 
 //! Constructor.
 /*!
@@ -9,26 +14,45 @@ CRITICAL_SECTION TheCriticalSection; /*!< CRITICAL_SECTION object to perform loc
 */
 
 LockObject::LockObject()
- {InitializeCriticalSection(&TheCriticalSection);
+ {
+#ifdef _WIN32
+  InitializeCriticalSection(&TheCriticalSection);
+#else
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr,PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&TheMutex,&attr);
+  pthread_mutexattr_destroy(&attr);
+#endif
  }
 
 //! Destructor.
 /*!
   Called upon destruction of the LockObject class; deletes the CRITICAL_SECTION object
 */
- 
+
 LockObject::~LockObject()
- {DeleteCriticalSection(&TheCriticalSection);
+ {
+#ifdef _WIN32
+  DeleteCriticalSection(&TheCriticalSection);
+#else
+  pthread_mutex_destroy(&TheMutex);
+#endif
  }
- 
+
 //! Lock.
 /*!
   Call to protect access to global variables. Make sure that each Lock() matches an Unlock()
   \sa Unlock()
 */
- 
+
 void LockObject::Lock()
-{EnterCriticalSection(&TheCriticalSection);
+{
+#ifdef _WIN32
+ EnterCriticalSection(&TheCriticalSection);
+#else
+ pthread_mutex_lock(&TheMutex);
+#endif
 }
 
 //! Unlock.
@@ -38,7 +62,12 @@ void LockObject::Lock()
 */
 
 void LockObject::Unlock()
-{LeaveCriticalSection(&TheCriticalSection);
+{
+#ifdef _WIN32
+ LeaveCriticalSection(&TheCriticalSection);
+#else
+ pthread_mutex_unlock(&TheMutex);
+#endif
 }
 
 LockObject theLock; /*!< singleton instanc of the LockObject class */
\ No newline at end of file
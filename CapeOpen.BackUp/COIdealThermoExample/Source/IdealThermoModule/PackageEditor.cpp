@@ -1,6 +1,7 @@
 #include "StdAfx.h"
 #include "IdealThermoModule.h"
 #include "Compound.h"
+#include "CompoundRegistry.h"
 #include "PackageEditor.h"
 #include "PropertyPackage.h"
 #include "resource.h"
@@ -208,26 +209,24 @@ void PackageEditor::OnOk()
   }
  //ok, load compounds and add to PP
  int i;
- vector<Compound *> newCompounds;
- for (i=0;i<(int)presentCompounds.size();i++)
-  {Compound *comp=new Compound();
-   newCompounds.push_back(comp);
-   string error;
-   if (!comp->Load(presentCompounds[i].c_str(),error))
-    {//failed to load, do not proceed
-     string s;
-     s="Unable to load compound \"";
-     s+=presentCompounds[i];
-     s+="\": ";
-     s+=error;
-     MessageBox(hDlg,s.c_str(),"Error:",MB_ICONHAND);
-     for (i=0;i<(int)newCompounds.size();i++) delete newCompounds[i];
-     return;
-    }
+ vector<shared_ptr<Compound> > newCompounds;
+ string error;
+ if (!CompoundRegistry::Acquire((int)presentCompounds.size(),&presentCompounds[0],newCompounds,error))
+  {//failed to load, do not proceed
+   string s;
+   s="Unable to load compounds: ";
+   s+=error;
+   MessageBox(hDlg,s.c_str(),"Error:",MB_ICONHAND);
+   return;
   }
- //all compounds loaded ok, replace compounds in package
- for (i=0;i<(int)package->compounds.size();i++) delete package->compounds[i];
- package->compounds=newCompounds;
+ //all compounds loaded ok, replace compounds in package; the previous compounds are deleted unless shared
+ package->compoundData=newCompounds;
+ package->compounds.resize(newCompounds.size());
+ for (i=0;i<(int)newCompounds.size();i++) package->compounds[i]=newCompounds[i].get();
+ //index of the compounds by lower case name, for GetCompoundIndex()
+ package->compoundNames.clear();
+ for (i=0;i<(int)package->compounds.size();i++) package->compoundNames[Compound::NameKey(package->compounds[i]->name.c_str())]=i;
+ package->BuildCorrelations();
  EndDialog(hDlg,IDOK);
 }
 
@@ -0,0 +1,81 @@
+#pragma once
+
+//! Platform shim
+/*!
+	The Ideal Thermo Module was written against the Win32 API and the
+	Microsoft secure CRT. This header maps the small subset of these that
+	is used by the numerical core (Compound, PropertyPackage, file and path
+	helpers) onto their POSIX equivalents, so that the core can be built
+	and profiled on non-Windows systems.
+
+	On Windows this header only defines the path separator. The user
+	interface parts of the module (editors, VB6 exports) remain Windows-only.
+*/
+
+#ifdef _WIN32
+
+//path separator, as string
+#define PATH_SEPARATOR "\\"
+
+#else
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <cmath>
+
+//path separator, as string
+#define PATH_SEPARATOR "/"
+
+//Win32 BOOL type (used by the VB export helpers of PropertyPackage)
+typedef int BOOL;
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+//case insensitive string comparison
+#define lstrcmpi strcasecmp
+
+//secure CRT routines; only the functionality used by this module is mapped
+#define sscanf_s sscanf
+#define fprintf_s fprintf
+#define sprintf_s snprintf
+
+//! fopen_s replacement
+/*!
+  \param f Receives the file handle, or NULL in case of failure
+  \param fileName Name of the file to open
+  \param mode Open mode, as for fopen
+  \return Zero for success, errno value in case of failure
+*/
+
+inline int fopen_s(FILE **f,const char *fileName,const char *mode)
+{*f=fopen(fileName,mode);
+ return (*f)?0:errno;
+}
+
+//! strerror_s replacement
+/*!
+  \param buf Receives the error text
+  \param size Size of buf
+  \param errCode errno value
+  \return Zero
+*/
+
+inline int strerror_s(char *buf,size_t size,int errCode)
+{strncpy(buf,strerror(errCode),size-1);
+ buf[size-1]=0;
+ return 0;
+}
+
+//! _isnan replacement
+inline int _isnan(double x) {return std::isnan(x)?1:0;}
+
+//! _finite replacement
+inline int _finite(double x) {return std::isfinite(x)?1:0;}
+
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+#include "CorrelationTable.h"
+
+//forward declarations
+class PropertyPackage; //forward declaration
+
+//! PreparedMixture class
+/*!
+	Holds the compound set of a mixture after it has been checked against a
+	property package, along with the compound data that the calculations need:
+	the molecular weights, the critical temperatures and their minimum, and
+	a CorrelationTable with the coefficients of the mixture compounds in mixture
+	order, so that the correlation kernels can use contiguous loads.
+
+	A PreparedMixture is filled in by PropertyPackage::PrepareMixture(). Flashes
+	and property calculations on a prepared mixture do not check the compound
+	indices again, which saves the per-call validation and mapping when many
+	calculations are done on the same compound set, as in dynamic simulation.
+
+	A PreparedMixture is not modified by calculations, and can be used by any
+	number of threads at the same time, each with its own PropertyWorkspace. It
+	must be prepared again if the property package is loaded again.
+
+	\sa PropertyPackage::PrepareMixture(), PropertyWorkspace
+*/
+
+class PreparedMixture
+{public:
+
+	//! Constructor
+	/*!
+	  Called upon construction of a PreparedMixture instance; the mixture is empty
+	  until prepared by PropertyPackage::PrepareMixture()
+	*/
+
+	PreparedMixture()
+	{package=NULL;
+	 minTC=0;
+	}
+
+	//! Number of compounds
+	/*!
+	  \return The number of compounds in the mixture
+	*/
+
+	int CompoundCount() const {return (int)compIndices.size();}
+
+private:
+
+	const PropertyPackage *package; /*!< package the mixture is prepared for, NULL if not prepared */
+	vector<int> compIndices; /*!< indices of the compounds in the property package */
+	vector<double> MW; /*!< molecular weights of the compounds */
+	vector<double> TC; /*!< critical temperatures of the compounds */
+	double minTC; /*!< lowest critical temperature of the compounds */
+	CorrelationTable correlations; /*!< correlation coefficients of the compounds, in mixture order */
+
+	//no copies
+	PreparedMixture(const PreparedMixture &);
+	PreparedMixture &operator=(const PreparedMixture &);
+
+	//the property package prepares the mixture and performs the calculations
+	friend class PropertyPackage;
+
+};
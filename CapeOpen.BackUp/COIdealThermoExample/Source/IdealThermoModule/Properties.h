@@ -158,6 +158,27 @@ typedef enum
 
 #define FlashPhaseTypeCount 3
 
+//! Status of a batch calculation item:
+/*!
+	Enumeration with identifiers for the outcome of each item of a batch calculation
+*/
+
+typedef enum 
+{ BatchItemOK=0, /*!< Calculation succeeded*/
+  BatchItemFailed=1, /*!< Calculation failed, the error message is stored with the batch*/
+} BatchItemStatus;
+
+//! Structure of composition-derivative matrices:
+/*!
+	Enumeration with identifiers for the structure of a StructuredMatrix
+*/
+
+typedef enum 
+{ ZeroMatrix=0, /*!< All elements are zero*/
+  DiagonalMatrix=1, /*!< Only the diagonal is non-zero*/
+  DiagonalPlusRankOneMatrix=2, /*!< A diagonal plus the outer product of two vectors*/
+} MatrixStructure;
+
 //defined only at the scope of IDealThermoModule.dll
 #ifdef IDEALTHERMOMODULE_EXPORTS
 #define DIMENSION_SCALAR 0
@@ -1,10 +1,18 @@
-#include "StdAfx.h"
+#include "stdafx.h"
 #include "PropertyPackage.h"
 #include "Compound.h"
+#include "CompoundRegistry.h"
+#include "VaporPressureSurrogate.h"
 #include "IdealThermoModule.h"
 #include <float.h>
 #include "Solver1Dim.h"
+#include "RachfordRice.h"
+#include "DualNumber.h"
+#include "LineReader.h"
+#include "Lock.h"
+#ifdef _WIN32
 #include "PackageEditor.h"
+#endif
 
 //! VECPTR macro
 /*!
@@ -15,6 +23,346 @@
   
 #define VECPTR(vec) &((vec)[0])
 
+//! Largest mixture for which duplicate compounds are found by comparing all pairs
+/*!
+  Larger mixtures, such as crude oil fractions of hundreds of pseudo-components,
+  are checked in linear time by marking the compounds in the workspace
+  \sa PropertyPackage::CheckCompoundIndices()
+*/
+
+#define PAIRWISE_DUPLICATE_CHECK 16
+
+//! Intermediate quantities of single-phase property calculations
+/*!
+  Per-compound quantities from which the single-phase properties are built. 
+  GetSinglePhaseProperties() determines which intermediates are needed for all 
+  requested properties, and evaluates each of these only once per call.
+  
+  The intermediates that only depend on temperature are the pure component
+  quantities, which are stored in the PureComponentCache of the workspace.
+  \sa SinglePhaseIntermediates(), PropertyPackage::GetSinglePhaseProperties(), PureComponentQuantity
+*/
+
+enum
+{IntermediatePSat=PureCompPSat,             /*!< vapor pressure */
+ IntermediatePSatDT=PureCompPSatDT,         /*!< temperature derivative of vapor pressure */
+ IntermediateLiqDens=PureCompLiqDens,       /*!< liquid density */
+ IntermediateLiqDensDT=PureCompLiqDensDT,   /*!< temperature derivative of liquid density */
+ IntermediateLiqVolume=PureCompLiqVolume,   /*!< liquid volume, 1/liquid density */
+ IntermediateCp=PureCompCp,                 /*!< ideal gas heat capacity */
+ IntermediateCpInt=PureCompCpInt,           /*!< integral of ideal gas heat capacity from reference temperature */
+ IntermediateCpIntOverT=PureCompCpIntOverT, /*!< integral of ideal gas heat capacity/T from reference temperature */
+ IntermediateHvap=PureCompHvap,             /*!< heat of vaporization */
+ IntermediateHvapDT=PureCompHvapDT,         /*!< temperature derivative of heat of vaporization */
+ IntermediateLnX=PureComponentQuantityCount,/*!< logarithm of mole fraction */
+ IntermediateCount
+};
+
+//! Bit of an intermediate in a set of intermediates
+#define INTERMEDIATE(id) (1<<(id))
+
+//! Set of the intermediates that are pure component quantities
+#define PURE_COMPONENT_INTERMEDIATES (INTERMEDIATE(PureComponentQuantityCount)-1)
+
+//! Intermediates on which the evaluation of each intermediate depends
+static const int IntermediateDependencies[IntermediateCount]=
+ {0,                                   //PSat
+  INTERMEDIATE(IntermediatePSat),      //PSatDT
+  0,                                   //LiqDens
+  0,                                   //LiqDensDT
+  INTERMEDIATE(IntermediateLiqDens),   //LiqVolume
+  0,0,0,0,0,0};                        //Cp, CpInt, CpIntOverT, Hvap, HvapDT, LnX
+
+//! Property group of a single-phase property
+/*!
+  The single-phase properties come in groups of five: the value, and its temperature,
+  pressure, mole fraction and mole number derivatives
+  \param propID The property
+  \return The value property of the group (Density, Volume, Enthalpy, ...)
+*/
+
+#define SINGLE_PHASE_GROUP(propID) ((SinglePhaseProperty)((propID)-(propID)%5))
+
+//! Kind of derivative of a single-phase property
+/*!
+  \param propID The property
+  \return 0 for the value, 1 for DT, 2 for DP, 3 for DX and 4 for Dn
+*/
+
+#define SINGLE_PHASE_DERIVATIVE(propID) ((propID)%5)
+
+//! Intermediates required for a single-phase property
+/*!
+  The values and their temperature and pressure derivatives are evaluated from
+  the same kernels, instantiated with double or DualNumber, so that the DT and
+  DP properties need the intermediates of the value along with their temperature
+  derivatives.
+  \param propID The property
+  \param phaseID The phase, Vapor or Liquid
+  \return Set of intermediates, excluding their dependencies
+  \sa PropertyPackage::GetSinglePhaseProperties(), PlanIntermediates()
+*/
+
+static int SinglePhaseIntermediates(SinglePhaseProperty propID,Phase phaseID)
+{int values,derivatives;
+ bool liquid=(phaseID==Liquid);
+ switch (SINGLE_PHASE_GROUP(propID))
+  {case Density:
+   case Volume:
+    values=liquid?INTERMEDIATE(IntermediateLiqDens):0;
+    derivatives=liquid?INTERMEDIATE(IntermediateLiqDensDT):0;
+    break;
+   case Enthalpy:
+    values=INTERMEDIATE(IntermediateCpInt)|(liquid?INTERMEDIATE(IntermediateHvap):0);
+    derivatives=INTERMEDIATE(IntermediateCp)|(liquid?INTERMEDIATE(IntermediateHvapDT):0);
+    break;
+   case Entropy:
+    values=INTERMEDIATE(IntermediateCpIntOverT)|INTERMEDIATE(IntermediateLnX)|(liquid?INTERMEDIATE(IntermediatePSat)|INTERMEDIATE(IntermediateHvap):0);
+    derivatives=INTERMEDIATE(IntermediateCp)|(liquid?INTERMEDIATE(IntermediatePSatDT)|INTERMEDIATE(IntermediateHvapDT):0);
+    break;
+   case Fugacity:
+   case FugacityCoefficient:
+   case LogFugacityCoefficient:
+    values=liquid?INTERMEDIATE(IntermediatePSat):0;
+    derivatives=liquid?INTERMEDIATE(IntermediatePSatDT):0;
+    break;
+   default:
+    //activity is the mole fraction
+    return 0;
+  }
+ switch (SINGLE_PHASE_DERIVATIVE(propID))
+  {case 0:
+    return values;
+   case 1:
+   case 2:
+    return values|derivatives;
+   default:
+    break;
+  }
+ //composition derivatives
+ switch (SINGLE_PHASE_GROUP(propID))
+  {case Density:
+   case Volume:
+    return liquid?INTERMEDIATE(IntermediateLiqVolume):0;
+   case Enthalpy:
+   case Entropy:
+   case Fugacity:
+    return values;
+   default:
+    break;
+  }
+ return 0;
+}
+
+//! Plan the evaluation of intermediates
+/*!
+  \param needed Set of intermediates
+  \return The set, extended with all intermediates on which these depend
+*/
+
+static int PlanIntermediates(int needed)
+{int i;
+ for (i=IntermediateCount-1;i>=0;i--) if (needed&INTERMEDIATE(i)) needed|=IntermediateDependencies[i];
+ return needed;
+}
+
+//! Evaluate pure component intermediates
+/*!
+  Evaluate a set of pure component intermediates at a temperature from the 
+  correlations, in order of dependency
+  \param table Correlation table of the compounds
+  \param tableIndices Indices of the compounds in the table, NULL if all compounds of the table in order
+  \param nComp Number of compounds
+  \param T Temperature [K]
+  \param needed Set of pure component intermediates to evaluate, including their dependencies
+  \param values Receives nComp values for each intermediate, in the layout of PureComponentState
+  \sa PropertyPackage::PureComponentValues()
+*/
+
+static void EvaluatePureComponentValues(const CorrelationTable &table,const int *tableIndices,int nComp,double T,int needed,double *values)
+{int j;
+ double *psat=values+IntermediatePSat*nComp;
+ double *liqDens=values+IntermediateLiqDens*nComp;
+ if (needed&INTERMEDIATE(IntermediatePSat)) table.PSat(nComp,tableIndices,T,psat);
+ if (needed&INTERMEDIATE(IntermediatePSatDT)) table.PSatDT(nComp,tableIndices,T,psat,values+IntermediatePSatDT*nComp);
+ if (needed&INTERMEDIATE(IntermediateLiqDens)) table.Value(liqDensCorrelationID,nComp,tableIndices,T,liqDens);
+ if (needed&INTERMEDIATE(IntermediateLiqDensDT)) table.ValueDT(liqDensCorrelationID,nComp,tableIndices,T,values+IntermediateLiqDensDT*nComp);
+ if (needed&INTERMEDIATE(IntermediateLiqVolume)) 
+  {double *liqVolume=values+IntermediateLiqVolume*nComp;
+   for (j=0;j<nComp;j++) liqVolume[j]=1.0/liqDens[j];
+  }
+ if (needed&INTERMEDIATE(IntermediateCp)) table.Value(CpCorrelationID,nComp,tableIndices,T,values+IntermediateCp*nComp);
+ if (needed&INTERMEDIATE(IntermediateCpInt)) table.IntValue(CpCorrelationID,nComp,tableIndices,T,values+IntermediateCpInt*nComp);
+ if (needed&INTERMEDIATE(IntermediateCpIntOverT)) table.IntValueOverT(CpCorrelationID,nComp,tableIndices,T,values+IntermediateCpIntOverT*nComp);
+ if (needed&INTERMEDIATE(IntermediateHvap)) table.Value(HvapCorrelationID,nComp,tableIndices,T,values+IntermediateHvap*nComp);
+ if (needed&INTERMEDIATE(IntermediateHvapDT)) table.ValueDT(HvapCorrelationID,nComp,tableIndices,T,values+IntermediateHvapDT*nComp);
+}
+
+//! Mixture molar volume kernel
+/*!
+  Unchecked kernel shared by GetSinglePhaseProperties() and the flashes; all 
+  inputs must have been validated by the caller. Instantiated with DualNumber,
+  the temperature and pressure derivatives are obtained along with the value.
+  \param phaseID Phase
+  \param nComp Number of compounds
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions
+  \param pure Pure component intermediates; liquid density and, for DualNumber, its temperature derivative
+  \return Molar volume [m3/mol]
+  \sa DualNumber
+*/
+
+template <class S> static S MixtureVolume(Phase phaseID,int nComp,const S &T,const S &P,const double *X,const double *pure)
+{int j;
+ S V,rho;
+ if (phaseID==Vapor) return GAS_CONSTANT*T/P; //ideal gas law
+ //V = sum(X/rho)
+ V=0.0;
+ for (j=0;j<nComp;j++) 
+  {PureComponent(rho,pure+IntermediateLiqDens*nComp,pure+IntermediateLiqDensDT*nComp,j);
+   V+=X[j]/rho;
+  }
+ return V;
+}
+
+//! Mixture enthalpy kernel
+/*!
+  Unchecked kernel shared by GetSinglePhaseProperties() and the flashes; all 
+  inputs must have been validated by the caller
+  \param phaseID Phase
+  \param nComp Number of compounds
+  \param X Mole fractions
+  \param pure Pure component intermediates; the integral of the ideal gas heat capacity, 
+  the heat of vaporization for the liquid phase and, for DualNumber, their temperature derivatives
+  \return Enthalpy [J/mol]
+  \sa DualNumber
+*/
+
+template <class S> static S MixtureEnthalpy(Phase phaseID,int nComp,const double *X,const double *pure)
+{int j;
+ S H,h;
+ //ideal part
+ H=0.0;
+ for (j=0;j<nComp;j++) 
+  if (X[j]>0) 
+   {PureComponent(h,pure+IntermediateCpInt*nComp,pure+IntermediateCp*nComp,j);
+    H+=X[j]*h;
+   }
+ //the pressure integral from P = 0 to P for [V - T (dV/dT)|P] cancels out for an ideal gas as V = T*dV/dT)|P = RT/P
+ if (phaseID==Liquid)
+  {//correct for Hvap
+   for (j=0;j<nComp;j++) 
+    if (X[j]>0) 
+     {PureComponent(h,pure+IntermediateHvap*nComp,pure+IntermediateHvapDT*nComp,j);
+      H-=X[j]*h;
+     }
+  }
+ return H;
+}
+
+//! Mixture entropy kernel
+/*!
+  Unchecked kernel shared by GetSinglePhaseProperties() and the flashes; all 
+  inputs must have been validated by the caller
+  \param phaseID Phase
+  \param nComp Number of compounds
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions
+  \param lnX Logarithm of the mole fractions; only used where X is positive
+  \param pure Pure component intermediates; the integral of the ideal gas heat capacity/T, 
+  the vapor pressure and heat of vaporization for the liquid phase and, for DualNumber, 
+  their temperature derivatives
+  \return Entropy [J/mol/K]
+  \sa DualNumber
+*/
+
+template <class S> static S MixtureEntropy(Phase phaseID,int nComp,const S &T,const S &P,const double *X,const double *lnX,const double *pure)
+{int j;
+ S entropy,s,psat,hvap;
+ //shared terms; d/dT of the integral of Cp/T is Cp/T
+ entropy=0.0;
+ double invT=1.0/ValueOf(T);
+ for (j=0;j<nComp;j++) 
+  if (X[j]>0)
+   {PureComponent(s,pure+IntermediateCpIntOverT*nComp,pure+IntermediateCp*nComp,j,invT);
+    entropy+=X[j]*(s-GAS_CONSTANT*lnX[j]);
+   }
+ if (phaseID==Vapor)
+  {//pressure term
+   entropy-=GAS_CONSTANT*log(P/REFERENCE_PRESSURE);
+  }
+ else
+  {//pressure and hVap terms
+   for (j=0;j<nComp;j++) 
+    if (X[j]>0)
+     {PureComponent(psat,pure+IntermediatePSat*nComp,pure+IntermediatePSatDT*nComp,j);
+      PureComponent(hvap,pure+IntermediateHvap*nComp,pure+IntermediateHvapDT*nComp,j);
+      entropy-=X[j]*(GAS_CONSTANT*log(psat/REFERENCE_PRESSURE)+hvap/T);
+     }
+  }
+ return entropy;
+}
+
+//! Scalar single-phase property kernel
+/*!
+  \param group Density, Volume, Enthalpy or Entropy
+  \param phaseID Phase
+  \param nComp Number of compounds
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions
+  \param lnX Logarithm of the mole fractions, for entropy
+  \param pure Pure component intermediates
+  \return The property
+  \sa MixtureVolume(), MixtureEnthalpy(), MixtureEntropy()
+*/
+
+template <class S> static S SinglePhaseScalar(SinglePhaseProperty group,Phase phaseID,int nComp,const S &T,const S &P,const double *X,const double *lnX,const double *pure)
+{switch (group)
+  {case Density: return 1.0/MixtureVolume(phaseID,nComp,T,P,X,pure);
+   case Volume: return MixtureVolume(phaseID,nComp,T,P,X,pure);
+   case Enthalpy: return MixtureEnthalpy<S>(phaseID,nComp,X,pure);
+   default: break;
+  }
+ return MixtureEntropy(phaseID,nComp,T,P,X,lnX,pure);
+}
+
+//! Fugacity kernel
+/*!
+  Fugacity, fugacity coefficient or log fugacity coefficient of a compound
+  \param group Fugacity, FugacityCoefficient or LogFugacityCoefficient
+  \param phaseID Phase
+  \param P Pressure [Pa]
+  \param lnP Logarithm of the pressure
+  \param X Mole fraction of the compound
+  \param psat Vapor pressure of each compound, not used for the vapor phase
+  \param psatDT Temperature derivative of the vapor pressure, for DualNumber
+  \param j Compound index
+  \return The property
+  \sa DualNumber
+*/
+
+template <class S> static S CompoundFugacity(SinglePhaseProperty group,Phase phaseID,const S &P,const S &lnP,double X,const double *psat,const double *psatDT,int j)
+{S ps;
+ if (phaseID==Vapor)
+  {switch (group)
+    {case Fugacity: return X*P;
+     case FugacityCoefficient: return S(1.0);
+     default: break;
+    }
+   return S(0.0); //ln(unity)
+  }
+ //liquid, fug[j]=x[j]*Psat[j]=phi[j]*x[j]*P -> phi[j]=Psat[j]/P
+ PureComponent(ps,psat,psatDT,j);
+ switch (group)
+  {case Fugacity: return X*ps;
+   case FugacityCoefficient: return ps/P;
+   default: break;
+  }
+ return log(ps)-lnP;
+}
 
 //! Constructor
 /*!
@@ -24,6 +372,11 @@
 PropertyPackage::PropertyPackage()
 {initialized=false; //methods can only be used after Load or LoadFromPPFile is successfully called
  lastError="No error"; //set value to error in case an error has occured
+ tabulationError=0; //vapor pressures from the Antoine equation
+ lazyLoading=false;
+ correlationsLoaded=NULL;
+ deferredCount=0;
+ loadedCount=0;
 }
 
 //! Destructor
@@ -32,9 +385,8 @@ PropertyPackage::PropertyPackage()
 */
 
 PropertyPackage::~PropertyPackage()
-{//clean up compounds
- int i;
- for (i=0;i<(int)compounds.size();i++) delete compounds[i]; 
+{//compounds are deleted with compoundData, once no other property package uses them
+ if (correlationsLoaded) delete[] correlationsLoaded;
 }
 
 //! Return the last error
@@ -56,7 +408,7 @@ const char *PropertyPackage::LastError()
   The property package
   \param pathName Location of the data file to load from
   \return True for success, false for error
-  \sa Save(), LoadFromPPFile(), LastError()
+  \sa Save(), LoadFromPPFile(), LastError(), SetLazyLoading(), CompoundRegistry
 */
 
 bool PropertyPackage::Load(const char *pathName)
@@ -65,9 +417,9 @@ bool PropertyPackage::Load(const char *pathName)
   {lastError="Load can only be called once";
    return false;
   }
- FILE *f;
- int errCode;
- errCode=fopen_s(&f,pathName,"rb");
+ LineReader reader;
+ int i,errCode;
+ errCode=reader.Open(pathName);
  if (errCode)
   {lastError="Failed to open \"";
    lastError+=pathName;
@@ -75,39 +427,188 @@ bool PropertyPackage::Load(const char *pathName)
    lastError+=ErrorString(errCode);
    return false;
   }
- //read the compounds
- string compName;
- while (ReadLine(f,compName))
-  {//load the compound
-   Compound *c=new Compound;
-   if (!c->Load(compName.c_str(),lastError)) 
-    {delete c;
-     fclose(f);
-     return false; //error is already set
+ //read the compound names; compounds must be unique, the names are hashed, so that this is linear in the number of compounds
+ vector<string> names;
+ const char *compName;
+ compoundNames.clear();
+ while ((compName=reader.Next())!=NULL)
+  {if (!compoundNames.insert(make_pair(Compound::NameKey(compName),(int)names.size())).second)
+    {lastError="Compound \"";
+     lastError+=compName;
+     lastError+="\" is present in property package more than once; compounds must be unique";
+     compoundNames.clear();
+     return false;
     }
-   compounds.push_back(c);
+   names.push_back(compName);
   }
- fclose(f);
+ reader.Close();
  //we must have at least one compound
- if (compounds.size()==0)
+ if (names.size()==0)
   {lastError="Property package must contain at least one compound";
    return false;
   }
- //compounds must be unique
- int i,j;
- for (i=0;i<(int)compounds.size();i++)
-  for (j=i+1;j<(int)compounds.size();j++)
-   if (lstrcmpi(compounds[i]->name.c_str(),compounds[j]->name.c_str())==0)
-    {lastError="Compound \"";
-     lastError+=compounds[i]->name;
-     lastError+="\" is present in property package more than once; compounds must be unique";
-     return false;
-    }
+ //obtain the compounds from the registry, which shares those that are in use by other property packages and
+ //loads the others from the compound database, the compound libraries and the .compound files;
+ //tabulation needs the vapor pressures of all compounds, so loading is only deferred without it
+ if (!CompoundRegistry::Acquire((int)names.size(),&names[0],compoundData,lastError,(lazyLoading)&&(tabulationError<=0)))
+  {compoundNames.clear();
+   return false; //error is already set
+  }
+ compounds.resize(names.size());
+ for (i=0;i<(int)names.size();i++) compounds[i]=compoundData[i].get();
+ //coefficient table for evaluation over mixtures
+ BuildCorrelations();
  //all ok
  initialized=true;
  return true; 
 }
 
+//! Set deferred loading of the correlations
+/*!
+  In lazy mode, Load() reads the names, formulas, CAS numbers and constants
+  of the compounds, but defers parsing the heat capacity, heat of vaporization,
+  liquid density and Antoine coefficients of compounds that are read from 
+  compound libraries and .compound files until a calculation first involves 
+  the compound. This saves most of the load time of large packages of which
+  only a few compounds are used. Compounds from the compound database and all
+  compounds of a tabulated package (see SetTabulation()) are loaded completely.
+
+  The correlations are loaded at most once per compound, also if several 
+  threads use the compound at the same time. Errors in the correlation data of 
+  a compound are reported by the first calculation that involves it. The 
+  compound files must not change while the package is in use.
+  \param lazy True to defer loading the correlations
+  \return True for success, false for error
+  \sa Load(), GetLoadCounters(), Compound::LoadCorrelations()
+*/
+
+bool PropertyPackage::SetLazyLoading(bool lazy)
+{if (initialized)
+  {lastError="Lazy loading must be set before the property package is loaded";
+   return false;
+  }
+ lazyLoading=lazy;
+ return true;
+}
+
+//! Get the load counters
+/*!
+  \param compoundCount Receives the number of compounds
+  \param deferred Receives the number of compounds of which loading the correlations was deferred
+  \param loaded Receives the number of those compounds of which the correlations have been loaded since
+  \sa SetLazyLoading()
+*/
+
+void PropertyPackage::GetLoadCounters(int &compoundCount,int &deferred,int &loaded) const
+{compoundCount=(int)compounds.size();
+ deferred=deferredCount;
+ loaded=loadedCount.load();
+}
+
+//! Build the coefficient table
+/*!
+  Internal routine to build the coefficient table, the tabulated vapor pressures
+  and the per-compound load flags after the compounds have been loaded or replaced. 
+  Compounds of which loading the correlations was deferred are added to the table 
+  by LoadCompoundCorrelations(). The global lock is held, as another property package
+  that shares a compound may load its correlations meanwhile.
+*/
+
+void PropertyPackage::BuildCorrelations()
+{int i;
+ theLock.Lock();
+ if (correlationsLoaded)
+  {delete[] correlationsLoaded;
+   correlationsLoaded=NULL;
+  }
+ deferredCount=0;
+ loadedCount=0;
+ for (i=0;i<(int)compounds.size();i++)
+  if (!compounds[i]->HasCorrelations()) deferredCount++;
+ if (deferredCount)
+  {correlationsLoaded=new atomic<char>[compounds.size()];
+   for (i=0;i<(int)compounds.size();i++) correlationsLoaded[i].store(compounds[i]->HasCorrelations()?1:0);
+  }
+ correlations.Build(compounds);
+ theLock.Unlock();
+ if (tabulationError>0) correlations.Tabulate(compounds,tabulationError);
+}
+
+//! Load deferred correlations of a mixture
+/*!
+  Internal routine to make sure that the correlations of the compounds of a mixture
+  are loaded; costs a single test if loading was not deferred, and a flag test per
+  compound otherwise.
+  \param ws Workspace receiving the error
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture, which have been checked
+  \return True if ok
+  \sa SetLazyLoading()
+*/
+
+bool PropertyPackage::LoadCorrelations(PropertyWorkspace &ws,int nComp,const int *compIndices) const
+{int i;
+ if (!correlationsLoaded) return true;
+ for (i=0;i<nComp;i++)
+  if (!correlationsLoaded[compIndices[i]].load(memory_order_acquire))
+   if (!LoadCompoundCorrelations(ws,compIndices[i])) return false;
+ return true;
+}
+
+//! Load deferred correlations of a compound
+/*!
+  Internal routine to load the correlations of a compound and copy them to its
+  column of the coefficient table. Loads are serialized by the global lock; the
+  flag of the compound is set after its column is written, so that threads that 
+  see the flag set see the coefficients.
+  \param ws Workspace receiving the error
+  \param compIndex Index of the compound
+  \return True if ok
+  \sa LoadCorrelations(), Compound::LoadCorrelations()
+*/
+
+bool PropertyPackage::LoadCompoundCorrelations(PropertyWorkspace &ws,int compIndex) const
+{Compound *c=compounds[compIndex];
+ string error;
+ bool ok=true;
+ theLock.Lock();
+ if (!correlationsLoaded[compIndex].load(memory_order_relaxed))
+  {if (c->LoadCorrelations(error))
+    {//no calculation reads the column of this compound before the flag is set
+     const_cast<CorrelationTable&>(correlations).Set(compIndex,*c);
+     correlationsLoaded[compIndex].store(1,memory_order_release);
+     loadedCount++;
+    }
+   else ok=false;
+  }
+ theLock.Unlock();
+ if (!ok)
+  {ws.lastError="Failed to load the correlations of compound \"";
+   ws.lastError+=c->name;
+   ws.lastError+="\": ";
+   ws.lastError+=error;
+  }
+ return ok;
+}
+
+//! Load all deferred correlations
+/*!
+  Internal routine to load the correlations of all compounds, as needed for tabulation
+  \return True if ok
+  \sa SetTabulation()
+*/
+
+bool PropertyPackage::LoadAllCorrelations()
+{int i;
+ if (!correlationsLoaded) return true;
+ for (i=0;i<(int)compounds.size();i++)
+  if (!LoadCorrelations(workspace,1,&i))
+   {lastError=workspace.lastError;
+    return false;
+   }
+ return true;
+}
+
 //! Save the PropertyPackage content to a file
 /*!
   Save the configuration of the PropertyPackage to
@@ -155,7 +656,7 @@ bool PropertyPackage::LoadFromPPFile(const char *ppName)
 {//call load, with the default PP folder
  string path;
  path=GetUserDataPath();
- path+='\\';
+ path+=PATH_SEPARATOR;
  path+=ppName;
  path+=".propertypackage";
  return Load(path.c_str());
@@ -209,6 +710,33 @@ const char *PropertyPackage::GetCompoundStringConstant(int compIndex,StringConst
  return NULL;
 }
 
+//! Get compound index
+/*!
+  Find a compound by name, ignoring character case. The names are hashed 
+  upon loading, so that looking up all compounds of a mixture is linear in 
+  the number of compounds.
+  \param compName Name of the compound
+  \param compIndex Receives the index of the compound
+  \return True if ok, false if the compound is not in this property package
+  \sa GetCompoundCount(), GetCompoundStringConstant(), LastError()
+*/
+
+bool PropertyPackage::GetCompoundIndex(const char *compName,int &compIndex)
+{if (!initialized)
+  {lastError="Property package has not been initialized";
+   return false;
+  }
+ unordered_map<string,int>::const_iterator it=compoundNames.find(Compound::NameKey(compName));
+ if (it==compoundNames.end())
+  {lastError="Compound \"";
+   lastError+=compName;
+   lastError+="\" is not present in property package";
+   return false;
+  }
+ compIndex=it->second;
+ return true;
+}
+
 //! Get compound real constant
 /*!
   Get real constant for a compound.
@@ -258,6 +786,7 @@ bool PropertyPackage::GetCompoundRealConstant(int compIndex,RealConstant constID
 //! Get compound temperature dependent property value at specified temperature
 /*!
   Get real constant for a compound. The real constants follow from the temperature correlations.
+  \param ws Workspace that receives the return values and the error
   \param compIndex Index of the compound. Must be between zero and number of compounds-1, inclusive.
   \param propID ID of the temperature dependent property to be obtained
   \param T Temperature [K]. Must be between zero and critical temperature of the compound
@@ -267,20 +796,34 @@ bool PropertyPackage::GetCompoundRealConstant(int compIndex,RealConstant constID
 */
 
 
-bool PropertyPackage::GetTemperatureDependentProperty(int compIndex,TDependentProperty propID,double T,double &value)
+bool PropertyPackage::GetTemperatureDependentProperty(PropertyWorkspace &ws,int compIndex,TDependentProperty propID,double T,double &value) const
 {if (!initialized)
-  {lastError="Property package has not been initialized";
+  {ws.lastError="Property package has not been initialized";
    return false;
   }
  if ((compIndex<0)||(compIndex>=(int)compounds.size()))
-  {lastError="Compound index out of range";
+  {ws.lastError="Compound index out of range";
    return false;
   }
- if (!CheckTemperature(T)) return false;
+ if (!LoadCorrelations(ws,1,&compIndex)) return false;
+ if (!CheckTemperature(ws,T)) return false;
  if (T>compounds[compIndex]->TC)
-  {lastError="Temperature exceeds critical temperature";
+  {ws.lastError="Temperature exceeds critical temperature";
    return false;
   }
+ //use the value stored by a mixture calculation at this temperature, if any
+ int quantity;
+ switch (propID)
+  {case HeatOfVaporization: quantity=PureCompHvap;break;
+   case HeatOfVaporizationDT: quantity=PureCompHvapDT;break;
+   case IdealGasHeatCapacity: quantity=PureCompCp;break;
+   case VaporPressure: quantity=PureCompPSat;break;
+   case VaporPressureDT: quantity=PureCompPSatDT;break;
+   case LiquidDensity: quantity=PureCompLiqDens;break;
+   case LiquidDensityDT: quantity=PureCompLiqDensDT;break;
+   default: quantity=-1;break;
+  }
+ if ((quantity>=0)&&(ws.cache.Find(correlations,compIndex,T,quantity,value))) return true;
  switch (propID)
   {case HeatOfVaporization:
         value=compounds[compIndex]->HvapCorrelation->Value(T);
@@ -295,10 +838,11 @@ bool PropertyPackage::GetTemperatureDependentProperty(int compIndex,TDependentPr
         value=compounds[compIndex]->CpCorrelation->ValueDT(T);
         break;
    case VaporPressure:
-        value=compounds[compIndex]->pSatCorrelation->Value(T);
+        correlations.PSat(1,&compIndex,T,&value); //tabulated, if so configured
         break;
    case VaporPressureDT:
-        value=compounds[compIndex]->pSatCorrelation->ValueDT(T);
+        correlations.PSat(1,&compIndex,T,&value);
+        correlations.PSatDT(1,&compIndex,T,&value,&value);
         break;
    case LiquidDensity:
         value=compounds[compIndex]->liqDensCorrelation->Value(T);
@@ -307,18 +851,148 @@ bool PropertyPackage::GetTemperatureDependentProperty(int compIndex,TDependentPr
         value=compounds[compIndex]->liqDensCorrelation->ValueDT(T);
         break;
    default:
-        lastError="Invalid property ID";
+        ws.lastError="Invalid property ID";
         return false;
   }
  return true; 
 }
 
+//! Set the tabulated mode
+/*!
+  Evaluate the vapor pressures of mixture calculations and flashes from tabulated
+  splines instead of the Antoine equation, trading a controlled error for speed, 
+  or switch back to the Antoine equation. The splines are built upon Load(), or 
+  immediately if the property package is already loaded. The heat capacity, heat
+  of vaporization and liquid density correlations are always evaluated exactly.
+  Tabulation loads the correlations of all compounds, see SetLazyLoading().
+
+  Must not be called while calculations are running on this property package. 
+  Mixtures that were prepared before must be prepared again.
+  \param maxRelError Maximum relative error of the vapor pressures; zero to use the Antoine equation
+  \return True if ok
+  \sa GetTabulationReport(), VaporPressureSurrogate
+*/
+
+bool PropertyPackage::SetTabulation(double maxRelError)
+{if (!((maxRelError>=0)&&(maxRelError<0.1)))
+  {lastError="Maximum relative error of tabulation must be at least zero and below 0.1";
+   return false;
+  }
+ if ((initialized)&&(maxRelError>0)&&(!LoadAllCorrelations())) return false;
+ tabulationError=maxRelError;
+ if (initialized) correlations.Tabulate(compounds,tabulationError);
+ return true;
+}
+
+//! Get the validation report of the tabulated mode
+/*!
+  Compare the tabulated vapor pressures and their temperature derivatives to
+  the Antoine equation for each compound. The report holds a header line and
+  one line per compound, of comma separated values:
+
+  compound,segments,Tmin,Tmax,maxRelError,maxRelErrorDT
+
+  Compounds that are not tabulated have zero segments and empty ranges and errors;
+  their vapor pressures are obtained from the Antoine equation.
+  \return The report, valid until the next call, or NULL in case of failure
+  \sa SetTabulation(), VaporPressureSurrogate::Validate()
+*/
+
+const char *PropertyPackage::GetTabulationReport()
+{int i;
+ char line[256];
+ SurrogateValidation validation;
+ const VaporPressureSurrogate *surrogate=correlations.Surrogate();
+ if (!initialized)
+  {lastError="Property package has not been initialized";
+   return NULL;
+  }
+ if (!surrogate)
+  {lastError="Property package is not tabulated";
+   return NULL;
+  }
+ tabulationReport="compound,segments,Tmin,Tmax,maxRelError,maxRelErrorDT\n";
+ for (i=0;i<(int)compounds.size();i++)
+  {tabulationReport+=compounds[i]->name;
+   if (surrogate->Validate(compounds[i],i,validation)) sprintf_s(line,sizeof(line),",%d,%.6g,%.6g,%.3e,%.3e\n",validation.segments,validation.Tmin,validation.Tmax,validation.maxError,validation.maxErrorDT);
+   else sprintf_s(line,sizeof(line),",0,,,,\n");
+   tabulationReport+=line;
+  }
+ return tabulationReport.c_str();
+}
+
+//! Get compound temperature dependent property value at specified temperature
+/*!
+  As GetTemperatureDependentProperty() with workspace argument, using the workspace of
+  this PropertyPackage
+  \param compIndex Index of the compound. Must be between zero and number of compounds-1, inclusive.
+  \param propID ID of the temperature dependent property to be obtained
+  \param T Temperature [K]. Must be between zero and critical temperature of the compound
+  \param value Receives the value of the requested temperature dependent property.
+  \return True if ok
+  \sa GetCompoundCount(), LastError(), TDependentProperty
+*/
+
+bool PropertyPackage::GetTemperatureDependentProperty(int compIndex,TDependentProperty propID,double T,double &value)
+{if (!GetTemperatureDependentProperty(workspace,compIndex,propID,T,value))
+  {lastError=workspace.lastError;
+   return false;
+  }
+ return true;
+}
+
+//! Prepare a mixture
+/*!
+  Check a compound set once, and store it in a PreparedMixture along with the compound
+  data that the calculations need. Flash() and GetSinglePhaseProperties() on the prepared
+  mixture do not check the compound indices again, and evaluate the correlations on 
+  contiguous coefficients in mixture order.
+  
+  The mixture must be prepared again if this property package is loaded again.
+  \param ws Workspace that receives the error
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param mixture Receives the prepared mixture
+  \return True if ok
+  \sa PreparedMixture, Flash(), GetSinglePhaseProperties()
+*/
+
+bool PropertyPackage::PrepareMixture(PropertyWorkspace &ws,int nComp,const int *compIndices,PreparedMixture &mixture) const
+{int i;
+ vector<Compound*> mixtureCompounds;
+ mixture.package=NULL;
+ if (!initialized)
+  {ws.lastError="Property package has not been initialized";
+   return false;
+  }
+ if (nComp<=0)
+  {ws.lastError="Mixture contains no compounds";
+   return false;
+  }
+ if (!CheckCompoundIndices(ws,nComp,compIndices)) return false;
+ mixture.compIndices.assign(compIndices,compIndices+nComp);
+ mixture.MW.resize(nComp);
+ mixture.TC.resize(nComp);
+ mixtureCompounds.resize(nComp);
+ for (i=0;i<nComp;i++)
+  {mixtureCompounds[i]=compounds[compIndices[i]];
+   mixture.MW[i]=mixtureCompounds[i]->MW;
+   mixture.TC[i]=mixtureCompounds[i]->TC;
+  }
+ mixture.minTC=mixture.TC[0];
+ for (i=1;i<nComp;i++) if (mixture.TC[i]<mixture.minTC) mixture.minTC=mixture.TC[i];
+ mixture.correlations.Build(mixtureCompounds);
+ mixture.correlations.Tabulate(correlations,nComp,compIndices);
+ mixture.package=this;
+ return true;
+}
+
 //! Get single-phase mixture properties at specified temperature, pressure and composition
 /*!
   Calculate and get single phase mixture properties. The properties are returned in arrays 
-  that are allocated and stored by this DLL. The return values are only valid until the next
-  call to GetSinglePhaseProperties, GetTwoPhaseProperties or Flash, so store the return values, but 
-  not the pointers to them. Multiple properties can be requested in a single call. For each
+  that are allocated and stored in the workspace. The return values are only valid until the next
+  call to GetSinglePhaseProperties, GetTwoPhaseProperties or Flash with the same workspace, so store 
+  the return values, but not the pointers to them. Multiple properties can be requested in a single call. For each
   property, the values and number of values are returned.
   
   For the vapor phase, volume and density follow from the ideal gas law. Enthalpy follows from
@@ -351,6 +1025,7 @@ bool PropertyPackage::GetTemperatureDependentProperty(int compIndex,TDependentPr
   Due to the nature of the thermodynamics, the mixture properties should not be used for T 
   larger than or equal to the critical temperature of any present compound.
   
+  \param ws Workspace that receives the return values and the error
   \param nComp Number of compounds in the mixture
   \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
   \param phaseID ID of the phase for which to calculate the properties
@@ -365,120 +1040,288 @@ bool PropertyPackage::GetTemperatureDependentProperty(int compIndex,TDependentPr
   \sa GetCompoundCount(), LastError(), Phase, SinglePhaseProperty
 */
 
-bool PropertyPackage::GetSinglePhaseProperties(int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int *&ValueCount,double **&Values)
-{//this implementation is for instructive purposes only; a production implementation would use
- // stored values for combined property evaluations, e.g. evaluate PSat only once for all 
- // requested properties for which Psat is required. THIS ROUTINE DOES NOT TAKE ADVANTAGE OF 
- // SIMULTANEOUS PROPERTY CALCULATIONS!!!
- int i,j,k,index;
- if (!initialized)
-  {lastError="Property package has not been initialized";
-   return false;
-  }
- //check the inputs
- if ((phaseID!=Vapor)&&(phaseID!=Liquid))
-  {lastError="Invalid phase ID";
-   return false;
-  }
- for (i=0;i<nComp;i++)
-  {if ((compIndices[i]<0)||(compIndices[i]>=(int)compounds.size()))
-    {lastError="Compound index out of range";
-     return false;
-    }
-   for (j=0;j<i;j++) 
-    if (compIndices[i]==compIndices[j])
-     {lastError="At least one compound appears in the mixture more than once";
-      return false;
-     }
-   if (T>compounds[compIndices[i]]->TC)
-    {lastError="Temperature exceeds critical temperature of one of the compounds in the mixture";
-     return false;
-    }
-   if (_isnan(X[i]))
-    {lastError="At least one value for composition is missing";
-     return false;
-    }
-   if (!_finite(X[i]))
-    {lastError="At least one value for composition is not finite";
-     return false;
-    }
-   if (X[i]<0)
-    {lastError="At least one value for composition is negative";
-     return false;
-    }
-  }
- if (!CheckTemperature(T)) return false;
- if (!CheckPressure(P)) return false;
- //check the properties and allocate and assign the return values
- int offset;
- valueCounts.resize(nProp);
- valueOffsets.resize(nProp);
- valuePointers.resize(nProp);
- offset=0;
+bool PropertyPackage::GetSinglePhaseProperties(PropertyWorkspace &ws,int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int *&ValueCount,double **&Values) const
+{int totalCount;
+ //invalid property IDs are counted as zero values here; the error is reported by the calculation
+ GetSinglePhasePropertySizes(nComp,nProp,propIDs,NULL,totalCount);
+ AllocatePropertyResults(ws,nProp,totalCount);
+ if (!GetSinglePhaseProperties(ws,nComp,compIndices,phaseID,T,P,X,nProp,propIDs,totalCount,VECPTR(ws.valueCounts),VECPTR(ws.values))) return false;
+ AssignPropertyResults(ws,nProp,ValueCount,Values);
+ return true;
+}
+
+//! Get the number of values of single-phase mixture properties
+/*!
+  Get the sizes of the buffers that GetSinglePhaseProperties() with caller-supplied 
+  buffers needs for a set of properties. The sizes only depend on the number of 
+  compounds and the properties, so a caller can allocate the buffers once and use 
+  them for all calculations on the same mixture.
+  \param nComp Number of compounds in the mixture
+  \param nProp Number of properties requested
+  \param propIDs IDs of the properties requested
+  \param valueCount Receives the number of values for each of the properties, one value for each property; can be NULL
+  \param totalCount Receives the total number of values of all properties
+  \return False if one or more of the property IDs is invalid; an invalid property is counted as zero values
+  \sa GetSinglePhaseProperties(), SinglePhaseProperty
+*/
+
+bool PropertyPackage::GetSinglePhasePropertySizes(int nComp,int nProp,const SinglePhaseProperty *propIDs,int *valueCount,int &totalCount)
+{int i,dim,nVal;
+ bool ok=true;
+ totalCount=0;
  for (i=0;i<nProp;i++)
-  {//get the number of values for this property
-   if ((propIDs[i]<0)||(propIDs[i]>=SinglePhasePropertyCount))
-    {lastError="One or more invalid single-phase property IDs";
-     return false;
+  {if ((propIDs[i]<0)||(propIDs[i]>=SinglePhasePropertyCount))
+    {nVal=0;
+     ok=false;
     }
-   int nVal=1;
-   int dim=SinglePhasePropertyDimension[propIDs[i]];
-   while (dim)
-    {nVal*=nComp;
-     dim--;
+   else 
+    {nVal=1;
+     dim=SinglePhasePropertyDimension[propIDs[i]];
+     while (dim)
+      {nVal*=nComp;
+       dim--;
+      }
     }
-   valueCounts[i]=nVal;
-   valueOffsets[i]=offset;
-   offset+=nVal;
-  }
- values.resize(offset); //offset now contains total count
- for (i=0;i<nProp;i++) valuePointers[i]=VECPTR(values)+valueOffsets[i];
- ValueCount=VECPTR(valueCounts);
- Values=VECPTR(valuePointers);
- //calculate the properties
+   if (valueCount) valueCount[i]=nVal;
+   totalCount+=nVal;
+  }
+ return ok;
+}
+
+//! Get single-phase mixture properties into caller-supplied buffers
+/*!
+  As GetSinglePhaseProperties() with workspace argument, but the values are written into 
+  buffers of the caller rather than into the workspace, so that the results remain valid
+  after subsequent calls and no buffers of the workspace are resized. The values of all
+  properties are stored consecutively, in the order of the properties. The required size
+  of the buffer is obtained from GetSinglePhasePropertySizes().
+  \param ws Workspace that receives the error
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param phaseID ID of the phase for which to calculate the properties
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions [mol/mol], one value for each compound, assumed normalized
+  \param nProp Number of properties requested
+  \param propIDs IDs of the properties requested
+  \param valueCapacity Number of values that fit in values
+  \param valueCount Receives the number of values for each of the properties, one value for each property
+  \param values Receives the values of all properties, those of each property following those of the previous property
+  \return True if ok
+  \sa GetSinglePhasePropertySizes(), LastError(), Phase, SinglePhaseProperty
+*/
+
+bool PropertyPackage::GetSinglePhaseProperties(PropertyWorkspace &ws,int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values) const
+{ws.scratch.Reset();
+ if (!CheckSinglePhaseInputs(ws,nComp,compIndices,phaseID,T,P,X)) return false;
+ return SinglePhaseProperties(ws,correlations,compIndices,nComp,phaseID,T,P,X,nProp,propIDs,valueCapacity,valueCount,values);
+}
+
+//! Check the inputs of a single-phase calculation
+/*!
+  Internal routine that checks the inputs of the single-phase calculations with
+  compound indices, sets the error in case not ok
+  \param ws Workspace receiving the error
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture
+  \param phaseID ID of the phase
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions [mol/mol], one value for each compound
+  \return True if ok
+  \sa GetSinglePhaseProperties(), GetSinglePhaseMatrix()
+*/
+
+bool PropertyPackage::CheckSinglePhaseInputs(PropertyWorkspace &ws,int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X) const
+{int i;
+ if (!initialized)
+  {ws.lastError="Property package has not been initialized";
+   return false;
+  }
+ //check the inputs
+ if ((phaseID!=Vapor)&&(phaseID!=Liquid))
+  {ws.lastError="Invalid phase ID";
+   return false;
+  }
+ if (!CheckCompoundIndices(ws,nComp,compIndices)) return false;
+ for (i=0;i<nComp;i++)
+  {if (T>compounds[compIndices[i]]->TC)
+    {ws.lastError="Temperature exceeds critical temperature of one of the compounds in the mixture";
+     return false;
+    }
+   if (!CheckComposition(ws,X[i])) return false;
+  }
+ if (!CheckTemperature(ws,T)) return false;
+ return CheckPressure(ws,P);
+}
+
+//! Get single-phase mixture properties of a prepared mixture
+/*!
+  As GetSinglePhaseProperties() with compound indices, for a mixture that has been prepared
+  by PrepareMixture(). The compound indices are not checked again, and the compound data is
+  taken from the mixture. The composition is checked in a single comparison per compound.
+  \param ws Workspace that receives the return values and the error
+  \param mixture Mixture prepared for this property package
+  \param phaseID ID of the phase for which to calculate the properties
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions [mol/mol], one value for each compound of the mixture, assumed normalized
+  \param nProp Number of properties requested
+  \param propIDs IDs of the properties requested
+  \param ValueCount Receives the number of values for each of the properties, one value for each property
+  \param Values Receives the values, one double array for each property. Size of the array corresponds to valueCount for each property
+  \return True if ok
+  \sa PrepareMixture(), PreparedMixture
+*/
+
+bool PropertyPackage::GetSinglePhaseProperties(PropertyWorkspace &ws,const PreparedMixture &mixture,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int *&ValueCount,double **&Values) const
+{int totalCount;
+ GetSinglePhasePropertySizes(mixture.CompoundCount(),nProp,propIDs,NULL,totalCount);
+ AllocatePropertyResults(ws,nProp,totalCount);
+ if (!GetSinglePhaseProperties(ws,mixture,phaseID,T,P,X,nProp,propIDs,totalCount,VECPTR(ws.valueCounts),VECPTR(ws.values))) return false;
+ AssignPropertyResults(ws,nProp,ValueCount,Values);
+ return true;
+}
+
+//! Get single-phase mixture properties of a prepared mixture into caller-supplied buffers
+/*!
+  As GetSinglePhaseProperties() with caller-supplied buffers and compound indices, for a 
+  mixture that has been prepared by PrepareMixture().
+  \param ws Workspace that receives the error
+  \param mixture Mixture prepared for this property package
+  \param phaseID ID of the phase for which to calculate the properties
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions [mol/mol], one value for each compound of the mixture, assumed normalized
+  \param nProp Number of properties requested
+  \param propIDs IDs of the properties requested
+  \param valueCapacity Number of values that fit in values
+  \param valueCount Receives the number of values for each of the properties, one value for each property
+  \param values Receives the values of all properties, those of each property following those of the previous property
+  \return True if ok
+  \sa PrepareMixture(), GetSinglePhasePropertySizes()
+*/
+
+bool PropertyPackage::GetSinglePhaseProperties(PropertyWorkspace &ws,const PreparedMixture &mixture,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values) const
+{ws.scratch.Reset();
+ if (!CheckSinglePhaseInputs(ws,mixture,phaseID,T,P,X)) return false;
+ return SinglePhaseProperties(ws,mixture.correlations,NULL,mixture.CompoundCount(),phaseID,T,P,X,nProp,propIDs,valueCapacity,valueCount,values);
+}
+
+//! Check the inputs of a single-phase calculation on a prepared mixture
+/*!
+  Internal routine that checks the inputs of the single-phase calculations on
+  a prepared mixture, sets the error in case not ok
+  \param ws Workspace receiving the error
+  \param mixture Mixture prepared by PrepareMixture()
+  \param phaseID ID of the phase
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions [mol/mol], one value for each compound of the mixture
+  \return True if ok
+  \sa GetSinglePhaseProperties(), GetSinglePhaseMatrix()
+*/
+
+bool PropertyPackage::CheckSinglePhaseInputs(PropertyWorkspace &ws,const PreparedMixture &mixture,Phase phaseID,double T,double P,const double *X) const
+{int i,nComp;
+ if (mixture.package!=this)
+  {ws.lastError="Mixture has not been prepared for this property package";
+   return false;
+  }
+ if ((phaseID!=Vapor)&&(phaseID!=Liquid))
+  {ws.lastError="Invalid phase ID";
+   return false;
+  }
+ nComp=mixture.CompoundCount();
+ for (i=0;i<nComp;i++) if (!((X[i]>=0)&&(X[i]<=DBL_MAX))) return CheckComposition(ws,X[i]); //also catches NaN
+ if (!CheckTemperature(ws,T)) return false;
+ if (T>mixture.minTC)
+  {ws.lastError="Temperature exceeds critical temperature of one of the compounds in the mixture";
+   return false;
+  }
+ return CheckPressure(ws,P);
+}
+
+//! Calculate single-phase mixture properties
+/*!
+  Internal routine that calculates the properties for GetSinglePhaseProperties(), after
+  the mixture, phase, temperature, pressure and composition have been checked
+  \param ws Workspace that receives the return values and the error
+  \param table Correlation table of the compounds
+  \param tableIndices Indices of the compounds in the table, NULL if all compounds of the table in order
+  \param nComp Number of compounds in the mixture
+  \param phaseID ID of the phase for which to calculate the properties
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions [mol/mol], one value for each compound
+  \param nProp Number of properties requested
+  \param propIDs IDs of the properties requested
+  \param valueCapacity Number of values that fit in values
+  \param valueCount Receives the number of values for each of the properties
+  \param values Receives the values of all properties, consecutively
+  \return True if ok
+  \sa GetSinglePhaseProperties()
+*/
+
+bool PropertyPackage::SinglePhaseProperties(PropertyWorkspace &ws,const CorrelationTable &table,const int *tableIndices,int nComp,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values) const
+{//the per-compound intermediates (Psat, liquid density, Cp integrals, ...) that are required for 
+ // the requested properties are evaluated only once, after which all properties are built
+ // from these
+ int i,j;
+ //check the properties and the size of the buffer
+ int offset;
+ if (!GetSinglePhasePropertySizes(nComp,nProp,propIDs,valueCount,offset))
+  {ws.lastError="One or more invalid single-phase property IDs";
+   return false;
+  }
+ if (offset>valueCapacity) //offset now contains total count
+  {ws.lastError="Buffer is too small for the values of the requested properties";
+   return false;
+  }
+ //plan the intermediates for all properties
+ int needed=0;
+ for (i=0;i<nProp;i++) needed|=SinglePhaseIntermediates(propIDs[i],phaseID);
+ needed=PlanIntermediates(needed);
+ //evaluate each intermediate once, in order of dependency; the pure component 
+ // intermediates are taken from the cache where available
+ double *pure=PureComponentValues(ws,table,tableIndices,nComp,T,needed&PURE_COMPONENT_INTERMEDIATES);
+ double *psat=pure+IntermediatePSat*nComp;
+ double *psatDT=pure+IntermediatePSatDT*nComp;
+ double *liqVolume=pure+IntermediateLiqVolume*nComp;
+ double *cpInt=pure+IntermediateCpInt*nComp;
+ double *cpIntOverT=pure+IntermediateCpIntOverT*nComp;
+ double *hvap=pure+IntermediateHvap*nComp;
+ double *lnX=ws.scratch.Allocate(nComp);
+ //temperature and pressure as independent variables of the DT and DP properties
+ DualNumber Td=DualNumber::Variable(T,1,0);
+ DualNumber Pd=DualNumber::Variable(P,0,1);
+ double *matrixValues=NULL; //structured form of matrix properties, allocated when first needed
+ StructuredMatrix matrix;
+ if (needed&INTERMEDIATE(IntermediateLnX)) for (j=0;j<nComp;j++) lnX[j]=(X[j]>0)?log(X[j]):-HUGE_VAL;
+ //calculate the properties from the intermediates
+ offset=0;
  for (i=0;i<nProp;i++) 
-  {double *vals=valuePointers[i];
+  {double *vals=values+offset;
+   offset+=valueCount[i];
    switch (propIDs[i])
     {case Density:
-         if (phaseID==Vapor)
-          {//vapor density, ideal gas law
-           *vals=P/(GAS_CONSTANT*T);
-          }
-         else
-          {//liquid density
-           // V = sum(X/rho)
-           double V=0;
-           for (j=0;j<nComp;j++) V+=X[j]/compounds[j]->liqDensCorrelation->Value(T);
-           *vals=1.0/V;
-          }
+     case Volume:
+     case Enthalpy:
+     case Entropy:
+         *vals=SinglePhaseScalar<double>(propIDs[i],phaseID,nComp,T,P,X,lnX,pure);
 		 break;   
      case DensityDT:
-         if (phaseID==Vapor)
-          {//vapor density, ideal gas law
-           *vals=-P/(GAS_CONSTANT*T*T);
-          }
-         else
-          {//liquid density
-           // V = sum(X/rho)
-           double V=0;
-           double VDT=0;
-           for (j=0;j<nComp;j++) 
-            {double vcomp=1.0/compounds[j]->liqDensCorrelation->Value(T);
-             V+=X[j]*vcomp;
-             VDT-=X[j]*compounds[j]->liqDensCorrelation->ValueDT(T)*vcomp*vcomp;
-            }
-           *vals=-VDT/(V*V);
-          }
-		 break;   
      case DensityDP:
-         if (phaseID==Vapor)
-          {//vapor density, ideal gas law
-           *vals=1.0/(GAS_CONSTANT*T);
-          }
-         else
-          {//liquid density, incompressible
-           *vals=0;
-          }
+     case VolumeDT:
+     case VolumeDP:
+     case EnthalpyDT:
+     case EnthalpyDP:
+     case EntropyDT:
+     case EntropyDP:
+         {//value and derivatives in one sweep
+          DualNumber d=SinglePhaseScalar(SINGLE_PHASE_GROUP(propIDs[i]),phaseID,nComp,Td,Pd,X,lnX,pure);
+          *vals=(SINGLE_PHASE_DERIVATIVE(propIDs[i])==1)?d.dT:d.dP;
+         }
 		 break;   
      case DensityDX:
          if (phaseID==Vapor)
@@ -488,13 +1331,9 @@ bool PropertyPackage::GetSinglePhaseProperties(int nComp,const int *compIndices,
          else
           {//liquid density
            double V;
-           vector<double> vComp; 
+           const double *vComp=liqVolume;
            V=0;
-           vComp.resize(nComp);
-           for (j=0;j<nComp;j++) 
-            {vComp[j]=1.0/compounds[j]->liqDensCorrelation->Value(T);
-             V+=X[j]*vComp[j];
-            }
+           for (j=0;j<nComp;j++) V+=X[j]*vComp[j];
            double invV2=-1.0/(V*V);
            for (j=0;j<nComp;j++) vals[j]=invV2*vComp[j];
           }
@@ -507,55 +1346,13 @@ bool PropertyPackage::GetSinglePhaseProperties(int nComp,const int *compIndices,
          else
           {//liquid density
            double V;
-           vector<double> vComp; 
+           const double *vComp=liqVolume;
            V=0;
-           vComp.resize(nComp);
-           for (j=0;j<nComp;j++) 
-            {vComp[j]=1.0/compounds[j]->liqDensCorrelation->Value(T);
-             V+=X[j]*vComp[j];
-            }
+           for (j=0;j<nComp;j++) V+=X[j]*vComp[j];
            double invV2=-1.0/(V*V);
            for (j=0;j<nComp;j++) vals[j]=invV2*(vComp[j]-V);
           }
 		 break;   
-     case Volume:
-         if (phaseID==Vapor)
-          {//vapor density, ideal gas law
-           *vals=GAS_CONSTANT*T/P;
-          }
-         else
-          {//liquid density
-           // V = sum(X/rho)
-           *vals=0;
-           for (j=0;j<nComp;j++) *vals+=X[j]/compounds[j]->liqDensCorrelation->Value(T);
-          }
-		 break;   
-     case VolumeDT:
-         if (phaseID==Vapor)
-          {//vapor density, ideal gas law
-           *vals=GAS_CONSTANT/P;
-          }
-         else
-          {//liquid density
-           // V = sum(X/rho)
-           double VDT=0;
-           for (j=0;j<nComp;j++) 
-            {double vcomp=1.0/compounds[j]->liqDensCorrelation->Value(T);
-             VDT-=X[j]*compounds[j]->liqDensCorrelation->ValueDT(T)*vcomp*vcomp;
-            }
-           *vals=VDT;
-          }
-		 break;   
-     case VolumeDP:
-         if (phaseID==Vapor)
-          {//vapor density, ideal gas law
-           *vals=-GAS_CONSTANT*T/(P*P);
-          }
-         else
-          {//liquid density, incompressible
-           *vals=0;
-          }
-		 break;   
      case VolumeDX:
          if (phaseID==Vapor)
           {//does not depend on composition
@@ -563,7 +1360,7 @@ bool PropertyPackage::GetSinglePhaseProperties(int nComp,const int *compIndices,
           }
          else
           {//liquid volume
-           for (j=0;j<nComp;j++) vals[j]=1.0/compounds[j]->liqDensCorrelation->Value(T);
+           for (j=0;j<nComp;j++) vals[j]=liqVolume[j];
           }
 		 break;   
      case VolumeDn: 
@@ -574,77 +1371,18 @@ bool PropertyPackage::GetSinglePhaseProperties(int nComp,const int *compIndices,
           }
          else
           {//liquid volume
-           for (j=0;j<nComp;j++) vals[j]=1.0/compounds[j]->liqDensCorrelation->Value(T);
-          }
-		 break;   
-     case Enthalpy:
-         //ideal part
-         *vals=0;
-         for (j=0;j<nComp;j++) if (X[j]>0) *vals+=X[j]*compounds[j]->CpCorrelation->IntValue(T);
-         //the pressure integral from P = 0 to P for [V - T (dV/dT)|P] cancels out for an ideal gas as V = T*dV/dT)|P = RT/P
-         if (phaseID==Liquid)
-          {//correct for Hvap
-           for (j=0;j<nComp;j++) if (X[j]>0) *vals-=X[j]*compounds[j]->HvapCorrelation->Value(T);
-          }
-		 break;   
-     case EnthalpyDT:
-         *vals=0;
-         for (j=0;j<nComp;j++) if (X[j]>0) *vals+=X[j]*compounds[j]->CpCorrelation->Value(T);
-         if (phaseID==Liquid)
-          {//correct for Hvap
-           for (j=0;j<nComp;j++) if (X[j]>0) *vals-=X[j]*compounds[j]->HvapCorrelation->ValueDT(T);
+           for (j=0;j<nComp;j++) vals[j]=liqVolume[j];
           }
 		 break;   
-     case EnthalpyDP:
-         //neither liquid nor vapor enthalpy depends on pressure
-         *vals=0;
-		 break;   
      case EnthalpyDX:
      case EnthalpyDn:
          //loop over components
          // DX and Dn are the same because the X-dependence is linear
          for (j=0;j<nComp;j++) 
-          {vals[j]=compounds[j]->CpCorrelation->IntValue(T);
-           if (phaseID==Liquid) vals[j]-=compounds[j]->HvapCorrelation->Value(T);
-          }
-		 break;   
-     case Entropy:
-         *vals=0;
-         //shared terms
-         for (j=0;j<nComp;j++) 
-          if (X[j]>0)
-           *vals+=X[j]*(compounds[j]->CpCorrelation->IntValueOverT(T)-GAS_CONSTANT*log(X[j]));  
-         if (phaseID==Vapor)
-          {//pressure term
-           *vals-=GAS_CONSTANT*log(P/REFERENCE_PRESSURE);
-          }
-         else
-          {//pressure and hVap terms
-           for (j=0;j<nComp;j++) 
-            if (X[j]>0)
-             *vals-=X[j]*(GAS_CONSTANT*log(compounds[j]->pSatCorrelation->Value(T)/REFERENCE_PRESSURE)+
-                         compounds[j]->HvapCorrelation->Value(T)/T);
-          }
-		 break;   
-     case EntropyDT:
-         *vals=0;
-         //shared terms
-         for (j=0;j<nComp;j++) 
-          if (X[j]>0)
-           *vals+=X[j]*compounds[j]->CpCorrelation->Value(T)/T;  
-         if (phaseID==Liquid)
-          {//pressure and hVap terms
-           for (j=0;j<nComp;j++) 
-            if (X[j]>0)
-             *vals-=X[j]*(GAS_CONSTANT*compounds[j]->pSatCorrelation->ValueDT(T)/compounds[j]->pSatCorrelation->Value(T)+
-                         compounds[j]->HvapCorrelation->ValueDT(T)/T
-                         -compounds[j]->HvapCorrelation->Value(T)/(T*T));
+          {vals[j]=cpInt[j];
+           if (phaseID==Liquid) vals[j]-=hvap[j];
           }
 		 break;   
-     case EntropyDP:
-         if (phaseID==Vapor) *vals=-GAS_CONSTANT/P;
-         else *vals=0; //incompressible
-		 break;   
      case EntropyDX:
      case EntropyDn:
          {//most terms are the same, except for d (XlnX) / dX vs d n*(XlnX) / dn as dX/dn is not unity
@@ -656,167 +1394,59 @@ bool PropertyPackage::GetSinglePhaseProperties(int nComp,const int *compIndices,
            }
           //shared terms
           for (j=0;j<nComp;j++) 
-           {vals[j]=compounds[j]->CpCorrelation->IntValueOverT(T);
+           {vals[j]=cpIntOverT[j];
             //add -RlnX, where -RlnX is -infinity for X=0; we take -1e200
-            double d=-GAS_CONSTANT*log(X[j]);
+            double d=-GAS_CONSTANT*lnX[j];
             if (!_finite(d)) d=-1e200; else if (d<-1e200) d=-1e200; //force continuity
             vals[j]+=d-GAS_CONSTANT+correction;
            }
           if (phaseID==Liquid)
            {//pressure and hVap terms
             for (j=0;j<nComp;j++) 
-             vals[j]-=(GAS_CONSTANT*log(compounds[j]->pSatCorrelation->Value(T)/REFERENCE_PRESSURE)+
-                         compounds[j]->HvapCorrelation->Value(T)/T);
+             vals[j]-=(GAS_CONSTANT*log(psat[j]/REFERENCE_PRESSURE)+
+                         hvap[j]/T);
            }
 	         }
 		 break;   
      case Fugacity:
-         if (phaseID==Vapor)
-          {//X*P
-           for (j=0;j<nComp;j++) vals[j]=X[j]*P;
-          }
-         else
-          {//liquid, fug[j]=x[j]*Psat[j]
-           for (j=0;j<nComp;j++) vals[j]=X[j]*compounds[j]->pSatCorrelation->Value(T);
-          }
+     case FugacityCoefficient:
+     case LogFugacityCoefficient:
+         {double lnP=log(P);
+          for (j=0;j<nComp;j++) vals[j]=CompoundFugacity<double>(propIDs[i],phaseID,P,lnP,X[j],psat,psatDT,j);
+         }
 		 break;   
      case FugacityDT:
-         if (phaseID==Vapor)
-          {//d/dT X*P = 0
-           for (j=0;j<nComp;j++) vals[j]=0;
-          }
-         else
-          {//liquid, fug[j]=x[j]*Psat[j]
-           for (j=0;j<nComp;j++) vals[j]=X[j]*compounds[j]->pSatCorrelation->ValueDT(T);
-          }
-		 break;   
      case FugacityDP:
-         if (phaseID==Vapor)
-          {//d/dT X*P = X
-           for (j=0;j<nComp;j++) vals[j]=X[j];
-          }
-         else
-          {//liquid, incompressible
-           for (j=0;j<nComp;j++) vals[j]=0;
-          }
-		 break;   
-     case FugacityDX:
-          if (phaseID==Vapor)
-          {//d/dT X*P = P * identity
-           memset(vals,0,sizeof(double)*nComp*nComp);
-           for (j=0;j<nComp;j++) vals[j+nComp*j]=P;
-          }
-         else
-          {//liquid, fug[j]=x[j]*Psat[j]
-           memset(vals,0,sizeof(double)*nComp*nComp);
-           for (j=0;j<nComp;j++) vals[j+nComp*j]=compounds[j]->pSatCorrelation->Value(T);
-          }
-		 break;   
-     case FugacityDn:
-         //for a total of 1 moles:
-         //d X[i] / d n[i] = 1-X[i]
-         //d X[i] / d n[j] = -X[i]
-         if (phaseID==Vapor)
-          {index=0;
-           for (j=0;j<nComp;j++)
-            {for (k=0;k<nComp;k++)
-              {//d X[k] / d n[j]
-               if (k==j) vals[index]=P*(1.0-X[k]); else vals[index]=-X[k]*P;
-               index++;
-              }
-            }
-          }
-         else
-          {index=0;
-           vector<double> PSat;
-           PSat.resize(nComp);
-           for (j=0;j<nComp;j++) PSat[j]=compounds[j]->pSatCorrelation->Value(T);
-           for (j=0;j<nComp;j++)
-            {for (k=0;k<nComp;k++)
-              {//d X[k] / d n[j]
-               if (k==j) vals[index]=PSat[k]*(1.0-X[k]); else vals[index]=-X[k]*PSat[k];
-               index++;
-              }
-            }
-          }
-		 break;   
-     case FugacityCoefficient:
-         if (phaseID==Vapor)
-          {//unity
-           for (j=0;j<nComp;j++) vals[j]=1.0;
-          }
-         else
-          {//liquid, fug[j]=x[j]*Psat[j]=phi[j]*x[j]*P -> phi[j]=Psat[j]/P
-           double invP=1.0/P;
-           for (j=0;j<nComp;j++) vals[j]=compounds[j]->pSatCorrelation->Value(T)*invP;
-          }
-		 break;   
      case FugacityCoefficientDT:
-         if (phaseID==Vapor)
-          {//zero
-           for (j=0;j<nComp;j++) vals[j]=0.0;
-          }
-         else
-          {//liquid
-           double invP=1.0/P;
-           for (j=0;j<nComp;j++) vals[j]=compounds[j]->pSatCorrelation->ValueDT(T)*invP;
-          }
-		 break;   
      case FugacityCoefficientDP:
-         if (phaseID==Vapor)
-          {//zero
-           for (j=0;j<nComp;j++) vals[j]=0.0;
-          }
-         else
-          {//liquid
-           double invP2=-1.0/(P*P);
-           for (j=0;j<nComp;j++) vals[j]=compounds[j]->pSatCorrelation->Value(T)*invP2;
-          }
-		 break;   
-     case FugacityCoefficientDX:
-     case FugacityCoefficientDn:
-         //zero for all phases
-         memset(vals,0,sizeof(double)*nComp*nComp);
-		 break;   
-     case LogFugacityCoefficient:
-         if (phaseID==Vapor)
-          {//ln(unity)=0
-           for (j=0;j<nComp;j++) vals[j]=0.0;
-          }
-         else
-          {//liquid, ln(phi[j])=ln(Psat[j]/P)
-           double lnP=log(P);
-           for (j=0;j<nComp;j++) vals[j]=log(compounds[j]->pSatCorrelation->Value(T))-lnP;
-          }
-		 break;   
      case LogFugacityCoefficientDT:
-         if (phaseID==Vapor)
-          {//d/dT ln(unity)=0
-           for (j=0;j<nComp;j++) vals[j]=0.0;
-          }
-         else
-          {//liquid
-           for (j=0;j<nComp;j++) vals[j]=compounds[j]->pSatCorrelation->ValueDT(T)/compounds[j]->pSatCorrelation->Value(T);
-          }
-		 break;   
      case LogFugacityCoefficientDP:
-         if (phaseID==Vapor)
-          {//d/dP ln(unity)=0
-           for (j=0;j<nComp;j++) vals[j]=0.0;
-          }
-         else
-          {//liquid
-           double minInvP=-1.0/P;
-           for (j=0;j<nComp;j++) vals[j]=minInvP;
-          }
+         {//value and derivatives in one sweep
+          SinglePhaseProperty group=SINGLE_PHASE_GROUP(propIDs[i]);
+          bool derivativeDT=(SINGLE_PHASE_DERIVATIVE(propIDs[i])==1);
+          DualNumber lnPd=log(Pd);
+          for (j=0;j<nComp;j++) 
+           {DualNumber d=CompoundFugacity(group,phaseID,Pd,lnPd,X[j],psat,psatDT,j);
+            vals[j]=derivativeDT?d.dT:d.dP;
+           }
+         }
 		 break;   
+     case FugacityDX:
+     case FugacityDn:
+     case FugacityCoefficientDX:
+     case FugacityCoefficientDn:
      case LogFugacityCoefficientDX:
      case LogFugacityCoefficientDn:
-         memset(vals,0,sizeof(double)*nComp*nComp);
+     case ActivityDX:
+     case ActivityDn:
+         //matrices are formed from their structured form
+         if (!matrixValues) matrixValues=ws.scratch.Allocate(3*nComp);
+         if (!SinglePhaseMatrix(ws,propIDs[i],phaseID,nComp,P,X,psat,matrixValues,matrix)) return false;
+         matrix.Expand(vals);
 		 break;   
      case Activity:
          if (phaseID==Vapor)
-          {lastError="Activity not supported for vapor phase";
+          {ws.lastError="Activity not supported for vapor phase";
            return false;
           }
          //liquid activity coefficent is unity, activity therefore equals X
@@ -825,40 +1455,14 @@ bool PropertyPackage::GetSinglePhaseProperties(int nComp,const int *compIndices,
      case ActivityDT:
      case ActivityDP:
          if (phaseID==Vapor)
-          {lastError="Activity not supported for vapor phase";
+          {ws.lastError="Activity not supported for vapor phase";
            return false;
           }
          //zero
          for (j=0;j<nComp;j++) vals[j]=0;
 		 break;   
-     case ActivityDX:
-         if (phaseID==Vapor)
-          {lastError="Activity not supported for vapor phase";
-           return false;
-          }
-         //identity matrix
-         memset(vals,0,sizeof(double)*nComp*nComp);
-         for (j=0;j<nComp;j++) vals[j+nComp*j]=1.0;
-		 break;   
-     case ActivityDn:
-         if (phaseID==Vapor)
-          {lastError="Activity not supported for vapor phase";
-           return false;
-          }
-         //for a total of 1 moles:
-         //d X[i] / d n[i] = 1-X[i]
-         //d X[i] / d n[j] = -X[i]
-         index=0;
-         for (j=0;j<nComp;j++)
-          {for (k=0;k<nComp;k++)
-            {//d X[k] / d n[j]
-             if (k==j) vals[index]=1.0-X[k]; else vals[index]=-X[k];
-             index++;
-            }
-          }
-		 break;   
      default:
-         lastError="Internal error: property calculation not defined";
+         ws.lastError="Internal error: property calculation not defined";
          return false;
     }    
   }
@@ -866,17 +1470,230 @@ bool PropertyPackage::GetSinglePhaseProperties(int nComp,const int *compIndices,
  return true;
 }
 
-//! Get two-phase mixture properties at specified temperature, pressure and composition
+//! Structured form of a single-phase composition-derivative matrix
+/*!
+  Internal routine that evaluates a matrix-valued single-phase property in 
+  structured form; for the ideal models of this package, the matrices are zero,
+  diagonal, or diagonal plus rank-one. Element [j][k] is the derivative of the 
+  value of compound k with respect to the mole fraction or number of compound j.
+  \param ws Workspace receiving the error
+  \param propID The property, a matrix-valued property
+  \param phaseID ID of the phase
+  \param nComp Number of compounds in the mixture
+  \param P Pressure [Pa]
+  \param X Mole fractions [mol/mol], one value for each compound
+  \param psat Vapor pressure of each compound; only used for the fugacity of the liquid phase
+  \param values Receives the vectors of the matrix, room for 3*nComp values
+  \param matrix Receives the matrix, pointing into values
+  \return True if ok
+  \sa GetSinglePhaseMatrix(), SinglePhaseProperties(), StructuredMatrix
+*/
+
+bool PropertyPackage::SinglePhaseMatrix(PropertyWorkspace &ws,SinglePhaseProperty propID,Phase phaseID,int nComp,double P,const double *X,const double *psat,double *values,StructuredMatrix &matrix) const
+{int j;
+ double *diagonal=values;
+ double *u=values+nComp;
+ double *v=u+nComp;
+ matrix=StructuredMatrix();
+ matrix.rows=matrix.columns=nComp;
+ switch (propID)
+  {case FugacityDX:
+   case FugacityDn:
+       //fug[j]=X[j]*P for vapor, X[j]*Psat[j] for liquid
+       if (phaseID==Vapor) for (j=0;j<nComp;j++) diagonal[j]=P;
+       else for (j=0;j<nComp;j++) diagonal[j]=psat[j];
+       matrix.structure=DiagonalMatrix;
+       if (propID==FugacityDn)
+        {//for a total of 1 moles:
+         //d X[k] / d n[k] = 1-X[k]
+         //d X[k] / d n[j] = -X[k]
+         for (j=0;j<nComp;j++) 
+          {u[j]=1.0;
+           v[j]=-X[j]*diagonal[j];
+          }
+         matrix.structure=DiagonalPlusRankOneMatrix;
+        }
+       break;
+   case FugacityCoefficientDX:
+   case FugacityCoefficientDn:
+   case LogFugacityCoefficientDX:
+   case LogFugacityCoefficientDn:
+       //zero for all phases
+       return true;
+   case ActivityDX:
+   case ActivityDn:
+       if (phaseID==Vapor)
+        {ws.lastError="Activity not supported for vapor phase";
+         return false;
+        }
+       //liquid activity equals X: the identity matrix, for ActivityDn with the rank-one term of dX/dn
+       for (j=0;j<nComp;j++) diagonal[j]=1.0;
+       matrix.structure=DiagonalMatrix;
+       if (propID==ActivityDn)
+        {for (j=0;j<nComp;j++) 
+          {u[j]=1.0;
+           v[j]=-X[j];
+          }
+         matrix.structure=DiagonalPlusRankOneMatrix;
+        }
+       break;
+   default:
+       ws.lastError="Property is not a composition-derivative matrix";
+       return false;
+  }
+ matrix.diagonal=diagonal;
+ if (matrix.structure==DiagonalPlusRankOneMatrix)
+  {matrix.u=u;
+   matrix.v=v;
+  }
+ return true;
+}
+
+//! Get a single-phase composition-derivative matrix in structured form
+/*!
+  Get one of the matrix-valued single-phase properties (FugacityDX, FugacityDn, 
+  FugacityCoefficientDX, FugacityCoefficientDn, LogFugacityCoefficientDX, 
+  LogFugacityCoefficientDn, ActivityDX or ActivityDn) as a StructuredMatrix, 
+  with the inputs checked as by GetSinglePhaseProperties(). Only O(nComp) values 
+  are evaluated and stored; the dense matrix is formed by StructuredMatrix::Expand()
+  if needed.
+  \param ws Workspace that receives the matrix values and the error
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param phaseID ID of the phase for which to calculate the property
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions [mol/mol], one value for each compound, assumed normalized
+  \param propID ID of the property, a matrix-valued property
+  \param matrix Receives the matrix; its vectors are valid until the next calculation on ws
+  \return True if ok
+  \sa GetSinglePhaseProperties(), StructuredMatrix
+*/
+
+bool PropertyPackage::GetSinglePhaseMatrix(PropertyWorkspace &ws,int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X,SinglePhaseProperty propID,StructuredMatrix &matrix) const
+{ws.scratch.Reset();
+ if (!CheckSinglePhaseInputs(ws,nComp,compIndices,phaseID,T,P,X)) return false;
+ return SinglePhaseMatrix(ws,correlations,compIndices,nComp,phaseID,T,P,X,propID,matrix);
+}
+
+//! Get a single-phase composition-derivative matrix of a prepared mixture in structured form
+/*!
+  As GetSinglePhaseMatrix() with compound indices, for a mixture that has been prepared
+  by PrepareMixture()
+  \param ws Workspace that receives the matrix values and the error
+  \param mixture Mixture prepared for this property package
+  \param phaseID ID of the phase for which to calculate the property
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions [mol/mol], one value for each compound of the mixture, assumed normalized
+  \param propID ID of the property, a matrix-valued property
+  \param matrix Receives the matrix; its vectors are valid until the next calculation on ws
+  \return True if ok
+  \sa PrepareMixture(), StructuredMatrix
+*/
+
+bool PropertyPackage::GetSinglePhaseMatrix(PropertyWorkspace &ws,const PreparedMixture &mixture,Phase phaseID,double T,double P,const double *X,SinglePhaseProperty propID,StructuredMatrix &matrix) const
+{ws.scratch.Reset();
+ if (!CheckSinglePhaseInputs(ws,mixture,phaseID,T,P,X)) return false;
+ return SinglePhaseMatrix(ws,mixture.correlations,NULL,mixture.CompoundCount(),phaseID,T,P,X,propID,matrix);
+}
+
+//! Structured single-phase composition-derivative matrix, after checking the inputs
+/*!
+  Internal routine that evaluates the pure component values that a matrix-valued
+  property needs, and the matrix into the value buffer of the workspace
+  \param ws Workspace that receives the matrix values and the error
+  \param table Correlation table of the compounds
+  \param tableIndices Indices of the compounds in the table, NULL if all compounds of the table in order
+  \param nComp Number of compounds in the mixture
+  \param phaseID ID of the phase
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions [mol/mol], one value for each compound
+  \param propID ID of the property
+  \param matrix Receives the matrix
+  \return True if ok
+  \sa GetSinglePhaseMatrix()
+*/
+
+bool PropertyPackage::SinglePhaseMatrix(PropertyWorkspace &ws,const CorrelationTable &table,const int *tableIndices,int nComp,Phase phaseID,double T,double P,const double *X,SinglePhaseProperty propID,StructuredMatrix &matrix) const
+{int needed;
+ if ((propID<0)||(propID>=SinglePhasePropertyCount)||(SinglePhasePropertyDimension[propID]!=DIMENSION_MATRIX))
+  {ws.lastError="Property is not a composition-derivative matrix";
+   return false;
+  }
+ needed=PlanIntermediates(SinglePhaseIntermediates(propID,phaseID));
+ double *pure=PureComponentValues(ws,table,tableIndices,nComp,T,needed&PURE_COMPONENT_INTERMEDIATES);
+ if (ws.values.size()<(size_t)(3*nComp+1)) ws.values.resize(3*nComp+1);
+ return SinglePhaseMatrix(ws,propID,phaseID,nComp,P,X,pure+IntermediatePSat*nComp,VECPTR(ws.values),matrix);
+}
+
+//! Get single-phase mixture properties at specified temperature, pressure and composition
+/*!
+  As GetSinglePhaseProperties() with workspace argument, using the workspace of this 
+  PropertyPackage. The return values are only valid until the next call to 
+  GetSinglePhaseProperties, GetTwoPhaseProperties or Flash without workspace argument.
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param phaseID ID of the phase for which to calculate the properties
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions [mol/mol], one value for each compound, assumed normalized
+  \param nProp Number of properties requested
+  \param propIDs IDs of the properties requested
+  \param ValueCount Receives the number of values for each of the properties, one value for each property
+  \param Values Receives the values, one double array for each property. Size of the array corresponds to valueCount for each property
+  \return True if ok
+  \sa GetCompoundCount(), LastError(), Phase, SinglePhaseProperty
+*/
+
+bool PropertyPackage::GetSinglePhaseProperties(int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int *&ValueCount,double **&Values)
+{if (!GetSinglePhaseProperties(workspace,nComp,compIndices,phaseID,T,P,X,nProp,propIDs,ValueCount,Values))
+  {lastError=workspace.lastError;
+   return false;
+  }
+ return true;
+}
+
+//! Get single-phase mixture properties into caller-supplied buffers
+/*!
+  As GetSinglePhaseProperties() with workspace argument and caller-supplied buffers, using 
+  the workspace of this PropertyPackage. 
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param phaseID ID of the phase for which to calculate the properties
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions [mol/mol], one value for each compound, assumed normalized
+  \param nProp Number of properties requested
+  \param propIDs IDs of the properties requested
+  \param valueCapacity Number of values that fit in values
+  \param valueCount Receives the number of values for each of the properties, one value for each property
+  \param values Receives the values of all properties, those of each property following those of the previous property
+  \return True if ok
+  \sa GetSinglePhasePropertySizes(), LastError(), Phase, SinglePhaseProperty
+*/
+
+bool PropertyPackage::GetSinglePhaseProperties(int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values)
+{if (!GetSinglePhaseProperties(workspace,nComp,compIndices,phaseID,T,P,X,nProp,propIDs,valueCapacity,valueCount,values))
+  {lastError=workspace.lastError;
+   return false;
+  }
+ return true;
+}
+
+//! Get two-phase mixture properties at specified temperature, pressure and composition
 /*!
   Calculate and get two-phase mixture properties. The properties are returned in arrays 
-  that are allocated and stored by this DLL. The return values are only valid until the next
-  call to GetSinglePhaseProperties, GetTwoPhaseProperties or Flash, so store the return values, but 
-  not the pointers to them. Multiple properties can be requested in a single call. For each
+  that are allocated and stored in the workspace. The return values are only valid until the next
+  call to GetSinglePhaseProperties, GetTwoPhaseProperties or Flash with the same workspace, so store 
+  the return values, but not the pointers to them. Multiple properties can be requested in a single call. For each
   property, the values and number of values are returned
   
   The only supported properties are kvalue, which is fugacity of phase 2 divided by fugacity of phase 1
   and log(kvalue).
   
+  \param ws Workspace that receives the return values and the error
   \param nComp Number of compounds in the mixture
   \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
   \param phaseID1 ID of the first phase for which to calculate the property
@@ -895,136 +1712,148 @@ bool PropertyPackage::GetSinglePhaseProperties(int nComp,const int *compIndices,
   \sa GetCompoundCount(), LastError(), Phase, TwoPhaseProperty
 */
 
-bool PropertyPackage::GetTwoPhaseProperties(int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2,int nProp,TwoPhaseProperty *propIDs,int *&ValueCount,double **&Values)
-{//this implementation is for instructive purposes only; a production implementation would use
- // stored values for combined property evaluations, THIS ROUTINE DOES NOT TAKE ADVANTAGE OF 
- // SIMULTANEOUS PROPERTY CALCULATIONS!!!
- int i,j;
- if (!initialized)
-  {lastError="Property package has not been initialized";
-   return false;
-  }
- //check the inputs
- if ((phaseID1!=Vapor)&&(phaseID1!=Liquid))
-  {lastError="Invalid phase ID 1";
-   return false;
+bool PropertyPackage::GetTwoPhaseProperties(PropertyWorkspace &ws,int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2,int nProp,TwoPhaseProperty *propIDs,int *&ValueCount,double **&Values) const
+{int totalCount;
+ //invalid property IDs are counted as zero values here; the error is reported by the calculation
+ GetTwoPhasePropertySizes(nComp,nProp,propIDs,NULL,totalCount);
+ AllocatePropertyResults(ws,nProp,totalCount);
+ if (!GetTwoPhaseProperties(ws,nComp,compIndices,phaseID1,phaseID2,T1,T2,P1,P2,X1,X2,nProp,propIDs,totalCount,VECPTR(ws.valueCounts),VECPTR(ws.values))) return false;
+ AssignPropertyResults(ws,nProp,ValueCount,Values);
+ return true;
+}
+
+//! Get the number of values of two-phase mixture properties
+/*!
+  Get the sizes of the buffers that GetTwoPhaseProperties() with caller-supplied 
+  buffers needs for a set of properties. The sizes only depend on the number of 
+  compounds and the properties.
+  \param nComp Number of compounds in the mixture
+  \param nProp Number of properties requested
+  \param propIDs IDs of the properties requested
+  \param valueCount Receives the number of values for each of the properties, one value for each property; can be NULL
+  \param totalCount Receives the total number of values of all properties
+  \return False if one or more of the property IDs is invalid; an invalid property is counted as zero values
+  \sa GetTwoPhaseProperties(), TwoPhaseProperty
+*/
+
+bool PropertyPackage::GetTwoPhasePropertySizes(int nComp,int nProp,const TwoPhaseProperty *propIDs,int *valueCount,int &totalCount)
+{int i,dim,nVal;
+ bool ok=true;
+ totalCount=0;
+ for (i=0;i<nProp;i++)
+  {if ((propIDs[i]<0)||(propIDs[i]>=TwoPhasePropertyCount))
+    {nVal=0;
+     ok=false;
+    }
+   else 
+    {nVal=1;
+     dim=TwoPhasePropertyDimension[propIDs[i]];
+     if (dim==DIMENSION_MATRIX) nVal=2; //as we only serve vector properties, a matrix is a derivative. Values for both phases are returned
+     while (dim)
+      {nVal*=nComp;
+       dim--;
+      }
+    }
+   if (valueCount) valueCount[i]=nVal;
+   totalCount+=nVal;
   }
- if ((phaseID2!=Vapor)&&(phaseID2!=Liquid))
-  {lastError="Invalid phase ID 2";
+ return ok;
+}
+
+//! Get two-phase mixture properties into caller-supplied buffers
+/*!
+  As GetTwoPhaseProperties() with workspace argument, but the values are written into 
+  buffers of the caller rather than into the workspace. The values of all properties are
+  stored consecutively, in the order of the properties. The required size of the buffer 
+  is obtained from GetTwoPhasePropertySizes().
+  \param ws Workspace that receives the error
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param phaseID1 ID of the first phase for which to calculate the property
+  \param phaseID2 ID of the second phase for which to calculate the property
+  \param T1 Temperature of phase 1[K]
+  \param T2 Temperature of phase 2[K]
+  \param P1 Pressure of phase 1 [Pa]
+  \param P2 Pressure of phase 2 [Pa]
+  \param X1 Mole fractions for phase 1 [mol/mol], one value for each compound, assumed normalized
+  \param X2 Mole fractions for phase 2 [mol/mol], one value for each compound, assumed normalized
+  \param nProp Number of properties requested
+  \param propIDs IDs of the properties requested
+  \param valueCapacity Number of values that fit in values
+  \param valueCount Receives the number of values for each of the properties, one value for each property
+  \param values Receives the values of all properties, those of each property following those of the previous property
+  \return True if ok
+  \sa GetTwoPhasePropertySizes(), LastError(), Phase, TwoPhaseProperty
+*/
+
+bool PropertyPackage::GetTwoPhaseProperties(PropertyWorkspace &ws,int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2,int nProp,TwoPhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values) const
+{//the vapor pressures and their temperature derivatives that the requested properties need are
+ // evaluated once for all properties, or taken from the pure component cache
+ int i,j;
+ ws.scratch.Reset();
+ if (!CheckTwoPhaseInputs(ws,nComp,compIndices,phaseID1,phaseID2,T1,T2,P1,P2,X1,X2)) return false;
+ //check the properties and the size of the buffer
+ int offset;
+ if (!GetTwoPhasePropertySizes(nComp,nProp,propIDs,valueCount,offset))
+  {ws.lastError="One or more invalid two-phase property IDs";
    return false;
   }
- if (phaseID1==phaseID2)
-  {lastError="Phases 1 and 2 cannot be the same";
+ if (offset>valueCapacity) //offset now contains total count
+  {ws.lastError="Buffer is too small for the values of the requested properties";
    return false;
   }
- for (i=0;i<nComp;i++)
-  {if ((compIndices[i]<0)||(compIndices[i]>=(int)compounds.size()))
-    {lastError="Compound index out of range";
-     return false;
-    }
-   for (j=0;j<i;j++) 
-    if (compIndices[i]==compIndices[j])
-     {lastError="At least one compound appears in the mixture more than once";
-      return false;
-     }
-   if (T1>compounds[compIndices[i]]->TC)
-    {lastError="Temperature of phase 1 exceeds critical temperature of one of the compounds in the mixture";
-     return false;
-    }
-   if (T2>compounds[compIndices[i]]->TC)
-    {lastError="Temperature of phase 2 exceeds critical temperature of one of the compounds in the mixture";
-     return false;
-    }
-   //note: this routine does not actually use compositions; all K values are independent of compositions
-   if (_isnan(X1[i]))
-    {lastError="At least one value for composition of phase 1 is missing";
-     return false;
-    }
-   if (_isnan(X2[i]))
-    {lastError="At least one value for composition of phase 2 is missing";
-     return false;
-    }
-   if (!_finite(X1[i]))
-    {lastError="At least one value for composition of phase 1 is not finite";
-     return false;
-    }
-   if (!_finite(X2[i]))
-    {lastError="At least one value for composition of phase 2 is not finite";
-     return false;
-    }
-   if (X1[i]<0)
-    {lastError="At least one value for composition of phase 1 is negative";
-     return false;
-    }
-   if (X2[i]<0)
-    {lastError="At least one value for composition of phase 2 is negative";
-     return false;
-    }
-  }
- //even though we only use T and P of the liquid phase, we expect both of them to be valid
- // (mostly they would be equal in any case)
- if (!CheckTemperature(T1)) return false;
- if (!CheckTemperature(T2)) return false;
- if (!CheckPressure(P1)) return false;
- if (!CheckPressure(P2)) return false;
- //check the properties and allocate and assign the return values
- int offset;
- valueCounts.resize(nProp);
- valueOffsets.resize(nProp);
- valuePointers.resize(nProp);
- offset=0;
- for (i=0;i<nProp;i++)
-  {//get the number of values for this property
-   if ((propIDs[i]<0)||(propIDs[i]>=TwoPhasePropertyCount))
-    {lastError="One or more invalid two-phase property IDs";
-     return false;
-    }
-   int nVal=1;
-   int dim=TwoPhasePropertyDimension[propIDs[i]];
-   if (dim==DIMENSION_MATRIX) nVal=2; //as we only serve vector properties, a matrix is a derivative. Values for both phases are returned
-   while (dim)
-    {nVal*=nComp;
-     dim--;
-    }
-   valueCounts[i]=nVal;
-   valueOffsets[i]=offset;
-   offset+=nVal;
-  }
- values.resize(offset); //offset now contains total count
- for (i=0;i<nProp;i++) valuePointers[i]=VECPTR(values)+valueOffsets[i];
- ValueCount=VECPTR(valueCounts);
- Values=VECPTR(valuePointers);
+ //per-compound vapor pressures at the liquid temperature, from the cache where available
+ int needed=0;
+ for (i=0;i<nProp;i++) 
+  switch (propIDs[i])
+   {case Kvalue: 
+    case KvalueDP: 
+    case LogKvalue:
+         needed|=INTERMEDIATE(IntermediatePSat);
+         break;
+    case KvalueDT: 
+    case LogKvalueDT:
+         needed|=INTERMEDIATE(IntermediatePSat)|INTERMEDIATE(IntermediatePSatDT);
+         break;
+    default:
+         break;
+   }
+ double *pure=PureComponentValues(ws,correlations,compIndices,nComp,(phaseID1==Vapor)?T2:T1,needed);
+ const double *psat=pure+IntermediatePSat*nComp;
+ const double *psatDT=pure+IntermediatePSatDT*nComp;
  //calculate the properties
  // Kvalue = FugacityCoefficient2/FugacityCoefficient1
  //  if phase 2 is Liquid, then phase 1 must be Vapor and Kvalue = Psat/P/1 = Psat/P
  //  if phase 1 is Liquid, then phase 2 must be Vapor and Kvalue = 1/(Psat/P) = P/Psat
  // so the K values depend on pressure and temperature (Psat=f(T)) but not on composition 
  // here, P and T are those of the liquid phase
+ offset=0;
  for (i=0;i<nProp;i++) 
-  {double *vals=valuePointers[i];
+  {double *vals=values+offset;
+   offset+=valueCount[i];
    switch (propIDs[i])
     {case Kvalue:
          if (phaseID1==Vapor) 
           {//Kvalue = Psat(T2)/P2
            double invP=1.0/P2;
-           for (j=0;j<nComp;j++) vals[j]=compounds[j]->pSatCorrelation->Value(T2)*invP;
+           for (j=0;j<nComp;j++) vals[j]=psat[j]*invP;
           }
          else 
           {//Kvalue = P1/Psat(T1)
-           for (j=0;j<nComp;j++) vals[j]=P1/compounds[j]->pSatCorrelation->Value(T1);
+           for (j=0;j<nComp;j++) vals[j]=P1/psat[j];
           }
 		 break;   
      case KvalueDT:
          if (phaseID1==Vapor) 
           {//Kvalue = Psat(T2)/P2
            double invP=1.0/P2;
-           for (j=0;j<nComp;j++) vals[j]=compounds[j]->pSatCorrelation->ValueDT(T2)*invP;
+           for (j=0;j<nComp;j++) vals[j]=psatDT[j]*invP;
           }
          else 
           {//Kvalue = P1/Psat(T1)
            for (j=0;j<nComp;j++) 
-            {double Psat=compounds[j]->pSatCorrelation->Value(T1);
-             vals[j]=-P1*compounds[j]->pSatCorrelation->ValueDT(T1)/(Psat*Psat);
+            {double Psat=psat[j];
+             vals[j]=-P1*psatDT[j]/(Psat*Psat);
             }
           }
 		 break;   
@@ -1032,11 +1861,11 @@ bool PropertyPackage::GetTwoPhaseProperties(int nComp,const int *compIndices,Pha
          if (phaseID1==Vapor) 
           {//Kvalue = Psat(T2)/P2
            double invP2=-1.0/(P2*P2);
-           for (j=0;j<nComp;j++) vals[j]=compounds[j]->pSatCorrelation->Value(T2)*invP2;
+           for (j=0;j<nComp;j++) vals[j]=psat[j]*invP2;
           }
          else 
           {//Kvalue = P1/Psat(T1)
-           for (j=0;j<nComp;j++) vals[j]=1.0/compounds[j]->pSatCorrelation->Value(T1);
+           for (j=0;j<nComp;j++) vals[j]=1.0/psat[j];
           }
 		 break;   
      case LogKvalue: 
@@ -1044,21 +1873,21 @@ bool PropertyPackage::GetTwoPhaseProperties(int nComp,const int *compIndices,Pha
          if (phaseID1==Vapor) 
           {//Kvalue = Psat(T2)/P2
            double invP=1.0/P2;
-           for (j=0;j<nComp;j++) vals[j]=log(compounds[j]->pSatCorrelation->Value(T2)*invP);
+           for (j=0;j<nComp;j++) vals[j]=log(psat[j]*invP);
           }
          else 
           {//Kvalue = P1/Psat(T1)
-           for (j=0;j<nComp;j++) vals[j]=log(P1/compounds[j]->pSatCorrelation->Value(T1));
+           for (j=0;j<nComp;j++) vals[j]=log(P1/psat[j]);
           }
 		 break;   
      case LogKvalueDT:
          if (phaseID1==Vapor) 
           {//Kvalue = Psat(T2)/P2
-           for (j=0;j<nComp;j++) vals[j]=compounds[j]->pSatCorrelation->ValueDT(T2)/compounds[j]->pSatCorrelation->Value(T2);
+           for (j=0;j<nComp;j++) vals[j]=psatDT[j]/psat[j];
           }
          else 
           {//Kvalue = P1/Psat(T1)
-           for (j=0;j<nComp;j++) vals[j]=-compounds[j]->pSatCorrelation->ValueDT(T1)/compounds[j]->pSatCorrelation->Value(T1);
+           for (j=0;j<nComp;j++) vals[j]=-psatDT[j]/psat[j];
           }
 		 break;   
      case LogKvalueDP:
@@ -1081,7 +1910,7 @@ bool PropertyPackage::GetTwoPhaseProperties(int nComp,const int *compIndices,Pha
          memset(vals,0,2*nComp*nComp*sizeof(double));
 		 break;   
      default:
-         lastError="Internal error: property calculation not defined";
+         ws.lastError="Internal error: property calculation not defined";
          return false;
     }    
   }
@@ -1089,12 +1918,197 @@ bool PropertyPackage::GetTwoPhaseProperties(int nComp,const int *compIndices,Pha
  return true;
 }
 
+//! Check the inputs of a two-phase calculation
+/*!
+  Internal routine that checks the inputs of the two-phase calculations, sets 
+  the error in case not ok
+  \param ws Workspace receiving the error
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture
+  \param phaseID1 ID of the first phase
+  \param phaseID2 ID of the second phase
+  \param T1 Temperature of phase 1 [K]
+  \param T2 Temperature of phase 2 [K]
+  \param P1 Pressure of phase 1 [Pa]
+  \param P2 Pressure of phase 2 [Pa]
+  \param X1 Mole fractions for phase 1 [mol/mol], one value for each compound
+  \param X2 Mole fractions for phase 2 [mol/mol], one value for each compound
+  \return True if ok
+  \sa GetTwoPhaseProperties(), GetTwoPhaseMatrix()
+*/
+
+bool PropertyPackage::CheckTwoPhaseInputs(PropertyWorkspace &ws,int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2) const
+{int i;
+ if (!initialized)
+
+  {ws.lastError="Property package has not been initialized";
+   return false;
+  }
+ //check the inputs
+ if ((phaseID1!=Vapor)&&(phaseID1!=Liquid))
+  {ws.lastError="Invalid phase ID 1";
+   return false;
+  }
+ if ((phaseID2!=Vapor)&&(phaseID2!=Liquid))
+  {ws.lastError="Invalid phase ID 2";
+   return false;
+  }
+ if (phaseID1==phaseID2)
+  {ws.lastError="Phases 1 and 2 cannot be the same";
+   return false;
+  }
+ if (!CheckCompoundIndices(ws,nComp,compIndices)) return false;
+ for (i=0;i<nComp;i++)
+  {if (T1>compounds[compIndices[i]]->TC)
+    {ws.lastError="Temperature of phase 1 exceeds critical temperature of one of the compounds in the mixture";
+     return false;
+    }
+   if (T2>compounds[compIndices[i]]->TC)
+    {ws.lastError="Temperature of phase 2 exceeds critical temperature of one of the compounds in the mixture";
+     return false;
+    }
+   //note: this routine does not actually use compositions; all K values are independent of compositions
+   if (_isnan(X1[i]))
+    {ws.lastError="At least one value for composition of phase 1 is missing";
+     return false;
+    }
+   if (_isnan(X2[i]))
+    {ws.lastError="At least one value for composition of phase 2 is missing";
+     return false;
+    }
+   if (!_finite(X1[i]))
+    {ws.lastError="At least one value for composition of phase 1 is not finite";
+     return false;
+    }
+   if (!_finite(X2[i]))
+    {ws.lastError="At least one value for composition of phase 2 is not finite";
+     return false;
+    }
+   if (X1[i]<0)
+    {ws.lastError="At least one value for composition of phase 1 is negative";
+     return false;
+    }
+   if (X2[i]<0)
+    {ws.lastError="At least one value for composition of phase 2 is negative";
+     return false;
+    }
+  }
+ //even though we only use T and P of the liquid phase, we expect both of them to be valid
+ // (mostly they would be equal in any case)
+ if (!CheckTemperature(ws,T1)) return false;
+ if (!CheckTemperature(ws,T2)) return false;
+ if (!CheckPressure(ws,P1)) return false;
+ return CheckPressure(ws,P2);
+}
+
+//! Get a two-phase composition-derivative matrix in structured form
+/*!
+  Get one of the matrix-valued two-phase properties (KvalueDX, KvalueDn, LogKvalueDX
+  or LogKvalueDn) as a StructuredMatrix, with the inputs checked as by 
+  GetTwoPhaseProperties(). The matrix has 2*nComp rows: the derivatives with respect 
+  to the composition of phase 1 followed by those of phase 2, as in the dense values. 
+  As the K values do not depend on composition, the matrix is always a ZeroMatrix.
+  \param ws Workspace that receives the matrix values and the error
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param phaseID1 ID of the first phase for which to calculate the property
+  \param phaseID2 ID of the second phase for which to calculate the property
+  \param T1 Temperature of phase 1[K]
+  \param T2 Temperature of phase 2[K]
+  \param P1 Pressure of phase 1 [Pa]
+  \param P2 Pressure of phase 2 [Pa]
+  \param X1 Mole fractions for phase 1 [mol/mol], one value for each compound, assumed normalized
+  \param X2 Mole fractions for phase 2 [mol/mol], one value for each compound, assumed normalized
+  \param propID ID of the property, a matrix-valued property
+  \param matrix Receives the matrix
+  \return True if ok
+  \sa GetTwoPhaseProperties(), StructuredMatrix
+*/
+
+bool PropertyPackage::GetTwoPhaseMatrix(PropertyWorkspace &ws,int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2,TwoPhaseProperty propID,StructuredMatrix &matrix) const
+{ws.scratch.Reset();
+ if (!CheckTwoPhaseInputs(ws,nComp,compIndices,phaseID1,phaseID2,T1,T2,P1,P2,X1,X2)) return false;
+ if ((propID<0)||(propID>=TwoPhasePropertyCount)||(TwoPhasePropertyDimension[propID]!=DIMENSION_MATRIX))
+  {ws.lastError="Property is not a composition-derivative matrix";
+   return false;
+  }
+ //no composition dependence for either phase
+ matrix=StructuredMatrix();
+ matrix.rows=2*nComp;
+ matrix.columns=nComp;
+ return true;
+}
+
+//! Get two-phase mixture properties at specified temperature, pressure and composition
+/*!
+  As GetTwoPhaseProperties() with workspace argument, using the workspace of this 
+  PropertyPackage. The return values are only valid until the next call to 
+  GetSinglePhaseProperties, GetTwoPhaseProperties or Flash without workspace argument.
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param phaseID1 ID of the first phase for which to calculate the property
+  \param phaseID2 ID of the second phase for which to calculate the property
+  \param T1 Temperature of phase 1[K]
+  \param T2 Temperature of phase 2[K]
+  \param P1 Pressure of phase 1 [Pa]
+  \param P2 Pressure of phase 2 [Pa]
+  \param X1 Mole fractions for phase 1 [mol/mol], one value for each compound, assumed normalized
+  \param X2 Mole fractions for phase 2 [mol/mol], one value for each compound, assumed normalized
+  \param nProp Number of properties requested
+  \param propIDs IDs of the properties requested
+  \param ValueCount Receives the number of values for each of the properties, one value for each property
+  \param Values Receives the values, one double array for each property. Size of the array corresponds to valueCount for each property
+  \return True if ok
+  \sa GetCompoundCount(), LastError(), Phase, TwoPhaseProperty
+*/
+
+bool PropertyPackage::GetTwoPhaseProperties(int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2,int nProp,TwoPhaseProperty *propIDs,int *&ValueCount,double **&Values)
+{if (!GetTwoPhaseProperties(workspace,nComp,compIndices,phaseID1,phaseID2,T1,T2,P1,P2,X1,X2,nProp,propIDs,ValueCount,Values))
+  {lastError=workspace.lastError;
+   return false;
+  }
+ return true;
+}
+
+//! Get two-phase mixture properties into caller-supplied buffers
+/*!
+  As GetTwoPhaseProperties() with workspace argument and caller-supplied buffers, using 
+  the workspace of this PropertyPackage. 
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param phaseID1 ID of the first phase for which to calculate the property
+  \param phaseID2 ID of the second phase for which to calculate the property
+  \param T1 Temperature of phase 1[K]
+  \param T2 Temperature of phase 2[K]
+  \param P1 Pressure of phase 1 [Pa]
+  \param P2 Pressure of phase 2 [Pa]
+  \param X1 Mole fractions for phase 1 [mol/mol], one value for each compound, assumed normalized
+  \param X2 Mole fractions for phase 2 [mol/mol], one value for each compound, assumed normalized
+  \param nProp Number of properties requested
+  \param propIDs IDs of the properties requested
+  \param valueCapacity Number of values that fit in values
+  \param valueCount Receives the number of values for each of the properties, one value for each property
+  \param values Receives the values of all properties, those of each property following those of the previous property
+  \return True if ok
+  \sa GetTwoPhasePropertySizes(), LastError(), Phase, TwoPhaseProperty
+*/
+
+bool PropertyPackage::GetTwoPhaseProperties(int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2,int nProp,TwoPhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values)
+{if (!GetTwoPhaseProperties(workspace,nComp,compIndices,phaseID1,phaseID2,T1,T2,P1,P2,X1,X2,nProp,propIDs,valueCapacity,valueCount,values))
+  {lastError=workspace.lastError;
+   return false;
+  }
+ return true;
+}
+
 //! Calculate phase equilibrium
 /*!
-  Calculate phase equilibrium. The vaues are returned in arrays that are allocated and stored by 
-  this DLL. The return values are only valid until the next call to GetSinglePhaseProperties, 
-  GetTwoPhaseProperties or Flash, so store the return values, but  not the pointers to them. 
+  Calculate phase equilibrium. The vaues are returned in arrays that are allocated and stored in 
+  the workspace. The return values are only valid until the next call to GetSinglePhaseProperties, 
+  GetTwoPhaseProperties or Flash with the same workspace, so store the return values, but  not the 
+  pointers to them. 
   
+  \param ws Workspace that receives the return values and the error
   \param nComp Number of compounds in the mixture
   \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
   \param X Overall mole fractions[mol/mol], one value for each compound, assumed normalized
@@ -1112,169 +2126,574 @@ bool PropertyPackage::GetTwoPhaseProperties(int nComp,const int *compIndices,Pha
   \sa GetCompoundCount(), LastError(), Phase, FlashType, FlashPhaseType
 */
 
-bool PropertyPackage::Flash(int nComp,const int *compIndices,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *&phases,double *&phaseFractions,double **&phaseCompositions,double &T, double &P)
-{int i,j;
- double H,S,VF;
+bool PropertyPackage::Flash(PropertyWorkspace &ws,int nComp,const int *compIndices,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *&phases,double *&phaseFractions,double **&phaseCompositions,double &T, double &P) const
+{AllocateFlashResults(ws,nComp);
+ if (!Flash(ws,nComp,compIndices,X,type,phaseType,spec1,spec2,phaseCount,VECPTR(ws.existingPhases),VECPTR(ws.values),VECPTR(ws.values)+PhaseCount,T,P)) return false;
+ AssignFlashResults(ws,nComp,phaseCount,phases,phaseFractions,phaseCompositions);
+ return true;
+}
+
+//! Get the sizes of the results of a flash
+/*!
+  Get the sizes of the buffers that Flash() with caller-supplied buffers needs. A flash
+  results in at most PhaseCount phases, regardless of the flash type, so that the sizes
+  only depend on the number of compounds.
+  \param nComp Number of compounds in the mixture
+  \param phaseCapacity Receives the number of values of the phases and phase fractions
+  \param compositionCapacity Receives the number of values of the phase compositions
+  \sa Flash()
+*/
+
+void PropertyPackage::GetFlashResultSizes(int nComp,int &phaseCapacity,int &compositionCapacity)
+{phaseCapacity=PhaseCount;
+ compositionCapacity=PhaseCount*nComp;
+}
+
+//! Calculate phase equilibrium into caller-supplied buffers
+/*!
+  As Flash() with workspace argument, but the results are written into buffers of the 
+  caller rather than into the workspace, so that they remain valid after subsequent calls
+  and no buffers of the workspace are resized. The compositions of the phases are stored
+  consecutively. The required sizes of the buffers are obtained from GetFlashResultSizes().
+  \param ws Workspace that receives the error
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param X Overall mole fractions[mol/mol], one value for each compound, assumed normalized
+  \param type Type of specifications passed (e.g. TP for a temperature and pressure specification)
+  \param phaseType Specified allowed phases in flash. 
+  \param spec1 Value of first specification (e.g. T/[K] for TP)
+  \param spec2 Value of second specification (e.g. P/[Pa] for TP)
+  \param phaseCount Receives the number of phases at equilibrium
+  \param phases Receives the types of the existing phases (Vapor or Liquid); room for PhaseCount values
+  \param phaseFractions Receives the phase fractions of the existing phases [mol/mol]; room for PhaseCount values
+  \param phaseCompositions Receives the compositions of the existing phases [mol/mol]; room for PhaseCount*nComp values, the composition of phase j starts at phaseCompositions[j*nComp]
+  \param T Receives the temperature at equilibrium
+  \param P Receives the pressure at equilibrium
+  \return True if ok
+  \sa GetFlashResultSizes(), LastError(), Phase, FlashType, FlashPhaseType
+*/
+
+bool PropertyPackage::Flash(PropertyWorkspace &ws,int nComp,const int *compIndices,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *phases,double *phaseFractions,double *phaseCompositions,double &T, double &P) const
+{int i;
+ ws.scratch.Reset();
  if (!initialized)
-  {lastError="Property package has not been initialized";
+  {ws.lastError="Property package has not been initialized";
    return false;
   }
- flashPhaseType=phaseType;
+ ws.flashPhaseType=phaseType;
+ ws.solverEvaluations=0;
  //check the inputs, set up compound map as we go (we only consider compounds with non-zero mole fraction)
- flashCompounds.clear();
- flashCompounds.reserve(nComp);
- flashCompoundMapping.clear();
- flashCompoundMapping.reserve(nComp);
- flashComposition.clear();
- flashComposition.reserve(nComp);
+ ws.flashCompounds.clear();
+ ws.flashCompounds.reserve(nComp);
+ ws.flashCompoundMapping.clear();
+ ws.flashCompoundMapping.reserve(nComp);
+ ws.flashComposition.clear();
+ ws.flashComposition.reserve(nComp);
+ if (!CheckCompoundIndices(ws,nComp,compIndices)) return false;
  for (i=0;i<nComp;i++)
-  {if ((compIndices[i]<0)||(compIndices[i]>=(int)compounds.size()))
-    {lastError="Compound index out of range";
-     return false;
-    }
-   for (j=0;j<i;j++) 
-    if (compIndices[i]==compIndices[j])
-     {lastError="At least one compound appears in the mixture more than once";
-      return false;
-     }
-   if (_isnan(X[i]))
-    {lastError="At least one value for composition is missing";
-     return false;
-    }
-   if (!_finite(X[i]))
-    {lastError="At least one value for composition is not finite";
-     return false;
-    }
-   if (X[i]<0)
-    {lastError="At least one value for composition is negative";
-     return false;
+  {if (!CheckComposition(ws,X[i])) return false;
+   if (X[i]>0)
+    {ws.flashCompounds.push_back(compIndices[i]);
+     ws.flashComposition.push_back(X[i]);
+     ws.flashCompoundMapping.push_back(i);
     }
+  }
+ if (ws.flashCompounds.size()==0)
+  {ws.lastError="All compositions are zero";
+   return false;
+  }
+ //compound data of the flash compounds
+ ws.flashTable=&correlations;
+ ws.flashTableIndices=VECPTR(ws.flashCompounds);
+ ws.flashMW.resize(ws.flashCompounds.size());
+ ws.flashTmax=compounds[ws.flashCompounds[0]]->TC;
+ for (i=0;i<(int)ws.flashCompounds.size();i++)
+  {ws.flashMW[i]=compounds[ws.flashCompounds[i]]->MW;
+   if (compounds[ws.flashCompounds[i]]->TC<ws.flashTmax) ws.flashTmax=compounds[ws.flashCompounds[i]]->TC;
+  }
+ return SolveFlash(ws,nComp,type,spec1,spec2,phaseCount,phases,phaseFractions,phaseCompositions,T,P);
+}
+
+//! Calculate phase equilibrium of a prepared mixture
+/*!
+  As Flash() with compound indices, for a mixture that has been prepared by PrepareMixture(). 
+  The compound indices are not checked again, and the compound data is taken from the
+  mixture. The composition is checked in a single comparison per compound.
+  \param ws Workspace that receives the return values and the error
+  \param mixture Mixture prepared for this property package
+  \param X Overall mole fractions[mol/mol], one value for each compound of the mixture, assumed normalized
+  \param type Type of specifications passed (e.g. TP for a temperature and pressure specification)
+  \param phaseType Specified allowed phases in flash. 
+  \param spec1 Value of first specification (e.g. T/[K] for TP)
+  \param spec2 Value of second specification (e.g. P/[Pa] for TP)
+  \param phaseCount Receives the number of phases at equilibrium
+  \param phases Receives the types of the existing phases (Vapor or Liquid)
+  \param phaseFractions Receives the phase fractions of the existing phases [mol/mol]
+  \param phaseCompositions Receives the compositions of the existing phases [mol/mol]; one array for each phase, each array contains one mole fraction for each compound
+  \param T Receives the temperature at equilibrium
+  \param P Receives the pressure at equilibrium
+  \return True if ok
+  \sa PrepareMixture(), PreparedMixture
+*/
+
+bool PropertyPackage::Flash(PropertyWorkspace &ws,const PreparedMixture &mixture,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *&phases,double *&phaseFractions,double **&phaseCompositions,double &T, double &P) const
+{int nComp=mixture.CompoundCount();
+ AllocateFlashResults(ws,nComp);
+ if (!Flash(ws,mixture,X,type,phaseType,spec1,spec2,phaseCount,VECPTR(ws.existingPhases),VECPTR(ws.values),VECPTR(ws.values)+PhaseCount,T,P)) return false;
+ AssignFlashResults(ws,nComp,phaseCount,phases,phaseFractions,phaseCompositions);
+ return true;
+}
+
+//! Calculate phase equilibrium of a prepared mixture into caller-supplied buffers
+/*!
+  As Flash() with caller-supplied buffers and compound indices, for a mixture that has 
+  been prepared by PrepareMixture().
+  \param ws Workspace that receives the error
+  \param mixture Mixture prepared for this property package
+  \param X Overall mole fractions[mol/mol], one value for each compound of the mixture, assumed normalized
+  \param type Type of specifications passed (e.g. TP for a temperature and pressure specification)
+  \param phaseType Specified allowed phases in flash. 
+  \param spec1 Value of first specification (e.g. T/[K] for TP)
+  \param spec2 Value of second specification (e.g. P/[Pa] for TP)
+  \param phaseCount Receives the number of phases at equilibrium
+  \param phases Receives the types of the existing phases (Vapor or Liquid); room for PhaseCount values
+  \param phaseFractions Receives the phase fractions of the existing phases [mol/mol]; room for PhaseCount values
+  \param phaseCompositions Receives the compositions of the existing phases [mol/mol]; room for PhaseCount*nComp values, the composition of phase j starts at phaseCompositions[j*nComp]
+  \param T Receives the temperature at equilibrium
+  \param P Receives the pressure at equilibrium
+  \return True if ok
+  \sa PrepareMixture(), GetFlashResultSizes()
+*/
+
+bool PropertyPackage::Flash(PropertyWorkspace &ws,const PreparedMixture &mixture,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *phases,double *phaseFractions,double *phaseCompositions,double &T, double &P) const
+{int i,nComp;
+ ws.scratch.Reset();
+ if (mixture.package!=this)
+  {ws.lastError="Mixture has not been prepared for this property package";
+   return false;
+  }
+ ws.flashPhaseType=phaseType;
+ ws.solverEvaluations=0;
+ //map the compounds with non-zero mole fraction
+ nComp=mixture.CompoundCount();
+ ws.flashCompounds.resize(nComp);
+ ws.flashCompoundMapping.resize(nComp);
+ ws.flashComposition.resize(nComp);
+ ws.flashMW.resize(nComp);
+ int count=0;
+ for (i=0;i<nComp;i++)
+  {if (!((X[i]>=0)&&(X[i]<=DBL_MAX))) return CheckComposition(ws,X[i]); //also catches NaN
    if (X[i]>0)
-    {flashCompounds.push_back(compIndices[i]);
-     flashComposition.push_back(X[i]);
-     flashCompoundMapping.push_back(i);
+    {ws.flashCompounds[count]=mixture.compIndices[i];
+     ws.flashComposition[count]=X[i];
+     ws.flashCompoundMapping[count]=i;
+     ws.flashMW[count]=mixture.MW[i];
+     count++;
     }
   }
- if (flashCompounds.size()==0)
-  {lastError="All compositions are zero";
+ if (count==0)
+  {ws.lastError="All compositions are zero";
    return false;
   }
+ ws.flashCompounds.resize(count);
+ ws.flashCompoundMapping.resize(count);
+ ws.flashComposition.resize(count);
+ ws.flashMW.resize(count);
+ //compound data of the flash compounds; the correlations are indexed in mixture order
+ ws.flashTable=&mixture.correlations;
+ if (count==nComp) 
+  {ws.flashTableIndices=NULL;
+   ws.flashTmax=mixture.minTC;
+  }
+ else
+  {ws.flashTableIndices=VECPTR(ws.flashCompoundMapping);
+   ws.flashTmax=mixture.TC[ws.flashCompoundMapping[0]];
+   for (i=1;i<count;i++) if (mixture.TC[ws.flashCompoundMapping[i]]<ws.flashTmax) ws.flashTmax=mixture.TC[ws.flashCompoundMapping[i]];
+  }
+ return SolveFlash(ws,nComp,type,spec1,spec2,phaseCount,phases,phaseFractions,phaseCompositions,T,P);
+}
+
+//! Solve a flash and return the results
+/*!
+  Internal routine that solves a flash for the flash compounds that have been set
+  up by Flash(), and maps the results to the compounds passed to Flash()
+  \param ws Workspace holding the flash compounds, receiving the return values and the error
+  \param nComp Number of compounds passed to Flash()
+  \param type Type of specifications passed (e.g. TP for a temperature and pressure specification)
+  \param spec1 Value of first specification (e.g. T/[K] for TP)
+  \param spec2 Value of second specification (e.g. P/[Pa] for TP)
+  \param phaseCount Receives the number of phases at equilibrium
+  \param phases Receives the types of the existing phases (Vapor or Liquid), PhaseCount values
+  \param phaseFractions Receives the phase fractions of the existing phases [mol/mol], PhaseCount values
+  \param phaseCompositions Receives the compositions of the existing phases [mol/mol], PhaseCount*nComp values
+  \param T Receives the temperature at equilibrium
+  \param P Receives the pressure at equilibrium
+  \return True if ok
+  \sa Flash()
+*/
+
+bool PropertyPackage::SolveFlash(PropertyWorkspace &ws,int nComp,FlashType type,double spec1,double spec2,int &phaseCount,Phase *phases,double *phaseFractions,double *phaseCompositions,double &T, double &P) const
+{int i;
+ double H,S,VF;
+ //previous solution for this composition, if the history is enabled; the TP flash is not iterative in T or P
+ ws.flashSeeded=false;
+ if (ws.history.Size())
+  {ws.flashFingerprint=FlashHistory::Fingerprint(this,correlations.Serial(),(int)ws.flashCompounds.size(),VECPTR(ws.flashCompounds),VECPTR(ws.flashComposition));
+   if (type!=TP)
+    {const FlashHistoryEntry *entry=ws.history.Find(ws.flashFingerprint);
+     if (entry)
+      {ws.flashSeed=*entry;
+       ws.flashSeeded=true;
+      }
+    }
+  }
  //check flash type and calculate
- vapX.resize(flashComposition.size());
- liqX.resize(flashComposition.size());
+ ws.vapX.resize(ws.flashComposition.size());
+ ws.liqX.resize(ws.flashComposition.size());
  switch (type)
   {case TP: 
      //TP flash 
      T=spec1;
      P=spec2;
-     if (!TPFlash(T,P)) return false; //error has been set
+     if (!TPFlash(ws,T,P)) return false; //error has been set
      break;
    case TVF:
      T=spec1;
      VF=spec2;
-     if (!TVFFlash(T,VF,P)) return false; //error has been set
+     if (!TVFFlash(ws,T,VF,P)) return false; //error has been set
      break;
    case PVF:
      P=spec1;
      VF=spec2;
-     if (!PVFFlash(P,VF,T)) return false; //error has been set
+     if (!PVFFlash(ws,P,VF,T)) return false; //error has been set
      break;
    case TVFm:
      T=spec1;
      VF=spec2;
-     if (!TVFmFlash(T,VF,P)) return false; //error has been set
+     if (!TVFmFlash(ws,T,VF,P)) return false; //error has been set
      break;
    case PVFm:
      P=spec1;
      VF=spec2;
-     if (!PVFmFlash(P,VF,T)) return false; //error has been set
+     if (!PVFmFlash(ws,P,VF,T)) return false; //error has been set
      break;
    case PH:
      P=spec1;
      H=spec2;
-     if (!PHFlash(P,H,T)) return false; //error has been set
+     if (!PHFlash(ws,P,H,T)) return false; //error has been set
      break;
    case PS:
      P=spec1;
      S=spec2;
-     if (!PSFlash(P,S,T)) return false; //error has been set
+     if (!PSFlash(ws,P,S,T)) return false; //error has been set
      break;
    default:
-    lastError="Invalid flash type specification";
+    ws.lastError="Invalid flash type specification";
     return false;
   }
- //flash returned ok, map outputs
+ if (ws.history.Size()) ws.history.Store(ws.flashFingerprint,T,P,ws.vapFrac);
+ //flash returned ok, map outputs; compounds that were not accounted for in the flash have zero mole fractions
  phaseCount=0;
- if (vaporExists) phaseCount++;
- if (liquidExists) phaseCount++;
- existingPhases.resize(phaseCount);
- valuePointers.resize(phaseCount);
- j=phaseCount*(1+nComp);
- values.resize(j);//alloc space for phase fraction of each resulting phase followed by composition of each resulting phase
- for (i=0;i<j;i++) values[i]=0;
- j=0; //phase index
- phases=VECPTR(existingPhases);
- phaseFractions=VECPTR(values);
- phaseCompositions=VECPTR(valuePointers);
- if (vaporExists)
-  {existingPhases[j]=Vapor;
-   phaseFractions[j]=vapFrac;
-   valuePointers[j]=VECPTR(values)+phaseCount+j*nComp;
-   for (i=0;i<(int)flashCompoundMapping.size();i++)phaseCompositions[j][flashCompoundMapping[i]]=vapX[i];
-   j++;
-  }
- if (liquidExists)
-  {existingPhases[j]=Liquid;
-   phaseFractions[j]=liqFrac;
-   valuePointers[j]=VECPTR(values)+phaseCount+j*nComp;
-   for (i=0;i<(int)flashCompoundMapping.size();i++) phaseCompositions[j][flashCompoundMapping[i]]=liqX[i];
-   j++;
+ if (ws.vaporExists)
+  {double *composition=phaseCompositions+phaseCount*nComp;
+   phases[phaseCount]=Vapor;
+   phaseFractions[phaseCount]=ws.vapFrac;
+   for (i=0;i<nComp;i++) composition[i]=0;
+   for (i=0;i<(int)ws.flashCompoundMapping.size();i++) composition[ws.flashCompoundMapping[i]]=ws.vapX[i];
+   phaseCount++;
+  }
+ if (ws.liquidExists)
+  {double *composition=phaseCompositions+phaseCount*nComp;
+   phases[phaseCount]=Liquid;
+   phaseFractions[phaseCount]=ws.liqFrac;
+   for (i=0;i<nComp;i++) composition[i]=0;
+   for (i=0;i<(int)ws.flashCompoundMapping.size();i++) composition[ws.flashCompoundMapping[i]]=ws.liqX[i];
+   phaseCount++;
   }
  //all ok 
  return true;
 }
 
+//! Allocate the workspace buffers for property results
+/*!
+  Internal routine that sizes the buffers of the workspace that receive the results of 
+  the calls to GetSinglePhaseProperties() and GetTwoPhaseProperties() that return pointers
+  \param ws Workspace to allocate the buffers of
+  \param nProp Number of properties requested
+  \param totalCount Total number of values of all properties
+  \sa AssignPropertyResults()
+*/
+
+void PropertyPackage::AllocatePropertyResults(PropertyWorkspace &ws,int nProp,int totalCount) const
+{ws.valueCounts.resize(nProp);
+ ws.valuePointers.resize(nProp);
+ ws.values.resize(totalCount);
+}
+
+//! Assign the pointers to property results in the workspace
+/*!
+  Internal routine that points to the results of a property calculation in the buffers 
+  allocated by AllocatePropertyResults()
+  \param ws Workspace holding the results
+  \param nProp Number of properties requested
+  \param valueCount Receives the number of values for each of the properties
+  \param values Receives the values, one double array for each property
+  \sa AllocatePropertyResults()
+*/
+
+void PropertyPackage::AssignPropertyResults(PropertyWorkspace &ws,int nProp,int *&valueCount,double **&values) const
+{int i,offset;
+ offset=0;
+ for (i=0;i<nProp;i++)
+  {ws.valuePointers[i]=VECPTR(ws.values)+offset;
+   offset+=ws.valueCounts[i];
+  }
+ valueCount=VECPTR(ws.valueCounts);
+ values=VECPTR(ws.valuePointers);
+}
+
+//! Allocate the workspace buffers for flash results
+/*!
+  Internal routine that sizes the buffers of the workspace that receive the results of 
+  the calls to Flash() that return pointers: the phases, and the phase fractions 
+  followed by the phase compositions
+  \param ws Workspace to allocate the buffers of
+  \param nComp Number of compounds passed to Flash()
+  \sa AssignFlashResults()
+*/
+
+void PropertyPackage::AllocateFlashResults(PropertyWorkspace &ws,int nComp) const
+{ws.existingPhases.resize(PhaseCount);
+ ws.valuePointers.resize(PhaseCount);
+ ws.values.resize(PhaseCount*(1+nComp));
+}
+
+//! Assign the pointers to flash results in the workspace
+/*!
+  Internal routine that points to the results of a flash in the buffers allocated by 
+  AllocateFlashResults()
+  \param ws Workspace holding the results
+  \param nComp Number of compounds passed to Flash()
+  \param phaseCount Number of phases at equilibrium
+  \param phases Receives the types of the existing phases
+  \param phaseFractions Receives the phase fractions of the existing phases
+  \param phaseCompositions Receives the compositions of the existing phases, one array for each phase
+  \sa AllocateFlashResults()
+*/
+
+void PropertyPackage::AssignFlashResults(PropertyWorkspace &ws,int nComp,int phaseCount,Phase *&phases,double *&phaseFractions,double **&phaseCompositions) const
+{int j;
+ for (j=0;j<phaseCount;j++) ws.valuePointers[j]=VECPTR(ws.values)+PhaseCount+j*nComp;
+ phases=VECPTR(ws.existingPhases);
+ phaseFractions=VECPTR(ws.values);
+ phaseCompositions=VECPTR(ws.valuePointers);
+}
+
+//! Calculate phase equilibrium
+/*!
+  As Flash() with workspace argument, using the workspace of this PropertyPackage. 
+  The return values are only valid until the next call to GetSinglePhaseProperties, 
+  GetTwoPhaseProperties or Flash without workspace argument.
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param X Overall mole fractions[mol/mol], one value for each compound, assumed normalized
+  \param type Type of specifications passed (e.g. TP for a temperature and pressure specification)
+  \param phaseType Specified allowed phases in flash. 
+  \param spec1 Value of first specification (e.g. T/[K] for TP)
+  \param spec2 Value of second specification (e.g. P/[Pa] for TP)
+  \param phaseCount Receives the number of phases at equilibrium
+  \param phases Receives the types of the existing phases (Vapor or Liquid)
+  \param phaseFractions Receives the phase fractions of the existing phases [mol/mol]
+  \param phaseCompositions Receives the compositions of the existing phases [mol/mol]; one array for each phase, each array contains one mole fraction for each compound
+  \param T Receives the temperature at equilibrium
+  \param P Receives the pressure at equilibrium
+  \return True if ok
+  \sa GetCompoundCount(), LastError(), Phase, FlashType, FlashPhaseType
+*/
+
+bool PropertyPackage::Flash(int nComp,const int *compIndices,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *&phases,double *&phaseFractions,double **&phaseCompositions,double &T, double &P)
+{if (!Flash(workspace,nComp,compIndices,X,type,phaseType,spec1,spec2,phaseCount,phases,phaseFractions,phaseCompositions,T,P))
+  {lastError=workspace.lastError;
+   return false;
+  }
+ return true;
+}
+
+//! Calculate phase equilibrium into caller-supplied buffers
+/*!
+  As Flash() with workspace argument and caller-supplied buffers, using the workspace of 
+  this PropertyPackage. 
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture. One index for each compounds. Must be between 0 and number of compounds-1, inclusive
+  \param X Overall mole fractions[mol/mol], one value for each compound, assumed normalized
+  \param type Type of specifications passed (e.g. TP for a temperature and pressure specification)
+  \param phaseType Specified allowed phases in flash. 
+  \param spec1 Value of first specification (e.g. T/[K] for TP)
+  \param spec2 Value of second specification (e.g. P/[Pa] for TP)
+  \param phaseCount Receives the number of phases at equilibrium
+  \param phases Receives the types of the existing phases (Vapor or Liquid); room for PhaseCount values
+  \param phaseFractions Receives the phase fractions of the existing phases [mol/mol]; room for PhaseCount values
+  \param phaseCompositions Receives the compositions of the existing phases [mol/mol]; room for PhaseCount*nComp values, the composition of phase j starts at phaseCompositions[j*nComp]
+  \param T Receives the temperature at equilibrium
+  \param P Receives the pressure at equilibrium
+  \return True if ok
+  \sa GetFlashResultSizes(), LastError(), Phase, FlashType, FlashPhaseType
+*/
+
+bool PropertyPackage::Flash(int nComp,const int *compIndices,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *phases,double *phaseFractions,double *phaseCompositions,double &T, double &P)
+{if (!Flash(workspace,nComp,compIndices,X,type,phaseType,spec1,spec2,phaseCount,phases,phaseFractions,phaseCompositions,T,P))
+  {lastError=workspace.lastError;
+   return false;
+  }
+ return true;
+}
+
 //! Check a temperature
 /*!
-  Internal routine to check a temperature, sets the error in case not ok
-  \param T Temperature to check [K]
+  Internal routine to check a temperature, sets the error in case not ok
+  \param ws Workspace receiving the error
+  \param T Temperature to check [K]
+  \return True if ok
+*/
+
+bool PropertyPackage::CheckTemperature(PropertyWorkspace &ws,double T) const
+{if (T<=0)
+  {ws.lastError="Temperature must be positive";
+   return false;
+  }
+ if (_isnan(T))
+  {ws.lastError="Temperature is missing";
+   return false;
+  }
+ if (!_finite(T))
+  {ws.lastError="Temperature is not finite";
+   return false;
+  }
+ return true;
+}
+
+//! Check a pressure
+/*!
+  Internal routine to check a pressure, sets the error in case not ok
+  \param ws Workspace receiving the error
+  \param P Pressure to check [Pa]
+  \return True if ok
+*/
+
+bool PropertyPackage::CheckPressure(PropertyWorkspace &ws,double P) const
+{if (P<=0)
+  {ws.lastError="Pressure must be positive";
+   return false;
+  }
+ if (_isnan(P))
+  {ws.lastError="Pressure is missing";
+   return false;
+  }
+ if (!_finite(P))
+  {ws.lastError="Pressure is not finite";
+   return false;
+  }
+ return true;
+}
+
+//! Get pure component intermediates
+/*!
+  Internal routine to get pure component intermediates at a temperature, from the 
+  PureComponentCache of the workspace if available there. Intermediates that are
+  not available are evaluated, in order of dependency, and stored in the cache. If the 
+  cache is disabled, the intermediates are evaluated into the scratch arena of the workspace.
+  \param ws Workspace holding the cache
+  \param table Correlation table of the compounds
+  \param tableIndices Indices of the compounds in the table, NULL if all compounds of the table in order
+  \param nComp Number of compounds
+  \param T Temperature [K]
+  \param needed Set of pure component intermediates that are needed, including their dependencies
+  \return Pointer to the intermediates, nComp values for each intermediate; only the needed intermediates are valid
+  \sa PureComponentCache
+*/
+
+double *PropertyPackage::PureComponentValues(PropertyWorkspace &ws,const CorrelationTable &table,const int *tableIndices,int nComp,double T,int needed) const
+{double *values;
+ PureComponentState *state=NULL;
+ if (needed) state=ws.cache.Get(table,tableIndices,nComp,T,needed);
+ if (state)
+  {values=state->Values(0);
+   needed&=~state->available;
+   state->available|=needed;
+  }
+ else values=ws.scratch.Allocate(PureComponentQuantityCount*nComp+1);
+ EvaluatePureComponentValues(table,tableIndices,nComp,T,needed,values);
+ return values;
+}
+
+//! Check the compound indices of a mixture
+/*!
+  Internal routine to check that the compound indices are in range and that no
+  compound appears more than once, sets the error in case not ok. Small mixtures
+  are checked by comparing all pairs. Mixtures of more than PAIRWISE_DUPLICATE_CHECK
+  compounds are checked in linear time: each compound is marked in the workspace
+  with the generation number of the check, so that the marks need not be cleared.
+  Once checked, the deferred correlations of the compounds are loaded, if any.
+  \param ws Workspace receiving the error
+  \param nComp Number of compounds in the mixture
+  \param compIndices Indices of the compounds in the mixture
   \return True if ok
 */
 
-bool PropertyPackage::CheckTemperature(double T)
-{if (T<=0)
-  {lastError="Temperature must be positive";
-   return false;
-  }
- if (_isnan(T))
-  {lastError="Temperature is missing";
-   return false;
-  }
- if (!_finite(T))
-  {lastError="Temperature is not finite";
-   return false;
+bool PropertyPackage::CheckCompoundIndices(PropertyWorkspace &ws,int nComp,const int *compIndices) const
+{int i,j,index;
+ for (i=0;i<nComp;i++)
+  if ((compIndices[i]<0)||(compIndices[i]>=(int)compounds.size()))
+   {ws.lastError="Compound index out of range";
+    return false;
+   }
+ if (nComp<=PAIRWISE_DUPLICATE_CHECK)
+  {//compare all pairs
+   for (i=1;i<nComp;i++)
+    for (j=0;j<i;j++) 
+     if (compIndices[i]==compIndices[j]) goto duplicate;
+   return LoadCorrelations(ws,nComp,compIndices);
+  }
+ //mark the compounds
+ if (ws.compoundMarks.size()<compounds.size())
+  {ws.compoundMarks.assign(compounds.size(),0);
+   ws.compoundGeneration=0;
+  }
+ if (++ws.compoundGeneration==0)
+  {//wrapped around
+   ws.compoundMarks.assign(ws.compoundMarks.size(),0);
+   ws.compoundGeneration=1;
   }
- return true;
+ for (i=0;i<nComp;i++)
+  {index=compIndices[i];
+   if (ws.compoundMarks[index]==ws.compoundGeneration) goto duplicate;
+   ws.compoundMarks[index]=ws.compoundGeneration;
+  }
+ return LoadCorrelations(ws,nComp,compIndices);
+ duplicate:
+ ws.lastError="At least one compound appears in the mixture more than once";
+ return false;
 }
 
-//! Check a pressure
+//! Check a mole fraction
 /*!
-  Internal routine to check a pressure, sets the error in case not ok
-  \param P Pressure to check [Pa]
+  Internal routine to check a mole fraction, sets the error in case not ok
+  \param ws Workspace receiving the error
+  \param X Mole fraction to check
   \return True if ok
 */
 
-bool PropertyPackage::CheckPressure(double P)
-{if (P<=0)
-  {lastError="Pressure must be positive";
+bool PropertyPackage::CheckComposition(PropertyWorkspace &ws,double X) const
+{if (_isnan(X))
+  {ws.lastError="At least one value for composition is missing";
    return false;
   }
- if (_isnan(P))
-  {lastError="Pressure is missing";
+ if (!_finite(X))
+  {ws.lastError="At least one value for composition is not finite";
    return false;
   }
- if (!_finite(P))
-  {lastError="Pressure is not finite";
+ if (X<0)
+  {ws.lastError="At least one value for composition is negative";
    return false;
   }
  return true;
@@ -1283,25 +2702,26 @@ bool PropertyPackage::CheckPressure(double P)
 //! Check a vapor fraction
 /*!
   Internal routine to check a vapor fraction, sets the error in case not ok
+  \param ws Workspace receiving the error
   \param VF Vapor phase fraction to check [mol/mol] or [kg/kg]
   \return True if ok
 */
 
-bool PropertyPackage::CheckVaporPhaseFraction(double VF)
+bool PropertyPackage::CheckVaporPhaseFraction(PropertyWorkspace &ws,double VF) const
 {if (VF<0)
-  {lastError="Vapor fraction cannot be negative";
+  {ws.lastError="Vapor fraction cannot be negative";
    return false;
   }
  if (VF>1.0)
-  {lastError="Vapor fraction cannot exceed unity";
+  {ws.lastError="Vapor fraction cannot exceed unity";
    return false;
   }
  if (_isnan(VF))
-  {lastError="Vapor fraction is missing";
+  {ws.lastError="Vapor fraction is missing";
    return false;
   }
  if (!_finite(VF))
-  {lastError="Vapor fraction is not finite";
+  {ws.lastError="Vapor fraction is not finite";
    return false;
   }
  return true;
@@ -1310,17 +2730,18 @@ bool PropertyPackage::CheckVaporPhaseFraction(double VF)
 //! Check an enthalpy
 /*!
   Internal routine to check enthalpy, sets the error in case not ok
+  \param ws Workspace receiving the error
   \param H Enthalpy to check [J/mol]
   \return True if ok
 */
 
-bool PropertyPackage::CheckEnthalpy(double H)
+bool PropertyPackage::CheckEnthalpy(PropertyWorkspace &ws,double H) const
 {if (_isnan(H))
-  {lastError="Enthalpy is missing";
+  {ws.lastError="Enthalpy is missing";
    return false;
   }
  if (!_finite(H))
-  {lastError="Enthalpy is not finite";
+  {ws.lastError="Enthalpy is not finite";
    return false;
   }
  return true;
@@ -1329,17 +2750,18 @@ bool PropertyPackage::CheckEnthalpy(double H)
 //! Check an entropy
 /*!
   Internal routine to check entropy, sets the error in case not ok
+  \param ws Workspace receiving the error
   \param S Entropy to check [J/mol/K]
   \return True if ok
 */
 
-bool PropertyPackage::CheckEntropy(double S)
+bool PropertyPackage::CheckEntropy(PropertyWorkspace &ws,double S) const
 {if (_isnan(S))
-  {lastError="Entropy is missing";
+  {ws.lastError="Entropy is missing";
    return false;
   }
  if (!_finite(S))
-  {lastError="Entropy is not finite";
+  {ws.lastError="Entropy is not finite";
    return false;
   }
  return true;
@@ -1348,59 +2770,142 @@ bool PropertyPackage::CheckEntropy(double S)
 //! Calculate dew point pressure given temperature
 /*!
   Internal routine to calculate dew point pressure given temperature
+  \param ws Workspace holding the flash state
   \return Dew point pressure [Pa]
-  \sa Flash()
+  \sa Flash(), SolveTPFlashN()
 */
 
-double PropertyPackage::DewPointPressure()
+template <int N> double PropertyPackage::DewPointPressure(PropertyWorkspace &ws) const
 {//Psat must have already been calculated at T
- double num,denom;
- int i,j;
- num=1.0;
- denom=0;
- for (i=0;i<(int)flashCompounds.size();i++)
-  {num*=Psat[i];
-   double d=1.0;
-   for (j=0;j<(int)flashCompounds.size();j++) if (j!=i) d*=Psat[j];
-   denom+=d*flashComposition[i];
-  }
- return num/denom;
+ //1/Pdew = sum X[i]/Psat[i]; unlike the equivalent product form, this does not 
+ // underflow or overflow for many compounds
+ double invPdew=0;
+ int i;
+ const int n=(N>0)?N:(int)ws.flashCompounds.size(); //trip count, constant if N is set
+ for (i=0;i<n;i++) 
+  if (ws.flashComposition[i]>0) invPdew+=ws.flashComposition[i]/ws.Psat[i];
+ return 1.0/invPdew;
 }
 
 //! Calculate bubble point pressure given temperature
 /*!
   Internal routine to calculate bubble point pressure given temperature
+  \param ws Workspace holding the flash state
   \return Bubble point pressure [Pa]
-  \sa Flash()
+  \sa Flash(), SolveTPFlashN()
 */
 
-double PropertyPackage::BubblePointPressure()
+template <int N> double PropertyPackage::BubblePointPressure(PropertyWorkspace &ws) const
 {//Psat must have already been calculated at T
  double Pbub=0;
  int i;
- for (i=0;i<(int)flashCompounds.size();i++) Pbub+=flashComposition[i]*Psat[i];
+ const int n=(N>0)?N:(int)ws.flashCompounds.size(); //trip count, constant if N is set
+ for (i=0;i<n;i++) Pbub+=ws.flashComposition[i]*ws.Psat[i];
  return Pbub;
 }
 
-//! Target function for solving TP flash problem
+//! Run a solver for a flash
 /*!
-  Target function for solving TP flash problem; solves the Rachford Rice
-  equation for constant K values. Kminus1 needs to be set before calling
-  this function
-  \param param Parameter passed to solver constructor: PropertyPackage
-  \param X Degree of freedom solved for: vapor fraction
-  \param F Receives the function value at X
-  \param error Receives the error description in case of failure
+  Internal routine to solve a 1-dimensional flash problem. The number of 
+  function evaluations is added to the flash statistics of the workspace.
+  \param ws Workspace holding the flash state and receiving the error
+  \param solver Solver that is set up for the flash problem
+  \param X Receives the solution
   \return True if ok
-  \sa TPFlash(), Solver1Dim
+  \sa Solver1Dim, PropertyWorkspace::SolverEvaluations()
+*/
+
+template <class Func> bool PropertyPackage::RunSolver(PropertyWorkspace &ws,Solver1Dim<Func> &solver,double &X) const
+{bool ok=solver.Solve(X,ws.lastError);
+ ws.solverEvaluations+=solver.Evaluations();
+ return ok;
+}
+
+//! Run a solver from a previous solution
+/*!
+  Internal routine to solve a flash in a tight bracket around a previous solution 
+  from the FlashHistory. Failure is counted as fallback; the caller then solves 
+  in the full bracket.
+  \param ws Workspace that receives the number of solver evaluations
+  \param func Function to be solved
+  \param seed Previous solution
+  \param step Half width of the bracket around seed
+  \param Xmin Lower limit of the full bracket
+  \param Xmax Upper limit of the full bracket
+  \param tol Required abs value of the function at solution
+  \param X Receives the solution
+  \return True if the solution was found inside the tight bracket
+  \sa FlashHistory, RunSolver()
+*/
+
+template <class Func> bool PropertyPackage::RunSeededSolver(PropertyWorkspace &ws,const Func &func,double seed,double step,double Xmin,double Xmax,double tol,double &X) const
+{double lo,hi;
+ lo=seed-step;
+ if (lo<Xmin) lo=Xmin;
+ hi=seed+step;
+ if (hi>Xmax) hi=Xmax;
+ if (lo<hi)
+  {Solver1Dim<Func> solver(func,lo,hi,tol);
+   if (RunSolver(ws,solver,X)) return true;
+  }
+ ws.history.SeedFailed();
+ return false;
+}
+
+//! Derivative of the two-phase vapor fraction
+/*!
+  Internal routine to calculate the derivative of the vapor fraction of the 
+  two-phase TP flash solution with respect to temperature or pressure, which follows 
+  from the Rachford Rice equation. With K' the derivative of the K values:
+  
+  d beta = sum z K' / D^2 / sum z (K-1)^2 / D^2, with D = 1 + beta (K-1)
+  
+  The mass vapor fraction is sum beta y MW / sum z MW, with
+  
+  d (beta y) = z (d beta K + beta (1-beta) K') / D^2
+  
+  Psat, Kminus1 and vapFrac must have been set by TPFlash(). For the temperature
+  derivative PsatDT is filled in.
+  \param ws Workspace holding the flash state
+  \param temperature True for the derivative to T, false for the derivative to P
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param massVapFracD Receives the derivative of the mass vapor fraction, if not NULL
+  \return Derivative of the molar vapor fraction [1/K or 1/Pa]
+  \sa TPFlash(), MassVapFrac()
 */
 
-bool TPFlashFunc(void *param,double X,double &F,string &error)
+double PropertyPackage::VapFracDerivative(PropertyWorkspace &ws,bool temperature,double T,double P,double *massVapFracD) const
 {int i;
- PropertyPackage *pp=(PropertyPackage *)param;
- F=0;
- for (i=0;i<(int)pp->flashComposition.size();i++) F+=pp->flashComposition[i]*pp->Kminus1[i]/(1.0+X*pp->Kminus1[i]);
- return true;
+ double D,w,KD,RRDbeta,RRD,betaD,MW,mass,vapMassD;
+ int nComp=(int)ws.flashCompounds.size();
+ const double *z=VECPTR(ws.flashComposition);
+ double beta=ws.vapFrac;
+ if (temperature)
+  {ws.PsatDT.resize(nComp);
+   ws.flashTable->PSatDT(nComp,ws.flashTableIndices,T,VECPTR(ws.Psat),VECPTR(ws.PsatDT));
+  }
+ RRDbeta=RRD=0;
+ for (i=0;i<nComp;i++)
+  {D=1.0+beta*ws.Kminus1[i];
+   w=z[i]/(D*D);
+   KD=temperature?ws.PsatDT[i]/P:-ws.Psat[i]/(P*P);
+   RRDbeta-=w*ws.Kminus1[i]*ws.Kminus1[i];
+   RRD+=w*KD;
+  }
+ betaD=-RRD/RRDbeta;
+ if (massVapFracD)
+  {mass=vapMassD=0;
+   for (i=0;i<nComp;i++)
+    {MW=ws.flashMW[i];
+     D=1.0+beta*ws.Kminus1[i];
+     KD=temperature?ws.PsatDT[i]/P:-ws.Psat[i]/(P*P);
+     mass+=z[i]*MW;
+     vapMassD+=MW*z[i]*(betaD*(1.0+ws.Kminus1[i])+beta*(1.0-beta)*KD)/(D*D);
+    }
+   *massVapFracD=vapMassD/mass;
+  }
+ return betaD;
 }
 
 //! Calculate TP phase equilibrium
@@ -1412,25 +2917,81 @@ bool TPFlashFunc(void *param,double X,double &F,string &error)
   For a multi-compound mixture, vapor-only or liquid-only solutions are
   returned if P > Pbub or P < Pdew. For Pdew < P < Pbub, the two 
   phase solution is solved for constant K values by solving the 
-  Rachford Rice equation.
+  Rachford Rice equation with RachfordRice.
   
+  \param ws Workspace holding the flash state and receiving the error
   \param T Temperature [K]
   \param P Pressure [Pa]
   \return True if ok
-  \sa Flash(), TPFlashFunc()
+  \sa Flash(), SolveTPFlash(), RachfordRice
 */
 
-bool PropertyPackage::TPFlash(double T,double P)
-{int i;
- for (i=0;i<(int)flashCompounds.size();i++)
-  {if (T>compounds[flashCompounds[i]]->TC)
-    {lastError="Temperature exceeds critical temperature of at least one compound";
-     return false;
-    }
+bool PropertyPackage::TPFlash(PropertyWorkspace &ws,double T,double P) const
+{if (T>ws.flashTmax)
+  {ws.lastError="Temperature exceeds critical temperature of at least one compound";
+   return false;
+  }
+ if (!CheckTemperature(ws,T)) return false;
+ if (!CheckPressure(ws,P)) return false;
+ return SolveTPFlash(ws,T,P);
+}
+
+//! Calculate TP phase equilibrium without checking the inputs
+/*!
+  Internal routine that calculates the TP equilibrium for TPFlash(), and for the 
+  flashes that iterate over the TP flash. T and P are not checked, other than 
+  for the critical temperature and for leaving the positive range, which an
+  iteration may do; errors are then reported as TPFlash() would.
+  \param ws Workspace holding the flash state and receiving the error
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \return True if ok
+  \sa TPFlash(), VapFracFlashFunc, TwoPhaseResidual()
+*/
+
+bool PropertyPackage::SolveTPFlash(PropertyWorkspace &ws,double T,double P) const
+{if (T>ws.flashTmax)
+  {ws.lastError="Temperature exceeds critical temperature of at least one compound";
+   return false;
   }
- if (!CheckTemperature(T)) return false;
- if (!CheckTemperature(P)) return false;
- switch (flashPhaseType)
+ if (!((T>0)&&(P>0)&&(P<=DBL_MAX))) return CheckTemperature(ws,T)&&CheckPressure(ws,P); //also catches NaN
+ switch (ws.flashCompounds.size())
+  {//most streams are binary or ternary; for a small number of compounds the 
+   // flash is instantiated for the exact number of compounds
+   case 2: return SolveTPFlashN<2>(ws,T,P);
+   case 3: return SolveTPFlashN<3>(ws,T,P);
+   case 4: return SolveTPFlashN<4>(ws,T,P);
+   case 5: return SolveTPFlashN<5>(ws,T,P);
+   case 6: return SolveTPFlashN<6>(ws,T,P);
+   case 7: return SolveTPFlashN<7>(ws,T,P);
+   case FIXED_SIZE_COMPOUNDS: return SolveTPFlashN<FIXED_SIZE_COMPOUNDS>(ws,T,P);
+   default: return SolveTPFlashN<0>(ws,T,P);
+  }
+}
+
+//! Calculate TP phase equilibrium for a number of compounds
+/*!
+  Internal routine that calculates the TP equilibrium for SolveTPFlash(), for N 
+  compounds, or for any number of compounds if N is 0. For N compounds, the 
+  bubble and dew point pressures, the K values and the Rachford Rice residual 
+  are evaluated in loops with a constant trip count, which the compiler unrolls.
+  The vapor pressures and K values are left in the workspace, as the flashes that
+  iterate over the TP flash use them for the derivatives.
+  \param ws Workspace holding the flash state and receiving the error; the 
+  temperature and pressure have been checked
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \return True if ok
+  \sa SolveTPFlash(), FIXED_SIZE_COMPOUNDS
+*/
+
+template <int N> bool PropertyPackage::SolveTPFlashN(PropertyWorkspace &ws,double T,double P) const
+{int i;
+ bool ok;
+ const int n=(N>0)?N:(int)ws.flashCompounds.size(); //trip count, constant if N is set
+ const double *z=VECPTR(ws.flashComposition);
+ double *Psat,*Kminus1; //declared up front, the single-phase branches are entered by goto
+ switch (ws.flashPhaseType)
   {case VaporLiquid:
     break;
    case VaporOnly:
@@ -1438,80 +2999,96 @@ bool PropertyPackage::TPFlash(double T,double P)
    case LiquidOnly:
     goto liqOnly;
    default:
-    lastError="Invalid/unsupported flashPhaseType argument";
+    ws.lastError="Invalid/unsupported ws.flashPhaseType argument";
     return false;
   }
- if (flashCompounds.size()==1)
+ //pre-calc Psat
+ ws.Psat.resize(n);
+ Psat=VECPTR(ws.Psat);
+ ws.flashTable->PSat(n,ws.flashTableIndices,T,Psat);
+ if (n==1)
   {//single compound TP flash
-   double PSat=compounds[flashCompounds[0]]->pSatCorrelation->Value(T);
-   if (P>PSat)
-    {//all liquid
-     liqOnly:
-     for (i=0;i<(int)flashCompounds.size();i++) liqX[i]=flashComposition[i];
-     vaporExists=false;
-     liquidExists=true;
-     liqFrac=1.0;
-     vapFrac=0.0; //not required for TP flash, but may be required for other flashes that iterate over this flash
-    }
-   else
-    {//all vapor
-     vapOnly: 
-     for (i=0;i<(int)flashCompounds.size();i++) vapX[i]=flashComposition[i];
-     vaporExists=true;
-     liquidExists=false;
-     vapFrac=1.0;
-     liqFrac=0.0; //not required for TP flash, but may be required for other flashes that iterate over this flash
-    }
-   return true;
+   if (P>Psat[0]) goto liqOnly;
+   goto vapOnly;
   }
- //pre-calc Psat
- Psat.resize(flashCompounds.size());
- for (i=0;i<(int)flashCompounds.size();i++) Psat[i]=compounds[flashCompoundMapping[i]]->pSatCorrelation->Value(T);
  //check ranges of two-phase solution
- double Pbub=BubblePointPressure();
- if (P>Pbub) goto liqOnly;
- double Pdew=DewPointPressure();
- if (P<Pdew) goto vapOnly;
+ if (P>BubblePointPressure<N>(ws)) 
+  {//all liquid
+   liqOnly:
+   for (i=0;i<n;i++) ws.liqX[i]=z[i];
+   ws.vaporExists=false;
+   ws.liquidExists=true;
+   ws.liqFrac=1.0;
+   ws.vapFrac=0.0; //not required for TP flash, but may be required for other flashes that iterate over this flash
+   return true;
+  }
+ if (P<DewPointPressure<N>(ws)) 
+  {//all vapor
+   vapOnly: 
+   for (i=0;i<n;i++) ws.vapX[i]=z[i];
+   ws.vaporExists=true;
+   ws.liquidExists=false;
+   ws.vapFrac=1.0;
+   ws.liqFrac=0.0; //not required for TP flash, but may be required for other flashes that iterate over this flash
+   return true;
+  }
  //two phase solution, solve using Rachford-Rice
  // http://en.wikipedia.org/wiki/Flash_evaporation
- Kminus1.resize(flashCompounds.size());
- for (i=0;i<(int)flashCompounds.size();i++) Kminus1[i]=Psat[i]/P-1.0;
- Solver1Dim solver(TPFlashFunc,0,1,this,1e-8);
- if (!solver.Solve(vapFrac,lastError)) 
-  {lastError="TP flash solution failed: "+lastError;
+ ws.Kminus1.resize(n);
+ Kminus1=VECPTR(ws.Kminus1);
+ for (i=0;i<n;i++) Kminus1[i]=Psat[i]/P-1.0;
+ //tight tolerance, as flashes that iterate over the TP flash use its vapor fraction derivative
+ RachfordRice rr(n,z,Kminus1,1e-12);
+ ok=rr.Solve<N>(ws.vapFrac,ws.lastError);
+ ws.solverEvaluations+=rr.Iterations();
+ if (!ok) 
+  {ws.lastError="TP flash solution failed: "+ws.lastError;
    return false;
   }
  //fill in results
- vaporExists=liquidExists=true;
- liqFrac=1.0-vapFrac;
- for (i=0;i<(int)flashComposition.size();i++)
-  {liqX[i]=flashComposition[i]/(1.0+vapFrac*Kminus1[i]);
-   vapX[i]=(1.0+Kminus1[i])*liqX[i];
+ ws.vaporExists=ws.liquidExists=true;
+ ws.liqFrac=1.0-ws.vapFrac;
+ for (i=0;i<n;i++)
+  {ws.liqX[i]=z[i]/(1.0+ws.vapFrac*Kminus1[i]);
+   ws.vapX[i]=(1.0+Kminus1[i])*ws.liqX[i];
   }
  return true;
 }
 
-//! Target function for solving TVF flash problem
+//! Target function for solving vapor fraction flash problems
 /*!
-  Target function for solving TVF flash problem; solves the TP
-  flash and returns vapFrac-flashVF
-  \param param Parameter passed to solver constructor: PropertyPackage
-  \param X Degree of freedom solved for: pressure
-  \param F Receives the function value at X
-  \param error Receives the error description in case of failure
-  \return True if ok
-  \sa TPFlash(), Solver1Dim
+  Target function for solving TVF, PVF, TVFm and PVFm flash problems; solves 
+  the TP flash and returns the molar or mass vapor fraction minus the specification.
+  The degree of freedom is pressure at constant temperature, or temperature at 
+  constant pressure.
+  \sa TVFFlash(), PVFFlash(), TVFmFlash(), PVFmFlash(), TPFlash(), MassVapFrac(), VapFracDerivative(), Solver1Dim
 */
 
-bool TVFFlashFunc(void *param,double X,double &F,string &error)
-{PropertyPackage *pp=(PropertyPackage *)param;
- if (!pp->TPFlash(pp->Tflash,X)) 
-  {error=pp->lastError;
-   return false;
-  }
- F=pp->vapFrac-pp->VFflash;
- return true;
-}
+struct PropertyPackage::VapFracFlashFunc
+{static const bool derivative=true;
+ const PropertyPackage *pp; /*!< package that solves the TP flash */
+ PropertyWorkspace *ws;     /*!< workspace holding the flash state and receiving the error */
+ bool temperature;          /*!< true if solving for T at constant P, false if solving for P at constant T */
+ bool mass;                 /*!< true for a mass vapor fraction specification */
+ double TP;                 /*!< constant P [Pa] or T [K] */
+ double VF;                 /*!< specified vapor fraction */
+ VapFracFlashFunc(const PropertyPackage *pp,PropertyWorkspace *ws,bool temperature,bool mass,double TP,double VF) : pp(pp),ws(ws),temperature(temperature),mass(mass),TP(TP),VF(VF) {}
+ bool operator()(double X,double &F,double &FDX) const
+ {double T=temperature?X:TP;
+  double P=temperature?TP:X;
+  if (!pp->SolveTPFlash(*ws,T,P)) return false;
+  FDX=0;
+  if (mass)
+   {F=pp->MassVapFrac(*ws)-VF;
+    if (ws->vaporExists&&ws->liquidExists) pp->VapFracDerivative(*ws,temperature,T,P,&FDX);
+   }
+  else
+   {F=ws->vapFrac-VF;
+    if (ws->vaporExists&&ws->liquidExists) FDX=pp->VapFracDerivative(*ws,temperature,T,P,NULL);
+   }
+  return true;
+ }
+};
 
 //! Calculate TVF phase equilibrium
 /*!
@@ -1525,155 +3102,100 @@ bool TVFFlashFunc(void *param,double X,double &F,string &error)
   
   For 0 < VF < 1, the TP flash is iteratively solved for resulting the proper vapor fraction.
   
+  \param ws Workspace holding the flash state and receiving the error
   \param T Temperature [K]
   \param VF Vapor phase fraction [mol/mol]
   \param P Receives equilibrium pressure [Pa]
   \return True if ok
-  \sa Flash(), TVFFlashFunc()
+  \sa Flash(), VapFracFlashFunc
 */
 
-bool PropertyPackage::TVFFlash(double T,double VF,double &P)
+bool PropertyPackage::TVFFlash(PropertyWorkspace &ws,double T,double VF,double &P) const
 {int i;
- for (i=0;i<(int)flashCompounds.size();i++)
-  {if (T>compounds[flashCompounds[i]]->TC)
-    {lastError="Temperature exceeds critical temperature of at least one compound";
-     return false;
-    }
+ if (T>ws.flashTmax)
+  {ws.lastError="Temperature exceeds critical temperature of at least one compound";
+   return false;
   }
- if (!CheckTemperature(T)) return false;
- if (!CheckVaporPhaseFraction(VF)) return false;
- switch (flashPhaseType)
+ if (!CheckTemperature(ws,T)) return false;
+ if (!CheckVaporPhaseFraction(ws,VF)) return false;
+ switch (ws.flashPhaseType)
   {case VaporLiquid:
     break;
    case VaporOnly:
    case LiquidOnly:
-    lastError="Single phase flashes with vapor fraction specification are not supported";
+    ws.lastError="Single phase flashes with vapor fraction specification are not supported";
     return false;
    default:
-    lastError="Invalid/unsupported flashPhaseType argument";
+    ws.lastError="Invalid/unsupported ws.flashPhaseType argument";
     return false;
   }
- vapFrac=VF; //we know the resulting phase fractions
- liqFrac=1.0-VF;
- vaporExists=liquidExists=true;
- if (flashCompounds.size()==1)
+ ws.vapFrac=VF; //we know the resulting phase fractions
+ ws.liqFrac=1.0-VF;
+ ws.vaporExists=ws.liquidExists=true;
+ if (ws.flashCompounds.size()==1)
   {//single compound TVF flash
-   P=compounds[flashCompounds[0]]->pSatCorrelation->Value(T);
-   vapX[0]=liqX[0]=1.0;
+   ws.flashTable->PSat(1,ws.flashTableIndices,T,&P);
+   ws.vapX[0]=ws.liqX[0]=1.0;
    return true;
   }
  //pre-calc the vapor pressures
- Psat.resize(flashCompounds.size());
- for (i=0;i<(int)flashCompounds.size();i++) Psat[i]=compounds[flashCompoundMapping[i]]->pSatCorrelation->Value(T);
+ ws.Psat.resize(ws.flashCompounds.size());
+ ws.flashTable->PSat((int)ws.flashCompounds.size(),ws.flashTableIndices,T,VECPTR(ws.Psat));
  if (VF==0)
   {//bubble point calculation
-   P=BubblePointPressure();
-   for (i=0;i<(int)flashCompounds.size();i++)
-    {liqX[i]=flashComposition[i];
-     vapX[i]=liqX[i]*compounds[flashCompounds[i]]->pSatCorrelation->Value(T)/P;
+   P=BubblePointPressure(ws);
+   for (i=0;i<(int)ws.flashCompounds.size();i++)
+    {ws.liqX[i]=ws.flashComposition[i];
+     ws.vapX[i]=ws.liqX[i]*ws.Psat[i]/P;
     }
    return true;   
   } 
  if (VF==1.0)
   {//dew point calculation
-   P=DewPointPressure();
-   for (i=0;i<(int)flashCompounds.size();i++)
-    {vapX[i]=flashComposition[i];
-     liqX[i]=vapX[i]*P/compounds[flashCompounds[i]]->pSatCorrelation->Value(T);
+   P=DewPointPressure(ws);
+   for (i=0;i<(int)ws.flashCompounds.size();i++)
+    {ws.vapX[i]=ws.flashComposition[i];
+     ws.liqX[i]=ws.vapX[i]*P/ws.Psat[i];
     }
    return true;   
   } 
  //find P so that VF is ok by solving TP flash
- double Pdew=DewPointPressure();
- double Pbub=BubblePointPressure();
- Tflash=T;
- VFflash=VF;
- Solver1Dim solver(TVFFlashFunc,Pdew,Pbub,this,1e-4);
- if (!solver.Solve(P,lastError)) 
-  {lastError="TVF flash solution failed: "+lastError;
+ double Pdew=DewPointPressure(ws);
+ double Pbub=BubblePointPressure(ws);
+ Solver1Dim<VapFracFlashFunc> solver(VapFracFlashFunc(this,&ws,false,false,T,VF),Pdew,Pbub,1e-9);
+ solver.SetBracketValues(1.0-VF,-VF); //all vapor at Pdew, all liquid at Pbub
+ if (!RunSolver(ws,solver,P)) 
+  {ws.lastError="TVF flash solution failed: "+ws.lastError;
    return false;
   }
  //results are already filled in by TP flash, but make sure phase fractions are ok
- vapFrac=VF; 
- liqFrac=1.0-VF;
- return true;
-}
-
-//! Target function for solving Psat(T)=Tspec
-/*!
-  Target function for solving Psat(T)=Tspec for a single compound
-  \param param Parameter passed to solver constructor: PropertyPackage
-  \param X Degree of freedom solved for: temperature
-  \param F Receives the function value at X
-  \param error Receives the error description in case of failure
-  \return True if ok
-  \sa PVFFlash(), Solver1Dim
-*/
-
-bool TsatFlashFunc(void *param,double X,double &F,string &error)
-{PropertyPackage *pp=(PropertyPackage *)param;
- F=pp->compounds[pp->flashCompounds[0]]->pSatCorrelation->Value(X)-pp->Pflash;
- return true;
-}
-
-//! Target function for solving Pbub(T)=Tspec
-/*!
-  Target function for solving Pbub(T)=Tspec for a mixture
-  \param param Parameter passed to solver constructor: PropertyPackage
-  \param X Degree of freedom solved for: temperature
-  \param F Receives the function value at X
-  \param error Receives the error description in case of failure
-  \return True if ok
-  \sa PVFFlash(), Solver1Dim
-*/
-
-bool TbubFlashFunc(void *param,double X,double &F,string &error)
-{int i;
- PropertyPackage *pp=(PropertyPackage *)param;
- for (i=0;i<(int)pp->flashCompounds.size();i++) pp->Psat[i]=pp->compounds[pp->flashCompoundMapping[i]]->pSatCorrelation->Value(X);
- F=pp->BubblePointPressure()-pp->Pflash;
- return true;
-}
-
-//! Target function for solving Pdew(T)=Tspec
-/*!
-  Target function for solving Pdew(T)=Tspec for a mixture
-  \param param Parameter passed to solver constructor: PropertyPackage
-  \param X Degree of freedom solved for: temperature
-  \param F Receives the function value at X
-  \param error Receives the error description in case of failure
-  \return True if ok
-  \sa PVFFlash(), Solver1Dim
-*/
-
-bool TdewFlashFunc(void *param,double X,double &F,string &error)
-{int i;
- PropertyPackage *pp=(PropertyPackage *)param;
- for (i=0;i<(int)pp->flashCompounds.size();i++) pp->Psat[i]=pp->compounds[pp->flashCompoundMapping[i]]->pSatCorrelation->Value(X);
- F=pp->DewPointPressure()-pp->Pflash;
+ ws.vapFrac=VF; 
+ ws.liqFrac=1.0-VF;
  return true;
 }
 
-//! Target function for solving PVF flash problem
+//! Target function for solving Pbub(T)=Pspec or Pdew(T)=Pspec
 /*!
-  Target function for solving PVF flash problem.  
-  \param param Parameter passed to solver constructor: PropertyPackage
-  \param X Degree of freedom solved for: temperature
-  \param F Receives the function value at X
-  \param error Receives the error description in case of failure
-  \return True if ok
-  \sa PVFFlash(), Solver1Dim
+  Target function for solving Pbub(T)=Pspec or Pdew(T)=Pspec for a mixture, or 
+  Psat(T)=Pspec for a single compound. The function value is ln(Pbub/Pspec) or 
+  ln(Pdew/Pspec), and the degree of freedom is 1/T, in which it is nearly linear.
+  \sa BubbleDewTemperature(), BubbleDewResidual(), Solver1Dim
 */
 
-bool PVFFlashFunc(void *param,double X,double &F,string &error)
-{PropertyPackage *pp=(PropertyPackage *)param;
- if (!pp->TPFlash(X,pp->Pflash)) 
-  {error=pp->lastError;
-   return false;
-  }
- F=pp->vapFrac-pp->VFflash;
- return true;
-}
+struct PropertyPackage::BubbleDewFlashFunc
+{static const bool derivative=true;
+ const PropertyPackage *pp; /*!< package that evaluates the residual */
+ PropertyWorkspace *ws;     /*!< workspace holding the flash state */
+ bool dew;                  /*!< true for the dew point, false for the bubble point */
+ double lnP;                /*!< logarithm of the specified pressure [ln(Pa)] */
+ BubbleDewFlashFunc(const PropertyPackage *pp,PropertyWorkspace *ws,bool dew,double lnP) : pp(pp),ws(ws),dew(dew),lnP(lnP) {}
+ bool operator()(double X,double &F,double &FDX) const
+ {double T=1.0/X;
+  pp->BubbleDewResidual(*ws,dew,T,lnP,F,FDX);
+  FDX*=-T*T; //d/d(1/T) = -T^2 d/dT
+  return true;
+ }
+};
 
 //! Calculate PVF phase equilibrium
 /*!
@@ -1687,140 +3209,104 @@ bool PVFFlashFunc(void *param,double X,double &F,string &error)
   
   For 0 < VF < 1, the TP flash is iteratively solved for resulting the proper vapor fraction.
   
-  Solutions are limited between 10 < T < min(TC)
+  Solutions are limited between 50 < T < min(TC)
 
+  \param ws Workspace holding the flash state and receiving the error
   \param P Pressure [Pa]
   \param VF Vapor phase fraction [mol/mol]
   \param T Receives equilibrium temperature [K]
   \return True if ok
-  \sa Flash(), TsatFlashFunc(), TbubFlashFunc(), TdewFlashFunc(), PVFFlashFunc()
+  \sa Flash(), BubbleDewTemperature(), VapFracFlashFunc
   
 */
 
-bool PropertyPackage::PVFFlash(double P,double VF,double &T)
+bool PropertyPackage::PVFFlash(PropertyWorkspace &ws,double P,double VF,double &T) const
 {int i;
- if (!CheckPressure(P)) return false;
- if (!CheckVaporPhaseFraction(VF)) return false;
- switch (flashPhaseType)
+ double Tmax,Tbub,Tdew;
+ if (!CheckPressure(ws,P)) return false;
+ if (!CheckVaporPhaseFraction(ws,VF)) return false;
+ switch (ws.flashPhaseType)
   {case VaporLiquid:
     break;
    case VaporOnly:
    case LiquidOnly:
-    lastError="Single phase flashes with vapor fraction specification are not supported";
+    ws.lastError="Single phase flashes with vapor fraction specification are not supported";
     return false;
    default:
-    lastError="Invalid/unsupported flashPhaseType argument";
+    ws.lastError="Invalid/unsupported ws.flashPhaseType argument";
     return false;
   }
- vapFrac=VF; //we know the resulting phase fractions
- liqFrac=1.0-VF;
- vaporExists=liquidExists=true;
- Pflash=P;
- if (flashCompounds.size()==1)
-  {//single compound PVF flash, solve Psat(T) = P for T
-   Solver1Dim solver(TsatFlashFunc,50.0,compounds[flashCompounds[0]]->TC,this,1e-4);
-   if (!solver.Solve(T,lastError)) 
-    {lastError="PVF flash solution failed: "+lastError;
-     return false;
-    }
-   vapX[0]=liqX[0]=1.0;
-   return true;
-  }
- Psat.resize(flashCompounds.size());
- double Tmax=compounds[flashCompounds[0]]->TC; //get Tmax = min(TC)
- for (i=1;i<(int)flashCompounds.size();i++) if (compounds[flashCompounds[i]]->TC<Tmax) Tmax=compounds[flashCompounds[i]]->TC;
- if (VF==0)
-  {//bubble point calculation
-   Solver1Dim solver(TbubFlashFunc,50.0,Tmax,this,1e-4);
-   if (!solver.Solve(T,lastError)) 
-    {lastError="PVF flash solution failed: "+lastError;
-     return false;
-    }
+ ws.vapFrac=VF; //we know the resulting phase fractions
+ ws.liqFrac=1.0-VF;
+ ws.vaporExists=ws.liquidExists=true;
+ //determine Tmax = min(TC)
+ Tmax=ws.flashTmax;
+ if ((VF==0)||(ws.flashCompounds.size()==1))
+  {//bubble point calculation; for a single compound, solve Psat(T) = P for T
+   if (!((ws.flashSeeded)&&(SeededBubbleDewTemperature(ws,false,P,Tmax,T))))
+    if (!BubbleDewTemperature(ws,false,P,50.0,Tmax,T)) goto failed;
+   if ((T<=50.0)||(T>=Tmax)) goto noSolution;
    //compositions
-   for (i=0;i<(int)flashCompounds.size();i++)
-    {liqX[i]=flashComposition[i];
-     vapX[i]=liqX[i]*compounds[flashCompounds[i]]->pSatCorrelation->Value(T)/P;
+   ws.flashTable->PSat((int)ws.flashCompounds.size(),ws.flashTableIndices,T,VECPTR(ws.Psat));
+   for (i=0;i<(int)ws.flashCompounds.size();i++)
+    {ws.liqX[i]=ws.flashComposition[i];
+     ws.vapX[i]=ws.liqX[i]*ws.Psat[i]/P;
     }
+   if (ws.flashCompounds.size()==1) ws.vapX[0]=1.0;
    return true;   
   } 
  if (VF==1.0)
   {//dew point calculation
-   Solver1Dim solver(TdewFlashFunc,50.0,Tmax,this,1e-4);
-   if (!solver.Solve(T,lastError)) 
-    {lastError="PVF flash solution failed: "+lastError;
-     return false;
-    }
-   for (i=0;i<(int)flashCompounds.size();i++)
-    {vapX[i]=flashComposition[i];
-     liqX[i]=vapX[i]*P/compounds[flashCompounds[i]]->pSatCorrelation->Value(T);
+   if (!((ws.flashSeeded)&&(SeededBubbleDewTemperature(ws,true,P,Tmax,T))))
+    if (!BubbleDewTemperature(ws,true,P,50.0,Tmax,T)) goto failed;
+   if ((T<=50.0)||(T>=Tmax)) goto noSolution;
+   ws.flashTable->PSat((int)ws.flashCompounds.size(),ws.flashTableIndices,T,VECPTR(ws.Psat));
+   for (i=0;i<(int)ws.flashCompounds.size();i++)
+    {ws.vapX[i]=ws.flashComposition[i];
+     ws.liqX[i]=ws.vapX[i]*P/ws.Psat[i];
     }
    return true;   
   } 
- //find T so that VF is ok by solving TP flash
- double Tbub,Tdew;
- Solver1Dim solverTbub(TbubFlashFunc,50.0,Tmax,this,1e-4);
- if (!solverTbub.Solve(Tbub,lastError)) 
-  {lastError="PVF flash solution failed: "+lastError;
-   return false; 
-  }
- Solver1Dim solverTdew(TdewFlashFunc,50.0,Tmax,this,1e-4);
- if (!solverTdew.Solve(Tdew,lastError)) 
-  {lastError="PVF flash solution failed: "+lastError;
-   return false; 
-  }
- VFflash=VF;
- Solver1Dim solver(PVFFlashFunc,Tbub,Tdew,this,1e-4);
- if (!solver.Solve(T,lastError)) 
-  {lastError="PVF flash solution failed: "+lastError;
-   return false;
+ //find T so that VF is ok by solving TP flash; starting from a previous solution, the bubble and dew points are not needed
+ if (!((ws.flashSeeded)&&(RunSeededSolver(ws,VapFracFlashFunc(this,&ws,true,false,P,VF),ws.flashSeed.T,ws.flashSeed.TStep(),50.0,Tmax,1e-9,T))))
+  {if (!BubbleDewTemperature(ws,false,P,50.0,Tmax,Tbub)) goto failed;
+   if (!BubbleDewTemperature(ws,true,P,50.0,Tmax,Tdew)) goto failed;
+   Solver1Dim<VapFracFlashFunc> solver(VapFracFlashFunc(this,&ws,true,false,P,VF),Tbub,Tdew,1e-9);
+   //all liquid at Tbub, all vapor at Tdew, unless limited by the allowed range
+   if ((Tbub>50.0)&&(Tdew<Tmax)) solver.SetBracketValues(-VF,1.0-VF);
+   if (!RunSolver(ws,solver,T)) goto failed;
   }
  //results are already filled in by TP flash, but make sure phase fractions are ok
- vapFrac=VF; 
- liqFrac=1.0-VF;
+ ws.vapFrac=VF; 
+ ws.liqFrac=1.0-VF;
  return true;
+ noSolution:
+ ws.lastError="Allowed region does not contain solution";
+ failed:
+ ws.lastError="PVF flash solution failed: "+ws.lastError;
+ return false;
 }
 
 //! Returns the mass vapor fraction during VFm flash calculations
 /*!
   Returns the mass vapor fraction during VFm flash calculations
+  \param ws Workspace holding the flash state and receiving the error
   \return Mass vapor fraction [kg/kg]
   \sa TPFlash()
 */
 
 
-double PropertyPackage::MassVapFrac()
-{if ((vapFrac==0)||(vapFrac==1.0)) return vapFrac;
+double PropertyPackage::MassVapFrac(PropertyWorkspace &ws) const
+{if ((ws.vapFrac==0)||(ws.vapFrac==1.0)) return ws.vapFrac;
  double vapMass,liqMass;
  int i;
  vapMass=liqMass=0;
- for (i=0;i<(int)flashCompounds.size();i++)
-  {double MW=compounds[flashCompounds[i]]->MW;
-   vapMass+=vapX[i]*MW;
-   liqMass+=liqX[i]*MW;
-  }
- return vapFrac*vapMass/(vapFrac*vapMass+liqFrac*liqMass);
-}
-
-//! Target function for solving TVFm flash problem
-/*!
-  Target function for solving TVFm flash problem; solves the TP
-  flash and returns massVapFrac-flashVF
-  \param param Parameter passed to solver constructor: PropertyPackage
-  \param X Degree of freedom solved for: pressure
-  \param F Receives the function value at X
-  \param error Receives the error description in case of failure
-  \return True if ok
-  \sa TPFlash(), MassVapFrac(), Solver1Dim
-*/
-
-bool TVFmFlashFunc(void *param,double X,double &F,string &error)
-{PropertyPackage *pp=(PropertyPackage *)param;
- if (!pp->TPFlash(pp->Tflash,X)) 
-  {error=pp->lastError;
-   return false;
+ for (i=0;i<(int)ws.flashCompounds.size();i++)
+  {double MW=ws.flashMW[i];
+   vapMass+=ws.vapX[i]*MW;
+   liqMass+=ws.liqX[i]*MW;
   }
- F=pp->MassVapFrac()-pp->VFflash;
- return true;
+ return ws.vapFrac*vapMass/(ws.vapFrac*vapMass+ws.liqFrac*liqMass);
 }
 
 //! Calculate TVF phase equilibrium
@@ -1831,256 +3317,524 @@ bool TVFmFlashFunc(void *param,double X,double &F,string &error)
   
   For mixtures with 0 < VF < 1, the TP flash is iteratively solved for resulting the proper mass vapor fraction.
   
+  \param ws Workspace holding the flash state and receiving the error
   \param T Temperature [K]
   \param VF Vapor phase fraction [kg/kg]
   \param P Receives equilibrium pressure [Pa]
   \return True if ok
-  \sa Flash(), TVFmFlashFunc()
+  \sa Flash(), VapFracFlashFunc
 */
 
-bool PropertyPackage::TVFmFlash(double T,double VF,double &P)
-{int i;
- for (i=0;i<(int)flashCompounds.size();i++)
-  {if (T>compounds[flashCompounds[i]]->TC)
-    {lastError="Temperature exceeds critical temperature of at least one compound";
-     return false;
-    }
+bool PropertyPackage::TVFmFlash(PropertyWorkspace &ws,double T,double VF,double &P) const
+{if (T>ws.flashTmax)
+  {ws.lastError="Temperature exceeds critical temperature of at least one compound";
+   return false;
   }
- if (!CheckTemperature(T)) return false;
- if (!CheckVaporPhaseFraction(VF)) return false;
- switch (flashPhaseType)
+ if (!CheckTemperature(ws,T)) return false;
+ if (!CheckVaporPhaseFraction(ws,VF)) return false;
+ switch (ws.flashPhaseType)
   {case VaporLiquid:
     break;
    case VaporOnly:
    case LiquidOnly:
-    lastError="Single phase flashes with vapor fraction specification are not supported";
+    ws.lastError="Single phase flashes with vapor fraction specification are not supported";
     return false;
    default:
-    lastError="Invalid/unsupported flashPhaseType argument";
+    ws.lastError="Invalid/unsupported ws.flashPhaseType argument";
     return false;
   }
- if ((VF==0)||(VF==1.0)||(flashCompounds.size()==1)) return TVFFlash(T,VF,P); //same as molar phase fraction
+ if ((VF==0)||(VF==1.0)||(ws.flashCompounds.size()==1)) return TVFFlash(ws,T,VF,P); //same as molar phase fraction
+ //pre-calc the vapor pressures
+ ws.Psat.resize(ws.flashCompounds.size());
+ ws.flashTable->PSat((int)ws.flashCompounds.size(),ws.flashTableIndices,T,VECPTR(ws.Psat));
  //find P so that VF is ok by solving TP flash
- double Pdew=DewPointPressure();
- double Pbub=BubblePointPressure();
- Tflash=T;
- VFflash=VF;
- Solver1Dim solver(TVFmFlashFunc,Pdew,Pbub,this,1e-4);
- if (!solver.Solve(P,lastError)) 
-  {lastError="TVF flash solution failed: "+lastError;
+ double Pdew=DewPointPressure(ws);
+ double Pbub=BubblePointPressure(ws);
+ Solver1Dim<VapFracFlashFunc> solver(VapFracFlashFunc(this,&ws,false,true,T,VF),Pdew,Pbub,1e-9);
+ solver.SetBracketValues(1.0-VF,-VF); //all vapor at Pdew, all liquid at Pbub
+ if (!RunSolver(ws,solver,P)) 
+  {ws.lastError="TVF flash solution failed: "+ws.lastError;
    return false;
   }
  //results are already filled in by TP flash
  return true;
 }
 
-//! Target function for solving PVFm flash problem
-/*!
-  Target function for solving PVFm flash problem; solves the TP
-  flash and returns massVapFrac-flashVF  
-  \param param Parameter passed to solver constructor: PropertyPackage
-  \param X Degree of freedom solved for: temperature
-  \param F Receives the function value at X
-  \param error Receives the error description in case of failure
-  \return True if ok
-  \sa PVFFlash(), Solver1Dim, MassVapFrac()
-*/
-
-bool PVFmFlashFunc(void *param,double X,double &F,string &error)
-{PropertyPackage *pp=(PropertyPackage *)param;
- if (!pp->TPFlash(X,pp->Pflash)) 
-  {error=pp->lastError;
-   return false;
-  }
- F=pp->MassVapFrac()-pp->VFflash;
- return true;
-}
-
 //! Calculate PVF phase equilibrium
 /*!
   Internal routine to calculate PVF equilibrium
+  \param ws Workspace holding the flash state and receiving the error
   \param P Pressure [Pa]
   \param VF Vapor phase fraction [kg/kg]
   \param T Receives equilibrium temperature [K]
   \return True if ok
-  \sa Flash(), PVFmFlashFunc()
+  \sa Flash(), VapFracFlashFunc
 */
 
-bool PropertyPackage::PVFmFlash(double P,double VF,double &T)
-{int i;
- if (!CheckPressure(P)) return false;
- if (!CheckVaporPhaseFraction(VF)) return false;
- switch (flashPhaseType)
+bool PropertyPackage::PVFmFlash(PropertyWorkspace &ws,double P,double VF,double &T) const
+{double Tmax,Tbub,Tdew;
+ if (!CheckPressure(ws,P)) return false;
+ if (!CheckVaporPhaseFraction(ws,VF)) return false;
+ switch (ws.flashPhaseType)
   {case VaporLiquid:
     break;
    case VaporOnly:
    case LiquidOnly:
-    lastError="Single phase flashes with vapor fraction specification are not supported";
+    ws.lastError="Single phase flashes with vapor fraction specification are not supported";
     return false;
    default:
-    lastError="Invalid/unsupported flashPhaseType argument";
+    ws.lastError="Invalid/unsupported ws.flashPhaseType argument";
     return false;
   }
- if ((VF==0)||(VF==1.0)||(flashCompounds.size()==1)) return TVFFlash(T,VF,P); //same as molar phase fraction
+ if ((VF==0)||(VF==1.0)||(ws.flashCompounds.size()==1)) return PVFFlash(ws,P,VF,T); //same as molar phase fraction
  //determine Tmax = min(TC)
- double Tmax=compounds[flashCompounds[0]]->TC;
- for (i=1;i<(int)flashCompounds.size();i++) if (compounds[flashCompounds[i]]->TC<Tmax) Tmax=compounds[flashCompounds[i]]->TC;
- //find T so that VF is ok by solving TP flash
- double Tbub,Tdew;
- Solver1Dim solverTbub(TbubFlashFunc,50.0,Tmax,this,1e-4);
- if (!solverTbub.Solve(Tbub,lastError)) 
-  {lastError="PVF flash solution failed: "+lastError;
-   return false; 
-  }
- Solver1Dim solverTdew(TdewFlashFunc,50.0,Tmax,this,1e-4);
- if (!solverTdew.Solve(Tdew,lastError)) 
-  {lastError="PVF flash solution failed: "+lastError;
-   return false; 
-  }
- VFflash=VF;
- Solver1Dim solver(PVFmFlashFunc,Tbub,Tdew,this,1e-4);
- if (!solver.Solve(T,lastError)) 
-  {lastError="PVF flash solution failed: "+lastError;
-   return false;
+ Tmax=ws.flashTmax;
+ //find T so that VF is ok by solving TP flash; starting from a previous solution, the bubble and dew points are not needed
+ if (!((ws.flashSeeded)&&(RunSeededSolver(ws,VapFracFlashFunc(this,&ws,true,true,P,VF),ws.flashSeed.T,ws.flashSeed.TStep(),50.0,Tmax,1e-9,T))))
+  {if (!BubbleDewTemperature(ws,false,P,50.0,Tmax,Tbub)) goto failed;
+   if (!BubbleDewTemperature(ws,true,P,50.0,Tmax,Tdew)) goto failed;
+   Solver1Dim<VapFracFlashFunc> solver(VapFracFlashFunc(this,&ws,true,true,P,VF),Tbub,Tdew,1e-9);
+   //all liquid at Tbub, all vapor at Tdew, unless limited by the allowed range
+   if ((Tbub>50.0)&&(Tdew<Tmax)) solver.SetBracketValues(-VF,1.0-VF);
+   if (!RunSolver(ws,solver,T)) goto failed;
   }
  //results are already filled in by TP flash
  return true;
+ failed:
+ ws.lastError="PVF flash solution failed: "+ws.lastError;
+ return false;
 }
 
-//! Target function for solving PH flash problem
+//! Calculate PH phase equilibrium
 /*!
-  Target function for solving PH flash problem.  
-  \param param Parameter passed to solver constructor: PropertyPackage
-  \param X Degree of freedom solved for: temperature
-  \param F Receives the function value at X
-  \param error Receives the error description in case of failure
+  Internal routine to calculate PH equilibrium, find T for which H = Hspec. 
+  Allowed range is 50 < T < min(TC)
+  \param ws Workspace holding the flash state and receiving the error
+  \param P Pressure [Pa]
+  \param H Enthalpy [J/mol]
+  \param T Receives equilibrium temperature [K]
   \return True if ok
-  \sa PHFlash(), Solver1Dim
+  \sa Flash(), PHSFlash()
 */
 
-bool PHFlashFunc(void *param,double X,double &F,string &error)
-{PropertyPackage *pp=(PropertyPackage *)param;
- if (!pp->TPFlash(X,pp->Pflash)) 
-  {error=pp->lastError;
-   return false;
+bool PropertyPackage::PHFlash(PropertyWorkspace &ws,double P,double H,double &T) const
+{if (!CheckPressure(ws,P)) return false;
+ if (!CheckEnthalpy(ws,H)) return false;
+ return PHSFlash(ws,Enthalpy,P,H,T);
+}
+
+//! Calculate PS phase equilibrium
+/*!
+  Internal routine to calculate PS equilibrium, find T for which S = Sspec. 
+  Allowed range is 50 < T < min(TC)
+  \param ws Workspace holding the flash state and receiving the error
+  \param P Pressure [Pa]
+  \param S Entropy [J/mol/K]
+  \param T Receives equilibrium temperature [K]
+  \return True if ok
+  \sa Flash(), PHSFlash()
+*/
+
+bool PropertyPackage::PSFlash(PropertyWorkspace &ws,double P,double S,double &T) const
+{if (!CheckPressure(ws,P)) return false;
+ if (!CheckEntropy(ws,S)) return false;
+ return PHSFlash(ws,Entropy,P,S,T);
+}
+
+//! Bubble or dew point residual
+/*!
+  Internal routine to evaluate ln(Pbub/P) or ln(Pdew/P) and its temperature 
+  derivative for the flash composition. Also fills in Psat and PsatDT.
+  \param ws Workspace holding the flash state
+  \param dew True for the dew point, false for the bubble point
+  \param T Temperature [K]
+  \param lnP Logarithm of the pressure [ln(Pa)]
+  \param F Receives the residual
+  \param FDT Receives the temperature derivative of the residual [1/K]
+  \sa BubbleDewTemperature()
+*/
+
+void PropertyPackage::BubbleDewResidual(PropertyWorkspace &ws,bool dew,double T,double lnP,double &F,double &FDT) const
+{int i;
+ double Psat,sum;
+ ws.flashTable->PSat((int)ws.flashCompounds.size(),ws.flashTableIndices,T,VECPTR(ws.Psat));
+ ws.flashTable->PSatDT((int)ws.flashCompounds.size(),ws.flashTableIndices,T,VECPTR(ws.Psat),VECPTR(ws.PsatDT));
+ sum=0;
+ if (dew)
+  {//d ln(Pdew) / dT = Pdew * sum X[i]*dPsat[i]/dT/Psat[i]^2
+   Psat=DewPointPressure(ws);
+   for (i=0;i<(int)ws.flashCompounds.size();i++) 
+    if (ws.flashComposition[i]>0) sum+=ws.flashComposition[i]*ws.PsatDT[i]/(ws.Psat[i]*ws.Psat[i]);
+   FDT=Psat*sum;
+  }
+ else
+  {//d ln(Pbub) / dT = sum X[i]*dPsat[i]/dT / Pbub
+   Psat=BubblePointPressure(ws);
+   for (i=0;i<(int)ws.flashCompounds.size();i++) sum+=ws.flashComposition[i]*ws.PsatDT[i];
+   FDT=sum/Psat;
+  }
+ F=log(Psat)-lnP;
+}
+
+//! Find the bubble or dew point temperature
+/*!
+  Internal routine to find the temperature for which Pbub or Pdew of the flash
+  composition equals P; for a single compound this is the saturation temperature.
+  Solves ln(Psat) = ln(P), which is nearly linear in 1/T, by Newton's method in 1/T
+  on the analytic derivative of the vapor pressure.
+  
+  The result is limited to the range Tmin..Tmax: if the saturation pressure 
+  exceeds P at Tmin, Tmin is returned, if it is below P at Tmax, Tmax is returned.
+  \param ws Workspace holding the flash state and receiving the error
+  \param dew True for the dew point, false for the bubble point
+  \param P Pressure [Pa]
+  \param Tmin Lower limit of temperature [K]
+  \param Tmax Upper limit of temperature [K]
+  \param T Receives the bubble or dew point temperature [K]
+  \return True if ok
+  \sa PVFFlash(), PHSFlash(), BubbleDewResidual(), BubbleDewFlashFunc
+*/
+
+bool PropertyPackage::BubbleDewTemperature(PropertyWorkspace &ws,bool dew,double P,double Tmin,double Tmax,double &T) const
+{double Flo,Fhi,FDTlo,FDThi,X,lnP;
+ ws.Psat.resize(ws.flashCompounds.size());
+ ws.PsatDT.resize(ws.flashCompounds.size());
+ lnP=log(P);
+ BubbleDewResidual(ws,dew,Tmin,lnP,Flo,FDTlo);
+ ws.solverEvaluations++;
+ if (Flo>=0) 
+  {T=Tmin;
+   return true;
   }
- F=-pp->Hflash;
- SinglePhaseProperty prop=Enthalpy;
- int *valueCount;
- double **values;
- if (pp->vaporExists)
-  {if (!pp->GetSinglePhaseProperties((int)pp->flashCompounds.size(),VECPTR(pp->flashCompounds),Vapor,X,pp->Pflash,VECPTR(pp->vapX),1,&prop,valueCount,values))
-    {error="Vapor enthalpy calculation failed: "+error;
-     return false;
-    }
-   F+=pp->vapFrac*values[0][0];
+ BubbleDewResidual(ws,dew,Tmax,lnP,Fhi,FDThi);
+ ws.solverEvaluations++;
+ if (Fhi<=0) 
+  {T=Tmax;
+   return true;
   }
- if (pp->liquidExists)
-  {if (!pp->GetSinglePhaseProperties((int)pp->flashCompounds.size(),VECPTR(pp->flashCompounds),Liquid,X,pp->Pflash,VECPTR(pp->liqX),1,&prop,valueCount,values))
-    {error="Liquid enthalpy calculation failed: "+error;
-     return false;
-    }
-   F+=pp->liqFrac*values[0][0];
+ //solve in 1/T; Psat typically underflows at Tmin, in which case Newton starts from Tmax
+ Solver1Dim<BubbleDewFlashFunc> solver(BubbleDewFlashFunc(this,&ws,dew,lnP),1.0/Tmax,1.0/Tmin,1e-12);
+ solver.SetBracketValues(Fhi,Flo,-Tmax*Tmax*FDThi,-Tmin*Tmin*FDTlo);
+ if (!RunSolver(ws,solver,X)) 
+  {ws.lastError=(dew?"Dew point solution failed: ":"Bubble point solution failed: ")+ws.lastError;
+   return false;
   }
+ T=1.0/X;
  return true;
 }
 
-//! Calculate PH phase equilibrium
+//! Find the bubble or dew point temperature from a previous solution
 /*!
-  Internal routine to calculate PH equilibrium. Solves TP flash and calculates H to 
-  find T for which H = Hspec. Allowed range is 50 < T < min(TC)
+  Internal routine to find the bubble or dew point temperature in a tight range
+  around the temperature of a previous solution from the FlashHistory. Failure,
+  or a result at the limits of the tight range, is counted as fallback; the caller
+  then searches the full range.
+  \param ws Workspace holding the flash state and the previous solution
+  \param dew True for the dew point, false for the bubble point
   \param P Pressure [Pa]
-  \param H Enthalpy [J/mol]
-  \param T Receives equilibrium temperature [K]
+  \param Tmax Upper limit of temperature [K]
+  \param T Receives the bubble or dew point temperature [K]
+  \return True if the temperature was found inside the tight range
+  \sa BubbleDewTemperature(), FlashHistory
+*/
+
+bool PropertyPackage::SeededBubbleDewTemperature(PropertyWorkspace &ws,bool dew,double P,double Tmax,double &T) const
+{double lo,hi,step;
+ step=ws.flashSeed.TStep();
+ lo=ws.flashSeed.T-step;
+ if (lo<50.0) lo=50.0;
+ hi=ws.flashSeed.T+step;
+ if (hi>Tmax) hi=Tmax;
+ if (lo<hi)
+  if (BubbleDewTemperature(ws,dew,P,lo,hi,T))
+   if ((T>lo)&&(T<hi)) return true;
+ ws.history.SeedFailed();
+ return false;
+}
+
+//! Calculate a mixture enthalpy or entropy and its temperature derivative
+/*!
+  Internal routine to calculate the enthalpy or entropy of a single phase 
+  of the flash compounds. The pure component values are evaluated directly from 
+  the correlation table, and combined by the same unchecked kernels as used by 
+  GetSinglePhaseProperties(); the inputs have already been checked by the flash.
+  The kernel is instantiated with DualNumber, so that the value and its temperature
+  derivative are obtained in a single sweep.
+  \param ws Workspace holding the flash state
+  \param phaseID Phase
+  \param propID Enthalpy or Entropy
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param X Mole fractions of the flash compounds
+  \param value Receives the property value
+  \param valueDT Receives the temperature derivative of the property value
+  \sa SinglePhaseFlash(), TwoPhaseResidual(), GetSinglePhaseProperties()
+*/
+
+void PropertyPackage::MixtureProperty(PropertyWorkspace &ws,Phase phaseID,SinglePhaseProperty propID,double T,double P,const double *X,double &value,double &valueDT) const
+{int j,needed;
+ int nComp=(int)ws.flashCompounds.size();
+ DualNumber property;
+ ScratchMark mark=ws.scratch.Mark(); //called in each solver iteration
+ double *pure=ws.scratch.Allocate(PureComponentQuantityCount*nComp+nComp);
+ double *lnX=pure+PureComponentQuantityCount*nComp;
+ //the intermediates of the temperature derivative include those of the value
+ needed=PlanIntermediates(SinglePhaseIntermediates((SinglePhaseProperty)(propID+1),phaseID));
+ EvaluatePureComponentValues(*ws.flashTable,ws.flashTableIndices,nComp,T,needed&PURE_COMPONENT_INTERMEDIATES,pure);
+ if (needed&INTERMEDIATE(IntermediateLnX)) for (j=0;j<nComp;j++) lnX[j]=(X[j]>0)?log(X[j]):-HUGE_VAL;
+ property=SinglePhaseScalar(propID,phaseID,nComp,DualNumber::Variable(T,1,0),DualNumber::Variable(P,0,1),X,lnX,pure);
+ value=property.value;
+ valueDT=property.dT;
+ ws.scratch.Release(mark);
+}
+
+//! Target function for solving a single-phase PH or PS flash
+/*!
+  Target function for solving a single-phase PH or PS flash; returns the 
+  enthalpy or entropy of the flash composition in a single phase minus
+  the specification. The degree of freedom is temperature.
+  \sa SinglePhaseFlash(), MixtureProperty(), Solver1Dim
+*/
+
+struct PropertyPackage::SinglePhaseFlashFunc
+{static const bool derivative=true;
+ const PropertyPackage *pp; /*!< package that evaluates the property */
+ PropertyWorkspace *ws;     /*!< workspace holding the flash state */
+ Phase phaseID;             /*!< phase */
+ SinglePhaseProperty propID; /*!< Enthalpy or Entropy */
+ double P;                  /*!< pressure [Pa] */
+ double spec;               /*!< specified enthalpy [J/mol] or entropy [J/mol/K] */
+ SinglePhaseFlashFunc(const PropertyPackage *pp,PropertyWorkspace *ws,Phase phaseID,SinglePhaseProperty propID,double P,double spec) : pp(pp),ws(ws),phaseID(phaseID),propID(propID),P(P),spec(spec) {}
+ bool operator()(double X,double &F,double &FDX) const
+ {pp->MixtureProperty(*ws,phaseID,propID,X,P,VECPTR(ws->flashComposition),F,FDX);
+  F-=spec;
+  return true;
+ }
+};
+
+//! Solve a single-phase PH or PS flash
+/*!
+  Internal routine to find T for which the enthalpy or entropy of the flash composition
+  in a single phase equals the specification. The enthalpy and entropy are evaluated
+  directly from the correlations, and inverted by Newton's method on the analytic 
+  temperature derivative.
+  
+  The flash results are filled in for the single phase solution.
+  
+  \param ws Workspace holding the flash state and receiving the error
+  \param phaseID Phase
+  \param propID Enthalpy or Entropy
+  \param P Pressure [Pa]
+  \param spec Specified enthalpy [J/mol] or entropy [J/mol/K]
+  \param Tlo Lower limit of temperature [K]
+  \param Thi Upper limit of temperature [K]
+  \param T Receives the temperature [K]
   \return True if ok
-  \sa Flash(), PHFlashFunc()
+  \sa PHSFlash(), SinglePhaseFlashFunc
 */
 
-bool PropertyPackage::PHFlash(double P,double H,double &T)
+bool PropertyPackage::SinglePhaseFlash(PropertyWorkspace &ws,Phase phaseID,SinglePhaseProperty propID,double P,double spec,double Tlo,double Thi,double &T) const
 {int i;
- if (!CheckPressure(P)) return false;
- if (!CheckEnthalpy(H)) return false;
- //determine Tmax = min(TC)
- double Tmax=compounds[flashCompounds[0]]->TC;
- for (i=1;i<(int)flashCompounds.size();i++) if (compounds[flashCompounds[i]]->TC<Tmax) Tmax=compounds[flashCompounds[i]]->TC;
- //find T so that VF is ok by solving TP flash
- Hflash=H;
- Pflash=P;
- Solver1Dim solver(PHFlashFunc,50,Tmax,this,1e-4);
- if (!solver.Solve(T,lastError)) 
-  {lastError="PH flash solution failed: "+lastError;
-   return false;
+ Solver1Dim<SinglePhaseFlashFunc> solver(SinglePhaseFlashFunc(this,&ws,phaseID,propID,P,spec),Tlo,Thi,1e-9*((fabs(spec)>1.0)?fabs(spec):1.0));
+ if (!RunSolver(ws,solver,T)) return false;
+ //fill in results
+ if (phaseID==Vapor)
+  {for (i=0;i<(int)ws.flashCompounds.size();i++) ws.vapX[i]=ws.flashComposition[i];
+   ws.vaporExists=true;
+   ws.liquidExists=false;
+   ws.vapFrac=1.0;
+   ws.liqFrac=0.0;
+  }
+ else
+  {for (i=0;i<(int)ws.flashCompounds.size();i++) ws.liqX[i]=ws.flashComposition[i];
+   ws.vaporExists=false;
+   ws.liquidExists=true;
+   ws.liqFrac=1.0;
+   ws.vapFrac=0.0;
   }
- //results are already filled in by TP flash
  return true;
 }
 
-//! Target function for solving PS flash problem
+//! Two-phase PH or PS flash residual
 /*!
-  Target function for solving PS flash problem.  
-  \param param Parameter passed to solver constructor: PropertyPackage
-  \param X Degree of freedom solved for: temperature
-  \param F Receives the function value at X
-  \param error Receives the error description in case of failure
+  Internal routine to solve the TP flash, by SolveTPFlash() as the inputs have
+  been checked by the flash, and evaluate the enthalpy or entropy
+  of the resulting phases minus the specification, and its temperature derivative.
+  
+  In the two-phase region, the derivative accounts for the change of the phase 
+  fractions and compositions with temperature, which follows from the Rachford 
+  Rice equation (see VapFracDerivative()). With l the liquid mole numbers for 1 mole of feed:
+  
+  dH/dT = sum z Cp - sum (dl/dT Hvap + l dHvap/dT) 
+  
+  dS/dT = sum z Cp/T - sum (dl/dT Hvap/T + l (R dPsat/dT/Psat + dHvap/dT/T - Hvap/T^2))
+  
+  \param ws Workspace holding the flash state and receiving the error
+  \param propID Enthalpy or Entropy
+  \param T Temperature [K]
+  \param P Pressure [Pa]
+  \param spec Specified enthalpy [J/mol] or entropy [J/mol/K]
+  \param F Receives the residual
+  \param FDT Receives the temperature derivative of the residual
   \return True if ok
-  \sa PSFlash(), Solver1Dim
+  \sa PHSFlash(), TwoPhaseFlashFunc
 */
 
-bool PSFlashFunc(void *param,double X,double &F,string &error)
-{PropertyPackage *pp=(PropertyPackage *)param;
- if (!pp->TPFlash(X,pp->Pflash)) 
-  {error=pp->lastError;
-   return false;
-  }
- F=-pp->Sflash;
- SinglePhaseProperty prop=Entropy;
- int *valueCount;
- double **values;
- if (pp->vaporExists)
-  {if (!pp->GetSinglePhaseProperties((int)pp->flashCompounds.size(),VECPTR(pp->flashCompounds),Vapor,X,pp->Pflash,VECPTR(pp->vapX),1,&prop,valueCount,values))
-    {error="Vapor entropy calculation failed: "+error;
-     return false;
-    }
-   F+=pp->vapFrac*values[0][0];
-  }
- if (pp->liquidExists)
-  {if (!pp->GetSinglePhaseProperties((int)pp->flashCompounds.size(),VECPTR(pp->flashCompounds),Liquid,X,pp->Pflash,VECPTR(pp->liqX),1,&prop,valueCount,values))
-    {error="Liquid entropy calculation failed: "+error;
-     return false;
-    }
-   F+=pp->liqFrac*values[0][0];
-  }
+bool PropertyPackage::TwoPhaseResidual(PropertyWorkspace &ws,SinglePhaseProperty propID,double T,double P,double spec,double &F,double &FDT) const
+{int i,nComp;
+ double value,valueDT;
+ if (!SolveTPFlash(ws,T,P)) return false;
+ F=-spec;
+ FDT=0;
+ if (ws.vaporExists)
+  {MixtureProperty(ws,Vapor,propID,T,P,VECPTR(ws.vapX),value,valueDT);
+   F+=ws.vapFrac*value;
+   FDT+=ws.vapFrac*valueDT;
+  }
+ if (ws.liquidExists)
+  {MixtureProperty(ws,Liquid,propID,T,P,VECPTR(ws.liqX),value,valueDT);
+   F+=ws.liqFrac*value;
+   FDT+=ws.liqFrac*valueDT;
+  }
+ if ((!ws.vaporExists)||(!ws.liquidExists)) return true; //single phase derivative
+ //two-phase derivative; Psat and Kminus1 are set by TP flash, PsatDT by VapFracDerivative
+ nComp=(int)ws.flashCompounds.size();
+ const CorrelationTable &correlations=*ws.flashTable;
+ const int *compIndices=ws.flashTableIndices;
+ const double *z=VECPTR(ws.flashComposition);
+ double beta=ws.vapFrac;
+ double betaDT=VapFracDerivative(ws,true,T,P,NULL);
+ ScratchMark mark=ws.scratch.Mark(); //called in each solver iteration
+ double *cp=ws.scratch.Allocate(3*nComp);
+ double *hvap=cp+nComp;
+ double *hvapDT=hvap+nComp;
+ correlations.Value(CpCorrelationID,nComp,compIndices,T,cp);
+ correlations.Value(HvapCorrelationID,nComp,compIndices,T,hvap);
+ correlations.ValueDT(HvapCorrelationID,nComp,compIndices,T,hvapDT);
+ FDT=0;
+ for (i=0;i<nComp;i++)
+  {if (z[i]<=0) continue;
+   double D=1.0+beta*ws.Kminus1[i];
+   double xDT=-z[i]*(betaDT*ws.Kminus1[i]+beta*ws.PsatDT[i]/P)/(D*D);
+   double l=(1.0-beta)*ws.liqX[i];
+   double lDT=(1.0-beta)*xDT-betaDT*ws.liqX[i];
+   if (propID==Enthalpy) FDT+=z[i]*cp[i]-lDT*hvap[i]-l*hvapDT[i];
+   else FDT+=(z[i]*cp[i]-lDT*hvap[i])/T-l*(GAS_CONSTANT*ws.PsatDT[i]/ws.Psat[i]+hvapDT[i]/T-hvap[i]/(T*T));
+  }
+ ws.scratch.Release(mark);
  return true;
 }
 
-//! Calculate PS phase equilibrium
+//! Target function for solving a two-phase PH or PS flash
 /*!
-  Internal routine to calculate PS equilibrium. Solves TP flash and calculates S to 
-  find T for which S = Sspec. Allowed range is 50 < T < min(TC)
+  Target function for solving a PH or PS flash between the bubble and dew point
+  temperatures; solves the TP flash and returns the enthalpy or entropy of the 
+  resulting phases minus the specification. The degree of freedom is temperature.
+  \sa PHSFlash(), TwoPhaseResidual(), Solver1Dim
+*/
+
+struct PropertyPackage::TwoPhaseFlashFunc
+{static const bool derivative=true;
+ const PropertyPackage *pp; /*!< package that evaluates the residual */
+ PropertyWorkspace *ws;     /*!< workspace holding the flash state and receiving the error */
+ SinglePhaseProperty propID; /*!< Enthalpy or Entropy */
+ double P;                  /*!< pressure [Pa] */
+ double spec;               /*!< specified enthalpy [J/mol] or entropy [J/mol/K] */
+ TwoPhaseFlashFunc(const PropertyPackage *pp,PropertyWorkspace *ws,SinglePhaseProperty propID,double P,double spec) : pp(pp),ws(ws),propID(propID),P(P),spec(spec) {}
+ bool operator()(double X,double &F,double &FDX) const
+ {return pp->TwoPhaseResidual(*ws,propID,X,P,spec,F,FDX);
+ }
+};
+
+//! Calculate PH or PS phase equilibrium
+/*!
+  Internal routine to calculate PH or PS equilibrium. Allowed range is 50 < T < min(TC)
+  
+  First the bubble and dew point temperatures at P are found. If the specification is 
+  below the liquid value at the bubble point, or above the vapor value at the dew point,
+  the single phase solution is found directly from the enthalpy or entropy expression
+  in SinglePhaseFlash(). Otherwise, for a single compound, T is the saturation temperature 
+  and the vapor fraction follows from the lever rule; for a mixture, the TP flash is 
+  solved iteratively between the bubble and dew point temperatures by Newton's method
+  on the derivative from TwoPhaseResidual().
+  
+  \param ws Workspace holding the flash state and receiving the error
+  \param propID Enthalpy or Entropy
   \param P Pressure [Pa]
-  \param S Entropy [J/mol/K]
+  \param spec Specified enthalpy [J/mol] or entropy [J/mol/K]
   \param T Receives equilibrium temperature [K]
   \return True if ok
-  \sa Flash(), PSFlashFunc()
+  \sa PHFlash(), PSFlash(), SinglePhaseFlash(), TwoPhaseFlashFunc
 */
 
-bool PropertyPackage::PSFlash(double P,double S,double &T)
-{int i;
- if (!CheckPressure(P)) return false;
- if (!CheckEntropy(S)) return false;
+bool PropertyPackage::PHSFlash(PropertyWorkspace &ws,SinglePhaseProperty propID,double P,double spec,double &T) const
+{double Tmax,Tbub,Tdew,valueL,valueV,valueDT,Flo,Fhi;
  //determine Tmax = min(TC)
- double Tmax=compounds[flashCompounds[0]]->TC;
- for (i=1;i<(int)flashCompounds.size();i++) if (compounds[flashCompounds[i]]->TC<Tmax) Tmax=compounds[flashCompounds[i]]->TC;
- //find T so that VF is ok by solving TP flash
- Sflash=S;
- Pflash=P;
- Solver1Dim solver(PSFlashFunc,50,Tmax,this,1e-4);
- if (!solver.Solve(T,lastError)) 
-  {lastError="PS flash solution failed: "+lastError;
-   return false;
+ Tmax=ws.flashTmax;
+ switch (ws.flashPhaseType)
+  {case VaporLiquid:
+    break;
+   case VaporOnly:
+    if (!SinglePhaseFlash(ws,Vapor,propID,P,spec,50,Tmax,T)) goto failed;
+    return true;
+   case LiquidOnly:
+    if (!SinglePhaseFlash(ws,Liquid,propID,P,spec,50,Tmax,T)) goto failed;
+    return true;
+   default:
+    ws.lastError="Invalid/unsupported ws.flashPhaseType argument";
+    return false;
   }
- //results are already filled in by TP flash
- return true;
+ //starting from a previous solution, the residual including the TP flash is valid in all phase regions,
+ // so that the phase boundaries are not needed
+ if ((ws.flashSeeded)&&(ws.flashCompounds.size()>1))
+  if (RunSeededSolver(ws,TwoPhaseFlashFunc(this,&ws,propID,P,spec),ws.flashSeed.T,ws.flashSeed.TStep(),50,Tmax,1e-9*((fabs(spec)>1.0)?fabs(spec):1.0),T)) return true;
+ //phase boundaries at P
+ if (!BubbleDewTemperature(ws,false,P,50,Tmax,Tbub)) goto failed;
+ if (ws.flashCompounds.size()==1) Tdew=Tbub;
+ else if (!BubbleDewTemperature(ws,true,P,50,Tmax,Tdew)) goto failed;
+ //liquid for 50 < T < Tbub
+ if (Tbub>50)
+  {MixtureProperty(ws,Liquid,propID,Tbub,P,VECPTR(ws.flashComposition),valueL,valueDT);
+   Flo=valueL-spec;
+   if (Flo>=0)
+    {if (!SinglePhaseFlash(ws,Liquid,propID,P,spec,50,Tbub,T)) goto failed;
+     return true;
+    }
+  }
+ //vapor for Tdew < T < Tmax
+ if (Tdew<Tmax)
+  {MixtureProperty(ws,Vapor,propID,Tdew,P,VECPTR(ws.flashComposition),valueV,valueDT);
+   Fhi=valueV-spec;
+   if (Fhi<=0)
+    {if (!SinglePhaseFlash(ws,Vapor,propID,P,spec,Tdew,Tmax,T)) goto failed;
+     return true;
+    }
+  }
+ //two-phase 
+ if (ws.flashCompounds.size()==1)
+  {if ((Tbub>50)&&(Tbub<Tmax))
+    {//the specification lies between the liquid and vapor values at Tsat
+     T=Tbub;
+     ws.vapFrac=(spec-valueL)/(valueV-valueL);
+     ws.liqFrac=1.0-ws.vapFrac;
+     ws.vaporExists=ws.liquidExists=true;
+     ws.vapX[0]=ws.liqX[0]=1.0;
+     return true;
+    }
+  }
+ else if (Tbub<Tdew)
+  {//the residuals at the bubble and dew points are only known if these are not limited by the allowed range
+   if (Tbub<=50) if (!TwoPhaseResidual(ws,propID,Tbub,P,spec,Flo,valueDT)) goto failed;
+   if (Tdew>=Tmax) if (!TwoPhaseResidual(ws,propID,Tdew,P,spec,Fhi,valueDT)) goto failed;
+   Solver1Dim<TwoPhaseFlashFunc> solver(TwoPhaseFlashFunc(this,&ws,propID,P,spec),Tbub,Tdew,1e-9*((fabs(spec)>1.0)?fabs(spec):1.0));
+   solver.SetBracketValues(Flo,Fhi);
+   if (!RunSolver(ws,solver,T)) goto failed;
+   return true;
+  }
+ ws.lastError="Allowed region does not contain solution";
+ failed:
+ ws.lastError=((propID==Enthalpy)?"PH flash solution failed: ":"PS flash solution failed: ")+ws.lastError;
+ return false;
 }
 
 //! Edit the property package
@@ -2090,8 +3844,14 @@ bool PropertyPackage::PSFlash(double P,double S,double &T)
 */
 
 bool PropertyPackage::Edit()
-{PackageEditor editor(this);
+{
+#ifdef _WIN32
+ PackageEditor editor(this);
  return editor.Edit();
+#else
+ lastError="Editing is not supported on this platform";
+ return false;
+#endif
 }
 
 //! Get Property Calculation Result
@@ -2104,12 +3864,12 @@ bool PropertyPackage::Edit()
 */
 
 BOOL PropertyPackage::GetPropertyResult(int index,int &count,double *&vals)
-{if ((index<0)||(index>=(int)valueCounts.size()))
+{if ((index<0)||(index>=(int)workspace.valueCounts.size()))
   {lastError="Result index out of range";
    return FALSE;
   }
- count=valueCounts[index];
- vals=valuePointers[index];
+ count=workspace.valueCounts[index];
+ vals=workspace.valuePointers[index];
  return TRUE;
 }
 
@@ -2129,15 +3889,15 @@ BOOL PropertyPackage::GetFlashPhase(int index,Phase &phase,double &phaseFrac,int
  Phase phases[2];
  //make phase list
  phaseCount=0;
- if (vaporExists) phases[phaseCount++]=Vapor;
- if (liquidExists) phases[phaseCount++]=Liquid;
+ if (workspace.vaporExists) phases[phaseCount++]=Vapor;
+ if (workspace.liquidExists) phases[phaseCount++]=Liquid;
  if ((index<0)||(index>=phaseCount))
   {lastError="Result index out of range";
    return FALSE;
   }
  phase=phases[index];
- phaseFrac=(phase==Vapor)?vapFrac:liqFrac;
- vector<double> *composition=(phase==Vapor)?&vapX:&liqX;
+ phaseFrac=(phase==Vapor)?workspace.vapFrac:workspace.liqFrac;
+ vector<double> *composition=(phase==Vapor)?&workspace.vapX:&workspace.liqX;
  Xcount=(int)composition->size();
  X=VECPTR(*composition);
  return TRUE;
@@ -2156,8 +3916,8 @@ BOOL PropertyPackage::GetFlashPhaseType(int index,Phase &phase)
  Phase phases[2];
  //make phase list
  phaseCount=0;
- if (vaporExists) phases[phaseCount++]=Vapor;
- if (liquidExists) phases[phaseCount++]=Liquid;
+ if (workspace.vaporExists) phases[phaseCount++]=Vapor;
+ if (workspace.liquidExists) phases[phaseCount++]=Liquid;
  if ((index<0)||(index>=phaseCount))
   {lastError="Result index out of range";
    return FALSE;
@@ -1,25 +1,39 @@
 #pragma once
 #include "Properties.h"
+#include "PropertyWorkspace.h"
+#include "CorrelationTable.h"
+#include "PreparedMixture.h"
+#include "StructuredMatrix.h"
+#include <unordered_map>
+#include <atomic>
+#include <memory>
 
 //forward declarations
 class Compound; //forward declaration
 class PropertyPackage; //forward declaration
+template <class Func> class Solver1Dim; //forward declaration
 
 //! PropertyPackage class
 /*!
 	This is the basic object that does the work. Its functionality corresponds to 
-	a CAPE-OPEN property package. The calculations are performed using variables
-	that are stored with each class. Although each property package can only be 
-	called from a single thread (due to the ApartmentThreaded annotation of the 
-	exported CAPE-OPEN classes), multiple property packages can exist and each 
-	should store their own variables to be thread-safe. 
+	a CAPE-OPEN property package. After loading, the property package holds only
+	the compound data, which is not modified by calculations. All variables that
+	are modified during calculations are stored in a PropertyWorkspace that is 
+	passed to the calculation routines. Any number of threads can calculate on a 
+	single property package at the same time, as long as each thread uses its own
+	PropertyWorkspace.
+	
+	The calculation routines that do not take a workspace argument use a workspace
+	that is stored with the property package; these can only be called from a single
+	thread at a time (as is the case for the ApartmentThreaded exported CAPE-OPEN 
+	classes).
 	
 	From C++ this class can be accessed via the PropertyPack exported wrapper class
 	
 	From VB6, this class can be accessed via a number of exposed functions, via
 	a property package handle.
 	
-	\sa PropertyPack
+	\sa PropertyPack, PropertyWorkspace
   
 */
 
@@ -36,20 +50,52 @@ class PropertyPackage
 	bool Save(const char *pathName);
 	bool LoadFromPPFile(const char *ppName);
 	
+	//deferred loading of the correlations
+	bool SetLazyLoading(bool lazy);
+	void GetLoadCounters(int &compoundCount,int &deferred,int &loaded) const;
+	
 	//compounds and their properties
 	bool GetCompoundCount(int *compoundCount);
 	const char *GetCompoundStringConstant(int compIndex,StringConstant constID); //returns NULL in case of FAIL
+	bool GetCompoundIndex(const char *compName,int &compIndex);
 	bool GetCompoundRealConstant(int compIndex,RealConstant constID,double &value); 
 	bool GetTemperatureDependentProperty(int compIndex,TDependentProperty propID,double T,double &value); 
+	bool GetTemperatureDependentProperty(PropertyWorkspace &ws,int compIndex,TDependentProperty propID,double T,double &value) const; 
+	
+	//tabulated vapor pressures
+	bool SetTabulation(double maxRelError);
+	const char *GetTabulationReport(); //returns NULL in case of FAIL
+	
+	//prepared mixtures
+	bool PrepareMixture(PropertyWorkspace &ws,int nComp,const int *compIndices,PreparedMixture &mixture) const;
 	
 	//single phase mixture properties
 	bool GetSinglePhaseProperties(int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int *&valueCount,double **&values);
+	bool GetSinglePhaseProperties(PropertyWorkspace &ws,int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int *&valueCount,double **&values) const;
+	bool GetSinglePhaseProperties(PropertyWorkspace &ws,const PreparedMixture &mixture,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int *&valueCount,double **&values) const;
+	static bool GetSinglePhasePropertySizes(int nComp,int nProp,const SinglePhaseProperty *propIDs,int *valueCount,int &totalCount);
+	bool GetSinglePhaseProperties(int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values);
+	bool GetSinglePhaseProperties(PropertyWorkspace &ws,int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values) const;
+	bool GetSinglePhaseProperties(PropertyWorkspace &ws,const PreparedMixture &mixture,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values) const;
+	bool GetSinglePhaseMatrix(PropertyWorkspace &ws,int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X,SinglePhaseProperty propID,StructuredMatrix &matrix) const;
+	bool GetSinglePhaseMatrix(PropertyWorkspace &ws,const PreparedMixture &mixture,Phase phaseID,double T,double P,const double *X,SinglePhaseProperty propID,StructuredMatrix &matrix) const;
 
 	//two-phase mixture properties
 	bool GetTwoPhaseProperties(int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2,int nProp,TwoPhaseProperty *propIDs,int *&valueCount,double **&values);
+	bool GetTwoPhaseProperties(PropertyWorkspace &ws,int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2,int nProp,TwoPhaseProperty *propIDs,int *&valueCount,double **&values) const;
+	static bool GetTwoPhasePropertySizes(int nComp,int nProp,const TwoPhaseProperty *propIDs,int *valueCount,int &totalCount);
+	bool GetTwoPhaseProperties(int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2,int nProp,TwoPhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values);
+	bool GetTwoPhaseProperties(PropertyWorkspace &ws,int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2,int nProp,TwoPhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values) const;
+	bool GetTwoPhaseMatrix(PropertyWorkspace &ws,int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2,TwoPhaseProperty propID,StructuredMatrix &matrix) const;
 	
 	//flash calculations
 	bool Flash(int nComp,const int *compIndices,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *&phases,double *&phaseFractions,double **&phaseCompositions,double &T, double &P);
+	bool Flash(PropertyWorkspace &ws,int nComp,const int *compIndices,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *&phases,double *&phaseFractions,double **&phaseCompositions,double &T, double &P) const;
+	bool Flash(PropertyWorkspace &ws,const PreparedMixture &mixture,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *&phases,double *&phaseFractions,double **&phaseCompositions,double &T, double &P) const;
+	static void GetFlashResultSizes(int nComp,int &phaseCapacity,int &compositionCapacity);
+	bool Flash(int nComp,const int *compIndices,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *phases,double *phaseFractions,double *phaseCompositions,double &T, double &P);
+	bool Flash(PropertyWorkspace &ws,int nComp,const int *compIndices,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *phases,double *phaseFractions,double *phaseCompositions,double &T, double &P) const;
+	bool Flash(PropertyWorkspace &ws,const PreparedMixture &mixture,const double *X,FlashType type,FlashPhaseType phaseType,double spec1,double spec2,int &phaseCount,Phase *phases,double *phaseFractions,double *phaseCompositions,double &T, double &P) const;
 	
 	//edit the package
 	bool Edit();
@@ -61,61 +107,80 @@ private:
 	string lastError; /*!< the last error is stored as text */
     bool initialized; /*!< before first use, LoadFromPPFile or Load should be called */
     vector<Compound*> compounds; /*!< compounds in this property package */
-    vector<double> values; /*!< internal buffer for return values */
-    vector<double*> valuePointers; /*!< internal buffer for pointers to return values */
-    vector<int> valueCounts; /*!< internal buffer for number of return values */
-    vector<int> valueOffsets; /*!< internal buffer for offsets of return values */
-    vector<int> flashCompounds; /*!< internal buffer storing compounds accounted for in flash */
-    vector<int> flashCompoundMapping; /*!< internal buffer storing mapping of compounds in array passed to Flash()*/
-    vector<double> flashComposition; /*!< internal buffer storing composition of compounds accounted for in flash*/
-	bool vaporExists,liquidExists; /*!< phase existence during flash calc*/
-	double vapFrac; /*!< molar vapor phase fraction during flash calc*/
-	double liqFrac; /*!< molar liquid phase fraction during flash calc*/
-	vector<double> vapX; /*!< molar vapor phase composition during flash calc*/
-	vector<double> liqX; /*!< molar liquid phase composition during flash calc*/
-	vector<Phase> existingPhases; /*!< internal buffer for returning existing phases after flash*/
-	vector<double> Psat; /*!< storage of Psat during constant T flashes*/
-	vector<double> Kminus1; /*!< storage of K-1 values during TP flashes*/
-	FlashPhaseType flashPhaseType; /*!< storage of allowed phases specifier during flash*/
-	double Hflash; /*!< storage of H during constant PH flashes*/
-	double Sflash; /*!< storage of S during constant PS flashes*/
-	double Pflash; /*!< storage of P during constant P flashes*/
-	double Tflash; /*!< storage of T during constant T flashes*/
-	double VFflash; /*!< storage of VF during constant VF flashes*/
+	vector<shared_ptr<Compound> > compoundData; /*!< references to the compounds, which are shared with other property packages, see CompoundRegistry */
+	unordered_map<string,int> compoundNames; /*!< index of each compound by its lower case name, see GetCompoundIndex() */
+	CorrelationTable correlations; /*!< correlation coefficients of the compounds, for evaluation over mixtures */
+	double tabulationError; /*!< maximum relative error of the tabulated vapor pressures, zero if not tabulated */
+	string tabulationReport; /*!< result of GetTabulationReport() */
+	bool lazyLoading; /*!< defer loading the correlations until first use, see SetLazyLoading() */
+	atomic<char> *correlationsLoaded; /*!< per compound, set once its correlations are loaded and copied to the table; NULL if all are loaded upon Load() */
+	int deferredCount; /*!< number of compounds of which loading the correlations was deferred */
+	mutable atomic<int> loadedCount; /*!< number of deferred compounds of which the correlations were loaded since */
+	PropertyWorkspace workspace; /*!< workspace for calculations without workspace argument */
 	
 	//editor can access private members:
 	friend class PackageEditor;
 
+	//compound data
+	void BuildCorrelations();
+	bool LoadCorrelations(PropertyWorkspace &ws,int nComp,const int *compIndices) const;
+	bool LoadCompoundCorrelations(PropertyWorkspace &ws,int compIndex) const;
+	bool LoadAllCorrelations();
+
 	//generic helpers
-	bool CheckTemperature(double T);
-	bool CheckPressure(double P);
-	bool CheckVaporPhaseFraction(double VF);
-	bool CheckEnthalpy(double H);
-	bool CheckEntropy(double S);
+	bool CheckTemperature(PropertyWorkspace &ws,double T) const;
+	bool CheckPressure(PropertyWorkspace &ws,double P) const;
+	bool CheckComposition(PropertyWorkspace &ws,double X) const;
+	bool CheckVaporPhaseFraction(PropertyWorkspace &ws,double VF) const;
+	bool CheckEnthalpy(PropertyWorkspace &ws,double H) const;
+	bool CheckEntropy(PropertyWorkspace &ws,double S) const;
+	bool CheckSinglePhaseInputs(PropertyWorkspace &ws,int nComp,const int *compIndices,Phase phaseID,double T,double P,const double *X) const;
+	bool CheckSinglePhaseInputs(PropertyWorkspace &ws,const PreparedMixture &mixture,Phase phaseID,double T,double P,const double *X) const;
+	bool CheckTwoPhaseInputs(PropertyWorkspace &ws,int nComp,const int *compIndices,Phase phaseID1,Phase phaseID2,double T1,double T2,double P1,double P2,const double *X1,const double *X2) const;
+
+	//calculation bodies, after checking the inputs
+	bool SinglePhaseProperties(PropertyWorkspace &ws,const CorrelationTable &table,const int *tableIndices,int nComp,Phase phaseID,double T,double P,const double *X,int nProp,SinglePhaseProperty *propIDs,int valueCapacity,int *valueCount,double *values) const;
+	bool SinglePhaseMatrix(PropertyWorkspace &ws,SinglePhaseProperty propID,Phase phaseID,int nComp,double P,const double *X,const double *psat,double *values,StructuredMatrix &matrix) const;
+	bool SinglePhaseMatrix(PropertyWorkspace &ws,const CorrelationTable &table,const int *tableIndices,int nComp,Phase phaseID,double T,double P,const double *X,SinglePhaseProperty propID,StructuredMatrix &matrix) const;
+	double *PureComponentValues(PropertyWorkspace &ws,const CorrelationTable &table,const int *tableIndices,int nComp,double T,int needed) const;
+	bool SolveFlash(PropertyWorkspace &ws,int nComp,FlashType type,double spec1,double spec2,int &phaseCount,Phase *phases,double *phaseFractions,double *phaseCompositions,double &T, double &P) const;
+
+	//result buffers of the workspace, for the calls that return pointers
+	void AllocatePropertyResults(PropertyWorkspace &ws,int nProp,int totalCount) const;
+	void AssignPropertyResults(PropertyWorkspace &ws,int nProp,int *&valueCount,double **&values) const;
+	void AllocateFlashResults(PropertyWorkspace &ws,int nComp) const;
+	void AssignFlashResults(PropertyWorkspace &ws,int nComp,int phaseCount,Phase *&phases,double *&phaseFractions,double **&phaseCompositions) const;
 
 	//flash helpers
-	double DewPointPressure();
-	double BubblePointPressure();
-	bool TPFlash(double T,double P);
-	bool TVFFlash(double T,double VF,double &P);
-	bool PVFFlash(double P,double VF,double &T);
-	bool TVFmFlash(double T,double VF,double &P);
-	bool PVFmFlash(double P,double VF,double &T);
-	bool PHFlash(double P,double H,double &T);
-	bool PSFlash(double P,double S,double &T);
-	double MassVapFrac();
+	bool CheckCompoundIndices(PropertyWorkspace &ws,int nComp,const int *compIndices) const;
+	template <int N=0> double DewPointPressure(PropertyWorkspace &ws) const;
+	template <int N=0> double BubblePointPressure(PropertyWorkspace &ws) const;
+	bool TPFlash(PropertyWorkspace &ws,double T,double P) const;
+	bool SolveTPFlash(PropertyWorkspace &ws,double T,double P) const;
+	template <int N> bool SolveTPFlashN(PropertyWorkspace &ws,double T,double P) const;
+	bool TVFFlash(PropertyWorkspace &ws,double T,double VF,double &P) const;
+	bool PVFFlash(PropertyWorkspace &ws,double P,double VF,double &T) const;
+	bool TVFmFlash(PropertyWorkspace &ws,double T,double VF,double &P) const;
+	bool PVFmFlash(PropertyWorkspace &ws,double P,double VF,double &T) const;
+	bool PHFlash(PropertyWorkspace &ws,double P,double H,double &T) const;
+	bool PSFlash(PropertyWorkspace &ws,double P,double S,double &T) const;
+	void BubbleDewResidual(PropertyWorkspace &ws,bool dew,double T,double lnP,double &F,double &FDT) const;
+	bool BubbleDewTemperature(PropertyWorkspace &ws,bool dew,double P,double Tmin,double Tmax,double &T) const;
+	bool SeededBubbleDewTemperature(PropertyWorkspace &ws,bool dew,double P,double Tmax,double &T) const;
+	bool PHSFlash(PropertyWorkspace &ws,SinglePhaseProperty propID,double P,double spec,double &T) const;
+	bool SinglePhaseFlash(PropertyWorkspace &ws,Phase phaseID,SinglePhaseProperty propID,double P,double spec,double Tlo,double Thi,double &T) const;
+	void MixtureProperty(PropertyWorkspace &ws,Phase phaseID,SinglePhaseProperty propID,double T,double P,const double *X,double &value,double &valueDT) const;
+	bool TwoPhaseResidual(PropertyWorkspace &ws,SinglePhaseProperty propID,double T,double P,double spec,double &F,double &FDT) const;
+	double VapFracDerivative(PropertyWorkspace &ws,bool temperature,double T,double P,double *massVapFracD) const;
+	template <class Func> bool RunSolver(PropertyWorkspace &ws,Solver1Dim<Func> &solver,double &X) const;
+	template <class Func> bool RunSeededSolver(PropertyWorkspace &ws,const Func &func,double seed,double step,double Xmin,double Xmax,double tol,double &X) const;
+	double MassVapFrac(PropertyWorkspace &ws) const;
 	
-	//target routines for solving flashes
-	friend bool TPFlashFunc(void *param,double X,double &F,string &error);
-	friend bool TVFFlashFunc(void *param,double X,double &F,string &error);
-	friend bool TsatFlashFunc(void *param,double X,double &F,string &error);
-	friend bool TbubFlashFunc(void *param,double X,double &F,string &error);
-	friend bool TdewFlashFunc(void *param,double X,double &F,string &error);
-	friend bool PVFFlashFunc(void *param,double X,double &F,string &error);
-	friend bool TVFmFlashFunc(void *param,double X,double &F,string &error);
-	friend bool PVFmFlashFunc(void *param,double X,double &F,string &error);
-	friend bool PHFlashFunc(void *param,double X,double &F,string &error);
-	friend bool PSFlashFunc(void *param,double X,double &F,string &error);
+	//target functions for solving flashes, see Solver1Dim
+	struct VapFracFlashFunc;
+	struct BubbleDewFlashFunc;
+	struct SinglePhaseFlashFunc;
+	struct TwoPhaseFlashFunc;
 
 public:
 
@@ -0,0 +1,180 @@
+#pragma once
+#include "Properties.h"
+#include "PureComponentCache.h"
+#include "FlashHistory.h"
+#include "ScratchArena.h"
+
+//forward declarations
+class PropertyPackage; //forward declaration
+class CorrelationTable; //forward declaration
+
+//! PropertyWorkspace class
+/*!
+	Holds all state that is modified during a calculation: the return value
+	buffers of property calculations and flashes, the flash intermediates and
+	the last error.
+
+	A PropertyPackage itself is not modified by calculations; it only holds
+	the compound data. Any number of threads can therefore perform calculations
+	on the same PropertyPackage at the same time, provided that each thread
+	uses its own PropertyWorkspace. A PropertyWorkspace can be used with
+	different PropertyPackage objects, but not by more than one thread at the
+	same time.
+
+	Return values of calculations point into the workspace and remain valid
+	until the next calculation that uses the same workspace.
+
+	The workspace also holds a PureComponentCache, so that calls at the same
+	temperature do not evaluate the pure component correlations again, and an
+	optional FlashHistory, from which flashes are started near the previous
+	solution for the same composition. The temporary arrays of a calculation
+	are taken from a ScratchArena, and all buffers are kept between calls, so
+	that repeating a calculation of the same size does not allocate memory.
+
+	The PropertyPackage calculation routines that do not take a workspace
+	argument use a workspace owned by the PropertyPackage.
+
+	\sa PropertyPackage
+
+*/
+
+class PropertyWorkspace
+{public:
+
+	//! Constructor
+	/*!
+	  Called upon construction of a PropertyWorkspace instance
+	*/
+
+	PropertyWorkspace()
+	{lastError="No error";
+	 vaporExists=liquidExists=false;
+	 vapFrac=liqFrac=0;
+	 flashPhaseType=VaporLiquid;
+	 flashTable=NULL;
+	 flashTableIndices=NULL;
+	 flashTmax=0;
+	 flashFingerprint=0;
+	 flashSeeded=false;
+	 solverEvaluations=0;
+	 compoundGeneration=0;
+	}
+
+	//! Return the last error
+	/*!
+	  Returns the error message of the last calculation that failed
+	  using this workspace
+	*/
+
+	const char *LastError() const {return lastError.c_str();}
+
+	//! Return the number of solver evaluations
+	/*!
+	  Returns the number of function evaluations performed by the 
+	  1-dimensional solvers during the last flash using this workspace,
+	  including those of nested TP flashes
+	*/
+
+	int SolverEvaluations() const {return solverEvaluations;}
+
+	//! Set the size of the pure component cache
+	/*!
+	  Set the number of temperatures (and compound sets) for which the pure component
+	  quantities are kept; zero disables the cache. Clears the cache.
+	  \param size Number of entries
+	  \sa PureComponentCache
+	*/
+
+	void SetCacheSize(int size) {cache.SetSize(size);}
+
+	//! Return the number of pure component cache hits
+	/*!
+	  Returns the number of calls that found all pure component quantities they 
+	  needed in the cache of this workspace
+	  \sa PureComponentCache
+	*/
+
+	long CacheHits() const {return cache.Hits();}
+
+	//! Return the number of pure component cache misses
+	/*!
+	  Returns the number of calls that evaluated pure component quantities
+	  \sa PureComponentCache
+	*/
+
+	long CacheMisses() const {return cache.Misses();}
+
+	//! Set the size of the flash solution history
+	/*!
+	  Set the number of compositions for which the last flash solution is kept,
+	  to start subsequent flashes of the same composition from; zero (the default)
+	  disables the history. Clears the history.
+	  \param size Number of entries
+	  \sa FlashHistory
+	*/
+
+	void SetFlashHistorySize(int size) {history.SetSize(size);}
+
+	//! Return the number of flash history hits
+	/*!
+	  Returns the number of flashes that found a previous solution for their composition
+	  \sa FlashHistory
+	*/
+
+	long FlashHistoryHits() const {return history.Hits();}
+
+	//! Return the number of flash history misses
+	/*!
+	  Returns the number of flashes that did not find a previous solution for their composition
+	  \sa FlashHistory
+	*/
+
+	long FlashHistoryMisses() const {return history.Misses();}
+
+	//! Return the number of flash history fallbacks
+	/*!
+	  Returns the number of solutions started from a previous solution that failed,
+	  after which the full bracket was used
+	  \sa FlashHistory
+	*/
+
+	long FlashHistoryFallbacks() const {return history.Fallbacks();}
+
+private:
+
+	//data members
+	string lastError; /*!< the last error is stored as text */
+    vector<double> values; /*!< internal buffer for return values */
+    vector<double*> valuePointers; /*!< internal buffer for pointers to return values */
+    vector<int> valueCounts; /*!< internal buffer for number of return values */
+    vector<int> flashCompounds; /*!< internal buffer storing compounds accounted for in flash */
+    vector<int> flashCompoundMapping; /*!< internal buffer storing mapping of compounds in array passed to Flash()*/
+    vector<double> flashComposition; /*!< internal buffer storing composition of compounds accounted for in flash*/
+    vector<double> flashMW; /*!< internal buffer storing molecular weights of compounds accounted for in flash*/
+	const CorrelationTable *flashTable; /*!< correlation table of the compounds accounted for in flash*/
+	const int *flashTableIndices; /*!< indices of the compounds accounted for in flash in flashTable, NULL if all compounds of flashTable in order*/
+	double flashTmax; /*!< lowest critical temperature of the compounds accounted for in flash*/
+    ScratchArena scratch; /*!< temporary per-compound arrays during property calcs and flashes, reset at each calculation*/
+	bool vaporExists,liquidExists; /*!< phase existence during flash calc*/
+	double vapFrac; /*!< molar vapor phase fraction during flash calc*/
+	double liqFrac; /*!< molar liquid phase fraction during flash calc*/
+	vector<double> vapX; /*!< molar vapor phase composition during flash calc*/
+	vector<double> liqX; /*!< molar liquid phase composition during flash calc*/
+	vector<Phase> existingPhases; /*!< internal buffer for returning existing phases after flash*/
+	vector<double> Psat; /*!< storage of Psat during constant T flashes*/
+	vector<double> PsatDT; /*!< storage of dPsat/dT during bubble and dew point calculations*/
+	vector<double> Kminus1; /*!< storage of K-1 values during TP flashes*/
+	FlashPhaseType flashPhaseType; /*!< storage of allowed phases specifier during flash*/
+	int solverEvaluations; /*!< number of solver function evaluations during the last flash*/
+	PureComponentCache cache; /*!< pure component quantities of recent calls*/
+	FlashHistory history; /*!< converged flash solutions of recent compositions*/
+	unsigned long long flashFingerprint; /*!< fingerprint of the composition of the current flash, if the history is enabled*/
+	bool flashSeeded; /*!< flashSeed holds a previous solution for the current flash*/
+	vector<unsigned int> compoundMarks; /*!< generation of the last duplicate check in which each compound of the package was seen, for large mixtures*/
+	unsigned int compoundGeneration; /*!< generation of the last duplicate check of a large mixture*/
+	FlashHistoryEntry flashSeed; /*!< previous solution for the current flash*/
+
+	//the property package performs the calculations
+	friend class PropertyPackage;
+
+};
@@ -0,0 +1,146 @@
+#include "stdafx.h"
+#include "PureComponentCache.h"
+#include "CorrelationTable.h"
+
+//! Constructor
+/*!
+  Called upon construction of a PureComponentCache instance
+  \param size Number of entries, optional (defaults to 4). Zero disables the cache
+*/
+
+PureComponentCache::PureComponentCache(int size)
+{useCount=0;
+ hits=misses=0;
+ SetSize(size);
+}
+
+//! Set the number of entries
+/*!
+  Set the number of entries of the cache; clears the cache. Zero disables the cache,
+  in which case Get() returns NULL and Find() always fails
+  \param size Number of entries
+*/
+
+void PureComponentCache::SetSize(int size)
+{if (size<0) size=0;
+ entries.clear();
+ entries.resize(size);
+ useCount=0;
+}
+
+//! Get the number of entries
+/*!
+  \return The number of entries of the cache
+*/
+
+int PureComponentCache::Size() const
+{return (int)entries.size();
+}
+
+//! Clear the cache
+/*!
+  Remove all entries; the counters are not reset
+*/
+
+void PureComponentCache::Clear()
+{int i;
+ for (i=0;i<(int)entries.size();i++)
+  {entries[i].table=NULL;
+   entries[i].available=0;
+  }
+}
+
+//! Check whether an entry matches a key
+/*!
+  \param entry The entry
+  \param table Correlation table of the compounds
+  \param indices Indices of the compounds in the table, NULL if all compounds of the table in order
+  \param n Number of compounds
+  \param T Temperature [K]
+  \return True if the entry holds the state of the compounds at T
+*/
+
+bool PureComponentCache::Matches(const PureComponentState &entry,const CorrelationTable &table,const int *indices,int n,double T) const
+{int i;
+ if ((entry.table!=&table)||(entry.T!=T)||(entry.n!=n)) return false;
+ if (entry.tableSerial!=table.Serial()) return false;
+ if (entry.allCompounds) return (indices==NULL);
+ if (!indices) return false;
+ for (i=0;i<n;i++) if (entry.indices[i]!=indices[i]) return false;
+ return true;
+}
+
+//! Get the state of a set of compounds
+/*!
+  Get the entry for a set of compounds at a temperature. If there is no such entry,
+  the least recently used entry is replaced by an entry without available quantities.
+  The caller evaluates the needed quantities that are not available, and adds them to
+  available. The entry remains valid until the next call to Get(), SetSize() or Clear().
+  \param table Correlation table of the compounds
+  \param indices Indices of the compounds in the table, NULL if all compounds of the table in order
+  \param n Number of compounds
+  \param T Temperature [K]
+  \param needed Quantities needed by the caller, one bit (1<<quantity) per quantity; used for counting hits
+  \return The entry, or NULL if the cache is disabled
+*/
+
+PureComponentState *PureComponentCache::Get(const CorrelationTable &table,const int *indices,int n,double T,int needed)
+{int i;
+ PureComponentState *entry;
+ if (entries.empty()) return NULL;
+ useCount++;
+ for (i=0;i<(int)entries.size();i++)
+  if (Matches(entries[i],table,indices,n,T))
+   {entry=&entries[i];
+    entry->lastUse=useCount;
+    if ((entry->available&needed)==needed) hits++;
+    else misses++;
+    return entry;
+   }
+ //replace the least recently used entry; unused entries have lastUse zero
+ entry=&entries[0];
+ for (i=1;i<(int)entries.size();i++) if (entries[i].lastUse<entry->lastUse) entry=&entries[i];
+ entry->table=&table;
+ entry->tableSerial=table.Serial();
+ entry->allCompounds=(indices==NULL);
+ if (indices) entry->indices.assign(indices,indices+n);
+ else entry->indices.clear();
+ entry->n=n;
+ entry->T=T;
+ entry->available=0;
+ entry->lastUse=useCount;
+ entry->values.resize(PureComponentQuantityCount*(size_t)(n>0?n:1));
+ misses++;
+ return entry;
+}
+
+//! Find a quantity of a single compound
+/*!
+  Look for a quantity of a compound at a temperature in the entries that are stored
+  for any set of compounds of the table that includes the compound. Counts a hit if 
+  found, and a miss otherwise; the entries are not modified.
+  \param table Correlation table of the compound
+  \param index Index of the compound in the table
+  \param T Temperature [K]
+  \param quantity The quantity
+  \param value Receives the value if found
+  \return True if found
+*/
+
+bool PureComponentCache::Find(const CorrelationTable &table,int index,double T,int quantity,double &value)
+{int i,j;
+ for (i=0;i<(int)entries.size();i++)
+  {PureComponentState &entry=entries[i];
+   if ((entry.table!=&table)||(entry.T!=T)||(!(entry.available&(1<<quantity)))) continue;
+   if (entry.tableSerial!=table.Serial()) continue;
+   if (entry.allCompounds) j=(index<entry.n)?index:-1;
+   else for (j=entry.n-1;j>=0;j--) if (entry.indices[j]==index) break;
+   if (j>=0)
+    {value=entry.Values(quantity)[j];
+     hits++;
+     return true;
+    }
+  }
+ misses++;
+ return false;
+}
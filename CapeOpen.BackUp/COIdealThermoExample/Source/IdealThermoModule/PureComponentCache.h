@@ -0,0 +1,132 @@
+#pragma once
+
+//forward declarations
+class CorrelationTable; //forward declaration
+
+//! Pure component quantities
+/*!
+	Temperature dependent pure component quantities that are stored by
+	PureComponentCache, one value per compound
+	\sa PureComponentCache
+*/
+
+typedef enum
+{	PureCompPSat=0,           /*!< vapor pressure */
+	PureCompPSatDT,           /*!< temperature derivative of vapor pressure */
+	PureCompLiqDens,          /*!< liquid density */
+	PureCompLiqDensDT,        /*!< temperature derivative of liquid density */
+	PureCompLiqVolume,        /*!< liquid volume, 1/liquid density */
+	PureCompCp,               /*!< ideal gas heat capacity */
+	PureCompCpInt,            /*!< integral of ideal gas heat capacity from reference temperature */
+	PureCompCpIntOverT,       /*!< integral of ideal gas heat capacity/T from reference temperature */
+	PureCompHvap,             /*!< heat of vaporization */
+	PureCompHvapDT,           /*!< temperature derivative of heat of vaporization */
+	PureComponentQuantityCount
+} PureComponentQuantity;
+
+//! PureComponentState class
+/*!
+	The pure component quantities of a set of compounds at a single temperature,
+	as stored by PureComponentCache. Quantities are evaluated when first needed;
+	available holds a bit (1<<quantity) for each quantity that has been evaluated.
+	\sa PureComponentCache
+*/
+
+class PureComponentState
+{public:
+
+	const CorrelationTable *table; /*!< correlation table of the compounds, NULL if the entry is not in use */
+	unsigned long tableSerial; /*!< serial number of the table when the entry was stored */
+	vector<int> indices; /*!< indices of the compounds in the table */
+	bool allCompounds; /*!< all compounds of the table in order; indices is then empty */
+	int n; /*!< number of compounds */
+	double T; /*!< temperature [K] */
+	int available; /*!< quantities that have been evaluated */
+	unsigned long lastUse; /*!< time of last use, for replacing the least recently used entry */
+	vector<double> values; /*!< n values for each quantity */
+
+	//! Constructor
+	PureComponentState()
+	{table=NULL;
+	 tableSerial=0;
+	 allCompounds=false;
+	 n=0;
+	 T=0;
+	 available=0;
+	 lastUse=0;
+	}
+
+	//! Values of a quantity
+	/*!
+	  \param quantity The quantity
+	  \return Pointer to n values
+	*/
+
+	double *Values(int quantity) {return &values[0]+quantity*n;}
+
+};
+
+//! PureComponentCache class
+/*!
+	A small least-recently-used cache of pure component quantities (vapor pressure,
+	heat of vaporization, heat capacity and its integrals, liquid density, and
+	their derivatives), keyed on the correlation table, the compound set and the
+	exact temperature.
+
+	Flowsheet solvers typically request several properties at the same temperature
+	in separate calls, for example vapor and liquid enthalpy followed by K values.
+	With the cache, only the first of these calls evaluates the correlations; the
+	others only evaluate the mixing rules.
+
+	Each PropertyWorkspace has its own cache, so that no locking is required. The
+	calls without workspace argument use the workspace, and thus the cache, of the
+	property package. Entries of a table that has been built again (e.g. because
+	the property package is loaded again) are not found, as the table serial
+	number changes upon building.
+
+	Hits and misses are counted per call; a call is a hit if all quantities it
+	needs were already available.
+
+	\sa PropertyWorkspace, CorrelationTable::Serial()
+*/
+
+class PureComponentCache
+{public:
+
+	//construction
+	PureComponentCache(int size=4);
+
+	//functions
+	void SetSize(int size);
+	int Size() const;
+	void Clear();
+	PureComponentState *Get(const CorrelationTable &table,const int *indices,int n,double T,int needed);
+	bool Find(const CorrelationTable &table,int index,double T,int quantity,double &value);
+
+	//! Number of hits
+	/*!
+	  \return Number of calls that found all needed quantities in the cache
+	*/
+
+	long Hits() const {return hits;}
+
+	//! Number of misses
+	/*!
+	  \return Number of calls that had to evaluate at least one quantity
+	*/
+
+	long Misses() const {return misses;}
+
+	//! Reset the hit and miss counters
+	void ResetCounters() {hits=misses=0;}
+
+private:
+
+	vector<PureComponentState> entries; /*!< the entries; an entry with NULL table is not in use */
+	unsigned long useCount; /*!< incremented at each use of an entry */
+	long hits; /*!< number of hits */
+	long misses; /*!< number of misses */
+
+	bool Matches(const PureComponentState &entry,const CorrelationTable &table,const int *indices,int n,double T) const;
+
+};
@@ -0,0 +1,126 @@
+#include "stdafx.h"
+#include "RachfordRice.h"
+#include "CorrelationTable.h"
+
+//SIMD kernels are available for x86 compilers that support per-function instruction sets
+#if (defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))) || (defined(_MSC_VER) && (_MSC_VER>=1910) && defined(_M_X64))
+#define RACHFORDRICE_SIMD
+#include <immintrin.h>
+#endif
+
+#ifdef __GNUC__
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define TARGET_AVX2
+#define TARGET_AVX512
+#endif
+
+#ifdef RACHFORDRICE_SIMD
+
+//! AVX2 Rachford Rice residual kernel
+/*!
+  As RachfordRice::ResidualScalar(), for 4 compounds at a time
+  \sa RachfordRice::ResidualScalar()
+*/
+
+TARGET_AVX2 static void ResidualAVX2(int n,const double *z,const double *c,double beta,double &F,double &FD)
+{int i;
+ double r,w,sum[4],sumD[4];
+ __m256d b=_mm256_set1_pd(beta);
+ __m256d one=_mm256_set1_pd(1.0);
+ __m256d f=_mm256_setzero_pd();
+ __m256d fd=_mm256_setzero_pd();
+ for (i=0;i+4<=n;i+=4)
+  {__m256d ci=_mm256_loadu_pd(c+i);
+   __m256d ri=_mm256_div_pd(one,_mm256_add_pd(one,_mm256_mul_pd(b,ci)));
+   __m256d wi=_mm256_mul_pd(_mm256_mul_pd(_mm256_loadu_pd(z+i),ci),ri);
+   f=_mm256_add_pd(f,wi);
+   fd=_mm256_sub_pd(fd,_mm256_mul_pd(_mm256_mul_pd(wi,ci),ri));
+  }
+ _mm256_storeu_pd(sum,f);
+ _mm256_storeu_pd(sumD,fd);
+ F=(sum[0]+sum[1])+(sum[2]+sum[3]);
+ FD=(sumD[0]+sumD[1])+(sumD[2]+sumD[3]);
+ //the tail is compiled for AVX2 as well, so the upper state need not be cleared
+ for (;i<n;i++)
+  {r=1.0/(1.0+beta*c[i]);
+   w=z[i]*c[i]*r;
+   F+=w;
+   FD-=w*c[i]*r;
+  }
+}
+
+//! AVX-512 Rachford Rice residual kernel
+/*!
+  As RachfordRice::ResidualScalar(), for 8 compounds at a time; the tail is done by masked loads
+  \sa RachfordRice::ResidualScalar()
+*/
+
+TARGET_AVX512 static void ResidualAVX512(int n,const double *z,const double *c,double beta,double &F,double &FD)
+{int i;
+ __m512d b=_mm512_set1_pd(beta);
+ __m512d one=_mm512_set1_pd(1.0);
+ __m512d f=_mm512_setzero_pd();
+ __m512d fd=_mm512_setzero_pd();
+ for (i=0;i<n;i+=8)
+  {//compounds beyond n are loaded as zero, and contribute zero
+   __mmask8 m=(n-i>=8)?(__mmask8)0xFF:(__mmask8)((1<<(n-i))-1);
+   __m512d ci=_mm512_maskz_loadu_pd(m,c+i);
+   __m512d ri=_mm512_div_pd(one,_mm512_add_pd(one,_mm512_mul_pd(b,ci)));
+   __m512d wi=_mm512_mul_pd(_mm512_mul_pd(_mm512_maskz_loadu_pd(m,z+i),ci),ri);
+   f=_mm512_add_pd(f,wi);
+   fd=_mm512_sub_pd(fd,_mm512_mul_pd(_mm512_mul_pd(wi,ci),ri));
+  }
+ F=_mm512_reduce_add_pd(f);
+ FD=_mm512_reduce_add_pd(fd);
+}
+
+#endif
+
+//! Constructor
+/*!
+  Called upon construction of a RachfordRice instance. The arrays are referenced,
+  not copied, and must remain valid while solving
+  \param nComp Number of compounds
+  \param z Overall composition
+  \param Kminus1 K values minus one
+  \param tol Required abs value of F at solution, optional (defaults to 1e-12)
+*/
+
+RachfordRice::RachfordRice(int nComp,const double *z,const double *Kminus1,double tol)
+{this->nComp=nComp;
+ this->z=z;
+ this->Kminus1=Kminus1;
+ this->tol=tol;
+ maxIterations=100;
+ iterations=0;
+}
+
+//! Evaluate the residual by the selected kernels
+/*!
+  Evaluate the Rachford Rice residual and its derivative for any number of 
+  compounds, using the kernels of the instruction set that is selected for the
+  CorrelationTable kernels; this is Residual() for a trip count of 0
+  \param beta Vapor fraction
+  \param F Receives the residual
+  \param FD Receives the derivative of the residual to beta
+  \sa CorrelationTable::Kernels()
+*/
+
+void RachfordRice::KernelResidual(double beta,double &F,double &FD) const
+{switch (CorrelationTable::Kernels())
+  {
+#ifdef RACHFORDRICE_SIMD
+   case AVX512Kernels:
+    ResidualAVX512(nComp,z,Kminus1,beta,F,FD);
+    return;
+   case AVX2Kernels:
+    ResidualAVX2(nComp,z,Kminus1,beta,F,FD);
+    return;
+#endif
+   default:
+    ResidualScalar<0>(nComp,z,Kminus1,beta,F,FD);
+    return;
+  }
+}
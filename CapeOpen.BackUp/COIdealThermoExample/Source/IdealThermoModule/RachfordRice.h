@@ -0,0 +1,173 @@
+#pragma once
+
+//! Largest number of compounds for which the flash kernels are specialised at compile time
+/*!
+  Most streams are binary or ternary. For up to this many compounds, the TP flash and
+  the Rachford Rice residual are instantiated for the exact number of compounds, so that
+  their loops have a compile-time trip count and are unrolled by the compiler. Above
+  this number, the generic code (with SIMD kernels for the residual) is used. The 
+  number of compounds is dispatched once, by PropertyPackage::SolveTPFlash(); the
+  code it calls is templated over the trip count, of which 0 is the generic code.
+  \sa RachfordRice, PropertyPackage::SolveTPFlash()
+*/
+
+#define FIXED_SIZE_COMPOUNDS 8
+
+//! RachfordRice class
+/*!
+	Solves the Rachford Rice equation for the vapor fraction beta of a two-phase
+	mixture with constant K values:
+
+	F(beta) = sum z[i] (K[i]-1) / (1 + beta (K[i]-1)) = 0
+
+	F decreases monotonically between the poles -1/(Kmax-1) and -1/(Kmin-1), so
+	the solution is unique on that interval. The search is further limited to the
+	region in which all phase mole fractions are between 0 and 1, and to 0..1.
+
+	Newton's method is applied to the Leibovici-Neoschil transform
+
+	G(beta) = (beta - poleLo) (poleHi - beta) F(beta)
+
+	which removes the poles and is nearly linear over the interval, so that
+	the solution is typically found in a few iterations for any number of
+	compounds. Steps that leave the bracketed region are replaced by bisection.
+
+	Solve is templated over the trip count N of the residual loop. For N = 0, the
+	residual and its derivative are evaluated by SIMD kernels, using the instruction
+	set selected for the CorrelationTable kernels. The caller instantiates N for
+	the number of compounds, up to FIXED_SIZE_COMPOUNDS, so that the residual is
+	evaluated in a loop with a constant trip count instead.
+
+	The caller must have established that a two-phase solution exists, that
+	is F(0) > 0 and F(1) < 0; TPFlash does so by comparing P to Pbub and Pdew.
+
+	\sa PropertyPackage::TPFlash(), CorrelationTable::SetKernels()
+*/
+
+class RachfordRice
+{public:
+
+	//construction
+	RachfordRice(int nComp,const double *z,const double *Kminus1,double tol=1e-12);
+
+	//functions
+	template <int N> bool Solve(double &beta,string &error);
+
+	//! Number of iterations
+	/*!
+	  \return The number of residual evaluations performed by the last call to Solve
+	*/
+
+	int Iterations() const {return iterations;}
+
+private:
+
+	int nComp; /*!< number of compounds */
+	const double *z; /*!< overall composition */
+	const double *Kminus1; /*!< K values minus one */
+	double tol; /*!< required abs value of F at solution */
+	int maxIterations; /*!< maximum number of iterations */
+	int iterations; /*!< number of iterations */
+
+	template <int N> void Residual(double beta,double &F,double &FD) const;
+	void KernelResidual(double beta,double &F,double &FD) const;
+
+	//! Scalar Rachford Rice residual kernel
+	/*!
+	  Evaluates the Rachford Rice residual and its derivative to the vapor fraction
+	  \param n Number of compounds, used if N is 0
+	  \param z Overall composition
+	  \param c K values minus one
+	  \param beta Vapor fraction
+	  \param F Receives sum z c / D, with D = 1 + beta c
+	  \param FD Receives the derivative of F to beta, - sum z c^2 / D^2
+	  \sa FIXED_SIZE_COMPOUNDS
+	*/
+
+	template <int N> static void ResidualScalar(int n,const double *z,const double *c,double beta,double &F,double &FD)
+	{int i;
+	 const int count=(N>0)?N:n; //trip count, constant if N is set
+	 double r,w;
+	 F=FD=0;
+	 for (i=0;i<count;i++)
+	  {r=1.0/(1.0+beta*c[i]);
+	   w=z[i]*c[i]*r;
+	   F+=w;
+	   FD-=w*c[i]*r;
+	  }
+	}
+
+};
+
+//! Evaluate the residual
+/*!
+  Evaluate the Rachford Rice residual and its derivative, for N compounds by the 
+  scalar kernel, or if N is 0 by KernelResidual()
+  \param beta Vapor fraction
+  \param F Receives the residual
+  \param FD Receives the derivative of the residual to beta
+*/
+
+template <int N> inline void RachfordRice::Residual(double beta,double &F,double &FD) const
+{if (N>0) ResidualScalar<N>(N,z,Kminus1,beta,F,FD);
+ else KernelResidual(beta,F,FD);
+}
+
+//! Solve
+/*!
+  Solve the Rachford Rice equation
+  \param beta Receives the vapor fraction
+  \param error Receives the error in case of failure
+  \return True if ok
+  \sa Residual()
+*/
+
+template <int N> bool RachfordRice::Solve(double &beta,string &error)
+{int i;
+ double c,cMin,cMax,poleLo,poleHi,lo,hi,bound,F,FD,a,b,betaNew;
+ iterations=0;
+ //poles, and the region in which 0 < y < 1 for K > 1 and 0 < x < 1 for K < 1
+ cMin=cMax=0;
+ lo=0;
+ hi=1.0;
+ for (i=0;i<nComp;i++)
+  {c=Kminus1[i];
+   if (c>0)
+    {if (c>cMax) cMax=c;
+     bound=(z[i]*(1.0+c)-1.0)/c;
+     if (bound>lo) lo=bound;
+    }
+   else if (c<0)
+    {if (c<cMin) cMin=c;
+     bound=(z[i]-1.0)/c;
+     if (bound<hi) hi=bound;
+    }
+  }
+ if ((cMax<=0)||(cMin>=0))
+  {error="K values do not allow a two-phase solution";
+   return false;
+  }
+ poleLo=-1.0/cMax;
+ poleHi=-1.0/cMin;
+ beta=0.5*(lo+hi);
+ for (;;)
+  {if (iterations>=maxIterations)
+    {error="Maximum number of Rachford Rice iterations exceeded";
+     return false;
+    }
+   iterations++;
+   Residual<N>(beta,F,FD);
+   if (fabs(F)<tol) break;
+   //F decreases monotonically, so the sign of F tells on which side the solution is
+   if (F>0) lo=beta;
+   else hi=beta;
+   //Newton step on G = a b F, with dG/dbeta = (b - a) F + a b dF/dbeta
+   a=beta-poleLo;
+   b=poleHi-beta;
+   betaNew=beta-a*b*F/((b-a)*F+a*b*FD);
+   if (!((betaNew>lo)&&(betaNew<hi))) betaNew=0.5*(lo+hi); //also catches NaN
+   if (betaNew==beta) break; //converged up to machine precision
+   beta=betaNew;
+  }
+ return true;
+}
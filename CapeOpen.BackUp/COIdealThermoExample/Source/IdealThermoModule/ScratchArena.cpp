@@ -0,0 +1,73 @@
+#include "stdafx.h"
+#include "ScratchArena.h"
+
+//! Minimum number of values of a block
+#define SCRATCH_MIN_BLOCK 1024
+
+//! Constructor
+/*!
+  Called upon construction of a ScratchArena instance; no memory is allocated
+  until the first call to Allocate()
+*/
+
+ScratchArena::ScratchArena()
+{block=offset=0;
+}
+
+//! Allocate values
+/*!
+  Take values from the current block, or from the next block if the current
+  block does not have enough values left. The next block is allocated or 
+  enlarged if needed; a new block holds at least twice the values of all
+  blocks before it.
+  \param count Number of values
+  \return Pointer to the values, which are not initialized; valid until released or until Reset()
+*/
+
+double *ScratchArena::Allocate(size_t count)
+{size_t i,size;
+ if ((block<blocks.size())&&(offset+count<=blocks[block].size()))
+  {double *values=&blocks[block][offset];
+   offset+=count;
+   return values;
+  }
+ //move on to the next block, unless nothing is in use in the current block
+ if ((block<blocks.size())&&(offset>0)) block++;
+ if ((block>=blocks.size())||(blocks[block].size()<count))
+  {size=SCRATCH_MIN_BLOCK;
+   for (i=0;i<block;i++) size+=2*blocks[i].size();
+   if (size<count) size=count;
+   if (block>=blocks.size()) blocks.resize(block+1); //moving the blocks does not move their values
+   blocks[block].resize(size);
+  }
+ offset=count;
+ return &blocks[block][0];
+}
+
+//! Release all values
+/*!
+  Release all values, and combine the blocks into a single block, so that the
+  next calculation does not need to allocate
+*/
+
+void ScratchArena::Reset()
+{size_t i,size;
+ block=offset=0;
+ if (blocks.size()<=1) return;
+ size=0;
+ for (i=0;i<blocks.size();i++) size+=blocks[i].size();
+ blocks.resize(1);
+ blocks[0].resize(size);
+}
+
+//! Get the capacity
+/*!
+  \return The total number of values of all blocks
+*/
+
+size_t ScratchArena::Capacity() const
+{size_t i,size;
+ size=0;
+ for (i=0;i<blocks.size();i++) size+=blocks[i].size();
+ return size;
+}
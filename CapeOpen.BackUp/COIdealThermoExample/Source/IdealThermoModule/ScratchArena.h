@@ -0,0 +1,87 @@
+#pragma once
+
+//! ScratchMark class
+/*!
+	A position in a ScratchArena, as returned by ScratchArena::Mark()
+	\sa ScratchArena
+*/
+
+class ScratchMark
+{public:
+
+	size_t block; /*!< index of the block */
+	size_t offset; /*!< number of values used in the block */
+
+};
+
+//! ScratchArena class
+/*!
+	A bump allocator for the temporary per-compound arrays of the property
+	calculations and flashes, such as the mixing rule intermediates. An 
+	allocation takes the next values of the current block; values are not
+	returned individually, but by going back to a position obtained from
+	Mark(), or by Reset() at the start of each calculation.
+
+	If the current block is full, the next block is used, and allocated if
+	needed, so that pointers obtained earlier remain valid. When the arena is
+	reset, multiple blocks are combined into a single block that holds all,
+	so that once the arena has grown to the size needed by a calculation,
+	repeating the calculation does not allocate.
+
+	Routines that are called in each iteration of a solver release their 
+	arrays before returning, so that the arena does not grow with the number 
+	of iterations:
+
+	\code
+	ScratchMark mark=ws.scratch.Mark();
+	double *values=ws.scratch.Allocate(nComp);
+	...
+	ws.scratch.Release(mark);
+	\endcode
+
+	Each PropertyWorkspace has its own arena, so that no locking is required.
+
+	\sa PropertyWorkspace
+*/
+
+class ScratchArena
+{public:
+
+	//construction
+	ScratchArena();
+
+	//functions
+	double *Allocate(size_t count);
+	void Reset();
+	size_t Capacity() const;
+
+	//! Current position
+	/*!
+	  \return The position, to pass to Release()
+	*/
+
+	ScratchMark Mark() const
+	{ScratchMark mark;
+	 mark.block=block;
+	 mark.offset=offset;
+	 return mark;
+	}
+
+	//! Go back to a position
+	/*!
+	  Release all values allocated after Mark() returned the position
+	  \param mark The position
+	*/
+
+	void Release(const ScratchMark &mark)
+	{block=mark.block;
+	 offset=mark.offset;
+	}
+
+private:
+
+	vector<vector<double> > blocks; /*!< the blocks; blocks after the current block are not in use */
+	size_t block; /*!< index of the current block */
+	size_t offset; /*!< number of values used in the current block */
+
+};
@@ -1,113 +1,363 @@
 #pragma once
+#include <float.h>
 
-//! Func1Dim function type definition
+//! Solver methods
 /*!
-
-    Signature for functions passed to Solver1Dim
-
-	\param param Parameter passed to Solver1Dim constructor
-	\param X Value of degree of freedom solved for
-	\param F Receives the value of function for which to find zero
-	\param error Receives error text in case of failure
-	\return True if ok
-    
-    \sa Solver1Dim()
-    
+	Method used by Solver1Dim to reduce the bracketed region
+	\sa Solver1Dim
 */
 
-typedef bool (*Func1Dim)(void *param,double X,double &F,string &error);
+typedef enum
+{	SolverIllinois=0,  /*!< regula falsi with the Illinois modification */
+	SolverBrent=1,     /*!< Brent's method: inverse quadratic interpolation, secant and bisection */
+	SolverNewton=2,    /*!< Newton's method, safeguarded by bisection; requires the derivative */
+} SolverMethod;
 
 //! Solver1Dim class
 /*!
 
-    Class for solving non-linear 1-dimensional problems
-    
-    This is a simple solver solver that requires bracketing the 
-    solution. The solution will then be found by reducing the 
-    bracketed region based upon 1st order information (without
-    the requirement to evaluate the derivative).
-    
-    The solver presumes the function to be solved is 
-    monotonically increasing or decreasing
-    
+    Class template for solving non-linear 1-dimensional problems
+
+    The function to be solved is a functor of type Func, which is stored by
+    value so that its evaluation is inlined into the solver. Func must 
+    provide
+
+    \code
+    static const bool derivative; //true if FDX is calculated
+    bool operator()(double X,double &F,double &FDX) const;
+    \endcode
+
+    which calculates F and, if derivative is true, dF/dX. The functor reports
+    its own errors, typically to the error member of the state it refers to;
+    Solve only sets the error for failures detected by the solver itself.
+
+    This solver requires bracketing the solution. The bracketed region
+    is then reduced until the function value is within the absolute
+    tolerance, until the bracketed region is smaller than the relative
+    tolerance times the solution, or until it cannot be reduced any further
+    in machine precision.
+
+    Without derivative information the bracketed region is reduced by
+    Brent's method (default) or by regula falsi with the Illinois modification.
+    If the function provides its derivative, Newton's method is the default; Newton
+    steps that leave the bracketed region or that do not reduce the step
+    size fast enough are replaced by bisection.
+
+    The number of function evaluations is limited, and is available after
+    solving along with the number of iterations.
+
 */
 
-class Solver1Dim
+template <class Func> class Solver1Dim
 {private:
- double Xlo;	/*!< lower limit of bracketed region */
- double Xhi;	/*!< upper limit of bracketed region */
- double X;	    /*!< current value and solution */
- Func1Dim func; /*!< function to be solved */
- double tol;    /*!< required tolerance */
- void *param;   /*!< parameter passed to func */
+ double Xlo;	   /*!< lower limit of bracketed region */
+ double Xhi;	   /*!< upper limit of bracketed region */
+ double Flo;     /*!< function value at Xlo */
+ double Fhi;     /*!< function value at Xhi */
+ double FDXlo;   /*!< derivative at Xlo, if known */
+ double FDXhi;   /*!< derivative at Xhi, if known */
+ bool bracketValues; /*!< Flo and Fhi are known */
+ double X;	     /*!< current value and solution */
+ Func func;      /*!< function to be solved */
+ SolverMethod method; /*!< method used to reduce the bracketed region */
+ double tol;     /*!< required tolerance */
+ double relTol;  /*!< required size of bracketed region, relative to solution */
+ int maxEvaluations; /*!< maximum number of function evaluations */
+ int evaluations;    /*!< number of function evaluations */
+ int iterations;     /*!< number of iterations */
+
+ //! Evaluate the function
+ /*!
+  Evaluate the function, check the result and count the evaluation
+  \param X Value of degree of freedom
+  \param F Receives the function value
+  \param FDX Receives the derivative, if available
+  \param error Receives the error in case of failure
+  \return True if ok
+ */
+
+ bool Evaluate(double X,double &F,double &FDX,string &error)
+ {if (evaluations>=maxEvaluations)
+   {error="Maximum number of function evaluations exceeded";
+    return false;
+   }
+  evaluations++;
+  FDX=0;
+  if (!func(X,F,FDX)) return false; //error is reported by func
+  if (_isnan(F))
+   {//without this check, the bracket would collapse onto NaN
+    error="Function value is not a number";
+    return false;
+   }
+  return true;
+ }
+
+ //! Initialize
+ /*!
+  Set defaults for the solver settings
+ */
+
+ void Init(double Xlo,double Xhi,double tol)
+ {this->Xlo=Xlo;
+  this->Xhi=Xhi;
+  this->tol=tol;
+  relTol=0;
+  maxEvaluations=100;
+  evaluations=iterations=0;
+  bracketValues=false;
+  FDXlo=FDXhi=0;
+ }
+
+ //! Solve by regula falsi with the Illinois modification
+ bool SolveIllinois(double &solution,string &error)
+ {double F,FDX;
+  int side=0; //side of bracket that was retained last
+  for (;;)
+  {iterations++;
+   X=(Xlo*Fhi-Xhi*Flo)/(Fhi-Flo);
+   if (!((X>Xlo)&&(X<Xhi))) X=0.5*(Xhi+Xlo); //also catches NaN
+   if ((X==Xlo)||(X==Xhi)) break; //converged up to machine precision
+   if (!Evaluate(X,F,FDX,error)) return false;
+   if (fabs(F)<tol) break;
+   if ((F<0)==(Flo<0))
+    {Xlo=X;
+     Flo=F;
+     if (side<0) Fhi*=0.5; //the same end point is retained twice
+     side=-1;
+    }
+   else
+    {Xhi=X;
+     Fhi=F;
+     if (side>0) Flo*=0.5;
+     side=1;
+    }
+   if (Xhi-Xlo<=relTol*fabs(X)) break;
+  }
+  solution=X;
+  return true;
+ }
+
+ //! Solve by Brent's method
+ bool SolveBrent(double &solution,string &error)
+ {double a,b,c,fa,fb,fc,d,e,p,q,r,s,tol1,xm,FDX;
+  a=Xlo;
+  fa=Flo;
+  b=Xhi;
+  fb=Fhi;
+  c=b;
+  fc=fb;
+  d=e=b-a;
+  for (;;)
+   {if ((fb>0)==(fc>0))
+     {//c must be on the other side of the solution
+      c=a;
+      fc=fa;
+      d=e=b-a;
+     }
+    if (fabs(fc)<fabs(fb))
+     {//b is the best estimate
+      a=b;b=c;c=a;
+      fa=fb;fb=fc;fc=fa;
+     }
+    tol1=2.0*DBL_EPSILON*fabs(b)+0.5*relTol*fabs(b);
+    xm=0.5*(c-b);
+    if (fabs(xm)<=tol1) break;
+    iterations++;
+    if ((fabs(e)>=tol1)&&(fabs(fa)>fabs(fb)))
+     {//try interpolation; secant if only two points are available
+      s=fb/fa;
+      if (a==c)
+       {p=2.0*xm*s;
+        q=1.0-s;
+       }
+      else
+       {q=fa/fc;
+        r=fb/fc;
+        p=s*(2.0*xm*q*(q-r)-(b-a)*(r-1.0));
+        q=(q-1.0)*(r-1.0)*(s-1.0);
+       }
+      if (p>0) q=-q;
+      p=fabs(p);
+      r=3.0*xm*q-fabs(tol1*q);
+      if (fabs(e*q)<r) r=fabs(e*q);
+      if (2.0*p<r)
+       {//accept interpolation
+        e=d;
+        d=p/q;
+       }
+      else
+       {//bisection
+        d=xm;
+        e=d;
+       }
+     }
+    else
+     {//bisection
+      d=xm;
+      e=d;
+     }
+    a=b;
+    fa=fb;
+    if (fabs(d)>tol1) b+=d;
+    else b+=(xm>0)?tol1:-tol1;
+    if (!Evaluate(b,fb,FDX,error)) return false;
+    if (fabs(fb)<tol) break;
+   }
+  solution=X=b;
+  return true;
+ }
+
+ //! Solve by safeguarded Newton's method
+ bool SolveNewton(double &solution,string &error)
+ {double F,FDX,Xnew,dx,dxOld;
+  //start by a Newton step from the end point with the smallest function value, if its
+  // derivative is known and the step stays within the bracketed region; else by interpolation
+  X=Xlo;
+  if (fabs(Flo)<fabs(Fhi)) 
+   {if (FDXlo!=0) X=Xlo-Flo/FDXlo;
+   }
+  else if (FDXhi!=0) X=Xhi-Fhi/FDXhi;
+  if (!((X>Xlo)&&(X<Xhi))) X=(Xlo*Fhi-Xhi*Flo)/(Fhi-Flo);
+  if (!((X>Xlo)&&(X<Xhi))) X=0.5*(Xhi+Xlo); //also catches NaN
+  dx=dxOld=Xhi-Xlo;
+  for (;;)
+   {iterations++;
+    if (!Evaluate(X,F,FDX,error)) return false;
+    if (fabs(F)<tol) break;
+    //reduce the bracketed region
+    if ((F<0)==(Flo<0))
+     {Xlo=X;
+      Flo=F;
+     }
+    else Xhi=X;
+    if (Xhi-Xlo<=relTol*fabs(X)) break;
+    //Newton step, unless it leaves the bracketed region or the step size does not reduce
+    dxOld=dx;
+    dx=F/FDX;
+    Xnew=X-dx;
+    if ((!((Xnew>Xlo)&&(Xnew<Xhi)))||(fabs(2.0*dx)>fabs(dxOld))) //also catches NaN
+     {Xnew=0.5*(Xlo+Xhi);
+      dx=X-Xnew;
+     }
+    if ((Xnew==Xlo)||(Xnew==Xhi)) break; //converged up to machine precision
+    X=Xnew;
+   }
+  solution=X;
+  return true;
+ }
 
  public:
 
  //! Constructor
  /*!
-  Called upon construction of a LinearSolver instance
+  Called upon construction of a Solver1Dim instance. The default method is 
+  SolverNewton if func provides the derivative, SolverBrent otherwise
   \param func Function to be solved
   \param Xlo Lower limit of bracketed region
   \param Xhi Upper limit of bracketed region
-  \param param Parameter passed to func
   \param tol Required abs value of F at solution, optional (defaults to 1e-8)
  */
 
- Solver1Dim(Func1Dim func,double Xlo,double Xhi,void *param,double tol=1e-8)
- {this->func=func;
-  this->Xlo=Xlo;
-  this->Xhi=Xhi;
-  this->param=param;
-  this->tol=tol;
+ Solver1Dim(const Func &func,double Xlo,double Xhi,double tol=1e-8) : func(func)
+ {method=Func::derivative?SolverNewton:SolverBrent;
+  Init(Xlo,Xhi,tol);
  }
- 
+
+ //! Set the method
+ /*!
+  Select the method used to reduce the bracketed region. SolverNewton
+  requires a function with derivative.
+  \param method Solver method
+ */
+
+ void SetMethod(SolverMethod method) {this->method=method;}
+
+ //! Set the relative tolerance
+ /*!
+  The solution is also accepted if the bracketed region is smaller than
+  relTol times the solution; by default only the absolute tolerance on F
+  and machine precision are used
+  \param relTol Relative tolerance
+ */
+
+ void SetRelativeTolerance(double relTol) {this->relTol=relTol;}
+
+ //! Set the maximum number of function evaluations
+ /*!
+  Solve fails if the solution is not found within this number of
+  function evaluations (defaults to 100)
+  \param maxEvaluations Maximum number of function evaluations
+ */
+
+ void SetMaxEvaluations(int maxEvaluations) {this->maxEvaluations=maxEvaluations;}
+
+ //! Set the function values at the limits of the bracketed region
+ /*!
+  If the function values at the limits of the bracketed region are already
+  known by the caller, they are not evaluated again. The limits are then not
+  accepted as solution without iterating, so that the solution is always 
+  a point at which the function was evaluated by the solver.
+  \param Flo Function value at Xlo
+  \param Fhi Function value at Xhi
+  \param FDXlo Derivative at Xlo, optional; used by SolverNewton for the first step
+  \param FDXhi Derivative at Xhi, optional; used by SolverNewton for the first step
+ */
+
+ void SetBracketValues(double Flo,double Fhi,double FDXlo=0,double FDXhi=0)
+ {this->Flo=Flo;
+  this->Fhi=Fhi;
+  this->FDXlo=FDXlo;
+  this->FDXhi=FDXhi;
+  bracketValues=true;
+ }
+
+ //! Number of function evaluations
+ /*!
+  \return The number of function evaluations performed by the last call to Solve
+ */
+
+ int Evaluations() const {return evaluations;}
+
+ //! Number of iterations
+ /*!
+  \return The number of iterations performed by the last call to Solve,
+   not counting the evaluations of the bracket limits
+ */
+
+ int Iterations() const {return iterations;}
+
  //! Solve
  /*!
   Solve the function
   \param solution Receives the solution
-  \param error Receives the error in case of failure
+  \param error Receives the error in case of a failure detected by the solver
   \return True if ok
  */
 
  bool Solve(double &solution,string &error)
- {double Flo;
-  double Fhi;
-  double frac;
-  double F;
-  bool increasing;
-  bool goUp;
-  if (!(*func)(param,Xlo,Flo,error)) return false;
-  if (fabs(Flo)<tol) {solution=Xlo;return true;}
-  if (!(*func)(param,Xhi,Fhi,error)) return false;
-  if (fabs(Fhi)<tol) {solution=Xhi;return true;}
-  if (Flo*Fhi>0) 
+ {evaluations=iterations=0;
+  if ((method==SolverNewton)&&(!Func::derivative))
+   {error="Newton method requires the derivative of the function";
+    return false;
+   }
+  if (!bracketValues)
+   {if (!Evaluate(Xlo,Flo,FDXlo,error)) return false;
+    if (fabs(Flo)<tol) {solution=Xlo;return true;}
+    if (!Evaluate(Xhi,Fhi,FDXhi,error)) return false;
+    if (fabs(Fhi)<tol) {solution=Xhi;return true;}
+   }
+  if (Flo*Fhi>0)
    {error="Allowed region does not contain solution";
     return false;
    }
-  increasing=(Fhi>Flo);
-  for (;;)
-  {//linear interpolation to find zero
-   frac=1.0-Fhi/(Fhi-Flo);
-   //limit to reasonable setp
-   if (frac<1e-3) frac=1e-3; else if (frac>0.999) frac=0.999;
-   X=Xlo+frac*(Xhi-Xlo);
-   if ((X==Xlo)||(X==Xhi)) X=0.5*(Xhi+Xlo);
-   if ((X==Xlo)||(X==Xhi)) {solution=X;return true;} //converged up to machine precision
-   if (!(*func)(param,X,F,error)) return false;
-   //check convergence
-   if (fabs(F)<tol) {solution=X;return true;}
-   //check direction   
-   goUp=(F<0);
-   if (!increasing) goUp=!goUp;
-   if (goUp)
-    {Xlo=X;
-     Flo=F;
-    }
-   else
-    {Xhi=X;
-     Fhi=F;
-    }
-  }
+  switch (method)
+   {case SolverIllinois:
+     return SolveIllinois(solution,error);
+    case SolverNewton:
+     return SolveNewton(solution,error);
+    default:
+     return SolveBrent(solution,error);
+   }
  }
- 
+
 };
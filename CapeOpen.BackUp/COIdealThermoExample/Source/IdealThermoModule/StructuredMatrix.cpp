@@ -0,0 +1,49 @@
+#include "stdafx.h"
+#include "StructuredMatrix.h"
+
+//! Constructor
+/*!
+  Called upon construction of a StructuredMatrix instance; the matrix is an
+  empty zero matrix
+*/
+
+StructuredMatrix::StructuredMatrix()
+{structure=ZeroMatrix;
+ rows=columns=0;
+ diagonal=u=v=NULL;
+}
+
+//! Element of the matrix
+/*!
+  \param row Row index
+  \param column Column index
+  \return The element
+*/
+
+double StructuredMatrix::Element(int row,int column) const
+{double value=0;
+ if ((structure!=ZeroMatrix)&&(row==column)) value=diagonal[column];
+ if (structure==DiagonalPlusRankOneMatrix) value+=u[row]*v[column];
+ return value;
+}
+
+//! Expand to a dense matrix
+/*!
+  Write all elements, row after row, in the layout of the matrix values of 
+  GetSinglePhaseProperties() and GetTwoPhaseProperties()
+  \param dense Receives rows*columns values
+  \sa DenseCount()
+*/
+
+void StructuredMatrix::Expand(double *dense) const
+{int i,j;
+ if (structure==DiagonalPlusRankOneMatrix)
+  {for (i=0;i<rows;i++)
+    {double *row=dense+i*columns;
+     for (j=0;j<columns;j++) row[j]=u[i]*v[j];
+    }
+  }
+ else memset(dense,0,sizeof(double)*rows*columns);
+ if (structure!=ZeroMatrix) 
+  for (i=0;(i<rows)&&(i<columns);i++) dense[i*columns+i]+=diagonal[i];
+}
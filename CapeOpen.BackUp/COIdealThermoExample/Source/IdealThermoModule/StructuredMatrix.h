@@ -0,0 +1,49 @@
+#pragma once
+#include "Properties.h"
+#include "ImportExport.h"
+
+//! StructuredMatrix class
+/*!
+	A composition-derivative matrix in structured form, as returned by 
+	PropertyPackage::GetSinglePhaseMatrix() and PropertyPackage::GetTwoPhaseMatrix().
+	
+	For the ideal models of this property package, the mole fraction and mole 
+	number derivatives of fugacity, fugacity coefficient, activity and K values
+	are zero, diagonal, or diagonal plus rank-one. Instead of rows*columns values,
+	the structured form holds at most 3 vectors:
+	
+	M[row][column] = (row==column ? diagonal[column] : 0) + u[row]*v[column]
+	
+	The dense matrix, in the layout of GetSinglePhaseProperties() and 
+	GetTwoPhaseProperties(), is only formed by Expand(). The vectors point into
+	the workspace of the calculation, and are valid until the next calculation
+	on that workspace.
+	
+	\sa MatrixStructure, PropertyPackage::GetSinglePhaseMatrix()
+*/
+
+class IMPORTEXPORT StructuredMatrix
+{public:
+
+	MatrixStructure structure; /*!< structure of the matrix */
+	int rows; /*!< number of rows */
+	int columns; /*!< number of columns */
+	const double *diagonal; /*!< the diagonal, columns values; NULL for ZeroMatrix */
+	const double *u; /*!< rank-one row factor, rows values; NULL unless DiagonalPlusRankOneMatrix */
+	const double *v; /*!< rank-one column factor, columns values; NULL unless DiagonalPlusRankOneMatrix */
+
+	//construction
+	StructuredMatrix();
+
+	//functions
+	double Element(int row,int column) const;
+	void Expand(double *dense) const;
+
+	//! Number of values of the dense matrix
+	/*!
+	  \return rows*columns, the size of the buffer that Expand() fills
+	*/
+
+	int DenseCount() const {return rows*columns;}
+
+};
@@ -0,0 +1,174 @@
+#include "stdafx.h"
+#include "VaporPressureSurrogate.h"
+#include "Compound.h"
+
+//! Lower limit of the tabulated range [K], which is the lower limit of the flashes
+#define SURROGATE_TMIN 50.0
+
+//! Vapor pressure at the lower end of the tabulated range [Pa], unless limited by SURROGATE_TMIN
+#define SURROGATE_PMIN 1e-3
+
+//! Maximum number of segments of a compound
+#define SURROGATE_MAX_SEGMENTS 1024
+
+//! Number of points inside each segment at which the error is checked upon building
+#define SURROGATE_CHECK_POINTS 8
+
+//! Exact vapor pressure from the Antoine equation
+/*!
+  \param antoine The Antoine equation
+  \param x Reciprocal temperature [1/K]
+  \param pSat Receives the vapor pressure [Pa]
+  \param dpSat Receives the derivative of the vapor pressure to x
+*/
+
+void VaporPressureSurrogate::ExactPSat(const Antoine &antoine,double x,double &pSat,double &dpSat)
+{double T=1.0/x;
+ double d=antoine.C+T;
+ pSat=antoine.Value(T);
+ dpSat=-pSat*antoine.Bln10*T*T/(d*d); //dPsat/dT * dT/dx
+}
+
+//! Constructor
+/*!
+  Called upon construction of a VaporPressureSurrogate instance; the surrogate
+  is empty until Build() is called
+*/
+
+VaporPressureSurrogate::VaporPressureSurrogate()
+{maxRelError=0;
+}
+
+//! Build the surrogate
+/*!
+  Tabulate the vapor pressure of all compounds
+  \param compounds The compounds; index i corresponds to compounds[i]
+  \param maxRelError Maximum relative error of the vapor pressure
+*/
+
+void VaporPressureSurrogate::Build(const vector<Compound*> &compounds,double maxRelError)
+{int i;
+ vector<double> coef;
+ this->maxRelError=maxRelError;
+ splines.resize(compounds.size());
+ coefficients.clear();
+ for (i=0;i<(int)compounds.size();i++)
+  {splines[i].offset=coefficients.size();
+   if (Tabulate(compounds[i],splines[i],coef)) coefficients.insert(coefficients.end(),coef.begin(),coef.end());
+  }
+}
+
+//! Build the surrogate from another surrogate
+/*!
+  Copy the splines of a number of compounds from another surrogate, such as for
+  a PreparedMixture from the surrogate of its property package
+  \param source The surrogate to copy from
+  \param n Number of compounds
+  \param indices Indices of the compounds in source; index i corresponds to source index indices[i]
+*/
+
+void VaporPressureSurrogate::Build(const VaporPressureSurrogate &source,int n,const int *indices)
+{int i;
+ maxRelError=source.maxRelError;
+ splines.resize(n);
+ coefficients.clear();
+ for (i=0;i<n;i++)
+  {const Spline &s=source.splines[indices[i]];
+   splines[i]=s;
+   splines[i].offset=coefficients.size();
+   coefficients.insert(coefficients.end(),source.coefficients.begin()+s.offset,source.coefficients.begin()+s.offset+4*s.segments);
+  }
+}
+
+//! Tabulate the vapor pressure of a compound
+/*!
+  Find the smallest number of segments, doubling from 8, for which the spline meets
+  the maximum relative error
+  \param compound The compound
+  \param s Receives the spline; the offset is not set
+  \param coef Receives the coefficients of the spline
+  \return False if the compound cannot be tabulated
+*/
+
+bool VaporPressureSurrogate::Tabulate(const Compound *compound,Spline &s,vector<double> &coef) const
+{int n,j,k;
+ double Tmin,xmax,h,x0,x1,f0,d0,f1,d1,f,d,t,value;
+ const Antoine &antoine=*compound->pSatCorrelation;
+ s.segments=0;
+ s.xmin=s.invH=0;
+ //temperature at which Psat = SURROGATE_PMIN
+ d=antoine.A-log10(SURROGATE_PMIN);
+ if (d<=0) return false; 
+ Tmin=antoine.B/d-antoine.C;
+ if (Tmin<SURROGATE_TMIN) Tmin=SURROGATE_TMIN;
+ if ((compound->TC<=Tmin)||(antoine.C+Tmin<=0)) return false;
+ s.xmin=1.0/compound->TC;
+ xmax=1.0/Tmin;
+ for (n=8;n<=SURROGATE_MAX_SEGMENTS;n*=2)
+  {h=(xmax-s.xmin)/n;
+   coef.resize(4*n);
+   ExactPSat(antoine,s.xmin,f0,d0);
+   for (j=0;j<n;j++)
+    {x0=s.xmin+j*h;
+     x1=(j+1==n)?xmax:s.xmin+(j+1)*h;
+     ExactPSat(antoine,x1,f1,d1);
+     //cubic Hermite in the position t in the segment
+     double *c=&coef[4*j];
+     c[0]=f0;
+     c[1]=h*d0;
+     c[2]=3.0*(f1-f0)-h*(2.0*d0+d1);
+     c[3]=2.0*(f0-f1)+h*(d0+d1);
+     for (k=1;k<=SURROGATE_CHECK_POINTS;k++)
+      {t=(double)k/(SURROGATE_CHECK_POINTS+1);
+       ExactPSat(antoine,x0+t*h,f,d);
+       value=c[0]+t*(c[1]+t*(c[2]+t*c[3]));
+       if (!(fabs(value-f)<=maxRelError*f)) break;
+      }
+     if (k<=SURROGATE_CHECK_POINTS) break; //error too large
+     f0=f1;
+     d0=d1;
+    }
+   if (j==n)
+    {s.invH=1.0/h;
+     s.segments=n;
+     return true;
+    }
+  }
+ s.xmin=s.invH=0;
+ return false;
+}
+
+//! Validate the surrogate of a compound
+/*!
+  Compare the tabulated vapor pressure and the temperature derivative that follows
+  from it, as in CorrelationTable::PSatDT(), to the Antoine equation, at 16 points
+  in each segment that differ from the points checked upon building
+  \param compound The compound
+  \param index Index of the compound in the surrogate
+  \param validation Receives the result
+  \return False if the compound is not tabulated
+*/
+
+bool VaporPressureSurrogate::Validate(const Compound *compound,int index,SurrogateValidation &validation) const
+{int j,k;
+ double x,T,pSat,dpSat,err;
+ const Spline &s=splines[index];
+ const Antoine &antoine=*compound->pSatCorrelation;
+ validation=SurrogateValidation();
+ if (!s.segments) return false;
+ validation.segments=s.segments;
+ validation.Tmin=1.0/(s.xmin+s.segments/s.invH);
+ validation.Tmax=1.0/s.xmin;
+ for (j=0;j<s.segments;j++)
+  for (k=0;k<16;k++)
+   {x=s.xmin+(j+(k+0.5)/16.0)/s.invH;
+    if (!Value(index,x,pSat)) continue;
+    T=1.0/x;
+    err=fabs(pSat/antoine.Value(T)-1.0);
+    if (err>validation.maxError) validation.maxError=err;
+    dpSat=pSat*antoine.Bln10/((antoine.C+T)*(antoine.C+T));
+    err=fabs(dpSat/antoine.ValueDT(T)-1.0);
+    if (err>validation.maxErrorDT) validation.maxErrorDT=err;
+   }
+ return true;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+//forward declarations
+class Compound; //forward declaration
+class Antoine; //forward declaration
+
+//! SurrogateValidation class
+/*!
+	The result of comparing the tabulated vapor pressure of a compound to the
+	exact Antoine equation, as obtained from VaporPressureSurrogate::Validate()
+	\sa VaporPressureSurrogate
+*/
+
+class SurrogateValidation
+{public:
+
+	int segments; /*!< number of spline segments, zero if the compound is not tabulated */
+	double Tmin; /*!< lower end of the tabulated range [K] */
+	double Tmax; /*!< upper end of the tabulated range [K] */
+	double maxError; /*!< largest relative error of the vapor pressure */
+	double maxErrorDT; /*!< largest relative error of the temperature derivative of the vapor pressure */
+
+	//! Constructor
+	SurrogateValidation()
+	{segments=0;
+	 Tmin=Tmax=maxError=maxErrorDT=0;
+	}
+
+};
+
+//! VaporPressureSurrogate class
+/*!
+	Tabulated vapor pressures, as an optional replacement of the Antoine equation
+	in the CorrelationTable. For each compound, Psat is sampled at load time on a 
+	grid that is uniform in 1/T, in which ln(Psat) is nearly linear, and is evaluated
+	from a piecewise cubic Hermite spline through the samples and the exact 
+	derivatives. The vapor pressure then costs a segment lookup and a cubic instead
+	of a pow() per compound.
+
+	The range of a compound is from the temperature at which Psat is 1e-3 Pa, or 
+	50 K if higher, to the critical temperature. Below 1e-3 Pa the vapor pressure
+	spans too many decades to be tabulated with a bounded relative error, and is
+	not relevant for the phase equilibrium. The number of segments of a compound 
+	is doubled until the relative error of the vapor pressure, checked at 8 points
+	inside each segment, is below the requested maximum. The temperature derivative
+	is not tabulated: it follows exactly from the tabulated vapor pressure, as
+	Psat B ln(10) / (C+T)^2, and so has the same relative error. Compounds that do not
+	reach the requested error within 1024 segments are not tabulated, and neither
+	are temperatures outside the range; for these, the Antoine equation is used.
+
+	The polynomial correlations (heat capacity and its integrals, heat of
+	vaporization and liquid density) are not tabulated: a quartic polynomial costs
+	no more than the evaluation of a spline segment.
+
+	\sa CorrelationTable::Tabulate(), PropertyPackage::SetTabulation()
+*/
+
+class VaporPressureSurrogate
+{public:
+
+	//construction
+	VaporPressureSurrogate();
+
+	//functions
+	void Build(const vector<Compound*> &compounds,double maxRelError);
+	void Build(const VaporPressureSurrogate &source,int n,const int *indices);
+	bool Validate(const Compound *compound,int index,SurrogateValidation &validation) const;
+
+	//! Maximum relative error
+	/*!
+	  \return The maximum relative error of the vapor pressure the surrogate was built for
+	*/
+
+	double MaxRelError() const {return maxRelError;}
+
+	//! Evaluate the spline of a compound
+	/*!
+	  \param index Index of the compound
+	  \param x Reciprocal temperature [1/K]
+	  \param pSat Receives the vapor pressure [Pa]
+	  \return False if the compound is not tabulated at x
+	*/
+
+	bool Value(int index,double x,double &pSat) const
+	{const Spline &s=splines[index];
+	 double u=(x-s.xmin)*s.invH;
+	 if (!((u>=0)&&(u<=s.segments))) return false; //also if not tabulated
+	 int seg=(int)u;
+	 if (seg==s.segments) seg--;
+	 double t=u-seg;
+	 const double *c=&coefficients[s.offset+4*seg];
+	 pSat=c[0]+t*(c[1]+t*(c[2]+t*c[3]));
+	 return true;
+	}
+
+private:
+
+	//! Spline of a single compound
+	struct Spline
+	{double xmin; /*!< reciprocal of the upper end of the range [1/K] */
+	 double invH; /*!< reciprocal of the segment width in x */
+	 int segments; /*!< number of segments, zero if not tabulated */
+	 size_t offset; /*!< start of the coefficients of the first segment */
+	};
+
+	vector<Spline> splines; /*!< the spline of each compound */
+	vector<double> coefficients; /*!< 4 coefficients per segment, of the cubic in the position in the segment */
+	double maxRelError; /*!< maximum relative error of the vapor pressure */
+
+	bool Tabulate(const Compound *compound,Spline &s,vector<double> &coef) const;
+	static void ExactPSat(const Antoine &antoine,double x,double &pSat,double &dpSat);
+
+};
@@ -5,6 +5,8 @@
 
 #pragma once
 
+#ifdef _WIN32
+
 // Modify the following defines if you have to target a platform prior to the ones specified below.
 // Refer to MSDN for the latest info on corresponding values for different platforms.
 #ifndef WINVER				// Allow use of features specific to Windows XP or later.
@@ -27,6 +29,11 @@
 // Windows Header Files:
 #include <windows.h>
 
+#endif
+
+//platform shim for non-Windows builds of the numerical core
+#include "Platform.h"
+
 //math library
 #include <math.h>
 
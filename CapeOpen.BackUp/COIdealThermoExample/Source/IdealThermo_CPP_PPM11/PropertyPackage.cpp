@@ -1676,27 +1676,15 @@ BOOL CPropertyPackage::GetCompounds(VARIANT compoundList,vector<int> &compoundIn
      return FALSE;
     }
    string compId=CT2CA(compID);
-   //compare against the component names in the property package (ignore character case)
-   for (j=0;j<count;j++)
-    {const char *compName=pack->GetCompoundStringConstant(j,Name);
-     if (!compName)
-      {error=L"Failed to get component name in property package: ";
-       error+=CA2CT(pack->LastError());
-       return FALSE;
-      }
-     if (lstrcmpiA(compName,compId.c_str())==0)
-      {//found it
-       compoundIndices[i]=j;
-       break;
-      }
-    }
-   if (j==count)
+   //look up the component name in the property package (ignore character case)
+   if (!pack->GetCompoundIndex(compId.c_str(),j))
     {//compound not found
      error=L"Invalid list of compounds: compound \"";
      error+=CA2CT(compId.c_str());
      error+=L"\" does not exist";
      return FALSE;
     }
+   compoundIndices[i]=j;
   }
  //all OK
  return TRUE;
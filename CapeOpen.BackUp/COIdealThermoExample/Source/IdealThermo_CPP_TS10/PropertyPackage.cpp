@@ -1416,22 +1416,8 @@ BOOL CPropertyPackage::GetCompoundsFromMaterial(ICapeThermoMaterialObjectPtr &ma
      return FALSE;
     }
    string compId=CT2CA(compID);
-   //compare against the component names in the property package (ignore character case)
-   for (j=0;j<count;j++)
-    {const char *compName=pack->GetCompoundStringConstant(j,Name);
-     if (!compName)
-      {s=L"Failed to get component name in property package: ";
-       s+=CA2CT(pack->LastError());
-       SetError(s.c_str(),iface,fnc);
-       return FALSE;
-      }
-     if (lstrcmpiA(compName,compId.c_str())==0)
-      {//found it
-       compIndices[i]=j;
-       break;
-      }
-    }
-   if (j==count)
+   //look up the component name in the property package (ignore character case)
+   if (!pack->GetCompoundIndex(compId.c_str(),j))
     {//compound not found
      s=L"Invalid list of compounds from material object: compound \"";
      s+=CA2CT(compId.c_str());
@@ -1439,6 +1425,7 @@ BOOL CPropertyPackage::GetCompoundsFromMaterial(ICapeThermoMaterialObjectPtr &ma
      SetError(s.c_str(),iface,fnc);
      return FALSE;
     }
+   compIndices[i]=j;
   }
  //all OK
  return TRUE;
@@ -0,0 +1,741 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <CPPExports.h>     // exports from the IdealThermoModule
+#include <TestData.h>       // synthetic compounds, shared with the ThermoTests
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+/*! \mainpage Thermo Bench
+*
+*This project (ThermoBench) implements a throughput benchmark for the
+*numerical core of the IdealThermoModule.
+*
+*A set of synthetic compounds is generated for each of the requested
+*mixture sizes (by default 2, 10, 50, 200 and 1000 compounds), each written
+*as .compound file along with a .propertypackage file, so that the
+*regular loading code is used. For each mixture the benchmark measures
+*
+* - compound name lookups per second, looking up all compounds of the
+*   package (benchmark "lookup")
+* - flashes per second for each FlashType, with compound indices and on a
+*   prepared mixture (benchmark "prepared")
+* - flashes per second for each FlashType with the vapor pressures
+*   tabulated to the relative error given by --tabulation, by default 1e-6
+*   (benchmark "tabulated"); 0 skips these
+* - flashes per second for each FlashType on a drifting specification,
+*   with and without the flash solution history (benchmark "history")
+* - calls per second for each SinglePhaseProperty, for both phases, and
+*   for all properties at once, also on a prepared mixture and without
+*   the pure component cache (benchmark "uncached")
+* - flashes per second for each FlashType using PropertyPackBatch, for
+*   each of the requested thread counts (by default 1 and the number of
+*   processors); the phase column holds the thread count
+*
+*Results are written as comma separated values, one line per case,
+*so that they can be compared between releases:
+*
+*  benchmark,case,phase,compounds,calls,failures,seconds,rate,evaluations
+*
+*where rate is the number of calls per second. For flashes, evaluations is 
+*the average number of function evaluations of the 1-dimensional solvers 
+*per flash, including those of nested TP flashes; it is empty for other cases.
+*
+*The large sizes show how the calls scale with the number of compounds, as
+*for crude oil fractions of hundreds of pseudo-components: for a call that is
+*linear in the number of compounds, rate times compounds is constant.
+*
+*Loading is measured from the .compound files (load,package), also on a
+*single thread (load,sequential), while the compounds are in use by another
+*package, so that they are shared rather than loaded (load,shared), from a
+*compound database image of the data folder (load,database) and from a
+*compound library with the compounds of the package (load,library) and
+*with deferred loading of the correlations (load,lazy); the first use of
+*the correlations of up to 10 compounds after a lazy load is reported as
+*load,lazy-use, with the number of compounds in the calls column. The 
+*time to compile the image is reported as compile,database, with the number
+*of compounds in the image in the compounds column. The image and the 
+*library are removed after loading, so that the other cases use the 
+*.compound files.
+*
+*The phase column of the load line holds the instruction set that is used
+*to evaluate the correlations for all compounds of a mixture at once; it
+*can be selected with --kernels (scalar, avx2 or avx512). The load line
+*of the tabulated package includes building the splines.
+*
+*The generated files are written to --data, where they are kept, or to a
+*temporary folder that is removed on exit.
+*
+*Usage: thermo_bench [--sizes 2,10,50,200,1000] [--threads 1,4] [--kernels name] [--time seconds] [--tabulation maxRelError] [--out file] [--data folder]
+*
+*/
+
+//! Names of the flash types, in order of FlashType
+static const char *flashTypeNames[FlashTypeCount]={"TP","TVF","PVF","TVFm","PVFm","PH","PS"};
+
+//! Names of the single phase properties, in order of SinglePhaseProperty
+static const char *singlePhasePropertyNames[SinglePhasePropertyCount]=
+ {"density","density.Dtemperature","density.Dpressure","density.Dmolfraction","density.Dmoles",
+  "volume","volume.Dtemperature","volume.Dpressure","volume.Dmolfraction","volume.Dmoles",
+  "enthalpy","enthalpy.Dtemperature","enthalpy.Dpressure","enthalpy.Dmolfraction","enthalpy.Dmoles",
+  "entropy","entropy.Dtemperature","entropy.Dpressure","entropy.Dmolfraction","entropy.Dmoles",
+  "fugacity","fugacity.Dtemperature","fugacity.Dpressure","fugacity.Dmolfraction","fugacity.Dmoles",
+  "fugacityCoefficient","fugacityCoefficient.Dtemperature","fugacityCoefficient.Dpressure","fugacityCoefficient.Dmolfraction","fugacityCoefficient.Dmoles",
+  "logFugacityCoefficient","logFugacityCoefficient.Dtemperature","logFugacityCoefficient.Dpressure","logFugacityCoefficient.Dmolfraction","logFugacityCoefficient.Dmoles",
+  "activity","activity.Dtemperature","activity.Dpressure","activity.Dmolfraction","activity.Dmoles"};
+
+//! Benchmark settings
+struct BenchSettings
+{vector<int> sizes;   /*!< mixture sizes */
+ vector<int> threads; /*!< thread counts for batch flashes */
+ double minTime;      /*!< minimum run time per case [s] */
+ double tabulation;   /*!< maximum relative error of the tabulated vapor pressures, 0 for no tabulated benchmark */
+ string dataFolder;   /*!< folder for generated compound and package files */
+ FILE *out;           /*!< result output */
+};
+
+//! Timer
+/*!
+  Returns elapsed time in seconds since first call
+*/
+
+static double Now()
+{static chrono::steady_clock::time_point start=chrono::steady_clock::now();
+ return chrono::duration<double>(chrono::steady_clock::now()-start).count();
+}
+
+//! Write a result line
+static void Report(BenchSettings &settings,const char *benchmark,const char *caseName,const char *phase,int nComp,long calls,long failures,double seconds,double evaluations=-1)
+{fprintf(settings.out,"%s,%s,%s,%d,%ld,%ld,%.6f,%.1f,",benchmark,caseName,phase,nComp,calls,failures,seconds,(seconds>0)?calls/seconds:0.0);
+ if (evaluations>=0) fprintf(settings.out,"%.2f",evaluations);
+ fprintf(settings.out,"\n");
+ fflush(settings.out);
+}
+
+//! Flash specifications for a mixture
+struct FlashSpecs
+{double T;     /*!< temperature in the two-phase region [K] */
+ double P;     /*!< pressure [Pa] */
+ double VF;    /*!< vapor fraction */
+ double H;     /*!< enthalpy at T,P [J/mol] */
+ double S;     /*!< entropy at T,P [J/mol/K] */
+};
+
+//! Determine flash specifications for a mixture
+/*!
+  Determine a temperature half way between bubble and dew point at atmospheric
+  pressure, and the enthalpy and entropy at that point. In case bubble or dew
+  point cannot be obtained, the mole fraction averaged normal boiling point is
+  used
+*/
+
+static void GetSpecs(PropertyPack &pp,int nComp,const int *compIndices,const double *X,FlashSpecs &specs)
+{int phaseCount,i,j;
+ Phase *phases;
+ double *phaseFractions;
+ double **phaseCompositions;
+ double T,P,Tbub,Tdew;
+ specs.P=101325.0;
+ specs.VF=0.5;
+ specs.T=0;
+ for (i=0;i<nComp;i++)
+  {double NBP;
+   pp.GetCompoundRealConstant(compIndices[i],NormalBoilingPoint,NBP);
+   specs.T+=X[i]*NBP;
+  }
+ if ((pp.Flash(nComp,compIndices,X,PVF,specs.P,0.0,phaseCount,phases,phaseFractions,phaseCompositions,Tbub,P))&&
+     (pp.Flash(nComp,compIndices,X,PVF,specs.P,1.0,phaseCount,phases,phaseFractions,phaseCompositions,Tdew,P)))
+  specs.T=0.5*(Tbub+Tdew);
+ specs.H=specs.S=0;
+ if (pp.Flash(nComp,compIndices,X,TP,specs.T,specs.P,phaseCount,phases,phaseFractions,phaseCompositions,T,P))
+  {//store phase results before calculating properties
+   vector<double> fractions(phaseFractions,phaseFractions+phaseCount);
+   vector<Phase> phaseIDs(phases,phases+phaseCount);
+   vector<vector<double> > compositions(phaseCount);
+   for (j=0;j<phaseCount;j++) compositions[j].assign(phaseCompositions[j],phaseCompositions[j]+nComp);
+   SinglePhaseProperty props[2]={Enthalpy,Entropy};
+   for (j=0;j<phaseCount;j++)
+    {int *valueCount;
+     double **values;
+     if (pp.GetSinglePhaseProperties(nComp,compIndices,phaseIDs[j],specs.T,specs.P,&compositions[j][0],2,props,valueCount,values))
+      {specs.H+=fractions[j]*values[0][0];
+       specs.S+=fractions[j]*values[1][0];
+      }
+    }
+  }
+}
+
+//! Get the specifications for a flash type
+static void GetFlashSpecs(int type,const FlashSpecs &specs,double &spec1,double &spec2)
+{switch (type)
+  {case TP: spec1=specs.T;spec2=specs.P;break;
+   case TVF: case TVFm: spec1=specs.T;spec2=specs.VF;break;
+   case PVF: case PVFm: spec1=specs.P;spec2=specs.VF;break;
+   case PH: spec1=specs.P;spec2=specs.H;break;
+   default: spec1=specs.P;spec2=specs.S;break;
+  }
+}
+
+//! Benchmark loading the .compound files on a single thread
+/*!
+  \param settings Benchmark settings
+  \param path Path of the property package
+  \param nComp Number of compounds
+*/
+
+static void BenchSequentialLoad(BenchSettings &settings,const string &path,int nComp)
+{PropertyPack pp;
+ SetCompoundLoadThreads(1);
+ double start=Now();
+ if (pp.Load(path.c_str())) Report(settings,"load","sequential",GetCorrelationKernels(),nComp,1,0,Now()-start);
+ else fprintf(stderr,"Failed to load package with %d compounds sequentially: %s\n",nComp,pp.LastError());
+ SetCompoundLoadThreads(0);
+}
+
+//! Benchmark loading from a compound database
+/*!
+  Compile the compounds of the data folder into a compound database image,
+  load the package from it, and remove the image again
+  \param settings Benchmark settings
+  \param path Path of the property package
+  \param nComp Number of compounds
+*/
+
+static void BenchDatabaseLoad(BenchSettings &settings,const string &path,int nComp)
+{char error[1024];
+ int count;
+ double start=Now();
+ if (!CompileCompoundDatabase(settings.dataFolder.c_str(),NULL,&count,error,sizeof(error)))
+  {fprintf(stderr,"Failed to compile compound database: %s\n",error);
+   return;
+  }
+ Report(settings,"compile","database","",count,1,0,Now()-start);
+ PropertyPack pp;
+ start=Now();
+ if (pp.Load(path.c_str())) Report(settings,"load","database",GetCorrelationKernels(),nComp,1,0,Now()-start);
+ else fprintf(stderr,"Failed to load package with %d compounds from compound database: %s\n",nComp,pp.LastError());
+ remove((settings.dataFolder+"/compounds.compounddb").c_str());
+ SetCompoundDataPath(settings.dataFolder.c_str());
+}
+
+//! Benchmark loading from a compound library
+/*!
+  Concatenate the .compound files of the package into a compound library in
+  the data folder, load the package from it, and remove the library again
+  \param settings Benchmark settings
+  \param path Path of the property package
+  \param nComp Number of compounds
+*/
+
+static void BenchLibraryLoad(BenchSettings &settings,const string &path,int nComp)
+{char name[64];
+ char block[4096];
+ size_t count;
+ int i;
+ sprintf(name,"/bench%d.compoundlibrary",nComp);
+ string libraryPath=settings.dataFolder+name;
+ FILE *f=fopen(libraryPath.c_str(),"wb");
+ if (!f)
+  {fprintf(stderr,"Failed to write compound library \"%s\"\n",libraryPath.c_str());
+   return;
+  }
+ for (i=0;i<nComp;i++)
+  {sprintf(name,"/bench%dc%d.compound",nComp,i);
+   FILE *comp=fopen((settings.dataFolder+name).c_str(),"rb");
+   if (!comp) continue;
+   while ((count=fread(block,1,sizeof(block),comp))>0) fwrite(block,1,count,f);
+   fclose(comp);
+  }
+ fclose(f);
+ PropertyPack pp;
+ double start=Now();
+ if (pp.Load(path.c_str())) Report(settings,"load","library",GetCorrelationKernels(),nComp,1,0,Now()-start);
+ else fprintf(stderr,"Failed to load package with %d compounds from compound library: %s\n",nComp,pp.LastError());
+ remove(libraryPath.c_str());
+}
+
+//! Benchmark loading with deferred correlations
+/*!
+  Load the package in lazy mode, and evaluate a temperature dependent property
+  of up to 10 compounds, which loads their correlations; a failure is counted
+  if the load counters do not show exactly these compounds as loaded
+  \param settings Benchmark settings
+  \param path Path of the property package
+  \param nComp Number of compounds
+*/
+
+static void BenchLazyLoad(BenchSettings &settings,const string &path,int nComp)
+{PropertyPack pp;
+ int i,used,compoundCount,deferred,loaded;
+ long failures=0;
+ double value;
+ pp.SetLazyLoading(true);
+ double start=Now();
+ if (!pp.Load(path.c_str()))
+  {fprintf(stderr,"Failed to load package with %d compounds lazily: %s\n",nComp,pp.LastError());
+   return;
+  }
+ Report(settings,"load","lazy",GetCorrelationKernels(),nComp,1,0,Now()-start);
+ used=(nComp<10)?nComp:10;
+ start=Now();
+ for (i=0;i<used;i++)
+  if (!pp.GetTemperatureDependentProperty(i,VaporPressure,300.0,value)) failures++;
+ double elapsed=Now()-start;
+ pp.GetLoadCounters(compoundCount,deferred,loaded);
+ if ((deferred!=nComp)||(loaded!=used)) failures++;
+ Report(settings,"load","lazy-use","",nComp,used,failures,elapsed);
+}
+
+//! Benchmark loading a package of which the compounds are in use
+/*!
+  Load the package again while it is loaded, so that all compounds are shared;
+  a failure is counted if the compounds are not shared
+  \param settings Benchmark settings
+  \param path Path of the property package
+  \param nComp Number of compounds
+*/
+
+static void BenchSharedLoad(BenchSettings &settings,const string &path,int nComp)
+{PropertyPack pp;
+ double start=Now();
+ if (pp.Load(path.c_str())) Report(settings,"load","shared",GetCorrelationKernels(),nComp,1,(GetSharedCompoundCount()!=nComp)?1:0,Now()-start);
+ else fprintf(stderr,"Failed to load package with %d compounds again: %s\n",nComp,pp.LastError());
+}
+
+//! Benchmark compound name lookups
+/*!
+  Look up all compounds of the package by name, in upper case, as the CAPE-OPEN
+  wrappers do for the compound lists they receive; one call is one lookup
+*/
+
+static void BenchLookup(BenchSettings &settings,PropertyPack &pp,int nComp)
+{int i,index;
+ vector<string> names(nComp);
+ for (i=0;i<nComp;i++) 
+  {names[i]=pp.GetCompoundStringConstant(i,Name);
+   for (size_t k=0;k<names[i].size();k++) names[i][k]=(char)toupper((unsigned char)names[i][k]);
+  }
+ long calls=0,failures=0;
+ long batch=1;
+ double start=Now(),elapsed;
+ for (;;)
+  {long j;
+   for (j=0;j<batch;j++)
+    for (i=0;i<nComp;i++)
+     if ((!pp.GetCompoundIndex(names[i].c_str(),index))||(index!=i)) failures++;
+   calls+=batch*nComp;
+   elapsed=Now()-start;
+   if (elapsed>=settings.minTime) break;
+   if (batch<1000000) batch*=2;
+  }
+ Report(settings,"lookup","name","",nComp,calls,failures,elapsed);
+}
+
+//! Benchmark the flashes for a mixture
+/*!
+  If mixture is not NULL, the flashes are performed on the prepared mixture
+*/
+
+static void BenchFlashes(BenchSettings &settings,const char *benchmark,PropertyPack &pp,int nComp,const int *compIndices,const double *X,const FlashSpecs &specs,const PropertyPackMixture *mixture=NULL)
+{PropertyPackWorkspace ws;
+ bool ok;
+ int type;
+ int phaseCount;
+ Phase *phases;
+ double *phaseFractions;
+ double **phaseCompositions;
+ double T,P;
+ for (type=0;type<FlashTypeCount;type++)
+  {double spec1,spec2;
+   GetFlashSpecs(type,specs,spec1,spec2);
+   long calls=0,failures=0,evaluations=0;
+   long batch=1;
+   double start=Now(),elapsed;
+   for (;;)
+    {long i;
+     for (i=0;i<batch;i++)
+      {if (mixture) ok=pp.Flash(ws,*mixture,X,(FlashType)type,VaporLiquid,spec1,spec2,phaseCount,phases,phaseFractions,phaseCompositions,T,P);
+       else ok=pp.Flash(ws,nComp,compIndices,X,(FlashType)type,VaporLiquid,spec1,spec2,phaseCount,phases,phaseFractions,phaseCompositions,T,P);
+       if (!ok) failures++;
+       evaluations+=ws.SolverEvaluations();
+      }
+     calls+=batch;
+     elapsed=Now()-start;
+     if (elapsed>=settings.minTime) break;
+     if (batch<1000000) batch*=2;
+    }
+   Report(settings,benchmark,flashTypeNames[type],"",nComp,calls,failures,elapsed,(double)evaluations/calls);
+  }
+}
+
+//! Benchmark flashes with and without the flash solution history
+/*!
+  Flash a slowly drifting specification, as a dynamic simulation would; the 
+  specification that is not a pressure or vapor fraction moves by +/- 1% around 
+  the nominal specification in 64 steps. The phase column is "off" without
+  and "on" with the flash solution history
+*/
+
+static void BenchHistoryFlashes(BenchSettings &settings,PropertyPack &pp,int nComp,const int *compIndices,const double *X,const FlashSpecs &specs)
+{PropertyPackWorkspace ws;
+ bool ok;
+ int type,history;
+ int phaseCount;
+ Phase *phases;
+ double *phaseFractions;
+ double **phaseCompositions;
+ double T,P;
+ for (history=0;history<2;history++)
+  {ws.SetFlashHistorySize(history?16:0);
+   for (type=0;type<FlashTypeCount;type++)
+    {double s1,s2;
+     GetFlashSpecs(type,specs,s1,s2);
+     long calls=0,failures=0,evaluations=0;
+     long batch=1;
+     double start=Now(),elapsed;
+     for (;;)
+      {long i;
+       for (i=0;i<batch;i++)
+        {double spec1=s1,spec2=s2;
+         int step=(int)((calls+i)%128);
+         double f=1.0+0.01*(((step<64)?step:128-step)/32.0-1.0);
+         switch (type)
+          {case PH: case PS: spec2+=fabs(s2)*(f-1.0);break;
+           default: spec1*=f;break;
+          }
+         ok=pp.Flash(ws,nComp,compIndices,X,(FlashType)type,VaporLiquid,spec1,spec2,phaseCount,phases,phaseFractions,phaseCompositions,T,P);
+         if (!ok) failures++;
+         evaluations+=ws.SolverEvaluations();
+        }
+       calls+=batch;
+       elapsed=Now()-start;
+       if (elapsed>=settings.minTime) break;
+       if (batch<1000000) batch*=2;
+      }
+     Report(settings,"history",flashTypeNames[type],history?"on":"off",nComp,calls,failures,elapsed,(double)evaluations/calls);
+    }
+  }
+}
+
+//! Benchmark batch flashes for a mixture
+/*!
+  Flash batches of items on multiple threads using PropertyPackBatch. The items
+  of a batch share the flash type; the specifications are spread by +/- 1% around
+  the nominal specifications, so that the items converge in different numbers 
+  of iterations
+*/
+
+static void BenchBatchFlashes(BenchSettings &settings,PropertyPack &pp,int nComp,const int *compIndices,const double *X,const FlashSpecs &specs)
+{const int itemCount=256;
+ int type,t,i;
+ char threadName[32];
+ vector<double> itemX((size_t)itemCount*nComp);
+ vector<FlashType> types(itemCount);
+ vector<double> spec1(itemCount),spec2(itemCount);
+ vector<int> phaseCounts(itemCount);
+ vector<Phase> phases((size_t)itemCount*PhaseCount);
+ vector<double> phaseFractions((size_t)itemCount*PhaseCount);
+ vector<double> phaseCompositions((size_t)itemCount*PhaseCount*nComp);
+ vector<double> T(itemCount),P(itemCount);
+ vector<BatchItemStatus> status(itemCount);
+ for (i=0;i<itemCount;i++) memcpy(&itemX[(size_t)i*nComp],X,nComp*sizeof(double));
+ for (t=0;t<(int)settings.threads.size();t++)
+  {PropertyPackBatch batch(pp,settings.threads[t]);
+   sprintf(threadName,"threads=%d",batch.ThreadCount());
+   for (type=0;type<FlashTypeCount;type++)
+    {double s1,s2;
+     GetFlashSpecs(type,specs,s1,s2);
+     for (i=0;i<itemCount;i++)
+      {double f=1.0+0.02*((double)i/(itemCount-1)-0.5);
+       types[i]=(FlashType)type;
+       spec1[i]=s1;
+       spec2[i]=s2;
+       //perturb the specification that is not a pressure or vapor fraction
+       switch (type)
+        {case TP: case TVF: case TVFm: spec1[i]*=f;break;
+         case PH: case PS: spec2[i]+=fabs(s2)*(f-1.0);break;
+         default: spec1[i]*=f;break;
+        }
+      }
+     long calls=0,failures=0;
+     double start=Now(),elapsed;
+     for (;;)
+      {if (!batch.Flash(itemCount,nComp,compIndices,&itemX[0],&types[0],VaporLiquid,&spec1[0],&spec2[0],&phaseCounts[0],&phases[0],&phaseFractions[0],&phaseCompositions[0],&T[0],&P[0],&status[0]))
+        {fprintf(stderr,"Batch flash failed: %s\n",batch.LastError());
+         return;
+        }
+       calls+=itemCount;
+       failures+=batch.FailureCount();
+       elapsed=Now()-start;
+       if (elapsed>=settings.minTime) break;
+      }
+     Report(settings,"batch",flashTypeNames[type],threadName,nComp,calls,failures,elapsed);
+    }
+  }
+}
+
+//! Benchmark the single phase properties for a mixture
+static void BenchProperties(BenchSettings &settings,PropertyPack &pp,int nComp,const int *compIndices,const double *X,const FlashSpecs &specs)
+{int prop,phase;
+ int *valueCount;
+ double **values;
+ for (phase=0;phase<PhaseCount;phase++)
+  for (prop=0;prop<SinglePhasePropertyCount;prop++)
+   {SinglePhaseProperty propID=(SinglePhaseProperty)prop;
+    long calls=0,failures=0;
+    long batch=1;
+    double start=Now(),elapsed;
+    for (;;)
+     {long i;
+      for (i=0;i<batch;i++)
+       if (!pp.GetSinglePhaseProperties(nComp,compIndices,(Phase)phase,specs.T,specs.P,X,1,&propID,valueCount,values)) failures++;
+      calls+=batch;
+      elapsed=Now()-start;
+      if (elapsed>=settings.minTime) break;
+      if (batch<1000000) batch*=2;
+     }
+    Report(settings,"property",singlePhasePropertyNames[prop],(phase==Vapor)?"vapor":"liquid",nComp,calls,failures,elapsed);
+   }
+ //all properties in a single call, sharing the intermediates
+ SinglePhaseProperty propIDs[SinglePhasePropertyCount];
+ for (prop=0;prop<SinglePhasePropertyCount;prop++) propIDs[prop]=(SinglePhaseProperty)prop;
+ for (phase=0;phase<PhaseCount;phase++)
+  {//activity is not supported for vapor
+   int nProp=(phase==Vapor)?(int)Activity:SinglePhasePropertyCount;
+   long calls=0,failures=0;
+   long batch=1;
+   double start=Now(),elapsed;
+   for (;;)
+    {long i;
+     for (i=0;i<batch;i++)
+      if (!pp.GetSinglePhaseProperties(nComp,compIndices,(Phase)phase,specs.T,specs.P,X,nProp,propIDs,valueCount,values)) failures++;
+     calls+=batch;
+     elapsed=Now()-start;
+     if (elapsed>=settings.minTime) break;
+     if (batch<1000000) batch*=2;
+    }
+   Report(settings,"property","all",(phase==Vapor)?"vapor":"liquid",nComp,calls,failures,elapsed);
+  }
+ //all properties without the pure component cache, so that each call evaluates the correlations
+ PropertyPackWorkspace ws;
+ ws.SetCacheSize(0);
+ for (phase=0;phase<PhaseCount;phase++)
+  {int nProp=(phase==Vapor)?(int)Activity:SinglePhasePropertyCount;
+   long calls=0,failures=0;
+   long batch=1;
+   double start=Now(),elapsed;
+   for (;;)
+    {long i;
+     for (i=0;i<batch;i++)
+      if (!pp.GetSinglePhaseProperties(ws,nComp,compIndices,(Phase)phase,specs.T,specs.P,X,nProp,propIDs,valueCount,values)) failures++;
+     calls+=batch;
+     elapsed=Now()-start;
+     if (elapsed>=settings.minTime) break;
+     if (batch<1000000) batch*=2;
+    }
+   Report(settings,"uncached","all",(phase==Vapor)?"vapor":"liquid",nComp,calls,failures,elapsed);
+  }
+ //all properties on a prepared mixture
+ ws.SetCacheSize(4);
+ PropertyPackMixture mixture;
+ if (!pp.PrepareMixture(ws,nComp,compIndices,mixture))
+  {fprintf(stderr,"Failed to prepare mixture: %s\n",ws.LastError());
+   return;
+  }
+ for (phase=0;phase<PhaseCount;phase++)
+  {int nProp=(phase==Vapor)?(int)Activity:SinglePhasePropertyCount;
+   long calls=0,failures=0;
+   long batch=1;
+   double start=Now(),elapsed;
+   for (;;)
+    {long i;
+     for (i=0;i<batch;i++)
+      if (!pp.GetSinglePhaseProperties(ws,mixture,(Phase)phase,specs.T,specs.P,X,nProp,propIDs,valueCount,values)) failures++;
+     calls+=batch;
+     elapsed=Now()-start;
+     if (elapsed>=settings.minTime) break;
+     if (batch<1000000) batch*=2;
+    }
+   Report(settings,"prepared","all",(phase==Vapor)?"vapor":"liquid",nComp,calls,failures,elapsed);
+  }
+}
+
+//! Print usage
+static void Usage()
+{fprintf(stderr,"Usage: thermo_bench [--sizes 2,10,50,200,1000] [--threads 1,4] [--kernels name] [--time seconds] [--tabulation maxRelError] [--out file] [--data folder]\n");
+}
+
+//! Parse a comma separated list of positive integers
+/*!
+  \param ptr The list
+  \param list Receives the values
+  \return False if a value is not a positive integer
+*/
+
+static bool ParseList(const char *ptr,vector<int> &list)
+{list.clear();
+ while (*ptr)
+  {int n=atoi(ptr);
+   if (n<1) return false;
+   list.push_back(n);
+   while ((*ptr)&&(*ptr!=',')) ptr++;
+   if (*ptr) ptr++;
+  }
+ return true;
+}
+
+//! Entry point
+/*!
+  Parse the command line, generate the synthetic packages and run the benchmarks
+  \param argc Number of arguments
+  \param argv Arguments
+  \return Zero if ok
+*/
+
+int main(int argc,char **argv)
+{BenchSettings settings;
+ TempFolder generated; //generated data folder, unless given
+ int i,j;
+ const char *outName=NULL;
+ settings.minTime=0.2;
+ settings.tabulation=1e-6;
+ settings.out=stdout;
+ for (i=1;i<argc;i++)
+  {if ((strcmp(argv[i],"--sizes")==0)&&(i+1<argc))
+    {if (!ParseList(argv[++i],settings.sizes))
+      {Usage();
+       return 1;
+      }
+    }
+   else if ((strcmp(argv[i],"--threads")==0)&&(i+1<argc))
+    {if (!ParseList(argv[++i],settings.threads))
+      {Usage();
+       return 1;
+      }
+    }
+   else if ((strcmp(argv[i],"--kernels")==0)&&(i+1<argc))
+    {if (!SetCorrelationKernels(argv[++i]))
+      {fprintf(stderr,"Kernels \"%s\" are not supported\n",argv[i]);
+       return 1;
+      }
+    }
+   else if ((strcmp(argv[i],"--time")==0)&&(i+1<argc)) settings.minTime=atof(argv[++i]);
+   else if ((strcmp(argv[i],"--tabulation")==0)&&(i+1<argc)) settings.tabulation=atof(argv[++i]);
+   else if ((strcmp(argv[i],"--out")==0)&&(i+1<argc)) outName=argv[++i];
+   else if ((strcmp(argv[i],"--data")==0)&&(i+1<argc)) settings.dataFolder=argv[++i];
+   else
+    {Usage();
+     return 1;
+    }
+  }
+ if (settings.sizes.empty())
+  {settings.sizes.push_back(2);
+   settings.sizes.push_back(10);
+   settings.sizes.push_back(50);
+   settings.sizes.push_back(200);
+   settings.sizes.push_back(1000);
+  }
+ if (settings.threads.empty())
+  {//single thread and all processors
+   settings.threads.push_back(1);
+   settings.threads.push_back(0);
+  }
+ if (settings.dataFolder.empty())
+  {//generated data is removed on exit, unless the data folder is given
+   if (generated.Create("thermo_bench")) settings.dataFolder=generated.Path();
+  }
+ else
+  {//create if not yet present
+#ifdef _WIN32
+   CreateDirectoryA(settings.dataFolder.c_str(),NULL);
+#else
+   mkdir(settings.dataFolder.c_str(),0755);
+#endif
+  }
+ if (settings.dataFolder.empty())
+  {fprintf(stderr,"Failed to create data folder\n");
+   return 1;
+  }
+ if (outName)
+  {settings.out=fopen(outName,"wb");
+   if (!settings.out)
+    {fprintf(stderr,"Failed to open \"%s\"\n",outName);
+     return 1;
+    }
+  }
+ SetCompoundDataPath(settings.dataFolder.c_str());
+ fprintf(settings.out,"benchmark,case,phase,compounds,calls,failures,seconds,rate,evaluations\n");
+ for (j=0;j<(int)settings.sizes.size();j++)
+  {int nComp=settings.sizes[j];
+   char name[32];
+   sprintf(name,"bench%d",nComp);
+   string path=(WriteCompounds(settings.dataFolder,name,nComp))?WritePackage(settings.dataFolder,name,name,0,nComp):string();
+   if (path.empty())
+    {fprintf(stderr,"Failed to write package with %d compounds to \"%s\"\n",nComp,settings.dataFolder.c_str());
+     return 1;
+    }
+   //the load cases come first, as compounds in use by a package are shared rather than loaded
+   BenchSequentialLoad(settings,path,nComp);
+   BenchDatabaseLoad(settings,path,nComp);
+   BenchLibraryLoad(settings,path,nComp);
+   BenchLazyLoad(settings,path,nComp);
+   PropertyPack pp;
+   double start=Now();
+   if (!pp.Load(path.c_str()))
+    {fprintf(stderr,"Failed to load package with %d compounds: %s\n",nComp,pp.LastError());
+     return 1;
+    }
+   Report(settings,"load","package",GetCorrelationKernels(),nComp,1,0,Now()-start);
+   BenchSharedLoad(settings,path,nComp);
+   BenchLookup(settings,pp,nComp);
+   //mixture: all compounds, composition decreasing linearly from light to heavy
+   vector<int> compIndices(nComp);
+   vector<double> X(nComp);
+   double sum=0;
+   for (i=0;i<nComp;i++)
+    {compIndices[i]=i;
+     X[i]=2.0*nComp-i;
+     sum+=X[i];
+    }
+   for (i=0;i<nComp;i++) X[i]/=sum;
+   FlashSpecs specs;
+   GetSpecs(pp,nComp,&compIndices[0],&X[0],specs);
+   BenchFlashes(settings,"flash",pp,nComp,&compIndices[0],&X[0],specs);
+   PropertyPackWorkspace ws;
+   PropertyPackMixture mixture;
+   if (!pp.PrepareMixture(ws,nComp,&compIndices[0],mixture))
+    {fprintf(stderr,"Failed to prepare mixture: %s\n",ws.LastError());
+     return 1;
+    }
+   BenchFlashes(settings,"prepared",pp,nComp,&compIndices[0],&X[0],specs,&mixture);
+   if (settings.tabulation>0)
+    {PropertyPack tabulated;
+     if (!tabulated.SetTabulation(settings.tabulation))
+      {fprintf(stderr,"Failed to set tabulation: %s\n",tabulated.LastError());
+       return 1;
+      }
+     start=Now();
+     if (!tabulated.Load(path.c_str()))
+      {fprintf(stderr,"Failed to load tabulated package with %d compounds: %s\n",nComp,tabulated.LastError());
+       return 1;
+      }
+     Report(settings,"load","tabulated",GetCorrelationKernels(),nComp,1,0,Now()-start);
+     BenchFlashes(settings,"tabulated",tabulated,nComp,&compIndices[0],&X[0],specs);
+    }
+   BenchHistoryFlashes(settings,pp,nComp,&compIndices[0],&X[0],specs);
+   BenchProperties(settings,pp,nComp,&compIndices[0],&X[0],specs);
+   BenchBatchFlashes(settings,pp,nComp,&compIndices[0],&X[0],specs);
+  }
+ if (settings.out!=stdout) fclose(settings.out);
+ return 0;
+}
@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <new>
+#include <string>
+#include <vector>
+#include <CPPExports.h>     // exports from the IdealThermoModule
+#include "TestData.h"
+
+using namespace std;
+
+/*! \mainpage Allocation Test
+*
+*This project (ThermoTests) checks that the numerical core of the
+*IdealThermoModule does not allocate memory in a steady state: once a 
+*workspace has been used for a calculation, repeating the calculation 
+*must be served entirely from the buffers, the scratch arena and the 
+*pure component cache of the workspace.
+*
+*The global operator new is replaced by a counting version. A synthetic 
+*property package is generated and loaded, and a fixed sequence of
+*calculations is performed a number of times to warm up the workspaces,
+*for two mixtures: a small one, which the TP flash solves with the 
+*fixed-size specialisation, and one of all compounds of the package, 
+*which takes the generic TP flash, the SIMD Rachford-Rice residual and 
+*the linear-time duplicate compound check:
+*
+* - flashes of each FlashType, with compound indices and pointer results,
+*   on a prepared mixture with caller-supplied buffers, and without 
+*   workspace argument
+* - single-phase properties, each property for both phases, and all 
+*   properties at once, with and without the pure component cache
+* - composition-derivative matrices in structured form
+* - two-phase properties
+* - flashes with the flash solution history enabled
+*
+*The sequence is then performed once more, and the test fails if any 
+*allocation is counted, or if any of the calculations fails.
+*
+*Usage: allocation_test
+*
+*/
+
+//! Number of allocations counted
+static long allocationCount=0;
+
+//! Counting operator new
+void *operator new(size_t size)
+{void *p;
+ allocationCount++;
+ p=malloc(size?size:1);
+ if (!p) throw std::bad_alloc();
+ return p;
+}
+
+//! Counting operator new[]
+void *operator new[](size_t size)
+{void *p;
+ allocationCount++;
+ p=malloc(size?size:1);
+ if (!p) throw std::bad_alloc();
+ return p;
+}
+
+//the replacement operators allocate with malloc and release with free; GCC does not
+//see that the operator new that it pairs with free is the replacement, and warns
+#if defined(__GNUC__)&&(__GNUC__>=11)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+//! Operator delete matching the counting operator new
+void operator delete(void *p) noexcept {free(p);}
+
+//! Operator delete[] matching the counting operator new[]
+void operator delete[](void *p) noexcept {free(p);}
+
+//! Sized operator delete matching the counting operator new
+void operator delete(void *p,size_t) noexcept {free(p);}
+
+//! Sized operator delete[] matching the counting operator new[]
+void operator delete[](void *p,size_t) noexcept {free(p);}
+
+#if defined(__GNUC__)&&(__GNUC__>=11)
+#pragma GCC diagnostic pop
+#endif
+
+//! Number of compounds in the test package and the large test mixture; more than PAIRWISE_DUPLICATE_CHECK (16)
+#define TEST_COMPOUNDS 20
+
+//! Number of compounds in the small test mixture; at most FIXED_SIZE_COMPOUNDS (8)
+#define SMALL_TEST_COMPOUNDS 8
+
+//! The calculations of the test
+/*!
+  Holds the package, the workspaces and all buffers, which are allocated up front,
+  so that Run() only allocates in the calculation routines
+*/
+
+struct AllocationTest
+{PropertyPack pp;                 /*!< the property package */
+ PropertyPackWorkspace ws;        /*!< workspace with default settings */
+ PropertyPackWorkspace uncached;  /*!< workspace without pure component cache */
+ PropertyPackWorkspace history;   /*!< workspace with flash solution history */
+ PropertyPackMixture mixture;     /*!< the test mixture, prepared */
+ int nComp;                       /*!< number of compounds of the mixture */
+ int compIndices[TEST_COMPOUNDS]; /*!< compounds of the mixture */
+ double X[TEST_COMPOUNDS];        /*!< composition of the mixture */
+ double T,P,VF,H,S;               /*!< flash specifications, in the two-phase region */
+ Phase phases[PhaseCount];        /*!< flash results */
+ double phaseFractions[PhaseCount]; /*!< flash results */
+ double phaseCompositions[PhaseCount*TEST_COMPOUNDS]; /*!< flash results */
+ vector<SinglePhaseProperty> singlePhaseProps; /*!< all single-phase properties */
+ vector<TwoPhaseProperty> twoPhaseProps; /*!< all two-phase properties */
+ vector<int> valueCounts;         /*!< property results */
+ vector<double> values;           /*!< property results */
+ int failures;                    /*!< number of failed calculations in the last Run() */
+
+ bool Init(const char *path,int nComp);
+ void Run();
+ void Check(bool ok,const char *what,const char *error);
+};
+
+//! Count a failed calculation
+/*!
+  \param ok Result of the calculation
+  \param what Name of the calculation
+  \param error Error message
+*/
+
+void AllocationTest::Check(bool ok,const char *what,const char *error)
+{if (ok) return;
+ if (!failures) fprintf(stderr,"%s failed: %s\n",what,error);
+ failures++;
+}
+
+//! Load the package and determine the specifications
+/*!
+  \param path Path of the property package file
+  \param nComp Number of compounds of the mixture, spread evenly over the volatility range of the package
+  \return True if ok
+*/
+
+bool AllocationTest::Init(const char *path,int nComp)
+{int i,j,phaseCount,totalCount;
+ double sum,Tbub,Tdew,T2,P2;
+ if (!pp.Load(path))
+  {fprintf(stderr,"Failed to load package: %s\n",pp.LastError());
+   return false;
+  }
+ this->nComp=nComp;
+ sum=0;
+ for (i=0;i<nComp;i++)
+  {compIndices[i]=(nComp==1)?0:i*(TEST_COMPOUNDS-1)/(nComp-1);
+   X[i]=2.0*nComp-i;
+   sum+=X[i];
+  }
+ for (i=0;i<nComp;i++) X[i]/=sum;
+ if (!pp.PrepareMixture(ws,nComp,compIndices,mixture))
+  {fprintf(stderr,"Failed to prepare mixture: %s\n",ws.LastError());
+   return false;
+  }
+ uncached.SetCacheSize(0);
+ history.SetFlashHistorySize(4);
+ //specifications half way between bubble and dew point at atmospheric pressure
+ P=101325.0;
+ VF=0.5;
+ if ((!pp.Flash(ws,mixture,X,PVF,VaporLiquid,P,0.0,phaseCount,phases,phaseFractions,phaseCompositions,Tbub,P2))||
+     (!pp.Flash(ws,mixture,X,PVF,VaporLiquid,P,1.0,phaseCount,phases,phaseFractions,phaseCompositions,Tdew,P2)))
+  {fprintf(stderr,"Failed to get bubble and dew point: %s\n",ws.LastError());
+   return false;
+  }
+ T=0.5*(Tbub+Tdew);
+ if (!pp.Flash(ws,mixture,X,TP,VaporLiquid,T,P,phaseCount,phases,phaseFractions,phaseCompositions,T2,P2))
+  {fprintf(stderr,"Failed to flash at T and P: %s\n",ws.LastError());
+   return false;
+  }
+ H=S=0;
+ for (j=0;j<phaseCount;j++)
+  {SinglePhaseProperty props[2]={Enthalpy,Entropy};
+   double HS[2];
+   int counts[2];
+   if (!pp.GetSinglePhaseProperties(ws,mixture,phases[j],T,P,phaseCompositions+j*nComp,2,props,2,counts,HS))
+    {fprintf(stderr,"Failed to get enthalpy and entropy: %s\n",ws.LastError());
+     return false;
+    }
+   H+=phaseFractions[j]*HS[0];
+   S+=phaseFractions[j]*HS[1];
+  }
+ //property lists and result buffers
+ for (i=0;i<SinglePhasePropertyCount;i++) singlePhaseProps.push_back((SinglePhaseProperty)i);
+ for (i=0;i<TwoPhasePropertyCount;i++) twoPhaseProps.push_back((TwoPhaseProperty)i);
+ PropertyPack::GetSinglePhasePropertySizes(nComp,SinglePhasePropertyCount,&singlePhaseProps[0],NULL,totalCount);
+ valueCounts.resize(SinglePhasePropertyCount);
+ values.resize(totalCount);
+ return true;
+}
+
+//! Perform all calculations once
+/*!
+  The number of failed calculations is stored in failures
+*/
+
+void AllocationTest::Run()
+{int type,i,j,phaseCount,*counts;
+ double spec1,spec2,T2,P2,**vals,*fractions,**compositions;
+ Phase *phaseIDs;
+ StructuredMatrix matrix;
+ failures=0;
+ for (type=0;type<FlashTypeCount;type++)
+  {switch (type)
+    {case TP: spec1=T;spec2=P;break;
+     case TVF: case TVFm: spec1=T;spec2=VF;break;
+     case PVF: case PVFm: spec1=P;spec2=VF;break;
+     case PH: spec1=P;spec2=H;break;
+     default: spec1=P;spec2=S;break;
+    }
+   Check(pp.Flash(ws,nComp,compIndices,X,(FlashType)type,VaporLiquid,spec1,spec2,phaseCount,phaseIDs,fractions,compositions,T2,P2),"Flash",ws.LastError());
+   Check(pp.Flash(ws,mixture,X,(FlashType)type,VaporLiquid,spec1,spec2,phaseCount,phases,phaseFractions,phaseCompositions,T2,P2),"Flash on prepared mixture",ws.LastError());
+   Check(pp.Flash(nComp,compIndices,X,(FlashType)type,VaporLiquid,spec1,spec2,phaseCount,phaseIDs,fractions,compositions,T2,P2),"Flash without workspace",pp.LastError());
+   //drifting specification, so that the history is used
+   for (i=0;i<3;i++) Check(pp.Flash(history,mixture,X,(FlashType)type,VaporLiquid,spec1*(1.0+1e-4*i),spec2,phaseCount,phases,phaseFractions,phaseCompositions,T2,P2),"Flash with history",history.LastError());
+  }
+ for (i=0;i<2;i++)
+  {Phase phaseID=(i==0)?Vapor:Liquid;
+   //the activity properties are only defined for the liquid phase
+   int nProp=(phaseID==Vapor)?(int)Activity:SinglePhasePropertyCount;
+   for (j=0;j<nProp;j++)
+    {Check(pp.GetSinglePhaseProperties(ws,nComp,compIndices,phaseID,T,P,X,1,&singlePhaseProps[j],counts,vals),"GetSinglePhaseProperties",ws.LastError());
+     Check(pp.GetSinglePhaseProperties(ws,mixture,phaseID,T+1.0,P,X,1,&singlePhaseProps[j],(int)values.size(),&valueCounts[0],&values[0]),"GetSinglePhaseProperties on prepared mixture",ws.LastError());
+     if ((j==FugacityDn)||(j==ActivityDn)) Check(pp.GetSinglePhaseMatrix(ws,mixture,phaseID,T,P,X,(SinglePhaseProperty)j,matrix),"GetSinglePhaseMatrix",ws.LastError());
+    }
+   Check(pp.GetSinglePhaseProperties(ws,nComp,compIndices,phaseID,T,P,X,nProp,&singlePhaseProps[0],(int)values.size(),&valueCounts[0],&values[0]),"GetSinglePhaseProperties, all properties",ws.LastError());
+   Check(pp.GetSinglePhaseProperties(uncached,mixture,phaseID,T,P,X,nProp,&singlePhaseProps[0],counts,vals),"GetSinglePhaseProperties without cache",uncached.LastError());
+   Check(pp.GetSinglePhaseProperties(nComp,compIndices,phaseID,T,P,X,nProp,&singlePhaseProps[0],counts,vals),"GetSinglePhaseProperties without workspace",pp.LastError());
+  }
+ Check(pp.GetTwoPhaseProperties(ws,nComp,compIndices,Vapor,Liquid,T,T,P,P,X,X,TwoPhasePropertyCount,&twoPhaseProps[0],counts,vals),"GetTwoPhaseProperties",ws.LastError());
+ Check(pp.GetTwoPhaseMatrix(ws,nComp,compIndices,Vapor,Liquid,T,T,P,P,X,X,KvalueDn,matrix),"GetTwoPhaseMatrix",ws.LastError());
+ Check(pp.GetTwoPhaseProperties(ws,nComp,compIndices,Liquid,Vapor,T,T,P,P,X,X,TwoPhasePropertyCount,&twoPhaseProps[0],(int)values.size(),&valueCounts[0],&values[0]),"GetTwoPhaseProperties into buffers",ws.LastError());
+}
+
+//! Entry point
+/*!
+  Generate the package, warm up the workspaces and count the allocations of
+  a final run of all calculations, for the small and the large mixture
+  \return Zero if no allocations were counted and all calculations succeeded
+*/
+
+int main()
+{int i,k,result=0;
+ long count;
+ static const int mixtureSizes[2]={SMALL_TEST_COMPOUNDS,TEST_COMPOUNDS};
+ TempFolder temp; //removed with the generated files on exit
+ if (!temp.Create("allocation_test"))
+  {fprintf(stderr,"Failed to create data folder\n");
+   return 1;
+  }
+ string folder=temp.Path();
+ string path=(WriteCompounds(folder,"allocation_test_",TEST_COMPOUNDS))?WritePackage(folder,"allocation_test","allocation_test_",0,TEST_COMPOUNDS):string();
+ if (path.empty())
+  {fprintf(stderr,"Failed to write package to \"%s\"\n",folder.c_str());
+   return 1;
+  }
+ SetCompoundDataPath(folder.c_str());
+ for (k=0;k<2;k++)
+  {AllocationTest *test=new AllocationTest;
+   if (!test->Init(path.c_str(),mixtureSizes[k])) return 1;
+   for (i=0;i<3;i++) test->Run(); //warm up
+   count=allocationCount;
+   test->Run();
+   count=allocationCount-count;
+   printf("%d compounds: %d calculations failed, %ld allocations\n",mixtureSizes[k],test->failures,count);
+   if ((test->failures)||(count)) result=1;
+   delete test;
+  }
+ return result;
+}
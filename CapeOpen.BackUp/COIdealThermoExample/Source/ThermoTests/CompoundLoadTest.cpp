@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <CPPExports.h>     // exports from the IdealThermoModule
+#include "TestData.h"
+
+using namespace std;
+
+/*! \mainpage Compound Load Test
+*
+*This test checks that the .compound files of a property package are
+*loaded the same by one thread and by several threads. A synthetic
+*property package is generated with more compounds than are needed to
+*start COMPOUND_LOAD_THREADS (8) threads of COMPOUND_LOAD_FILES_PER_THREAD
+*(8) files each:
+*
+* - with two broken .compound files, loading must fail with the error of
+*   the first broken compound in the order of the package, for one thread
+*   and for eight threads; the first broken file is long and truncated,
+*   and the next file is missing, so that with eight threads the later
+*   file fails before the earlier one
+* - with the broken files repaired, the compound constants and the
+*   temperature dependent properties must be identical for one thread
+*   and for eight threads
+*
+*Each load is repeated a number of times.
+*
+*Usage: compound_load_test
+*
+*/
+
+//! Number of compounds in the test package; more than 8*COMPOUND_LOAD_FILES_PER_THREAD
+#define TEST_COMPOUNDS 80
+
+//! Index of the first broken compound, which is long and truncated
+#define FIRST_BROKEN_COMPOUND 60
+
+//! Index of the second broken compound, which is missing
+#define SECOND_BROKEN_COMPOUND 61
+
+//! Number of comment lines in the first broken compound
+#define BROKEN_COMPOUND_PADDING 100000
+
+//! Start of the names of the test compounds
+#define COMPOUND_PREFIX "compound_load_test_"
+
+//! Number of times each load is repeated
+#define LOAD_REPEATS 10
+
+//! Break the test compounds
+/*!
+  Truncate the first broken compound after many comment lines, and remove the second one
+  \param folder Data folder
+  \return True if ok
+*/
+
+static bool BreakCompounds(const string &folder)
+{if (!WriteCompound(folder,CompoundName(COMPOUND_PREFIX,FIRST_BROKEN_COMPOUND),0.5,true,BROKEN_COMPOUND_PADDING)) return false;
+ return (remove((folder+"/"+CompoundName(COMPOUND_PREFIX,SECOND_BROKEN_COMPOUND)+".compound").c_str())==0);
+}
+
+//! Data of the loaded compounds
+/*!
+  \param pp The loaded property package
+  \param strings Receives the string constants of all compounds
+  \param values Receives the real constants and temperature dependent properties of all compounds
+  \return True if ok
+*/
+
+static bool GetCompoundData(PropertyPack &pp,vector<string> &strings,vector<double> &values)
+{int i,j,k,count;
+ const char *s;
+ double value;
+ strings.clear();
+ values.clear();
+ if ((!pp.GetCompoundCount(&count))||(count!=TEST_COMPOUNDS)) return false;
+ for (i=0;i<count;i++)
+  {for (j=Name;j<=ChemicalFormula;j++)
+    {if ((s=pp.GetCompoundStringConstant(i,(StringConstant)j))==NULL) return false;
+     strings.push_back(s);
+    }
+   for (j=0;j<RealConstantCount;j++)
+    {if (!pp.GetCompoundRealConstant(i,(RealConstant)j,value)) return false;
+     values.push_back(value);
+    }
+   for (j=0;j<TDependentPropertyCount;j++)
+    for (k=0;k<3;k++)
+     {if (!pp.GetTemperatureDependentProperty(i,(TDependentProperty)j,250.0+50.0*k,value)) return false;
+      values.push_back(value);
+     }
+  }
+ return true;
+}
+
+//! Entry point
+/*!
+  Load the package with broken and with repaired compounds, by one and by eight threads
+  \return Zero if all checks passed
+*/
+
+int main()
+{int i,k;
+ static const int threadCounts[2]={1,8};
+ vector<string> strings[2],repeatStrings;
+ vector<double> values[2],repeatValues;
+ TempFolder temp; //removed with the generated files on exit
+ if (!temp.Create("compound_load_test"))
+  {fprintf(stderr,"Failed to create data folder\n");
+   return 1;
+  }
+ string folder=temp.Path();
+ string path=WritePackage(folder,"compound_load_test",COMPOUND_PREFIX,0,TEST_COMPOUNDS);
+ if ((path.empty())||(!WriteCompounds(folder,COMPOUND_PREFIX,TEST_COMPOUNDS))||(!BreakCompounds(folder)))
+  {fprintf(stderr,"Failed to write package to \"%s\"\n",folder.c_str());
+   return 1;
+  }
+ SetCompoundDataPath(folder.c_str());
+ //the error is that of the first broken compound
+ string expected="\""+CompoundName(COMPOUND_PREFIX,FIRST_BROKEN_COMPOUND)+"\"";
+ for (k=0;k<2;k++)
+  {SetCompoundLoadThreads(threadCounts[k]);
+   for (i=0;i<LOAD_REPEATS;i++)
+    {PropertyPack pp;
+     Check(!pp.Load(path.c_str()),"Load of broken compounds succeeded");
+     Check(strstr(pp.LastError(),expected.c_str())!=NULL,"Load of broken compounds reports another compound",pp.LastError());
+    }
+  }
+ Check(GetSharedCompoundCount()==0,"Compounds of failed loads are still shared");
+ //the loaded data does not depend on the number of threads
+ if (!WriteCompounds(folder,COMPOUND_PREFIX,TEST_COMPOUNDS))
+  {fprintf(stderr,"Failed to repair compounds in \"%s\"\n",folder.c_str());
+   return 1;
+  }
+ for (k=0;k<2;k++)
+  {SetCompoundLoadThreads(threadCounts[k]);
+   for (i=0;i<LOAD_REPEATS;i++)
+    {//one package at a time, so that compounds are not shared between the loads
+     PropertyPack pp;
+     if (!pp.Load(path.c_str()))
+      {Check(false,"Load failed",pp.LastError());
+       continue;
+      }
+     if (i==0) Check(GetCompoundData(pp,strings[k],values[k]),"Failed to get compound data",pp.LastError());
+     else
+      {Check(GetCompoundData(pp,repeatStrings,repeatValues),"Failed to get compound data",pp.LastError());
+       Check((repeatStrings==strings[k])&&(repeatValues==values[k]),"Compound data differs between loads");
+      }
+    }
+   Check(GetSharedCompoundCount()==0,"Compounds of released packages are still shared");
+  }
+ Check((!values[0].empty())&&(strings[0]==strings[1])&&(values[0]==values[1]),"Compound data differs between one and eight threads");
+ SetCompoundLoadThreads(0);
+ printf("%d compounds: %d checks failed\n",TEST_COMPOUNDS,FailedChecks());
+ return FailedChecks()?1:0;
+}
@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <CPPExports.h>     // exports from the IdealThermoModule
+#include "TestData.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+using namespace std;
+
+/*! \mainpage Compound Registry Test
+*
+*This test checks that property packages share the compounds they
+*have in common while they are loaded. Synthetic compounds and two
+*overlapping property packages are generated:
+*
+* - the number of shared compounds rises as packages are loaded, counts
+*   the compounds of the overlap once, and drops to zero once all
+*   packages are released
+* - an eager package that obtains compounds that a lazy package has
+*   loaded without correlations gets the correlations, and calculates
+*   as a package that loaded the compounds itself
+* - threads that load the same package at the same time, lazily and
+*   eagerly, all succeed and share one set of compounds
+*
+*Usage: compound_registry_test
+*
+*/
+
+//! Number of compounds of each test package
+#define PACKAGE_COMPOUNDS 32
+
+//! Index of the first compound of the second test package; the packages overlap in the compounds from here
+#define SECOND_PACKAGE_START 16
+
+//! Number of compounds of both test packages
+#define TEST_COMPOUNDS (SECOND_PACKAGE_START+PACKAGE_COMPOUNDS)
+
+//! Start of the names of the test compounds
+#define COMPOUND_PREFIX "compound_registry_test_"
+
+//! Number of threads that load a package concurrently
+#define TEST_THREADS 8
+
+//! Number of times the concurrent loads are repeated
+#define LOAD_REPEATS 10
+
+//! Number of temperatures at which the temperature dependent properties are compared
+#define TEST_TEMPERATURES 3
+
+//! Load a test property package
+/*!
+  \param pp The property package
+  \param path Path of the property package file
+  \param lazy True to load lazily
+  \return True if ok
+*/
+
+static bool LoadPackage(PropertyPack &pp,const string &path,bool lazy)
+{return (pp.SetLazyLoading(lazy))&&(pp.Load(path.c_str()));
+}
+
+//! Number of compounds of which loading the correlations was deferred
+/*!
+  \param pp The property package
+  \return The number of deferred compounds
+*/
+
+static int DeferredCount(const PropertyPack &pp)
+{int compoundCount,deferred,loaded;
+ pp.GetLoadCounters(compoundCount,deferred,loaded);
+ return deferred;
+}
+
+//! Temperature dependent properties of all compounds
+/*!
+  \param pp The property package
+  \param values Receives the values
+  \return True if ok
+*/
+
+static bool GetProperties(PropertyPack &pp,vector<double> &values)
+{int i,j,k;
+ double value;
+ values.clear();
+ for (i=0;i<PACKAGE_COMPOUNDS;i++)
+  for (j=0;j<TDependentPropertyCount;j++)
+   for (k=0;k<TEST_TEMPERATURES;k++)
+    {if (!pp.GetTemperatureDependentProperty(i,(TDependentProperty)j,250.0+50.0*k,value)) return false;
+     values.push_back(value);
+    }
+ return true;
+}
+
+//! Load of a package by one thread
+struct ThreadLoad
+{PropertyPack pp;  /*!< the property package */
+ string path;      /*!< path of the property package file */
+ bool lazy;        /*!< load lazily */
+ bool ok;          /*!< result of the load */
+ string error;     /*!< error of the load */
+
+ void Run();
+};
+
+//! Load the package
+void ThreadLoad::Run()
+{ok=LoadPackage(pp,path,lazy);
+ if (!ok) error=pp.LastError();
+}
+
+//! Loading thread
+/*!
+  \param param The ThreadLoad
+*/
+
+#ifdef _WIN32
+static DWORD WINAPI ThreadProc(LPVOID param)
+#else
+static void *ThreadProc(void *param)
+#endif
+{((ThreadLoad *)param)->Run();
+ return 0;
+}
+
+//! Load packages concurrently
+/*!
+  \param loads The loads, one per thread
+  \return True if all threads were started
+*/
+
+static bool RunThreads(ThreadLoad **loads)
+{int i,started;
+#ifdef _WIN32
+ HANDLE threads[TEST_THREADS];
+ for (started=0;started<TEST_THREADS;started++)
+  if ((threads[started]=::CreateThread(NULL,0,ThreadProc,loads[started],0,NULL))==NULL) break;
+ for (i=0;i<started;i++)
+  {WaitForSingleObject(threads[i],INFINITE);
+   CloseHandle(threads[i]);
+  }
+#else
+ pthread_t threads[TEST_THREADS];
+ for (started=0;started<TEST_THREADS;started++)
+  if (pthread_create(threads+started,NULL,ThreadProc,loads[started])!=0) break;
+ for (i=0;i<started;i++) pthread_join(threads[i],NULL);
+#endif
+ return (started==TEST_THREADS);
+}
+
+//! Entry point
+/*!
+  Check the shared compound count, the correlations of compounds shared between
+  lazy and eager packages, and concurrent loads of a package
+  \return Zero if all checks passed
+*/
+
+int main()
+{int i,k;
+ vector<double> reference,values;
+ ThreadLoad *loads[TEST_THREADS];
+ TempFolder temp; //removed with the generated files on exit
+ if (!temp.Create("compound_registry_test"))
+  {fprintf(stderr,"Failed to create data folder\n");
+   return 1;
+  }
+ string folder=temp.Path();
+ if (!WriteCompounds(folder,COMPOUND_PREFIX,TEST_COMPOUNDS))
+  {fprintf(stderr,"Failed to write compounds to \"%s\"\n",folder.c_str());
+   return 1;
+  }
+ string first=WritePackage(folder,"compound_registry_test_first",COMPOUND_PREFIX,0,PACKAGE_COMPOUNDS);
+ string second=WritePackage(folder,"compound_registry_test_second",COMPOUND_PREFIX,SECOND_PACKAGE_START,PACKAGE_COMPOUNDS);
+ if ((first.empty())||(second.empty()))
+  {fprintf(stderr,"Failed to write packages to \"%s\"\n",folder.c_str());
+   return 1;
+  }
+ SetCompoundDataPath(folder.c_str());
+ //shared compound count
+ Check(GetSharedCompoundCount()==0,"Compounds are shared before loading");
+ {PropertyPack *pp1=new PropertyPack,*pp2=new PropertyPack;
+  Check(LoadPackage(*pp1,first,false),"Load failed",pp1->LastError());
+  Check(GetSharedCompoundCount()==PACKAGE_COMPOUNDS,"Shared compound count after loading one package");
+  Check(GetProperties(*pp1,reference),"GetTemperatureDependentProperty failed",pp1->LastError());
+  Check(LoadPackage(*pp2,second,false),"Load failed",pp2->LastError());
+  Check(GetSharedCompoundCount()==TEST_COMPOUNDS,"Shared compound count after loading two overlapping packages");
+  Check(pp1->GetCompoundStringConstant(SECOND_PACKAGE_START,Name)==pp2->GetCompoundStringConstant(0,Name),"Compound of both packages is not shared");
+  delete pp1;
+  Check(GetSharedCompoundCount()==PACKAGE_COMPOUNDS,"Shared compound count after releasing one package");
+  delete pp2;
+  Check(GetSharedCompoundCount()==0,"Shared compound count after releasing both packages");
+ }
+ //an eager package completes the compounds of a lazy package
+ {PropertyPack lazy,eager;
+  Check(LoadPackage(lazy,first,true),"Lazy load failed",lazy.LastError());
+  Check(DeferredCount(lazy)==PACKAGE_COMPOUNDS,"Correlations of lazy package are not deferred");
+  Check(LoadPackage(eager,first,false),"Eager load failed",eager.LastError());
+  Check(GetSharedCompoundCount()==PACKAGE_COMPOUNDS,"Compounds of lazy and eager package are not shared");
+  Check(DeferredCount(eager)==0,"Correlations of eager package are deferred");
+  Check((GetProperties(eager,values))&&(values==reference),"Properties of eager package on shared compounds differ");
+  Check((GetProperties(lazy,values))&&(values==reference),"Properties of lazy package on shared compounds differ");
+ }
+ Check(GetSharedCompoundCount()==0,"Shared compound count after releasing lazy and eager package");
+ //concurrent loads of the same package
+ for (k=0;k<LOAD_REPEATS;k++)
+  {for (i=0;i<TEST_THREADS;i++)
+    {loads[i]=new ThreadLoad;
+     loads[i]->path=first;
+     loads[i]->lazy=(i%2==1);
+    }
+   Check(RunThreads(loads),"Failed to start threads");
+   Check(GetSharedCompoundCount()==PACKAGE_COMPOUNDS,"Shared compound count after concurrent loads");
+   for (i=0;i<TEST_THREADS;i++)
+    {Check(loads[i]->ok,"Concurrent load failed",loads[i]->error.c_str());
+     if (!loads[i]->ok) continue;
+     Check(loads[i]->pp.GetCompoundStringConstant(0,Name)==loads[0]->pp.GetCompoundStringConstant(0,Name),"Compound of concurrent loads is not shared");
+     if (!loads[i]->lazy) Check(DeferredCount(loads[i]->pp)==0,"Correlations of eager package are deferred");
+     Check((GetProperties(loads[i]->pp,values))&&(values==reference),"Properties of concurrently loaded package differ");
+    }
+   for (i=0;i<TEST_THREADS;i++) delete loads[i];
+   Check(GetSharedCompoundCount()==0,"Shared compound count after releasing concurrently loaded packages");
+  }
+ printf("%d compounds, %d threads: %d checks failed\n",TEST_COMPOUNDS,TEST_THREADS,FailedChecks());
+ return FailedChecks()?1:0;
+}
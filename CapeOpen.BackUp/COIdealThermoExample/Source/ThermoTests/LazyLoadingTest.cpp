@@ -0,0 +1,268 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <CPPExports.h>     // exports from the IdealThermoModule
+#include "TestData.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+using namespace std;
+
+/*! \mainpage Lazy Loading Test
+*
+*This test checks the lazy loading mode of property packages, in which
+*the correlations of a compound are loaded when a calculation first
+*involves the compound. A synthetic property package is generated and
+*loaded lazily and eagerly:
+*
+* - the load counters of a lazy package count exactly the compounds
+*   that calculations have touched, each compound once
+* - the temperature dependent properties of all compounds are identical
+*   for the lazy and the eager package
+* - threads that flash overlapping mixtures on a freshly loaded lazy
+*   package, so that they load the same compounds at the same time, get
+*   the same results as the eager package
+*
+*Each package is released before the next one is loaded, as packages
+*share their compounds while they are loaded.
+*
+*Usage: lazy_loading_test
+*
+*/
+
+//! Number of compounds in the test package
+#define TEST_COMPOUNDS 64
+
+//! Number of threads that flash concurrently
+#define TEST_THREADS 8
+
+//! Number of compounds in the mixture of each thread
+#define THREAD_COMPOUNDS 12
+
+//! Number of temperatures at which the temperature dependent properties are compared
+#define TEST_TEMPERATURES 3
+
+//! Load the test property package
+/*!
+  \param pp The property package
+  \param path Path of the property package file
+  \param lazy True to load lazily
+  \return True if ok
+*/
+
+static bool LoadPackage(PropertyPack &pp,const string &path,bool lazy)
+{if (!pp.SetLazyLoading(lazy))
+  {Check(false,"SetLazyLoading failed",pp.LastError());
+   return false;
+  }
+ if (!pp.Load(path.c_str()))
+  {Check(false,"Load failed",pp.LastError());
+   return false;
+  }
+ return true;
+}
+
+//! Check the load counters
+/*!
+  \param pp The property package
+  \param deferred Expected number of compounds of which loading the correlations was deferred
+  \param loaded Expected number of those compounds of which the correlations have been loaded
+  \param what Description of the check
+*/
+
+static void CheckCounters(const PropertyPack &pp,int deferred,int loaded,const char *what)
+{int compoundCount,deferredCount,loadedCount;
+ pp.GetLoadCounters(compoundCount,deferredCount,loadedCount);
+ Check((compoundCount==TEST_COMPOUNDS)&&(deferredCount==deferred)&&(loadedCount==loaded),what);
+}
+
+//! Temperature dependent properties of all compounds
+/*!
+  \param pp The property package
+  \param values Receives the values
+  \return True if ok
+*/
+
+static bool GetProperties(PropertyPack &pp,vector<double> &values)
+{int i,j,k;
+ double value;
+ values.clear();
+ for (i=0;i<TEST_COMPOUNDS;i++)
+  for (j=0;j<TDependentPropertyCount;j++)
+   for (k=0;k<TEST_TEMPERATURES;k++)
+    {if (!pp.GetTemperatureDependentProperty(i,(TDependentProperty)j,250.0+50.0*k,value)) return false;
+     values.push_back(value);
+    }
+ return true;
+}
+
+//! Flash of the mixture of one thread
+/*!
+  The mixtures of the threads overlap, so that the threads use the same compounds
+*/
+
+struct ThreadFlash
+{const PropertyPack *pp;         /*!< the property package */
+ int compIndices[THREAD_COMPOUNDS]; /*!< compounds of the mixture */
+ double X[THREAD_COMPOUNDS];      /*!< composition of the mixture */
+ bool ok;                         /*!< result of the flash */
+ string error;                    /*!< error of the flash */
+ vector<double> results;          /*!< temperature, phase fractions and phase compositions */
+
+ void Init(const PropertyPack *pp,int thread);
+ void Run();
+};
+
+//! Set up the mixture of a thread
+/*!
+  \param pp The property package
+  \param thread Index of the thread
+*/
+
+void ThreadFlash::Init(const PropertyPack *pp,int thread)
+{int i;
+ this->pp=pp;
+ for (i=0;i<THREAD_COMPOUNDS;i++)
+  {compIndices[i]=(5*thread+3*i)%TEST_COMPOUNDS;
+   X[i]=1.0/THREAD_COMPOUNDS;
+  }
+ ok=false;
+}
+
+//! Flash the mixture half way between bubble and dew point
+void ThreadFlash::Run()
+{PropertyPackWorkspace ws;
+ int i,j,phaseCount;
+ Phase *phases;
+ double *phaseFractions,**phaseCompositions,T,P;
+ results.clear();
+ ok=pp->Flash(ws,THREAD_COMPOUNDS,compIndices,X,PVF,VaporLiquid,101325.0,0.5,phaseCount,phases,phaseFractions,phaseCompositions,T,P);
+ if (!ok)
+  {error=ws.LastError();
+   return;
+  }
+ results.push_back(T);
+ for (i=0;i<phaseCount;i++)
+  {results.push_back(phaseFractions[i]);
+   for (j=0;j<THREAD_COMPOUNDS;j++) results.push_back(phaseCompositions[i][j]);
+  }
+}
+
+//! Flashing thread
+/*!
+  \param param The ThreadFlash
+*/
+
+#ifdef _WIN32
+static DWORD WINAPI ThreadProc(LPVOID param)
+#else
+static void *ThreadProc(void *param)
+#endif
+{((ThreadFlash *)param)->Run();
+ return 0;
+}
+
+//! Flash the mixtures of all threads concurrently
+/*!
+  \param flashes The flashes, one per thread
+  \return True if all threads were started
+*/
+
+static bool RunThreads(ThreadFlash *flashes)
+{int i,started;
+#ifdef _WIN32
+ HANDLE threads[TEST_THREADS];
+ for (started=0;started<TEST_THREADS;started++)
+  if ((threads[started]=::CreateThread(NULL,0,ThreadProc,flashes+started,0,NULL))==NULL) break;
+ for (i=0;i<started;i++)
+  {WaitForSingleObject(threads[i],INFINITE);
+   CloseHandle(threads[i]);
+  }
+#else
+ pthread_t threads[TEST_THREADS];
+ for (started=0;started<TEST_THREADS;started++)
+  if (pthread_create(threads+started,NULL,ThreadProc,flashes+started)!=0) break;
+ for (i=0;i<started;i++) pthread_join(threads[i],NULL);
+#endif
+ return (started==TEST_THREADS);
+}
+
+//! Entry point
+/*!
+  Check the counters of a lazy package, then the results of concurrent first use
+  of a lazy package, and compare both to an eager package
+  \return Zero if all checks passed
+*/
+
+int main()
+{int i,j,touchedCount;
+ static const int mixture[3]={40,7,21};
+ bool touched[TEST_COMPOUNDS];
+ double value,X[3]={0.2,0.3,0.5};
+ int phaseCount;
+ Phase *phases;
+ double *phaseFractions,**phaseCompositions,T,P;
+ vector<double> lazyValues,eagerValues;
+ static ThreadFlash lazyFlashes[TEST_THREADS],eagerFlashes[TEST_THREADS];
+ TempFolder temp; //removed with the generated files on exit
+ if (!temp.Create("lazy_loading_test"))
+  {fprintf(stderr,"Failed to create data folder\n");
+   return 1;
+  }
+ string folder=temp.Path();
+ string path=(WriteCompounds(folder,"lazy_loading_test_",TEST_COMPOUNDS))?WritePackage(folder,"lazy_loading_test","lazy_loading_test_",0,TEST_COMPOUNDS):string();
+ if (path.empty())
+  {fprintf(stderr,"Failed to write package to \"%s\"\n",folder.c_str());
+   return 1;
+  }
+ SetCompoundDataPath(folder.c_str());
+ //the counters count each touched compound once
+ {PropertyPack lazy;
+  if (!LoadPackage(lazy,path,true)) return 1;
+  CheckCounters(lazy,TEST_COMPOUNDS,0,"Load counters of a lazy package after loading");
+  for (i=0;i<RealConstantCount;i++) Check(lazy.GetCompoundRealConstant(7,(RealConstant)i,value),"GetCompoundRealConstant failed",lazy.LastError());
+  CheckCounters(lazy,TEST_COMPOUNDS,0,"Load counters of a lazy package after getting constants");
+  for (i=0;i<2;i++) Check(lazy.GetTemperatureDependentProperty(7,VaporPressure,300.0,value),"GetTemperatureDependentProperty failed",lazy.LastError());
+  CheckCounters(lazy,TEST_COMPOUNDS,1,"Load counters of a lazy package after using one compound");
+  Check(lazy.Flash(3,mixture,X,PVF,VaporLiquid,101325.0,0.5,phaseCount,phases,phaseFractions,phaseCompositions,T,P),"Flash failed",lazy.LastError());
+  CheckCounters(lazy,TEST_COMPOUNDS,3,"Load counters of a lazy package after a flash");
+  Check(GetProperties(lazy,lazyValues),"GetTemperatureDependentProperty failed",lazy.LastError());
+  CheckCounters(lazy,TEST_COMPOUNDS,TEST_COMPOUNDS,"Load counters of a lazy package after using all compounds");
+ }
+ //concurrent first use of overlapping mixtures
+ {PropertyPack lazy;
+  if (!LoadPackage(lazy,path,true)) return 1;
+  for (i=0;i<TEST_COMPOUNDS;i++) touched[i]=false;
+  for (i=0;i<TEST_THREADS;i++)
+   {lazyFlashes[i].Init(&lazy,i);
+    for (j=0;j<THREAD_COMPOUNDS;j++) touched[lazyFlashes[i].compIndices[j]]=true;
+   }
+  touchedCount=0;
+  for (i=0;i<TEST_COMPOUNDS;i++) if (touched[i]) touchedCount++;
+  Check(RunThreads(lazyFlashes),"Failed to start threads");
+  for (i=0;i<TEST_THREADS;i++) Check(lazyFlashes[i].ok,"Flash on lazy package failed",lazyFlashes[i].error.c_str());
+  CheckCounters(lazy,TEST_COMPOUNDS,touchedCount,"Load counters of a lazy package after concurrent flashes");
+ }
+ //the eager package loads its own compounds, as the lazy packages are released
+ Check(GetSharedCompoundCount()==0,"Compounds of released packages are still shared");
+ {PropertyPack eager;
+  if (!LoadPackage(eager,path,false)) return 1;
+  CheckCounters(eager,0,0,"Load counters of an eager package");
+  Check(GetProperties(eager,eagerValues),"GetTemperatureDependentProperty failed",eager.LastError());
+  Check(eagerValues==lazyValues,"Properties differ between lazy and eager package");
+  for (i=0;i<TEST_THREADS;i++)
+   {eagerFlashes[i].Init(&eager,i);
+    eagerFlashes[i].Run();
+    Check(eagerFlashes[i].ok,"Flash on eager package failed",eagerFlashes[i].error.c_str());
+    Check(eagerFlashes[i].results==lazyFlashes[i].results,"Flash results differ between lazy and eager package");
+   }
+ }
+ printf("%d compounds, %d threads: %d checks failed\n",TEST_COMPOUNDS,TEST_THREADS,FailedChecks());
+ return FailedChecks()?1:0;
+}
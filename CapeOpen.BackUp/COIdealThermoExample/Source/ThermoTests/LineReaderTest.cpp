@@ -0,0 +1,187 @@
+#include <stdafx.h>         // internal headers of the IdealThermoModule
+#include <LineReader.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TestData.h"
+
+/*! \mainpage Line Reader Test
+*
+*This test checks the block-buffered LineReader that reads the data
+*files of the IdealThermoModule, on fixed file contents:
+*
+* - carriage returns and zero characters are removed, and white space
+*   is stripped
+* - empty lines and comments are skipped, and line numbers count them
+* - the last line need not end with a line end
+* - a line longer than the 64 kB block is returned whole
+* - Seek() to a Position() continues with the same lines and line
+*   numbers, also for a position in a later block
+*
+*Usage: line_reader_test
+*
+*/
+
+//! Write a test file
+/*!
+  \param path Path of the file
+  \param data File contents, may contain zero characters
+  \return True if ok
+*/
+
+static bool WriteFile(const string &path,const string &data)
+{FILE *f=fopen(path.c_str(),"wb");
+ if (!f) return false;
+ bool ok=(fwrite(data.data(),1,data.size(),f)==data.size());
+ if (fclose(f)) ok=false;
+ return ok;
+}
+
+//! Check the lines of a file
+/*!
+  Open the file and compare all lines returned by Next() and their line numbers
+  \param path Path of the file
+  \param test Name of the test case
+  \param lines Expected lines
+  \param lineNumbers Expected line numbers
+  \param count Number of expected lines
+*/
+
+static void CheckLines(const string &path,const char *test,const char **lines,const int *lineNumbers,int count)
+{LineReader reader;
+ const char *line;
+ int i;
+ if (reader.Open(path.c_str()))
+  {Check(false,test,"cannot open file");
+   return;
+  }
+ for (i=0;i<count;i++)
+  {line=reader.Next();
+   if (!line)
+    {Check(false,test,"too few lines");
+     return;
+    }
+   Check(strcmp(line,lines[i])==0,test,"line differs");
+   Check(reader.LineNumber()==lineNumbers[i],test,"line number differs");
+  }
+ Check(reader.Next()==NULL,test,"too many lines");
+ Check(reader.Next()==NULL,test,"lines after the end");
+}
+
+//! Carriage returns, zero characters and white space
+static void TestCharacters(const string &folder)
+{static const char data[]="first\r\n\tsec\0ond \r\n\r\nthi\rrd\t\n";
+ static const char *lines[]={"first","second","third"};
+ static const int lineNumbers[]={1,2,4};
+ string path=folder+"/characters.txt";
+ if (!WriteFile(path,string(data,sizeof(data)-1))) Check(false,"characters","cannot write file");
+ else CheckLines(path,"characters",lines,lineNumbers,3);
+}
+
+//! Empty lines and comments
+static void TestComments(const string &folder)
+{static const char *lines[]={"a","b # not a comment","c"};
+ static const int lineNumbers[]={3,5,8};
+ string path=folder+"/comments.txt";
+ if (!WriteFile(path,"# comment\n\na\n  # indented comment\nb # not a comment\n \t \n\nc\n#\n")) Check(false,"comments","cannot write file");
+ else CheckLines(path,"comments",lines,lineNumbers,3);
+}
+
+//! No line end after the last line
+static void TestLastLine(const string &folder)
+{static const char *lines[]={"a","last"};
+ static const int lineNumbers[]={1,2};
+ string path=folder+"/lastline.txt";
+ if (!WriteFile(path,"a\nlast")) Check(false,"last line","cannot write file");
+ else CheckLines(path,"last line",lines,lineNumbers,2);
+ //a last line with only a carriage return
+ path=folder+"/lastlinecr.txt";
+ if (!WriteFile(path,"a\nlast\r")) Check(false,"last line","cannot write file");
+ else CheckLines(path,"last line",lines,lineNumbers,2);
+}
+
+//! Lines longer than the block size, with and without line end
+static void TestLongLine(const string &folder)
+{string longLine(3*65536+17,'x');
+ string longLast(65536,'y');
+ const char *lines[]={"a",longLine.c_str(),"b",longLast.c_str()};
+ static const int lineNumbers[]={1,2,3,4};
+ string path=folder+"/longline.txt";
+ if (!WriteFile(path,"a\n"+longLine+"\r\nb\n"+longLast)) Check(false,"long line","cannot write file");
+ else CheckLines(path,"long line",lines,lineNumbers,4);
+}
+
+//! Seek to a position returned by Position()
+static void TestSeek(const string &folder)
+{LineReader reader;
+ const char *line;
+ char text[32];
+ int i,lineNumber;
+ long position;
+ string data;
+ vector<string> rest;
+ vector<int> restNumbers;
+ //enough lines to span several blocks, with comments in between
+ for (i=0;i<20000;i++)
+  {sprintf(text,"line %d\r\n",i);
+   data+=text;
+   if (i%7==0) data+="# comment\n";
+  }
+ string path=folder+"/seek.txt";
+ if (!WriteFile(path,data))
+  {Check(false,"seek","cannot write file");
+   return;
+  }
+ //positions in the first block and in a later block
+ for (int skip=1;skip<=15000;skip+=14999)
+  {if (reader.Open(path.c_str()))
+    {Check(false,"seek","cannot open file");
+     return;
+    }
+   Check(reader.Skip(skip),"seek","too few lines");
+   position=reader.Position();
+   lineNumber=reader.LineNumber();
+   rest.clear();
+   restNumbers.clear();
+   while ((line=reader.Next())!=NULL)
+    {rest.push_back(line);
+     restNumbers.push_back(reader.LineNumber());
+    }
+   Check((int)rest.size()==20000-skip,"seek","wrong number of lines");
+   Check(reader.Seek(position,lineNumber),"seek","Seek() failed");
+   for (i=0;i<(int)rest.size();i++)
+    {line=reader.Next();
+     if (!line)
+      {Check(false,"seek","too few lines after Seek()");
+       break;
+      }
+     Check(rest[i]==line,"seek","line differs after Seek()");
+     Check(restNumbers[i]==reader.LineNumber(),"seek","line number differs after Seek()");
+    }
+   Check(reader.Next()==NULL,"seek","too many lines after Seek()");
+  }
+ //Seek() requires an open file
+ reader.Close();
+ Check(!reader.Seek(0,0),"seek","Seek() succeeded on a closed reader");
+}
+
+//! Entry point
+/*!
+  \return Zero if all checks passed
+*/
+
+int main()
+{TempFolder temp; //removed with the generated files on exit
+ if (!temp.Create("line_reader_test"))
+  {fprintf(stderr,"Failed to create test folder\n");
+   return 1;
+  }
+ string folder=temp.Path();
+ TestCharacters(folder);
+ TestComments(folder);
+ TestLastLine(folder);
+ TestLongLine(folder);
+ TestSeek(folder);
+ printf("%d checks failed\n",FailedChecks());
+ return FailedChecks()?1:0;
+}
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <CPPExports.h>     // exports from the IdealThermoModule
+#include "TestData.h"
+
+using namespace std;
+
+/*! \mainpage Tabulation Test
+*
+*This test checks the tabulated mode of property packages, in which the
+*vapor pressures are evaluated from splines. A synthetic property package
+*is generated and tabulated for a number of maximum relative errors; for
+*each, the tabulation report must list all compounds as tabulated, with
+*the largest relative errors of the vapor pressure and of its temperature
+*derivative within the maximum.
+*
+*Usage: tabulation_test
+*
+*/
+
+//! Number of compounds in the test package
+#define TEST_COMPOUNDS 50
+
+//! Number of maximum relative errors for which the package is tabulated
+#define TEST_ERRORS 4
+
+//! Check the tabulation report
+/*!
+  \param report The tabulation report
+  \param maxRelError Maximum relative error the package is tabulated for
+  \return The number of compounds in the report
+*/
+
+static int CheckReport(const char *report,double maxRelError)
+{int count,segments;
+ double Tmin,Tmax,error,errorDT;
+ char what[256];
+ const char *line=strchr(report,'\n');
+ for (count=0;(line)&&(line[1]);count++)
+  {const char *values=strchr(line+1,',');
+   line=strchr(line+1,'\n');
+   if ((!values)||(sscanf(values,",%d,%lg,%lg,%lg,%lg",&segments,&Tmin,&Tmax,&error,&errorDT)!=5))
+    {sprintf(what,"Compound %d is not tabulated for maximum relative error %g",count,maxRelError);
+     Check(false,what);
+     continue;
+    }
+   sprintf(what,"Compound %d: vapor pressure error %.3e exceeds %g",count,error,maxRelError);
+   Check(error<=maxRelError,what);
+   sprintf(what,"Compound %d: vapor pressure derivative error %.3e exceeds %g",count,errorDT,maxRelError);
+   Check(errorDT<=maxRelError,what);
+  }
+ return count;
+}
+
+//! Entry point
+/*!
+  Tabulate the package for each maximum relative error and check the reports
+  \return Zero if all checks passed
+*/
+
+int main()
+{int i;
+ static const double maxRelErrors[TEST_ERRORS]={1e-3,1e-4,1e-6,1e-8};
+ TempFolder temp; //removed with the generated files on exit
+ if (!temp.Create("tabulation_test"))
+  {fprintf(stderr,"Failed to create data folder\n");
+   return 1;
+  }
+ string folder=temp.Path();
+ string path=(WriteCompounds(folder,"tabulation_test_",TEST_COMPOUNDS))?WritePackage(folder,"tabulation_test","tabulation_test_",0,TEST_COMPOUNDS):string();
+ if (path.empty())
+  {fprintf(stderr,"Failed to write package to \"%s\"\n",folder.c_str());
+   return 1;
+  }
+ SetCompoundDataPath(folder.c_str());
+ PropertyPack pp;
+ if (!pp.Load(path.c_str()))
+  {fprintf(stderr,"Load failed: %s\n",pp.LastError());
+   return 1;
+  }
+ for (i=0;i<TEST_ERRORS;i++)
+  {if (!pp.SetTabulation(maxRelErrors[i]))
+    {Check(false,"SetTabulation failed",pp.LastError());
+     continue;
+    }
+   const char *report=pp.GetTabulationReport();
+   if (!report)
+    {Check(false,"GetTabulationReport failed",pp.LastError());
+     continue;
+    }
+   Check(CheckReport(report,maxRelErrors[i])==TEST_COMPOUNDS,"Tabulation report does not list all compounds");
+  }
+ printf("%d compounds, %d maximum errors: %d checks failed\n",TEST_COMPOUNDS,TEST_ERRORS,FailedChecks());
+ return FailedChecks()?1:0;
+}
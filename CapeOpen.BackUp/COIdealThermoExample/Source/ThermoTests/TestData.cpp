@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include "TestData.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <dirent.h>
+#endif
+
+using namespace std;
+
+//! Number of failed checks
+static int failedChecks=0;
+
+//! Number of failed checks that are reported
+#define REPORTED_CHECKS 10
+
+//! Count a failed check
+/*!
+  The first failed checks are reported on stderr
+  \param ok Result of the check
+  \param what Description of the check
+  \param detail Further description, such as an error message, or NULL
+  \sa FailedChecks()
+*/
+
+void Check(bool ok,const char *what,const char *detail)
+{if (ok) return;
+ if (failedChecks<REPORTED_CHECKS) fprintf(stderr,"%s%s%s\n",what,(detail)?": ":"",(detail)?detail:"");
+ failedChecks++;
+}
+
+//! Number of failed checks
+/*!
+  \return The number of failed checks so far
+  \sa Check()
+*/
+
+int FailedChecks()
+{return failedChecks;
+}
+
+//! Create the folder
+/*!
+  Create an empty folder in the folder for temporary files
+  \param prefix Start of the folder name, e.g. the name of the executable
+  \return True if ok
+*/
+
+bool TempFolder::Create(const char *prefix)
+{Remove();
+#ifdef _WIN32
+ char buf[MAX_PATH];
+ char name[64];
+ GetTempPathA(MAX_PATH,buf);
+ sprintf(name,"_%u",(unsigned)GetCurrentProcessId());
+ string folder=buf;
+ folder+=prefix;
+ folder+=name;
+ if (!CreateDirectoryA(folder.c_str(),NULL)) return false;
+ path=folder;
+#else
+ const char *tmp=getenv("TMPDIR");
+ string folder=(tmp&&*tmp)?tmp:"/tmp";
+ folder+="/";
+ folder+=prefix;
+ folder+="_XXXXXX";
+ vector<char> buf(folder.begin(),folder.end());
+ buf.push_back(0);
+ if (!mkdtemp(&buf[0])) return false;
+ path=&buf[0];
+#endif
+ return true;
+}
+
+//! Remove the folder
+/*!
+  Delete the files in the folder and the folder itself
+*/
+
+void TempFolder::Remove()
+{if (path.empty()) return;
+#ifdef _WIN32
+ WIN32_FIND_DATAA data;
+ HANDLE find=FindFirstFileA((path+"\\*").c_str(),&data);
+ if (find!=INVALID_HANDLE_VALUE)
+  {do
+    {if (!(data.dwFileAttributes&FILE_ATTRIBUTE_DIRECTORY)) DeleteFileA((path+"\\"+data.cFileName).c_str());
+    } while (FindNextFileA(find,&data));
+   FindClose(find);
+  }
+ RemoveDirectoryA(path.c_str());
+#else
+ DIR *dir=opendir(path.c_str());
+ if (dir)
+  {struct dirent *entry;
+   while ((entry=readdir(dir))!=NULL)
+    if ((strcmp(entry->d_name,".")!=0)&&(strcmp(entry->d_name,"..")!=0)) unlink((path+"/"+entry->d_name).c_str());
+   closedir(dir);
+  }
+ rmdir(path.c_str());
+#endif
+ path.clear();
+}
+
+//! Destructor
+/*!
+  Removes the folder
+*/
+
+TempFolder::~TempFolder()
+{Remove();
+}
+
+//! Name of a synthetic compound
+/*!
+  \param prefix Start of the name
+  \param index Index of the compound
+  \return The compound name (also file name)
+*/
+
+string CompoundName(const char *prefix,int index)
+{char name[32];
+ sprintf(name,"c%d",index);
+ return prefix+string(name);
+}
+
+//! Generate a synthetic compound
+/*!
+  Write a .compound file for a synthetic compound
+  \param folder Data folder
+  \param name Compound name (also file name)
+  \param frac Position in the volatility range, 0 (light) to 1 (heavy)
+  \param truncated If set, the file ends before the correlations
+  \param paddingLines Number of comment lines after the constants
+  \return True if ok
+*/
+
+bool WriteCompound(const string &folder,const string &name,double frac,bool truncated,int paddingLines)
+{int i;
+ string path=folder+"/"+name+".compound";
+ FILE *f=fopen(path.c_str(),"wb");
+ if (!f) return false;
+ double NBP=280.0+100.0*frac;
+ double TC=1.5*NBP;
+ double MW=0.25*NBP;
+ double Hvb=88.0*NBP; //Trouton
+ double antC=-0.1*NBP;
+ double antB=Hvb*(NBP+antC)*(NBP+antC)/(8.314472*NBP*NBP*log(10.0));
+ double antA=log10(101325.0)+antB/(NBP+antC);
+ double hvapB=-Hvb/(TC-NBP);
+ double hvapA=-hvapB*TC;
+ double rho0=1.2e4*(1.0-0.5*frac);
+ fprintf(f,"# synthetic compound\n");
+ fprintf(f,"%s\n",name.c_str());
+ fprintf(f,"C%dH%d\n",(int)(NBP/30),2*(int)(NBP/30)+2);
+ fprintf(f,"0-00-%d\n",(int)(frac*1000));
+ fprintf(f,"%.10g\n%.10g\n%.10g\n%.10g\n%.10g\n",MW,NBP,TC,3.0e6*(1.0-0.5*frac),3.0e-4*(1.0+frac));
+ for (i=0;i<paddingLines;i++) fprintf(f,"# padding line %d\n",i);
+ if (!truncated)
+  {fprintf(f,"%.10g %.10g %.10g %.10g %.10g\n",30.0+0.1*NBP,0.1,-3.0e-5,0.0,0.0);
+   fprintf(f,"%.10g %.10g %.10g %.10g %.10g\n",hvapA,hvapB,0.0,0.0,0.0);
+   fprintf(f,"%.10g %.10g %.10g %.10g %.10g\n",1.3*rho0,-0.6*rho0/TC,0.0,0.0,0.0);
+   fprintf(f,"%.10g %.10g %.10g\n",antA,antB,antC);
+  }
+ return (fclose(f)==0);
+}
+
+//! Generate a set of synthetic compounds
+/*!
+  Write count compounds, spread evenly over the volatility range from light to heavy
+  \param folder Data folder
+  \param prefix Start of the compound names, see CompoundName()
+  \param count Number of compounds
+  \return True if ok
+*/
+
+bool WriteCompounds(const string &folder,const char *prefix,int count)
+{int i;
+ for (i=0;i<count;i++)
+  if (!WriteCompound(folder,CompoundName(prefix,i),(count==1)?0.5:(double)i/(count-1))) return false;
+ return true;
+}
+
+//! Generate a property package
+/*!
+  Write a property package of a range of synthetic compounds; the compounds are
+  not written, see WriteCompounds()
+  \param folder Data folder
+  \param name Name of the property package (also file name)
+  \param prefix Start of the compound names, see CompoundName()
+  \param first Index of the first compound
+  \param count Number of compounds
+  \return Path of the property package file, empty in case of failure
+*/
+
+string WritePackage(const string &folder,const char *name,const char *prefix,int first,int count)
+{int i;
+ string path=folder+"/"+name+".propertypackage";
+ FILE *f=fopen(path.c_str(),"wb");
+ if (!f) return string();
+ for (i=first;i<first+count;i++) fprintf(f,"%s\n",CompoundName(prefix,i).c_str());
+ if (fclose(f)) return string();
+ return path;
+}
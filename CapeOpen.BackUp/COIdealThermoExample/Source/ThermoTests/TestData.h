@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stddef.h>
+#include <string>
+
+/*! \file TestData.h
+*
+*Test data generation and checks shared by the ThermoTests executables
+*and by ThermoBench.
+*
+*The synthetic compounds are hydrocarbon-like: they span normal boiling
+*points from 280 to 380 K, the critical temperature is 1.5 times the
+*normal boiling point, the heat of vaporization follows Trouton's rule
+*and vanishes at the critical point, and the Antoine constants are fitted
+*to pass through the normal boiling point with a slope consistent with
+*the heat of vaporization. A compound is named by a prefix and its index,
+*e.g. bench10c3 for compound 3 with prefix bench10.
+*
+*/
+
+//checks
+void Check(bool ok,const char *what,const char *detail=NULL);
+int FailedChecks();
+
+//generated data
+std::string CompoundName(const char *prefix,int index);
+bool WriteCompound(const std::string &folder,const std::string &name,double frac,bool truncated=false,int paddingLines=0);
+bool WriteCompounds(const std::string &folder,const char *prefix,int count);
+std::string WritePackage(const std::string &folder,const char *name,const char *prefix,int first,int count);
+
+//! TempFolder class
+/*!
+	A temporary folder for generated data, which is removed with the files
+	in it when the TempFolder goes out of scope. Sub folders are not supported.
+	\code
+	TempFolder temp;
+	if (temp.Create("my_test")) WriteCompounds(temp.Path(),"my_test_",10);
+	\endcode
+*/
+
+class TempFolder
+{public:
+
+	//construction
+	TempFolder() {}
+	~TempFolder();
+
+	//functions
+	bool Create(const char *prefix);
+	void Remove();
+
+	//! Path of the folder
+	/*!
+	  \return The path of the folder, empty if not created
+	*/
+
+	const std::string &Path() const {return path;}
+
+private:
+
+	std::string path; /*!< path of the folder, empty if not created */
+
+	//no copies of the folder
+	TempFolder(const TempFolder &);
+	TempFolder &operator=(const TempFolder &);
+
+};